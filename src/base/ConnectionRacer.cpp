@@ -0,0 +1,273 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "ConnectionRacer.h"
+
+#include "StringLiterals.h"
+
+#include <algorithm>
+
+#include <QHostInfo>
+#include <QTcpSocket>
+#include <QTimer>
+
+namespace QXmpp::Private {
+
+static QString formatAddress(const QHostAddress &address, quint16 port)
+{
+    if (address.protocol() == QAbstractSocket::IPv6Protocol) {
+        return u'[' + address.toString() + u"]:" + QString::number(port);
+    }
+    return address.toString() + u':' + QString::number(port);
+}
+
+QList<QHostAddress> interleaveAddressFamilies(const QList<QHostAddress> &addresses)
+{
+    if (addresses.isEmpty()) {
+        return {};
+    }
+
+    const auto firstFamily = addresses.first().protocol();
+    QList<QHostAddress> first, second;
+    for (const auto &address : addresses) {
+        (address.protocol() == firstFamily ? first : second).append(address);
+    }
+
+    QList<QHostAddress> result;
+    result.reserve(addresses.size());
+    for (qsizetype i = 0; i < std::max(first.size(), second.size()); i++) {
+        if (i < first.size()) {
+            result.append(first.at(i));
+        }
+        if (i < second.size()) {
+            result.append(second.at(i));
+        }
+    }
+    return result;
+}
+
+ConnectionRacer::ConnectionRacer(QXmppLoggable *logger, std::chrono::milliseconds attemptDelay)
+    : m_logger(logger),
+      m_attemptDelay(attemptDelay),
+      m_attemptTimer(new QTimer(logger))
+{
+    m_attemptTimer->setSingleShot(true);
+    QObject::connect(m_attemptTimer, &QTimer::timeout, m_attemptTimer, [this] {
+        startNextAttempt();
+    });
+}
+
+ConnectionRacer::~ConnectionRacer()
+{
+    abort();
+}
+
+//
+// Starts a new race, a running race is aborted.
+//
+// The task reports the first server address a connection could be established to or the error of
+// the last failed attempt.
+//
+QXmppTask<ConnectionRacer::Result> ConnectionRacer::race(const std::vector<ServerAddress> &addresses)
+{
+    abort();
+
+    m_promise.emplace();
+    auto task = m_promise->task();
+    m_lastError = QAbstractSocket::HostNotFoundError;
+
+    m_targets.reserve(addresses.size());
+    for (const auto &address : addresses) {
+        m_targets.push_back(Target { address.host, address.port });
+    }
+
+    const auto generation = m_generation;
+    for (std::size_t i = 0; i < m_targets.size() && generation == m_generation; i++) {
+        const auto id = QHostInfo::lookupHost(m_targets[i].host, m_logger, [this, generation, i](const QHostInfo &info) {
+            if (generation == m_generation) {
+                handleLookup(i, info.addresses(), info.error() == QHostInfo::NoError ? QString() : info.errorString());
+            }
+        });
+        if (generation == m_generation && !m_targets[i].resolved) {
+            m_targets[i].lookupId = id;
+        }
+    }
+
+    if (m_targets.empty()) {
+        finish(QAbstractSocket::HostNotFoundError);
+    }
+    return task;
+}
+
+//
+// Aborts all host lookups and connection attempts. The task of a running race is not finished.
+//
+void ConnectionRacer::abort()
+{
+    m_generation++;
+    m_attemptTimer->stop();
+
+    for (const auto &target : m_targets) {
+        if (target.lookupId >= 0) {
+            QHostInfo::abortHostLookup(target.lookupId);
+        }
+    }
+    for (const auto &attempt : m_attempts) {
+        attempt.socket->disconnect();
+        attempt.socket->abort();
+        attempt.socket->deleteLater();
+    }
+
+    m_targets.clear();
+    m_attempts.clear();
+    m_promise.reset();
+}
+
+void ConnectionRacer::handleLookup(std::size_t index, const QList<QHostAddress> &addresses, const QString &error)
+{
+    auto &target = m_targets[index];
+    target.lookupId = -1;
+    target.resolved = true;
+
+    if (!error.isEmpty()) {
+        log(QXmppLogger::WarningMessage, u"Could not resolve %1: %2"_s.arg(target.host, error));
+    } else {
+        target.addresses = interleaveAddressFamilies(addresses);
+    }
+
+    // if no attempt is waiting for its delay, the next one can start right away
+    if (!m_attemptTimer->isActive()) {
+        startNextAttempt();
+    } else {
+        finishIfExhausted();
+    }
+}
+
+void ConnectionRacer::startNextAttempt()
+{
+    // the server addresses are tried in order, addresses that are still being resolved are
+    // skipped until their lookup finished
+    auto target = std::find_if(m_targets.begin(), m_targets.end(), [](const Target &target) {
+        return target.resolved && target.nextAddress < target.addresses.size();
+    });
+    if (target == m_targets.end()) {
+        finishIfExhausted();
+        return;
+    }
+
+    const auto address = target->addresses.at(target->nextAddress++);
+    auto *socket = new QTcpSocket(m_logger);
+    socket->setProxy(m_proxy);
+    m_attempts.push_back(Attempt { socket, std::size_t(target - m_targets.begin()), address, Clock::now() });
+
+    QObject::connect(socket, &QAbstractSocket::connected, socket, [this, socket] {
+        handleConnected(socket);
+    });
+    QObject::connect(socket, &QAbstractSocket::errorOccurred, socket, [this, socket] {
+        handleError(socket);
+    });
+
+    log(QXmppLogger::DebugMessage, u"Connecting to %1 (%2)"_s.arg(formatAddress(address, target->port), target->host));
+    if (m_logger->isMetricsEnabled()) {
+        Q_EMIT m_logger->updateCounter(u"connect.attempts"_s);
+    }
+    socket->connectToHost(address, target->port);
+
+    if (m_attemptDelay.count() > 0) {
+        m_attemptTimer->start(m_attemptDelay);
+    }
+}
+
+void ConnectionRacer::handleConnected(QTcpSocket *socket)
+{
+    auto attempt = findAttempt(socket);
+    if (attempt == m_attempts.end()) {
+        return;
+    }
+
+    const auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - attempt->start);
+    const auto &target = m_targets[attempt->target];
+    log(QXmppLogger::InformationMessage,
+        u"Connected to %1 (%2) after %3 ms"_s
+            .arg(formatAddress(attempt->address, target.port), target.host, QString::number(latency.count())));
+    if (m_logger->isMetricsEnabled()) {
+        Q_EMIT m_logger->updateHistogram(u"connect.latency"_s, std::chrono::duration<double>(latency).count());
+    }
+
+    // only the other attempts are aborted
+    Winner winner { attempt->target, attempt->address, latency, {} };
+    m_attempts.erase(attempt);
+    socket->disconnect();
+    socket->setParent(nullptr);
+    winner.socket = std::shared_ptr<QTcpSocket>(socket, [](QTcpSocket *socket) {
+        socket->abort();
+        socket->deleteLater();
+    });
+
+    finish(std::move(winner));
+}
+
+void ConnectionRacer::handleError(QTcpSocket *socket)
+{
+    auto attempt = findAttempt(socket);
+    if (attempt == m_attempts.end()) {
+        return;
+    }
+
+    const auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - attempt->start);
+    log(QXmppLogger::WarningMessage,
+        u"Connection attempt to %1 (%2) failed after %3 ms: %4"_s
+            .arg(formatAddress(attempt->address, m_targets[attempt->target].port),
+                 m_targets[attempt->target].host,
+                 QString::number(latency.count()),
+                 socket->errorString()));
+    if (m_logger->isMetricsEnabled()) {
+        Q_EMIT m_logger->updateCounter(u"connect.failed-attempts"_s);
+    }
+
+    m_lastError = socket->error();
+    m_attempts.erase(attempt);
+    socket->disconnect();
+    socket->deleteLater();
+
+    // do not wait for the delay after a failure
+    m_attemptTimer->stop();
+    startNextAttempt();
+}
+
+// Fails the race if all addresses have been tried without success.
+void ConnectionRacer::finishIfExhausted()
+{
+    if (!m_promise || !m_attempts.empty()) {
+        return;
+    }
+    const auto pending = std::any_of(m_targets.cbegin(), m_targets.cend(), [](const Target &target) {
+        return !target.resolved || target.nextAddress < target.addresses.size();
+    });
+    if (!pending) {
+        finish(m_lastError);
+    }
+}
+
+void ConnectionRacer::finish(Result &&result)
+{
+    // the promise is reset by abort(), a continuation may start a new race
+    auto promise = std::move(*m_promise);
+    abort();
+    promise.finish(std::move(result));
+}
+
+std::vector<ConnectionRacer::Attempt>::iterator ConnectionRacer::findAttempt(QTcpSocket *socket)
+{
+    return std::find_if(m_attempts.begin(), m_attempts.end(), [socket](const Attempt &attempt) {
+        return attempt.socket == socket;
+    });
+}
+
+void ConnectionRacer::log(QXmppLogger::MessageType type, const QString &message)
+{
+    Q_EMIT m_logger->logMessage(type, message);
+}
+
+}  // namespace QXmpp::Private
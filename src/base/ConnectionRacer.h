@@ -0,0 +1,120 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef CONNECTIONRACER_H
+#define CONNECTIONRACER_H
+
+#include "QXmppPromise.h"
+#include "QXmppTask.h"
+
+#include "XmppSocket.h"
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <variant>
+#include <vector>
+
+#include <QAbstractSocket>
+#include <QHostAddress>
+#include <QNetworkProxy>
+
+class QTcpSocket;
+class QTimer;
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QXmpp API.
+//
+// This header file may change from version to version without notice,
+// or even be removed.
+//
+// We mean it.
+//
+
+namespace QXmpp::Private {
+
+// Alternates between IPv6 and IPv4 addresses, starting with the family of the first address
+// (RFC 8305, section 4). The order within a family is kept.
+QXMPP_AUTOTEST_EXPORT QList<QHostAddress> interleaveAddressFamilies(const QList<QHostAddress> &addresses);
+
+//
+// Races TCP connection attempts to a list of server addresses (RFC 8305, "Happy Eyeballs").
+//
+// All host names are resolved in parallel (A and AAAA records). Attempts are started in the order
+// of the server addresses, the next one after the attempt delay or as soon as the previous attempt
+// failed. The first established connection wins and all other attempts are aborted.
+//
+// The winning connection is passed on, so the stream can take it over with
+// XmppSocket::connectToSocket() without connecting again.
+//
+class QXMPP_AUTOTEST_EXPORT ConnectionRacer
+{
+public:
+    struct Winner {
+        // index of the server address in the raced list
+        std::size_t index;
+        QHostAddress address;
+        std::chrono::milliseconds latency;
+        // the established connection, it is aborted when the last reference is dropped
+        std::shared_ptr<QTcpSocket> socket;
+    };
+    using Result = std::variant<Winner, QAbstractSocket::SocketError>;
+
+    ConnectionRacer(QXmppLoggable *logger, std::chrono::milliseconds attemptDelay = std::chrono::milliseconds(250));
+    ~ConnectionRacer();
+
+    std::chrono::milliseconds attemptDelay() const { return m_attemptDelay; }
+    void setAttemptDelay(std::chrono::milliseconds delay) { m_attemptDelay = delay; }
+    void setProxy(const QNetworkProxy &proxy) { m_proxy = proxy; }
+
+    bool isRunning() const { return m_promise.has_value(); }
+    QXmppTask<Result> race(const std::vector<ServerAddress> &addresses);
+    void abort();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Target {
+        QString host;
+        quint16 port;
+        int lookupId = -1;
+        bool resolved = false;
+        QList<QHostAddress> addresses;
+        qsizetype nextAddress = 0;
+    };
+    struct Attempt {
+        QTcpSocket *socket;
+        std::size_t target;
+        QHostAddress address;
+        Clock::time_point start;
+    };
+
+    void handleLookup(std::size_t target, const QList<QHostAddress> &addresses, const QString &error);
+    void startNextAttempt();
+    void handleConnected(QTcpSocket *socket);
+    void handleError(QTcpSocket *socket);
+    void finishIfExhausted();
+    void finish(Result &&result);
+    std::vector<Attempt>::iterator findAttempt(QTcpSocket *socket);
+    void log(QXmppLogger::MessageType type, const QString &message);
+
+    QXmppLoggable *m_logger;
+    std::chrono::milliseconds m_attemptDelay;
+    QNetworkProxy m_proxy = QNetworkProxy::DefaultProxy;
+    QTimer *m_attemptTimer;
+
+    // state of the current race
+    quint32 m_generation = 0;
+    std::optional<QXmppPromise<Result>> m_promise;
+    std::vector<Target> m_targets;
+    std::vector<Attempt> m_attempts;
+    QAbstractSocket::SocketError m_lastError = QAbstractSocket::HostNotFoundError;
+};
+
+}  // namespace QXmpp::Private
+
+#endif  // CONNECTIONRACER_H
@@ -0,0 +1,209 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "DnsCache.h"
+
+#include "QXmppFutureUtils_p.h"
+#include "QXmppPromise.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <QMutexLocker>
+#include <QRandomGenerator>
+
+using namespace std::chrono;
+
+namespace QXmpp::Private {
+
+// QDnsLookup and QXmppPromise are not thread-safe, so lookups are only merged within a thread.
+static QHash<QString, std::vector<QXmppPromise<DnsCache::SrvResult>>> &pendingSrvLookups()
+{
+    thread_local QHash<QString, std::vector<QXmppPromise<DnsCache::SrvResult>>> lookups;
+    return lookups;
+}
+
+DnsCache &DnsCache::instance()
+{
+    static DnsCache cache;
+    return cache;
+}
+
+std::chrono::seconds DnsCache::negativeTtl() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_negativeTtl;
+}
+
+void DnsCache::setNegativeTtl(std::chrono::seconds ttl)
+{
+    QMutexLocker locker(&m_mutex);
+    m_negativeTtl = ttl;
+}
+
+std::chrono::seconds DnsCache::maximumTtl() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maximumTtl;
+}
+
+void DnsCache::setMaximumTtl(std::chrono::seconds ttl)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maximumTtl = ttl;
+}
+
+//
+// Looks up the SRV records of the name, e.g. "_xmpp-client._tcp.example.org".
+//
+// The task is finished immediately if a valid result is cached.
+//
+QXmppTask<DnsCache::SrvResult> DnsCache::lookupSrv(const QString &name)
+{
+    if (auto cached = cachedSrv(name)) {
+        return makeReadyTask(ordered(std::move(*cached)));
+    }
+
+    auto &waiting = pendingSrvLookups()[name];
+    QXmppPromise<SrvResult> p;
+    auto task = p.task();
+    waiting.push_back(std::move(p));
+
+    // a lookup for this name is already running
+    if (waiting.size() > 1) {
+        return task;
+    }
+
+    auto *dns = new QDnsLookup(QDnsLookup::SRV, name);
+    QObject::connect(dns, &QDnsLookup::finished, dns, [this, dns, name] {
+        dns->deleteLater();
+
+        const auto error = dns->error();
+        if (error == QDnsLookup::NoError) {
+            const auto records = dns->serviceRecords();
+            if (records.isEmpty()) {
+                handleSrvLookup(name, records, negativeTtl());
+            } else {
+                const auto minTtl = std::min_element(records.begin(), records.end(), [](const auto &a, const auto &b) {
+                    return a.timeToLive() < b.timeToLive();
+                })->timeToLive();
+                handleSrvLookup(name, records, seconds(minTtl));
+            }
+        } else {
+            // only cache that the name does not exist, other errors may be temporary
+            const auto ttl = error == QDnsLookup::NotFoundError ? negativeTtl() : seconds(0);
+            handleSrvLookup(name, QXmppError { dns->errorString(), error }, ttl);
+        }
+    });
+    dns->lookup();
+
+    return task;
+}
+
+//
+// Orders the records for connection attempts as described in RFC 2782: ascending by priority and
+// randomly weighted within the same priority.
+//
+QList<QDnsServiceRecord> DnsCache::orderedSrvRecords(QList<QDnsServiceRecord> records)
+{
+    std::stable_sort(records.begin(), records.end(), [](const auto &a, const auto &b) {
+        return a.priority() < b.priority();
+    });
+
+    auto *random = QRandomGenerator::global();
+    for (auto groupBegin = records.begin(); groupBegin != records.end();) {
+        const auto groupEnd = std::find_if(groupBegin, records.end(), [&](const auto &record) {
+            return record.priority() != groupBegin->priority();
+        });
+
+        // records with weight 0 have a very small chance to be selected first
+        std::stable_partition(groupBegin, groupEnd, [](const auto &record) { return record.weight() == 0; });
+
+        // select the records one after the other, a record's chance is proportional to its weight
+        for (auto next = groupBegin; next != groupEnd; ++next) {
+            quint32 totalWeight = 0;
+            for (auto itr = next; itr != groupEnd; ++itr) {
+                totalWeight += itr->weight();
+            }
+
+            const auto selection = random->bounded(totalWeight + 1);
+            quint32 runningSum = 0;
+            auto selected = next;
+            for (; selected != groupEnd; ++selected) {
+                runningSum += selected->weight();
+                if (runningSum >= selection) {
+                    break;
+                }
+            }
+            // keeps the order of the remaining records, so those with weight 0 stay in front
+            std::rotate(next, selected, std::next(selected));
+        }
+        groupBegin = groupEnd;
+    }
+    return records;
+}
+
+//
+// Returns the cached result for the name if it has not expired yet. The records are in the order
+// in which they were received.
+//
+std::optional<DnsCache::SrvResult> DnsCache::cachedSrv(const QString &name, Clock::time_point now) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (auto itr = m_srvEntries.constFind(name); itr != m_srvEntries.constEnd() && itr->expiry > now) {
+        return itr->result;
+    }
+    return {};
+}
+
+//
+// Caches the result for the TTL (limited by the maximum TTL). A TTL of 0 removes the entry.
+//
+void DnsCache::insertSrv(const QString &name, const SrvResult &result, std::chrono::seconds ttl, Clock::time_point now)
+{
+    QMutexLocker locker(&m_mutex);
+
+    // drop expired entries, so the cache does not grow with every name ever looked up
+    for (auto itr = m_srvEntries.begin(); itr != m_srvEntries.end();) {
+        if (itr->expiry <= now) {
+            itr = m_srvEntries.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+
+    ttl = std::min(ttl, m_maximumTtl);
+    if (ttl.count() > 0) {
+        m_srvEntries.insert(name, Entry { result, now + ttl });
+    } else {
+        m_srvEntries.remove(name);
+    }
+}
+
+void DnsCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_srvEntries.clear();
+}
+
+void DnsCache::handleSrvLookup(const QString &name, SrvResult &&result, std::chrono::seconds ttl)
+{
+    insertSrv(name, result, ttl);
+
+    // every caller gets its own order
+    const auto promises = pendingSrvLookups().take(name);
+    for (auto promise : promises) {
+        promise.finish(ordered(result));
+    }
+}
+
+DnsCache::SrvResult DnsCache::ordered(SrvResult result)
+{
+    if (auto *records = std::get_if<QList<QDnsServiceRecord>>(&result)) {
+        *records = orderedSrvRecords(std::move(*records));
+    }
+    return result;
+}
+
+}  // namespace QXmpp::Private
@@ -0,0 +1,85 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef DNSCACHE_H
+#define DNSCACHE_H
+
+#include "QXmppError.h"
+#include "QXmppTask.h"
+
+#include <chrono>
+#include <optional>
+#include <variant>
+
+#include <QDnsLookup>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QXmpp API.
+//
+// This header file may change from version to version without notice,
+// or even be removed.
+//
+// We mean it.
+//
+
+namespace QXmpp::Private {
+
+//
+// Process-wide cache for DNS SRV lookups.
+//
+// Results are kept for the smallest TTL of the returned records (limited by the maximum TTL).
+// Non-existent names and empty answers are cached for the negative TTL, QDnsLookup does not
+// expose the SOA record that would specify it (RFC 2308). Other errors (e.g. timeouts) are not
+// cached.
+//
+// Concurrent lookups for the same name are only sent once per thread, all callers get the same
+// result.
+//
+// The records are cached as received. Every lookup orders them again by priority and weight
+// (RFC 2782), so the load is still spread over servers with the same priority.
+//
+class QXMPP_AUTOTEST_EXPORT DnsCache
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using SrvResult = std::variant<QList<QDnsServiceRecord>, QXmppError>;
+
+    static DnsCache &instance();
+
+    std::chrono::seconds negativeTtl() const;
+    void setNegativeTtl(std::chrono::seconds ttl);
+    std::chrono::seconds maximumTtl() const;
+    void setMaximumTtl(std::chrono::seconds ttl);
+
+    QXmppTask<SrvResult> lookupSrv(const QString &name);
+    static QList<QDnsServiceRecord> orderedSrvRecords(QList<QDnsServiceRecord> records);
+
+    std::optional<SrvResult> cachedSrv(const QString &name, Clock::time_point now = Clock::now()) const;
+    void insertSrv(const QString &name, const SrvResult &result, std::chrono::seconds ttl, Clock::time_point now = Clock::now());
+    void clear();
+
+private:
+    struct Entry {
+        SrvResult result;
+        Clock::time_point expiry;
+    };
+
+    static SrvResult ordered(SrvResult result);
+    void handleSrvLookup(const QString &name, SrvResult &&result, std::chrono::seconds ttl);
+
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_srvEntries;
+    std::chrono::seconds m_negativeTtl = std::chrono::seconds(60);
+    std::chrono::seconds m_maximumTtl = std::chrono::hours(1);
+};
+
+}  // namespace QXmpp::Private
+
+#endif  // DNSCACHE_H
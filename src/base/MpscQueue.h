@@ -0,0 +1,121 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <atomic>
+#include <optional>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QXmpp API.
+//
+// This header file may change from version to version without notice,
+// or even be removed.
+//
+// We mean it.
+//
+
+namespace QXmpp::Private {
+
+//
+// Unbounded lock-free multi-producer single-consumer queue (Dmitry Vyukov's intrusive MPSC node
+// queue).
+//
+// push() can be called from any thread, pop() must only be called from one thread at a time.
+// Pushing is wait-free, one node is allocated per element.
+//
+// pop() may return nothing while a push is still in progress in another thread, the element is
+// returned by a later call. Consumers that are woken up by the producers therefore need to be
+// woken up after the push has completed.
+//
+template<typename T>
+class MpscQueue
+{
+public:
+    MpscQueue()
+        : m_head(&m_stub),
+          m_tail(&m_stub)
+    {
+    }
+    ~MpscQueue()
+    {
+        while (pop()) {
+        }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    void push(T &&value)
+    {
+        pushNode(new Node { {}, std::move(value) });
+    }
+
+    std::optional<T> pop()
+    {
+        auto *tail = m_tail;
+        auto *next = tail->next.load(std::memory_order_acquire);
+
+        if (tail == &m_stub) {
+            if (!next) {
+                return {};
+            }
+            m_tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            m_tail = next;
+            return take(tail);
+        }
+
+        // a producer has exchanged the head, but not linked its node yet
+        if (tail != m_head.load(std::memory_order_acquire)) {
+            return {};
+        }
+
+        // tail is the last node, the stub is needed to take it out
+        pushNode(&m_stub);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            m_tail = next;
+            return take(tail);
+        }
+        return {};
+    }
+
+private:
+    struct Node {
+        std::atomic<Node *> next = nullptr;
+        std::optional<T> value;
+    };
+
+    void pushNode(Node *node)
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        auto *previous = m_head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    static std::optional<T> take(Node *node)
+    {
+        auto value = std::move(node->value);
+        delete node;
+        return value;
+    }
+
+    // written by the producers
+    alignas(64) std::atomic<Node *> m_head;
+    // only accessed by the consumer
+    alignas(64) Node *m_tail;
+    Node m_stub;
+};
+
+}  // namespace QXmpp::Private
+
+#endif  // MPSCQUEUE_H
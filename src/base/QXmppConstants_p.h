@@ -28,6 +28,7 @@ constexpr quint16 XMPP_SERVER_DEFAULT_PORT = 5269;
 // QXmpp
 inline constexpr QStringView ns_qxmpp_credentials = u"org.qxmpp.credentials";
 inline constexpr QStringView ns_qxmpp_export = u"org.qxmpp.export";
+inline constexpr QStringView ns_qxmpp_stream_resumption = u"org.qxmpp.stream-resumption";
 // XMPP
 inline constexpr QStringView ns_stream = u"http://etherx.jabber.org/streams";
 inline constexpr QStringView ns_client = u"jabber:client";
@@ -163,6 +163,25 @@ enum Cipher {
     Aes256CbcPkcs7,
 };
 
+///
+/// Priority of outgoing stanzas.
+///
+/// Stanzas are only held back if a write buffer limit is configured using
+/// QXmppConfiguration::setWriteBufferHighWaterMark(). While the limit is exceeded, stanzas are
+/// queued and written in order of their priority as soon as the socket has written its buffered
+/// data. The order of stanzas with the same priority is always kept.
+///
+/// \since QXmpp 1.11
+///
+enum class SendPriority : uint8_t {
+    /// Stream control traffic (e.g. pings), never held back.
+    Control,
+    /// Default priority, e.g. for chat messages and IQ requests.
+    Interactive,
+    /// Traffic that can be delayed, e.g. synchronization of archives or bulk publishing.
+    Bulk,
+};
+
 ///
 /// An empty struct indicating success in results.
 ///
@@ -5,14 +5,25 @@
 
 #include "QXmppLogger.h"
 
+#include "QXmppMetrics.h"
+
 #include "StringLiterals.h"
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include <QChildEvent>
 #include <QDateTime>
 #include <QFile>
+#include <QMetaMethod>
 #include <QMetaType>
+#include <QPointer>
 #include <QTextStream>
 
 QXmppLogger *QXmppLogger::m_logger = nullptr;
@@ -35,19 +46,297 @@ static QStringView typeName(QXmppLogger::MessageType type)
     }
 }
 
+static QString formatted(const QDateTime &time, QXmppLogger::MessageType type, const QString &text)
+{
+    return time.toString() + u' ' + typeName(type) + u' ' + text;
+}
+
 static QString formatted(QXmppLogger::MessageType type, const QString &text)
 {
-    return QDateTime::currentDateTime().toString() + u' ' + typeName(type) + u' ' + text;
+    return formatted(QDateTime::currentDateTime(), type, text);
+}
+
+// Renames 'path' to 'path.1', 'path.1' to 'path.2' and so on, keeping at most 'count' old files.
+static void rotateLogFiles(const QString &path, int count)
+{
+    const auto numbered = [&](int i) { return QString(path + u'.' + QString::number(i)); };
+
+    QFile::remove(numbered(count));
+    for (int i = count - 1; i > 0; i--) {
+        QFile::rename(numbered(i), numbered(i + 1));
+    }
+    if (count > 0) {
+        QFile::rename(path, numbered(1));
+    } else {
+        QFile::remove(path);
+    }
 }
 
+namespace {
+
+// reported in the enabled-mask next to the message types
+constexpr quint32 MetricsEnabledFlag = 1u << 31;
+
+// State of a loggable, kept outside of the class so its size stays the same.
+struct LoggableState {
+    // read without locking: the loggable and the mask of everything consuming its signals
+    std::atomic<const QXmppLoggable *> loggable = nullptr;
+    std::atomic<LoggableState *> next = nullptr;
+    std::atomic<quint32> enabledMask = 0;
+
+    // the rest is guarded by LoggableStates::mutex
+    QPointer<QXmppLogger> logger;
+    // connections to logMessage() and to updateCounter() or updateHistogram()
+    int logReceivers = 0;
+    int metricReceivers = 0;
+    // the part of them made by relaySignals() and connectLogger()
+    int internalLogReceivers = 0;
+    int internalMetricReceivers = 0;
+    // the parent loggable the signals are relayed to and the children relaying to this one
+    LoggableState *relayTarget = nullptr;
+    std::vector<LoggableState *> relaySources;
+
+    quint32 ownMask() const
+    {
+        quint32 mask = 0;
+        if (logReceivers > internalLogReceivers) {
+            mask |= QXmppLogger::AnyMessage;
+        }
+        if (metricReceivers > internalMetricReceivers) {
+            mask |= MetricsEnabledFlag;
+        }
+        if (const auto *logger = this->logger.data()) {
+            for (auto type : { QXmppLogger::DebugMessage, QXmppLogger::InformationMessage, QXmppLogger::WarningMessage,
+                               QXmppLogger::ReceivedMessage, QXmppLogger::SentMessage }) {
+                if (logger->isEnabled(type)) {
+                    mask |= type;
+                }
+            }
+            if (logger->metricsEnabled()) {
+                mask |= MetricsEnabledFlag;
+            }
+        }
+        return mask;
+    }
+
+    // Recalculates the mask of this loggable and of the children relaying to it.
+    void updateMask()
+    {
+        const auto mask = ownMask() | (relayTarget ? relayTarget->enabledMask.load(std::memory_order_relaxed) : 0);
+        if (enabledMask.exchange(mask, std::memory_order_relaxed) != mask) {
+            for (auto *source : relaySources) {
+                source->updateMask();
+            }
+        }
+    }
+};
+
+//
+// Hash table of the loggable states that can be searched without locking.
+//
+// The states are never freed, only reused for other loggables. A reader that is moved to another
+// bucket by a concurrent removal may miss a state, it then searches again with the mutex locked.
+//
+class LoggableStates
+{
+public:
+    std::mutex mutex;
+
+    quint32 enabledMask(const QXmppLoggable *loggable)
+    {
+        if (const auto *state = find(loggable)) {
+            return state->enabledMask.load(std::memory_order_relaxed);
+        }
+
+        std::lock_guard lock(mutex);
+        const auto *state = find(loggable);
+        return state ? state->enabledMask.load(std::memory_order_relaxed) : 0;
+    }
+
+    void insert(const QXmppLoggable *loggable)
+    {
+        std::lock_guard lock(mutex);
+
+        LoggableState *state;
+        if (freeStates.empty()) {
+            state = new LoggableState();
+        } else {
+            state = freeStates.back();
+            freeStates.pop_back();
+        }
+
+        auto &head = bucket(loggable);
+        state->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        state->loggable.store(loggable, std::memory_order_release);
+        head.store(state, std::memory_order_release);
+    }
+
+    void erase(const QXmppLoggable *loggable)
+    {
+        std::lock_guard lock(mutex);
+
+        auto *link = &bucket(loggable);
+        auto *state = link->load(std::memory_order_relaxed);
+        while (state && state->loggable.load(std::memory_order_relaxed) != loggable) {
+            link = &state->next;
+            state = link->load(std::memory_order_relaxed);
+        }
+        if (!state) {
+            return;
+        }
+
+        // keep 'next' so readers currently on this state can go on
+        link->store(state->next.load(std::memory_order_relaxed), std::memory_order_release);
+        state->loggable.store(nullptr, std::memory_order_relaxed);
+
+        if (auto *target = state->relayTarget) {
+            std::erase(target->relaySources, state);
+        }
+        for (auto *source : state->relaySources) {
+            source->relayTarget = nullptr;
+            source->updateMask();
+        }
+
+        state->enabledMask.store(0, std::memory_order_relaxed);
+        state->logger = nullptr;
+        state->logReceivers = 0;
+        state->metricReceivers = 0;
+        state->internalLogReceivers = 0;
+        state->internalMetricReceivers = 0;
+        state->relayTarget = nullptr;
+        state->relaySources.clear();
+        freeStates.push_back(state);
+    }
+
+    template<typename Function>
+    void update(const QXmppLoggable *loggable, Function function)
+    {
+        std::lock_guard lock(mutex);
+        if (auto *state = find(loggable)) {
+            function(*state);
+            state->updateMask();
+        }
+    }
+
+    void setRelayTarget(const QXmppLoggable *from, const QXmppLoggable *to)
+    {
+        std::lock_guard lock(mutex);
+        auto *state = find(from);
+        if (!state) {
+            return;
+        }
+
+        if (auto *oldTarget = std::exchange(state->relayTarget, find(to))) {
+            std::erase(oldTarget->relaySources, state);
+        }
+        if (state->relayTarget) {
+            state->relayTarget->relaySources.push_back(state);
+        }
+        state->updateMask();
+    }
+
+    // Updates the loggables connected to the logger after its settings have changed.
+    void updateLogger(const QXmppLogger *logger, bool destroyed = false)
+    {
+        std::lock_guard lock(mutex);
+        for (auto &head : buckets) {
+            for (auto *state = head.load(std::memory_order_relaxed); state; state = state->next.load(std::memory_order_relaxed)) {
+                if (state->logger == logger) {
+                    if (destroyed) {
+                        // the connections are removed by ~QObject() and reported to disconnectNotify()
+                        state->logger = nullptr;
+                        state->internalLogReceivers--;
+                        state->internalMetricReceivers -= 2;
+                    }
+                    state->updateMask();
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr std::size_t BucketCount = 1024;
+
+    std::atomic<LoggableState *> &bucket(const QXmppLoggable *loggable)
+    {
+        // the lowest bits are the same for most heap objects
+        return buckets[(quintptr(loggable) >> 4) % BucketCount];
+    }
+
+    LoggableState *find(const QXmppLoggable *loggable)
+    {
+        for (auto *state = bucket(loggable).load(std::memory_order_acquire); state; state = state->next.load(std::memory_order_acquire)) {
+            if (state->loggable.load(std::memory_order_acquire) == loggable) {
+                return state;
+            }
+        }
+        return nullptr;
+    }
+
+    std::array<std::atomic<LoggableState *>, BucketCount> buckets {};
+    std::vector<LoggableState *> freeStates;
+};
+
+// intentionally leaked, loggables may be destroyed after static objects
+LoggableStates &loggableStates()
+{
+    static auto *states = new LoggableStates();
+    return *states;
+}
+
+const QMetaMethod &logMessageSignal()
+{
+    static const auto signal = QMetaMethod::fromSignal(&QXmppLoggable::logMessage);
+    return signal;
+}
+
+const QMetaMethod &updateCounterSignal()
+{
+    static const auto signal = QMetaMethod::fromSignal(&QXmppLoggable::updateCounter);
+    return signal;
+}
+
+const QMetaMethod &updateHistogramSignal()
+{
+    static const auto signal = QMetaMethod::fromSignal(&QXmppLoggable::updateHistogram);
+    return signal;
+}
+
+}  // namespace
+
 static void relaySignals(QXmppLoggable *from, QXmppLoggable *to)
 {
-    QObject::connect(from, &QXmppLoggable::logMessage,
-                     to, &QXmppLoggable::logMessage);
+    // the relay does not consume messages itself, see QXmppLoggable::isLoggingEnabled()
+    if (QObject::connect(from, &QXmppLoggable::logMessage,
+                         to, &QXmppLoggable::logMessage)) {
+        loggableStates().update(from, [](auto &state) { state.internalLogReceivers++; });
+    }
     QObject::connect(from, &QXmppLoggable::setGauge,
                      to, &QXmppLoggable::setGauge);
-    QObject::connect(from, &QXmppLoggable::updateCounter,
-                     to, &QXmppLoggable::updateCounter);
+    const int metricConnections =
+        bool(QObject::connect(from, &QXmppLoggable::updateCounter,
+                              to, &QXmppLoggable::updateCounter)) +
+        bool(QObject::connect(from, &QXmppLoggable::updateHistogram,
+                              to, &QXmppLoggable::updateHistogram));
+    loggableStates().update(from, [=](auto &state) { state.internalMetricReceivers += metricConnections; });
+    loggableStates().setRelayTarget(from, to);
+}
+
+static void unrelaySignals(QXmppLoggable *from, QXmppLoggable *to)
+{
+    if (QObject::disconnect(from, &QXmppLoggable::logMessage,
+                            to, &QXmppLoggable::logMessage)) {
+        loggableStates().update(from, [](auto &state) { state.internalLogReceivers--; });
+    }
+    QObject::disconnect(from, &QXmppLoggable::setGauge,
+                        to, &QXmppLoggable::setGauge);
+    const int metricConnections =
+        int(QObject::disconnect(from, &QXmppLoggable::updateCounter,
+                                to, &QXmppLoggable::updateCounter)) +
+        int(QObject::disconnect(from, &QXmppLoggable::updateHistogram,
+                                to, &QXmppLoggable::updateHistogram));
+    loggableStates().update(from, [=](auto &state) { state.internalMetricReceivers -= metricConnections; });
+    loggableStates().setRelayTarget(from, nullptr);
 }
 
 /// Constructs a new QXmppLoggable.
@@ -57,6 +346,11 @@ static void relaySignals(QXmppLoggable *from, QXmppLoggable *to)
 QXmppLoggable::QXmppLoggable(QObject *parent)
     : QObject(parent)
 {
+    loggableStates().insert(this);
+    connect(this, &QObject::destroyed, [this]() {
+        loggableStates().erase(this);
+    });
+
     auto *logParent = qobject_cast<QXmppLoggable *>(parent);
     if (logParent) {
         relaySignals(this, logParent);
@@ -74,32 +368,337 @@ void QXmppLoggable::childEvent(QChildEvent *event)
     if (event->added()) {
         relaySignals(child, this);
     } else if (event->removed()) {
-        disconnect(child, &QXmppLoggable::logMessage,
-                   this, &QXmppLoggable::logMessage);
-        disconnect(child, &QXmppLoggable::setGauge,
-                   this, &QXmppLoggable::setGauge);
-        disconnect(child, &QXmppLoggable::updateCounter,
-                   this, &QXmppLoggable::updateCounter);
+        unrelaySignals(child, this);
+    }
+}
+
+void QXmppLoggable::connectNotify(const QMetaMethod &signal)
+{
+    if (signal == logMessageSignal()) {
+        loggableStates().update(this, [](auto &state) { state.logReceivers++; });
+    } else if (signal == updateCounterSignal() || signal == updateHistogramSignal()) {
+        loggableStates().update(this, [](auto &state) { state.metricReceivers++; });
+    }
+}
+
+void QXmppLoggable::disconnectNotify(const QMetaMethod &signal)
+{
+    if (signal == logMessageSignal()) {
+        loggableStates().update(this, [](auto &state) { state.logReceivers--; });
+    } else if (signal == updateCounterSignal() || signal == updateHistogramSignal()) {
+        loggableStates().update(this, [](auto &state) { state.metricReceivers--; });
+    } else if (!signal.isValid()) {
+        // all signals have been disconnected at once
+        const bool logConnected = isSignalConnected(logMessageSignal());
+        const bool metricsConnected = isSignalConnected(updateCounterSignal()) || isSignalConnected(updateHistogramSignal());
+        loggableStates().update(this, [=](auto &state) {
+            if (!logConnected) {
+                state.logReceivers = 0;
+                state.internalLogReceivers = 0;
+            }
+            if (!metricsConnected) {
+                state.metricReceivers = 0;
+                state.internalMetricReceivers = 0;
+            }
+            if (!logConnected && !metricsConnected) {
+                state.logger = nullptr;
+            }
+        });
+    }
+}
+
+//
+// Connects the signals of this loggable to the logger and disconnects the previously connected
+// logger. Unlike other receivers of logMessage(), the logger can tell which message types it
+// handles.
+//
+void QXmppLoggable::connectLogger(QXmppLogger *logger)
+{
+    QPointer<QXmppLogger> oldLogger;
+    loggableStates().update(this, [&](auto &state) { oldLogger = std::exchange(state.logger, logger); });
+
+    if (oldLogger) {
+        if (disconnect(this, &QXmppLoggable::logMessage,
+                       oldLogger, &QXmppLogger::log)) {
+            loggableStates().update(this, [](auto &state) { state.internalLogReceivers--; });
+        }
+        disconnect(this, &QXmppLoggable::setGauge,
+                   oldLogger, &QXmppLogger::setGauge);
+        const int metricConnections =
+            int(disconnect(this, &QXmppLoggable::updateCounter,
+                           oldLogger, &QXmppLogger::updateCounter)) +
+            int(disconnect(this, &QXmppLoggable::updateHistogram,
+                           oldLogger, &QXmppLogger::updateHistogram));
+        loggableStates().update(this, [=](auto &state) { state.internalMetricReceivers -= metricConnections; });
+    }
+
+    if (logger) {
+        if (connect(this, &QXmppLoggable::logMessage,
+                    logger, &QXmppLogger::log)) {
+            loggableStates().update(this, [](auto &state) { state.internalLogReceivers++; });
+        }
+        connect(this, &QXmppLoggable::setGauge,
+                logger, &QXmppLogger::setGauge);
+        const int metricConnections =
+            bool(connect(this, &QXmppLoggable::updateCounter,
+                         logger, &QXmppLogger::updateCounter)) +
+            bool(connect(this, &QXmppLoggable::updateHistogram,
+                         logger, &QXmppLogger::updateHistogram));
+        loggableStates().update(this, [=](auto &state) { state.internalMetricReceivers += metricConnections; });
     }
 }
 /// \endcond
 
+///
+/// Returns whether log messages of the given type are currently consumed by anyone.
+///
+/// This is the case if a QXmppLogger that handles the type or any other receiver is connected to
+/// logMessage() of this loggable or one of its parents. The check is cheap, so it can be used to
+/// avoid formatting messages that would be discarded anyway.
+///
+/// debug(), info(), warning(), logReceived() and logSent() only emit logMessage() if this returns
+/// true.
+///
+/// \since QXmpp 1.11
+///
+bool QXmppLoggable::isLoggingEnabled(QXmppLogger::MessageType type) const
+{
+    // kept up to date by connectNotify(), disconnectNotify(), connectLogger(), the relays to the
+    // parents and the logger settings
+    return loggableStates().enabledMask(this) & type;
+}
+
+///
+/// Returns whether metrics reported by this loggable are currently recorded by anyone.
+///
+/// This is the case if a QXmppLogger with metricsEnabled() or any other receiver is connected to
+/// updateCounter() or updateHistogram() of this loggable or one of its parents. Metrics that are
+/// updated very often, e.g. for every packet, should only be reported if this returns true.
+///
+/// \since QXmpp 1.11
+///
+bool QXmppLoggable::isMetricsEnabled() const
+{
+    return loggableStates().enabledMask(this) & MetricsEnabledFlag;
+}
+
+namespace QXmpp::Private {
+
+// The writer thread wakes up once this many messages are queued or after the flush interval.
+constexpr std::size_t LOG_BATCH_SIZE = 256;
+constexpr std::chrono::milliseconds LOG_FLUSH_INTERVAL(1000);
+// Messages are dropped if more are queued.
+constexpr std::size_t MAXIMUM_QUEUED_LOG_MESSAGES = 16 * 1024;
+
+//
+// Writes log messages to a file on a background thread.
+//
+// Messages are queued and written in batches with one write() call, so the logging thread never
+// waits for the disk. If the queue is full, messages are dropped and counted; the number of
+// dropped messages is also written to the file.
+//
+class LogFileWriter
+{
+public:
+    struct Entry {
+        QDateTime time;
+        QXmppLogger::MessageType type;
+        QString text;
+    };
+    struct FileOptions {
+        QString path;
+        qint64 maximumSize;
+        int maximumCount;
+    };
+
+    explicit LogFileWriter(const FileOptions &options);
+    ~LogFileWriter();
+
+    void write(Entry &&entry);
+    void flush();
+    void reopen(const FileOptions &options);
+    quint64 droppedMessages() const { return m_droppedMessages; }
+
+private:
+    void run();
+    void writeBatch(const std::vector<Entry> &entries, const FileOptions &options);
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::condition_variable m_flushed;
+    std::vector<Entry> m_queue;
+    FileOptions m_options;
+    bool m_reopen = false;
+    bool m_stop = false;
+    quint64 m_flushRequests = 0;
+    quint64 m_finishedFlushRequests = 0;
+    std::atomic<quint64> m_droppedMessages = 0;
+
+    // only used by the writer thread
+    std::unique_ptr<QFile> m_file;
+    quint64 m_reportedDroppedMessages = 0;
+
+    std::thread m_thread;
+};
+
+LogFileWriter::LogFileWriter(const FileOptions &options)
+    : m_options(options),
+      m_thread(&LogFileWriter::run, this)
+{
+}
+
+LogFileWriter::~LogFileWriter()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wakeUp.notify_one();
+    m_thread.join();
+}
+
+void LogFileWriter::write(Entry &&entry)
+{
+    std::lock_guard lock(m_mutex);
+    if (m_queue.size() >= MAXIMUM_QUEUED_LOG_MESSAGES) {
+        m_droppedMessages++;
+        return;
+    }
+
+    m_queue.push_back(std::move(entry));
+    if (m_queue.size() == LOG_BATCH_SIZE) {
+        m_wakeUp.notify_one();
+    }
+}
+
+// Blocks until all queued messages have been written.
+void LogFileWriter::flush()
+{
+    std::unique_lock lock(m_mutex);
+    const auto request = ++m_flushRequests;
+    m_wakeUp.notify_one();
+    m_flushed.wait(lock, [&] { return m_finishedFlushRequests >= request; });
+}
+
+void LogFileWriter::reopen(const FileOptions &options)
+{
+    std::lock_guard lock(m_mutex);
+    m_options = options;
+    m_reopen = true;
+}
+
+void LogFileWriter::run()
+{
+    std::vector<Entry> entries;
+
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        m_wakeUp.wait_for(lock, LOG_FLUSH_INTERVAL, [this] {
+            return m_stop || m_flushRequests > m_finishedFlushRequests || m_queue.size() >= LOG_BATCH_SIZE;
+        });
+
+        std::swap(entries, m_queue);
+        const auto options = m_options;
+        const auto reopen = std::exchange(m_reopen, false);
+        const auto stop = m_stop;
+        const auto flushRequests = m_flushRequests;
+        lock.unlock();
+
+        if (reopen) {
+            m_file.reset();
+        }
+        writeBatch(entries, options);
+        entries.clear();
+
+        lock.lock();
+        m_finishedFlushRequests = flushRequests;
+        m_flushed.notify_all();
+
+        if (stop) {
+            m_file.reset();
+            return;
+        }
+    }
+}
+
+void LogFileWriter::writeBatch(const std::vector<Entry> &entries, const FileOptions &options)
+{
+    QByteArray data;
+    for (const auto &entry : entries) {
+        data += formatted(entry.time, entry.type, entry.text).toUtf8();
+        data += '\n';
+    }
+
+    const quint64 dropped = m_droppedMessages;
+    if (dropped != m_reportedDroppedMessages) {
+        const auto text = u"Dropped %1 log messages, the queue was full."_s.arg(dropped - m_reportedDroppedMessages);
+        data += formatted(QXmppLogger::WarningMessage, text).toUtf8();
+        data += '\n';
+        m_reportedDroppedMessages = dropped;
+    }
+
+    if (data.isEmpty()) {
+        return;
+    }
+
+    const auto openFile = [&] {
+        m_file = std::make_unique<QFile>(options.path);
+        m_file->open(QIODevice::WriteOnly | QIODevice::Append);
+    };
+
+    if (!m_file) {
+        openFile();
+    }
+    if (options.maximumSize > 0 && m_file->size() > 0 && m_file->size() + data.size() > options.maximumSize) {
+        m_file.reset();
+        rotateLogFiles(options.path, options.maximumCount);
+        openFile();
+    }
+
+    m_file->write(data);
+    m_file->flush();
+}
+
+}  // namespace QXmpp::Private
+
+using namespace QXmpp::Private;
+
 class QXmppLoggerPrivate
 {
 public:
     QXmppLoggerPrivate();
 
+    LogFileWriter::FileOptions fileOptions() const { return { logFilePath, maximumLogFileSize, maximumLogFileCount }; }
+
     QXmppLogger::LoggingType loggingType;
     QFile *logFile;
     QString logFilePath;
+    qint64 maximumLogFileSize = 0;
+    int maximumLogFileCount = 1;
+    // only exists with asynchronous file logging
+    std::unique_ptr<LogFileWriter> fileWriter;
+    bool asynchronousFileLogging = false;
+    QXmppMetrics ownMetrics;
+    // the registry of a QXmppClientPool or ownMetrics
+    QXmppMetrics *metrics = &ownMetrics;
+    // may be read from other threads
+    std::atomic<bool> metricsEnabled = false;
     QXmppLogger::MessageTypes messageTypes;
+    // message types that are actually handled, may be read from other threads
+    std::atomic<int> enabledTypes;
+
+    void updateEnabledTypes()
+    {
+        enabledTypes = loggingType == QXmppLogger::NoLogging ? 0 : int(messageTypes);
+    }
 };
 
 QXmppLoggerPrivate::QXmppLoggerPrivate()
     : loggingType(QXmppLogger::NoLogging),
       logFile(nullptr),
       logFilePath(u"QXmppClientLog.log"_s),
-      messageTypes(QXmppLogger::AnyMessage)
+      messageTypes(QXmppLogger::AnyMessage),
+      enabledTypes(0)
 {
 }
 
@@ -116,16 +715,23 @@ QXmppLogger::QXmppLogger(QObject *parent)
     qRegisterMetaType<QXmppLogger::MessageType>("QXmppLogger::MessageType");
 }
 
-QXmppLogger::~QXmppLogger() = default;
+QXmppLogger::~QXmppLogger()
+{
+    loggableStates().updateLogger(this, true);
+}
 
 ///
 /// Returns the default logger.
 ///
+/// The logger is created on the first call and lives in the thread of that call. This function
+/// is thread-safe.
+///
 QXmppLogger *QXmppLogger::getLogger()
 {
-    if (!m_logger) {
+    static std::once_flag created;
+    std::call_once(created, [] {
         m_logger = new QXmppLogger();
-    }
+    });
 
     return m_logger;
 }
@@ -140,6 +746,8 @@ void QXmppLogger::setLoggingType(QXmppLogger::LoggingType type)
 {
     if (d->loggingType != type) {
         d->loggingType = type;
+        d->updateEnabledTypes();
+        loggableStates().updateLogger(this);
         reopen();
         Q_EMIT loggingTypeChanged();
     }
@@ -163,10 +771,25 @@ void QXmppLogger::setMessageTypes(QXmppLogger::MessageTypes types)
 {
     if (d->messageTypes != types) {
         d->messageTypes = types;
+        d->updateEnabledTypes();
+        loggableStates().updateLogger(this);
         Q_EMIT messageTypesChanged();
     }
 }
 
+///
+/// Returns whether messages of the given type are handled.
+///
+/// This is the case if the logging type is not NoLogging and the type is included in
+/// messageTypes(). This function is thread-safe.
+///
+/// \since QXmpp 1.11
+///
+bool QXmppLogger::isEnabled(QXmppLogger::MessageType type) const
+{
+    return d->enabledTypes.load(std::memory_order_relaxed) & type;
+}
+
 ///
 /// \fn QXmppLogger::messageTypesChanged()
 ///
@@ -185,11 +808,24 @@ void QXmppLogger::log(QXmppLogger::MessageType type, const QString &text)
 
     switch (d->loggingType) {
     case QXmppLogger::FileLogging:
+        if (d->asynchronousFileLogging) {
+            if (!d->fileWriter) {
+                d->fileWriter = std::make_unique<LogFileWriter>(d->fileOptions());
+            }
+            d->fileWriter->write({ QDateTime::currentDateTime(), type, text });
+            break;
+        }
+
         if (!d->logFile) {
             d->logFile = new QFile(d->logFilePath);
             d->logFile->open(QIODevice::WriteOnly | QIODevice::Append);
         }
         QTextStream(d->logFile) << formatted(type, text) << "\n";
+
+        if (d->maximumLogFileSize > 0 && d->logFile->size() > d->maximumLogFileSize) {
+            reopen();
+            rotateLogFiles(d->logFilePath, d->maximumLogFileCount);
+        }
         break;
     case QXmppLogger::StdoutLogging:
         std::cout << qPrintable(formatted(type, text)) << std::endl;
@@ -205,23 +841,84 @@ void QXmppLogger::log(QXmppLogger::MessageType type, const QString &text)
 ///
 /// Sets the given \a gauge to \a value.
 ///
-/// NOTE: the base implementation does nothing.
+/// The base implementation records the value in metrics() if metricsEnabled() is true.
 ///
 void QXmppLogger::setGauge(const QString &gauge, double value)
 {
-    Q_UNUSED(gauge)
-    Q_UNUSED(value)
+    if (d->metricsEnabled.load(std::memory_order_relaxed)) {
+        d->metrics->setGauge(gauge, value);
+    }
 }
 
 ///
 /// Updates the given \a counter by \a amount.
 ///
-/// NOTE: the base implementation does nothing.
+/// The base implementation records the value in metrics() if metricsEnabled() is true.
 ///
 void QXmppLogger::updateCounter(const QString &counter, qint64 amount)
 {
-    Q_UNUSED(counter)
-    Q_UNUSED(amount)
+    if (d->metricsEnabled.load(std::memory_order_relaxed)) {
+        d->metrics->updateCounter(counter, amount);
+    }
+}
+
+///
+/// Records \a value in the given \a histogram. Durations are reported in seconds.
+///
+/// The value is recorded in metrics() if metricsEnabled() is true.
+///
+/// \since QXmpp 1.11
+///
+void QXmppLogger::updateHistogram(const QString &histogram, double value)
+{
+    if (d->metricsEnabled.load(std::memory_order_relaxed)) {
+        d->metrics->updateHistogram(histogram, value);
+    }
+}
+
+///
+/// Returns whether the metrics reported by the connected loggables are recorded.
+///
+/// \since QXmpp 1.11
+///
+bool QXmppLogger::metricsEnabled() const
+{
+    return d->metricsEnabled.load(std::memory_order_relaxed);
+}
+
+///
+/// Sets whether the metrics reported by the connected loggables are recorded in metrics().
+///
+/// Loggables skip metrics that are updated for every packet if nobody records them, so this also
+/// needs to be enabled by subclasses that reimplement setGauge() or updateCounter() to receive
+/// all metrics. This function is thread-safe. The default value is false.
+///
+/// \since QXmpp 1.11
+///
+void QXmppLogger::setMetricsEnabled(bool enabled)
+{
+    d->metricsEnabled.store(enabled, std::memory_order_relaxed);
+    loggableStates().updateLogger(this);
+}
+
+///
+/// Returns the metrics reported by the loggables connected to this logger.
+///
+/// Use QXmppMetrics::toPrometheusText() to export them.
+///
+/// \since QXmpp 1.11
+///
+QXmppMetrics *QXmppLogger::metrics() const
+{
+    return d->metrics;
+}
+
+//
+// Records the metrics in the given registry instead of the own one.
+//
+void QXmppLogger::setMetricsRegistry(QXmppMetrics *metrics)
+{
+    d->metrics = metrics ? metrics : &d->ownMetrics;
 }
 
 QString QXmppLogger::logFilePath()
@@ -260,4 +957,120 @@ void QXmppLogger::reopen()
         delete d->logFile;
         d->logFile = nullptr;
     }
+    if (d->fileWriter) {
+        d->fileWriter->reopen(d->fileOptions());
+    }
+}
+
+///
+/// Waits until all messages have been written to the log file.
+///
+/// This is only needed with asynchronous file logging, otherwise messages are written directly.
+///
+/// \since QXmpp 1.11
+///
+void QXmppLogger::flush()
+{
+    if (d->fileWriter) {
+        d->fileWriter->flush();
+    } else if (d->logFile) {
+        d->logFile->flush();
+    }
+}
+
+///
+/// Returns whether log messages are written to the file on a background thread.
+///
+/// \since QXmpp 1.11
+///
+bool QXmppLogger::asynchronousFileLogging() const
+{
+    return d->asynchronousFileLogging;
+}
+
+///
+/// Sets whether log messages are written to the file on a background thread.
+///
+/// With asynchronous file logging, log() only queues the message and does not wait for the disk.
+/// The messages are written in batches when enough of them are queued, after at most one second
+/// or when flush() is called. If messages are logged faster than they can be written, they are
+/// dropped, see droppedMessageCount().
+///
+/// This only has an effect with FileLogging. The default value is false.
+///
+/// \since QXmpp 1.11
+///
+void QXmppLogger::setAsynchronousFileLogging(bool enabled)
+{
+    if (d->asynchronousFileLogging != enabled) {
+        d->asynchronousFileLogging = enabled;
+        // writes the remaining messages
+        d->fileWriter.reset();
+        reopen();
+    }
+}
+
+///
+/// Returns the size in bytes at which the log file is rotated.
+///
+/// \since QXmpp 1.11
+///
+qint64 QXmppLogger::maximumLogFileSize() const
+{
+    return d->maximumLogFileSize;
+}
+
+///
+/// Sets the size in bytes at which the log file is rotated.
+///
+/// When the log file exceeds this size, it is renamed by appending ".1" to its path, older files
+/// are renamed to ".2", ".3" and so on, and a new file is started. See setMaximumLogFileCount()
+/// for how many old files are kept.
+///
+/// If set to zero, the log file is never rotated. The default value is 0.
+///
+/// \since QXmpp 1.11
+///
+void QXmppLogger::setMaximumLogFileSize(qint64 bytes)
+{
+    if (d->maximumLogFileSize != bytes) {
+        d->maximumLogFileSize = bytes;
+        reopen();
+    }
+}
+
+///
+/// Returns how many rotated log files are kept.
+///
+/// \since QXmpp 1.11
+///
+int QXmppLogger::maximumLogFileCount() const
+{
+    return d->maximumLogFileCount;
+}
+
+///
+/// Sets how many rotated log files are kept.
+///
+/// If set to zero, the log file is truncated on rotation. The default value is 1.
+///
+/// \since QXmpp 1.11
+///
+void QXmppLogger::setMaximumLogFileCount(int count)
+{
+    if (d->maximumLogFileCount != count) {
+        d->maximumLogFileCount = count;
+        reopen();
+    }
+}
+
+///
+/// Returns the number of messages that have been dropped because the queue of the asynchronous
+/// file logging was full, since it has been enabled.
+///
+/// \since QXmpp 1.11
+///
+quint64 QXmppLogger::droppedMessageCount() const
+{
+    return d->fileWriter ? d->fileWriter->droppedMessages() : 0;
 }
@@ -19,6 +19,7 @@
 #endif
 
 class QXmppLoggerPrivate;
+class QXmppMetrics;
 
 ///
 /// \brief The QXmppLogger class represents a sink for logging messages.
@@ -86,20 +87,42 @@ public:
     void setMessageTypes(QXmppLogger::MessageTypes types);
     Q_SIGNAL void messageTypesChanged();
 
+    bool isEnabled(QXmppLogger::MessageType type) const;
+
+    bool asynchronousFileLogging() const;
+    void setAsynchronousFileLogging(bool enabled);
+
+    qint64 maximumLogFileSize() const;
+    void setMaximumLogFileSize(qint64 bytes);
+    int maximumLogFileCount() const;
+    void setMaximumLogFileCount(int count);
+
+    quint64 droppedMessageCount() const;
+
+    bool metricsEnabled() const;
+    void setMetricsEnabled(bool enabled);
+    QXmppMetrics *metrics() const;
+
 public Q_SLOTS:
     virtual void setGauge(const QString &gauge, double value);
     virtual void updateCounter(const QString &counter, qint64 amount);
+    void updateHistogram(const QString &histogram, double value);
 
     void log(QXmppLogger::MessageType type, const QString &text);
     void reopen();
+    void flush();
 
 Q_SIGNALS:
     /// This signal is emitted whenever a log message is received.
     void message(QXmppLogger::MessageType type, const QString &text);
 
 private:
+    void setMetricsRegistry(QXmppMetrics *metrics);
+
     static QXmppLogger *m_logger;
     const std::unique_ptr<QXmppLoggerPrivate> d;
+
+    friend class QXmppClientPool;
 };
 
 /// \brief The QXmppLoggable class represents a source of logging messages.
@@ -113,18 +136,28 @@ class QXMPP_EXPORT QXmppLoggable : public QObject
 public:
     QXmppLoggable(QObject *parent = nullptr);
 
+    bool isMetricsEnabled() const;
+
 protected:
     /// \cond
     void childEvent(QChildEvent *event) override;
+    void connectNotify(const QMetaMethod &signal) override;
+    void disconnectNotify(const QMetaMethod &signal) override;
+
+    void connectLogger(QXmppLogger *logger);
     /// \endcond
 
+    bool isLoggingEnabled(QXmppLogger::MessageType type) const;
+
     /// Logs a debugging message.
     ///
     /// \param message
 
     void debug(const QString &message)
     {
-        Q_EMIT logMessage(QXmppLogger::DebugMessage, qxmpp_loggable_trace(message));
+        if (isLoggingEnabled(QXmppLogger::DebugMessage)) {
+            Q_EMIT logMessage(QXmppLogger::DebugMessage, qxmpp_loggable_trace(message));
+        }
     }
 
     /// Logs an informational message.
@@ -133,7 +166,9 @@ protected:
 
     void info(const QString &message)
     {
-        Q_EMIT logMessage(QXmppLogger::InformationMessage, qxmpp_loggable_trace(message));
+        if (isLoggingEnabled(QXmppLogger::InformationMessage)) {
+            Q_EMIT logMessage(QXmppLogger::InformationMessage, qxmpp_loggable_trace(message));
+        }
     }
 
     /// Logs a warning message.
@@ -142,7 +177,9 @@ protected:
 
     void warning(const QString &message)
     {
-        Q_EMIT logMessage(QXmppLogger::WarningMessage, qxmpp_loggable_trace(message));
+        if (isLoggingEnabled(QXmppLogger::WarningMessage)) {
+            Q_EMIT logMessage(QXmppLogger::WarningMessage, qxmpp_loggable_trace(message));
+        }
     }
 
     /// Logs a received packet.
@@ -151,7 +188,9 @@ protected:
 
     void logReceived(const QString &message)
     {
-        Q_EMIT logMessage(QXmppLogger::ReceivedMessage, qxmpp_loggable_trace(message));
+        if (isLoggingEnabled(QXmppLogger::ReceivedMessage)) {
+            Q_EMIT logMessage(QXmppLogger::ReceivedMessage, qxmpp_loggable_trace(message));
+        }
     }
 
     /// Logs a sent packet.
@@ -160,7 +199,9 @@ protected:
 
     void logSent(const QString &message)
     {
-        Q_EMIT logMessage(QXmppLogger::SentMessage, qxmpp_loggable_trace(message));
+        if (isLoggingEnabled(QXmppLogger::SentMessage)) {
+            Q_EMIT logMessage(QXmppLogger::SentMessage, qxmpp_loggable_trace(message));
+        }
     }
 
 Q_SIGNALS:
@@ -172,6 +213,13 @@ Q_SIGNALS:
 
     /// Updates the given \a counter by \a amount.
     void updateCounter(const QString &counter, qint64 amount = 1);
+
+    ///
+    /// Records \a value in the given \a histogram. Durations are reported in seconds.
+    ///
+    /// \since QXmpp 1.11
+    ///
+    void updateHistogram(const QString &histogram, double value);
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(QXmppLogger::MessageTypes)
@@ -236,7 +236,7 @@ QString QXmppMessage::body() const
 /// Sets the message's body.
 void QXmppMessage::setBody(const QString &body)
 {
-    d->body = body;
+    parsed(d)->body = body;
 }
 
 ///
@@ -251,7 +251,7 @@ void QXmppMessage::setBody(const QString &body)
 ///
 QString QXmppMessage::e2eeFallbackBody() const
 {
-    return d->e2eeFallbackBody;
+    return parsed(d)->e2eeFallbackBody;
 }
 
 ///
@@ -266,7 +266,7 @@ QString QXmppMessage::e2eeFallbackBody() const
 ///
 void QXmppMessage::setE2eeFallbackBody(const QString &fallbackBody)
 {
-    d->e2eeFallbackBody = fallbackBody;
+    parsed(d)->e2eeFallbackBody = fallbackBody;
 }
 
 /// Returns the message's type.
@@ -284,25 +284,25 @@ void QXmppMessage::setType(QXmppMessage::Type type)
 /// Returns the message's subject.
 QString QXmppMessage::subject() const
 {
-    return d->subject;
+    return parsed(d)->subject;
 }
 
 /// Sets the message's subject.
 void QXmppMessage::setSubject(const QString &subject)
 {
-    d->subject = subject;
+    parsed(d)->subject = subject;
 }
 
 /// Returns the message's thread.
 QString QXmppMessage::thread() const
 {
-    return d->thread;
+    return parsed(d)->thread;
 }
 
 /// Sets the message's thread.
 void QXmppMessage::setThread(const QString &thread)
 {
-    d->thread = thread;
+    parsed(d)->thread = thread;
 }
 
 ///
@@ -314,7 +314,7 @@ void QXmppMessage::setThread(const QString &thread)
 ///
 QString QXmppMessage::parentThread() const
 {
-    return d->parentThread;
+    return parsed(d)->parentThread;
 }
 
 ///
@@ -326,7 +326,7 @@ QString QXmppMessage::parentThread() const
 ///
 void QXmppMessage::setParentThread(const QString &parent)
 {
-    d->parentThread = parent;
+    parsed(d)->parentThread = parent;
 }
 
 ///
@@ -336,11 +336,12 @@ void QXmppMessage::setParentThread(const QString &parent)
 ///
 QString QXmppMessage::outOfBandUrl() const
 {
-    if (d->outOfBandUrls.empty()) {
+    auto *data = parsed(d);
+    if (data->outOfBandUrls.empty()) {
         return {};
     }
 
-    return d->outOfBandUrls.front().url();
+    return data->outOfBandUrls.front().url();
 }
 
 ///
@@ -354,7 +355,7 @@ void QXmppMessage::setOutOfBandUrl(const QString &url)
 {
     QXmppOutOfBandUrl data;
     data.setUrl(url);
-    d->outOfBandUrls = { std::move(data) };
+    parsed(d)->outOfBandUrls = { std::move(data) };
 }
 
 ///
@@ -364,7 +365,7 @@ void QXmppMessage::setOutOfBandUrl(const QString &url)
 ///
 QVector<QXmppOutOfBandUrl> QXmppMessage::outOfBandUrls() const
 {
-    return d->outOfBandUrls;
+    return parsed(d)->outOfBandUrls;
 }
 
 ///
@@ -374,7 +375,7 @@ QVector<QXmppOutOfBandUrl> QXmppMessage::outOfBandUrls() const
 ///
 void QXmppMessage::setOutOfBandUrls(const QVector<QXmppOutOfBandUrl> &urls)
 {
-    d->outOfBandUrls = urls;
+    parsed(d)->outOfBandUrls = urls;
 }
 
 ///
@@ -384,7 +385,7 @@ void QXmppMessage::setOutOfBandUrls(const QVector<QXmppOutOfBandUrl> &urls)
 ///
 QString QXmppMessage::xhtml() const
 {
-    return d->xhtml;
+    return parsed(d)->xhtml;
 }
 
 ///
@@ -394,7 +395,7 @@ QString QXmppMessage::xhtml() const
 ///
 void QXmppMessage::setXhtml(const QString &xhtml)
 {
-    d->xhtml = xhtml;
+    parsed(d)->xhtml = xhtml;
 }
 
 ///
@@ -405,7 +406,7 @@ void QXmppMessage::setXhtml(const QString &xhtml)
 ///
 QXmppMessage::State QXmppMessage::state() const
 {
-    return d->state;
+    return parsed(d)->state;
 }
 
 ///
@@ -416,7 +417,7 @@ QXmppMessage::State QXmppMessage::state() const
 ///
 void QXmppMessage::setState(QXmppMessage::State state)
 {
-    d->state = state;
+    parsed(d)->state = state;
 }
 
 ///
@@ -427,7 +428,7 @@ void QXmppMessage::setState(QXmppMessage::State state)
 ///
 QDateTime QXmppMessage::stamp() const
 {
-    return d->stamp;
+    return parsed(d)->stamp;
 }
 
 ///
@@ -441,7 +442,7 @@ QDateTime QXmppMessage::stamp() const
 ///
 void QXmppMessage::setStamp(const QDateTime &stamp)
 {
-    d->stamp = stamp;
+    parsed(d)->stamp = stamp;
 }
 
 ///
@@ -452,7 +453,7 @@ void QXmppMessage::setStamp(const QDateTime &stamp)
 ///
 bool QXmppMessage::isReceiptRequested() const
 {
-    return d->receiptRequested;
+    return parsed(d)->receiptRequested;
 }
 
 ///
@@ -463,7 +464,7 @@ bool QXmppMessage::isReceiptRequested() const
 ///
 void QXmppMessage::setReceiptRequested(bool requested)
 {
-    d->receiptRequested = requested;
+    parsed(d)->receiptRequested = requested;
     if (requested && id().isEmpty()) {
         generateAndSetNextId();
     }
@@ -477,7 +478,7 @@ void QXmppMessage::setReceiptRequested(bool requested)
 ///
 QString QXmppMessage::receiptId() const
 {
-    return d->receiptId;
+    return parsed(d)->receiptId;
 }
 
 ///
@@ -487,7 +488,7 @@ QString QXmppMessage::receiptId() const
 ///
 void QXmppMessage::setReceiptId(const QString &id)
 {
-    d->receiptId = id;
+    parsed(d)->receiptId = id;
 }
 
 ///
@@ -498,7 +499,7 @@ void QXmppMessage::setReceiptId(const QString &id)
 ///
 bool QXmppMessage::isAttentionRequested() const
 {
-    return d->attentionRequested;
+    return parsed(d)->attentionRequested;
 }
 
 ///
@@ -511,7 +512,7 @@ bool QXmppMessage::isAttentionRequested() const
 ///
 void QXmppMessage::setAttentionRequested(bool requested)
 {
-    d->attentionRequested = requested;
+    parsed(d)->attentionRequested = requested;
 }
 
 ///
@@ -523,7 +524,7 @@ void QXmppMessage::setAttentionRequested(bool requested)
 ///
 QXmppBitsOfBinaryDataList QXmppMessage::bitsOfBinaryData() const
 {
-    return d->bitsOfBinaryData;
+    return parsed(d)->bitsOfBinaryData;
 }
 
 ///
@@ -535,7 +536,7 @@ QXmppBitsOfBinaryDataList QXmppMessage::bitsOfBinaryData() const
 ///
 QXmppBitsOfBinaryDataList &QXmppMessage::bitsOfBinaryData()
 {
-    return d->bitsOfBinaryData;
+    return parsed(d)->bitsOfBinaryData;
 }
 
 ///
@@ -545,7 +546,7 @@ QXmppBitsOfBinaryDataList &QXmppMessage::bitsOfBinaryData()
 ///
 void QXmppMessage::setBitsOfBinaryData(const QXmppBitsOfBinaryDataList &bitsOfBinaryData)
 {
-    d->bitsOfBinaryData = bitsOfBinaryData;
+    parsed(d)->bitsOfBinaryData = bitsOfBinaryData;
 }
 
 ///
@@ -571,7 +572,7 @@ bool QXmppMessage::isSlashMeCommand(const QString &body)
 ///
 bool QXmppMessage::isSlashMeCommand() const
 {
-    return isSlashMeCommand(d->body);
+    return isSlashMeCommand(parsed(d)->body);
 }
 
 ///
@@ -606,7 +607,7 @@ QString QXmppMessage::slashMeCommandText(const QString &body)
 ///
 QString QXmppMessage::slashMeCommandText() const
 {
-    return slashMeCommandText(d->body);
+    return slashMeCommandText(parsed(d)->body);
 }
 
 ///
@@ -617,7 +618,7 @@ QString QXmppMessage::slashMeCommandText() const
 ///
 QString QXmppMessage::mucInvitationJid() const
 {
-    return d->mucInvitationJid;
+    return parsed(d)->mucInvitationJid;
 }
 
 ///
@@ -628,7 +629,7 @@ QString QXmppMessage::mucInvitationJid() const
 ///
 void QXmppMessage::setMucInvitationJid(const QString &jid)
 {
-    d->mucInvitationJid = jid;
+    parsed(d)->mucInvitationJid = jid;
 }
 
 ///
@@ -639,7 +640,7 @@ void QXmppMessage::setMucInvitationJid(const QString &jid)
 ///
 QString QXmppMessage::mucInvitationPassword() const
 {
-    return d->mucInvitationPassword;
+    return parsed(d)->mucInvitationPassword;
 }
 
 ///
@@ -650,7 +651,7 @@ QString QXmppMessage::mucInvitationPassword() const
 ///
 void QXmppMessage::setMucInvitationPassword(const QString &password)
 {
-    d->mucInvitationPassword = password;
+    parsed(d)->mucInvitationPassword = password;
 }
 
 ///
@@ -661,7 +662,7 @@ void QXmppMessage::setMucInvitationPassword(const QString &password)
 ///
 QString QXmppMessage::mucInvitationReason() const
 {
-    return d->mucInvitationReason;
+    return parsed(d)->mucInvitationReason;
 }
 
 ///
@@ -672,7 +673,7 @@ QString QXmppMessage::mucInvitationReason() const
 ///
 void QXmppMessage::setMucInvitationReason(const QString &reason)
 {
-    d->mucInvitationReason = reason;
+    parsed(d)->mucInvitationReason = reason;
 }
 
 ///
@@ -684,7 +685,7 @@ void QXmppMessage::setMucInvitationReason(const QString &reason)
 ///
 bool QXmppMessage::isPrivate() const
 {
-    return d->privatemsg;
+    return parsed(d)->privatemsg;
 }
 
 ///
@@ -696,7 +697,7 @@ bool QXmppMessage::isPrivate() const
 ///
 void QXmppMessage::setPrivate(const bool priv)
 {
-    d->privatemsg = priv;
+    parsed(d)->privatemsg = priv;
 }
 
 ///
@@ -706,7 +707,7 @@ void QXmppMessage::setPrivate(const bool priv)
 ///
 bool QXmppMessage::isCarbonForwarded() const
 {
-    return d->isCarbonForwarded;
+    return parsed(d)->isCarbonForwarded;
 }
 
 ///
@@ -718,7 +719,7 @@ bool QXmppMessage::isCarbonForwarded() const
 ///
 void QXmppMessage::setCarbonForwarded(bool forwarded)
 {
-    d->isCarbonForwarded = forwarded;
+    parsed(d)->isCarbonForwarded = forwarded;
 }
 
 ///
@@ -730,7 +731,7 @@ void QXmppMessage::setCarbonForwarded(bool forwarded)
 ///
 QString QXmppMessage::replaceId() const
 {
-    return d->replaceId;
+    return parsed(d)->replaceId;
 }
 
 ///
@@ -741,7 +742,7 @@ QString QXmppMessage::replaceId() const
 ///
 void QXmppMessage::setReplaceId(const QString &replaceId)
 {
-    d->replaceId = replaceId;
+    parsed(d)->replaceId = replaceId;
 }
 
 ///
@@ -752,7 +753,7 @@ void QXmppMessage::setReplaceId(const QString &replaceId)
 ///
 bool QXmppMessage::isMarkable() const
 {
-    return d->markable;
+    return parsed(d)->markable;
 }
 
 ///
@@ -762,7 +763,7 @@ bool QXmppMessage::isMarkable() const
 ///
 void QXmppMessage::setMarkable(const bool markable)
 {
-    d->markable = markable;
+    parsed(d)->markable = markable;
 }
 
 ///
@@ -772,7 +773,7 @@ void QXmppMessage::setMarkable(const bool markable)
 ///
 QString QXmppMessage::markedId() const
 {
-    return d->markedId;
+    return parsed(d)->markedId;
 }
 
 ///
@@ -782,7 +783,7 @@ QString QXmppMessage::markedId() const
 ///
 void QXmppMessage::setMarkerId(const QString &markerId)
 {
-    d->markedId = markerId;
+    parsed(d)->markedId = markerId;
 }
 
 ///
@@ -792,7 +793,7 @@ void QXmppMessage::setMarkerId(const QString &markerId)
 ///
 QString QXmppMessage::markedThread() const
 {
-    return d->markedThread;
+    return parsed(d)->markedThread;
 }
 
 ///
@@ -802,7 +803,7 @@ QString QXmppMessage::markedThread() const
 ///
 void QXmppMessage::setMarkedThread(const QString &markedThread)
 {
-    d->markedThread = markedThread;
+    parsed(d)->markedThread = markedThread;
 }
 
 ///
@@ -812,7 +813,7 @@ void QXmppMessage::setMarkedThread(const QString &markedThread)
 ///
 QXmppMessage::Marker QXmppMessage::marker() const
 {
-    return d->marker;
+    return parsed(d)->marker;
 }
 
 ///
@@ -822,7 +823,7 @@ QXmppMessage::Marker QXmppMessage::marker() const
 ///
 void QXmppMessage::setMarker(const Marker marker)
 {
-    d->marker = marker;
+    parsed(d)->marker = marker;
 }
 
 ///
@@ -833,7 +834,7 @@ void QXmppMessage::setMarker(const Marker marker)
 ///
 bool QXmppMessage::hasHint(const Hint hint) const
 {
-    return d->hints & hint;
+    return parsed(d)->hints & hint;
 }
 
 ///
@@ -844,7 +845,7 @@ bool QXmppMessage::hasHint(const Hint hint) const
 ///
 void QXmppMessage::addHint(const Hint hint)
 {
-    d->hints |= hint;
+    parsed(d)->hints |= hint;
 }
 
 ///
@@ -855,7 +856,7 @@ void QXmppMessage::addHint(const Hint hint)
 ///
 void QXmppMessage::removeHint(const Hint hint)
 {
-    d->hints &= ~hint;
+    parsed(d)->hints &= ~hint;
 }
 
 ///
@@ -866,7 +867,7 @@ void QXmppMessage::removeHint(const Hint hint)
 ///
 void QXmppMessage::removeAllHints()
 {
-    d->hints = 0;
+    parsed(d)->hints = 0;
 }
 
 ///
@@ -875,7 +876,7 @@ void QXmppMessage::removeAllHints()
 ///
 std::optional<QXmppJingleMessageInitiationElement> QXmppMessage::jingleMessageInitiationElement() const
 {
-    return d->jingleMessageInitiationElement;
+    return parsed(d)->jingleMessageInitiationElement;
 }
 
 ///
@@ -884,7 +885,7 @@ std::optional<QXmppJingleMessageInitiationElement> QXmppMessage::jingleMessageIn
 ///
 void QXmppMessage::setJingleMessageInitiationElement(const std::optional<QXmppJingleMessageInitiationElement> &jingleMessageInitiationElement)
 {
-    d->jingleMessageInitiationElement = jingleMessageInitiationElement;
+    parsed(d)->jingleMessageInitiationElement = jingleMessageInitiationElement;
 }
 
 ///
@@ -897,7 +898,8 @@ void QXmppMessage::setJingleMessageInitiationElement(const std::optional<QXmppJi
 ///
 QString QXmppMessage::stanzaId() const
 {
-    return d->stanzaIds.empty() ? QString() : d->stanzaIds.last().id;
+    auto *data = parsed(d);
+    return data->stanzaIds.empty() ? QString() : data->stanzaIds.last().id;
 }
 
 ///
@@ -910,10 +912,11 @@ QString QXmppMessage::stanzaId() const
 ///
 void QXmppMessage::setStanzaId(const QString &id)
 {
-    if (d->stanzaIds.size() == 1) {
-        d->stanzaIds.first().id = id;
+    auto *data = parsed(d);
+    if (data->stanzaIds.size() == 1) {
+        data->stanzaIds.first().id = id;
     } else {
-        d->stanzaIds = { QXmppStanzaId { id, {} } };
+        data->stanzaIds = { QXmppStanzaId { id, {} } };
     }
 }
 
@@ -927,7 +930,8 @@ void QXmppMessage::setStanzaId(const QString &id)
 ///
 QString QXmppMessage::stanzaIdBy() const
 {
-    return d->stanzaIds.empty() ? QString() : d->stanzaIds.last().by;
+    auto *data = parsed(d);
+    return data->stanzaIds.empty() ? QString() : data->stanzaIds.last().by;
 }
 
 ///
@@ -940,10 +944,11 @@ QString QXmppMessage::stanzaIdBy() const
 ///
 void QXmppMessage::setStanzaIdBy(const QString &by)
 {
-    if (d->stanzaIds.size() == 1) {
-        d->stanzaIds.first().by = by;
+    auto *data = parsed(d);
+    if (data->stanzaIds.size() == 1) {
+        data->stanzaIds.first().by = by;
     } else {
-        d->stanzaIds = { QXmppStanzaId { {}, by } };
+        data->stanzaIds = { QXmppStanzaId { {}, by } };
     }
 }
 
@@ -954,7 +959,7 @@ void QXmppMessage::setStanzaIdBy(const QString &by)
 ///
 QVector<QXmppStanzaId> QXmppMessage::stanzaIds() const
 {
-    return d->stanzaIds;
+    return parsed(d)->stanzaIds;
 }
 
 ///
@@ -964,7 +969,7 @@ QVector<QXmppStanzaId> QXmppMessage::stanzaIds() const
 ///
 void QXmppMessage::setStanzaIds(const QVector<QXmppStanzaId> &ids)
 {
-    d->stanzaIds = ids;
+    parsed(d)->stanzaIds = ids;
 }
 
 ///
@@ -975,7 +980,7 @@ void QXmppMessage::setStanzaIds(const QVector<QXmppStanzaId> &ids)
 ///
 QString QXmppMessage::originId() const
 {
-    return d->originId;
+    return parsed(d)->originId;
 }
 
 ///
@@ -986,7 +991,7 @@ QString QXmppMessage::originId() const
 ///
 void QXmppMessage::setOriginId(const QString &id)
 {
-    d->originId = id;
+    parsed(d)->originId = id;
 }
 
 ///
@@ -997,7 +1002,7 @@ void QXmppMessage::setOriginId(const QString &id)
 ///
 QString QXmppMessage::attachId() const
 {
-    return d->attachId;
+    return parsed(d)->attachId;
 }
 
 ///
@@ -1011,7 +1016,7 @@ QString QXmppMessage::attachId() const
 ///
 void QXmppMessage::setAttachId(const QString &attachId)
 {
-    d->attachId = attachId;
+    parsed(d)->attachId = attachId;
 }
 
 ///
@@ -1032,7 +1037,7 @@ QString QXmppMessage::mixParticipantId() const
 ///
 QString QXmppMessage::mixUserJid() const
 {
-    return d->mixUserJid;
+    return parsed(d)->mixUserJid;
 }
 
 ///
@@ -1042,7 +1047,7 @@ QString QXmppMessage::mixUserJid() const
 ///
 void QXmppMessage::setMixUserJid(const QString &mixUserJid)
 {
-    d->mixUserJid = mixUserJid;
+    parsed(d)->mixUserJid = mixUserJid;
 }
 
 ///
@@ -1052,7 +1057,7 @@ void QXmppMessage::setMixUserJid(const QString &mixUserJid)
 ///
 QString QXmppMessage::mixUserNick() const
 {
-    return d->mixUserNick;
+    return parsed(d)->mixUserNick;
 }
 
 ///
@@ -1062,7 +1067,7 @@ QString QXmppMessage::mixUserNick() const
 ///
 void QXmppMessage::setMixUserNick(const QString &mixUserNick)
 {
-    d->mixUserNick = mixUserNick;
+    parsed(d)->mixUserNick = mixUserNick;
 }
 
 ///
@@ -1081,10 +1086,11 @@ void QXmppMessage::setMixUserNick(const QString &mixUserNick)
 ///
 QXmpp::EncryptionMethod QXmppMessage::encryptionMethod() const
 {
-    if (d->encryptionMethod.isEmpty()) {
+    auto *data = parsed(d);
+    if (data->encryptionMethod.isEmpty()) {
         return QXmpp::NoEncryption;
     }
-    return QXmpp::Private::encryptionFromString(d->encryptionMethod).value_or(QXmpp::UnknownEncryption);
+    return QXmpp::Private::encryptionFromString(data->encryptionMethod).value_or(QXmpp::UnknownEncryption);
 }
 
 ///
@@ -1095,7 +1101,7 @@ QXmpp::EncryptionMethod QXmppMessage::encryptionMethod() const
 ///
 void QXmppMessage::setEncryptionMethod(QXmpp::EncryptionMethod method)
 {
-    d->encryptionMethod = QXmpp::Private::encryptionToString(method).toString();
+    parsed(d)->encryptionMethod = QXmpp::Private::encryptionToString(method).toString();
 }
 
 ///
@@ -1106,7 +1112,7 @@ void QXmppMessage::setEncryptionMethod(QXmpp::EncryptionMethod method)
 ///
 QString QXmppMessage::encryptionMethodNs() const
 {
-    return d->encryptionMethod;
+    return parsed(d)->encryptionMethod;
 }
 
 ///
@@ -1117,7 +1123,7 @@ QString QXmppMessage::encryptionMethodNs() const
 ///
 void QXmppMessage::setEncryptionMethodNs(const QString &encryptionMethod)
 {
-    d->encryptionMethod = encryptionMethod;
+    parsed(d)->encryptionMethod = encryptionMethod;
 }
 
 ///
@@ -1129,8 +1135,9 @@ void QXmppMessage::setEncryptionMethodNs(const QString &encryptionMethod)
 ///
 QString QXmppMessage::encryptionName() const
 {
-    if (!d->encryptionName.isEmpty()) {
-        return d->encryptionName;
+    auto *data = parsed(d);
+    if (!data->encryptionName.isEmpty()) {
+        return data->encryptionName;
     }
     return QXmpp::Private::encryptionToName(encryptionMethod()).toString();
 }
@@ -1146,7 +1153,7 @@ QString QXmppMessage::encryptionName() const
 ///
 void QXmppMessage::setEncryptionName(const QString &encryptionName)
 {
-    d->encryptionName = encryptionName;
+    parsed(d)->encryptionName = encryptionName;
 }
 
 ///
@@ -1159,7 +1166,7 @@ void QXmppMessage::setEncryptionName(const QString &encryptionName)
 ///
 bool QXmppMessage::isSpoiler() const
 {
-    return d->isSpoiler;
+    return parsed(d)->isSpoiler;
 }
 
 ///
@@ -1174,7 +1181,7 @@ bool QXmppMessage::isSpoiler() const
 ///
 void QXmppMessage::setIsSpoiler(bool isSpoiler)
 {
-    d->isSpoiler = isSpoiler;
+    parsed(d)->isSpoiler = isSpoiler;
 }
 
 ///
@@ -1186,7 +1193,7 @@ void QXmppMessage::setIsSpoiler(bool isSpoiler)
 ///
 QString QXmppMessage::spoilerHint() const
 {
-    return d->spoilerHint;
+    return parsed(d)->spoilerHint;
 }
 
 ///
@@ -1202,9 +1209,10 @@ QString QXmppMessage::spoilerHint() const
 ///
 void QXmppMessage::setSpoilerHint(const QString &spoilerHint)
 {
-    d->spoilerHint = spoilerHint;
+    auto *data = parsed(d);
+    data->spoilerHint = spoilerHint;
     if (!spoilerHint.isEmpty()) {
-        d->isSpoiler = true;
+        data->isSpoiler = true;
     }
 }
 
@@ -1217,7 +1225,7 @@ void QXmppMessage::setSpoilerHint(const QString &spoilerHint)
 ///
 std::optional<QXmppOmemoElement> QXmppMessage::omemoElement() const
 {
-    return d->omemoElement;
+    return parsed(d)->omemoElement;
 }
 
 ///
@@ -1227,7 +1235,7 @@ std::optional<QXmppOmemoElement> QXmppMessage::omemoElement() const
 ///
 void QXmppMessage::setOmemoElement(const std::optional<QXmppOmemoElement> &omemoElement)
 {
-    d->omemoElement = omemoElement;
+    parsed(d)->omemoElement = omemoElement;
 }
 /// \endcond
 #endif
@@ -1241,7 +1249,7 @@ void QXmppMessage::setOmemoElement(const std::optional<QXmppOmemoElement> &omemo
 ///
 std::optional<QXmppMixInvitation> QXmppMessage::mixInvitation() const
 {
-    return d->mixInvitation;
+    return parsed(d)->mixInvitation;
 }
 
 ///
@@ -1252,7 +1260,7 @@ std::optional<QXmppMixInvitation> QXmppMessage::mixInvitation() const
 ///
 void QXmppMessage::setMixInvitation(const std::optional<QXmppMixInvitation> &mixInvitation)
 {
-    d->mixInvitation = mixInvitation;
+    parsed(d)->mixInvitation = mixInvitation;
 }
 
 ///
@@ -1267,7 +1275,7 @@ void QXmppMessage::setMixInvitation(const std::optional<QXmppMixInvitation> &mix
 ///
 bool QXmppMessage::isFallback() const
 {
-    return !d->fallbackMarkers.empty();
+    return !parsed(d)->fallbackMarkers.empty();
 }
 
 ///
@@ -1282,10 +1290,11 @@ bool QXmppMessage::isFallback() const
 ///
 void QXmppMessage::setIsFallback(bool isFallback)
 {
+    auto *data = parsed(d);
     if (isFallback) {
-        d->fallbackMarkers = { QXmppFallback { {}, {} } };
+        data->fallbackMarkers = { QXmppFallback { {}, {} } };
     } else {
-        d->fallbackMarkers.clear();
+        data->fallbackMarkers.clear();
     }
 }
 
@@ -1296,7 +1305,7 @@ void QXmppMessage::setIsFallback(bool isFallback)
 ///
 const QVector<QXmppFallback> &QXmppMessage::fallbackMarkers() const
 {
-    return d->fallbackMarkers;
+    return parsed(d)->fallbackMarkers;
 }
 
 ///
@@ -1306,7 +1315,7 @@ const QVector<QXmppFallback> &QXmppMessage::fallbackMarkers() const
 ///
 void QXmppMessage::setFallbackMarkers(const QVector<QXmppFallback> &fallbackMarkers)
 {
-    d->fallbackMarkers = fallbackMarkers;
+    parsed(d)->fallbackMarkers = fallbackMarkers;
 }
 
 ///
@@ -1320,8 +1329,9 @@ void QXmppMessage::setFallbackMarkers(const QVector<QXmppFallback> &fallbackMark
 ///
 QString QXmppMessage::readFallbackRemovedText(QXmppFallback::Element element, const QVector<QString> &supportedNamespaces) const
 {
+    auto *data = parsed(d);
     // filter out all QXmppFallback::Reference s
-    auto markers = d->fallbackMarkers |
+    auto markers = data->fallbackMarkers |
         views::filter([&](const auto &marker) { return contains(supportedNamespaces, marker.forNamespace()); }) |
         views::transform([](auto &&marker) { return marker.references(); });
 
@@ -1342,7 +1352,7 @@ QString QXmppMessage::readFallbackRemovedText(QXmppFallback::Element element, co
     // sort by begin of fallback
     std::ranges::sort(references, {}, &QXmppFallback::Range::start);
 
-    const auto &fullText = element == QXmppFallback::Subject ? d->subject : d->body;
+    const auto &fullText = element == QXmppFallback::Subject ? data->subject : data->body;
     QString output;
     qsizetype index = 0;
     for (const auto &range : std::as_const(references)) {
@@ -1377,10 +1387,11 @@ QString QXmppMessage::readFallbackRemovedText(QXmppFallback::Element element, co
 ///
 QString QXmppMessage::readFallbackText(QXmppFallback::Element element, QStringView forNamespace) const
 {
-    const auto &fullText = element == QXmppFallback::Subject ? d->subject : d->body;
+    auto *data = parsed(d);
+    const auto &fullText = element == QXmppFallback::Subject ? data->subject : data->body;
 
     // filter out all QXmppFallback::Reference s
-    auto markers = d->fallbackMarkers |
+    auto markers = data->fallbackMarkers |
         views::filter([&](const auto &marker) { return marker.forNamespace() == forNamespace; }) |
         views::transform([](auto &&marker) { return marker.references(); });
 
@@ -1416,7 +1427,7 @@ QString QXmppMessage::readFallbackText(QXmppFallback::Element element, QStringVi
 ///
 std::optional<QXmppTrustMessageElement> QXmppMessage::trustMessageElement() const
 {
-    return d->trustMessageElement;
+    return parsed(d)->trustMessageElement;
 }
 
 ///
@@ -1426,7 +1437,7 @@ std::optional<QXmppTrustMessageElement> QXmppMessage::trustMessageElement() cons
 ///
 void QXmppMessage::setTrustMessageElement(const std::optional<QXmppTrustMessageElement> &trustMessageElement)
 {
-    d->trustMessageElement = trustMessageElement;
+    parsed(d)->trustMessageElement = trustMessageElement;
 }
 
 ///
@@ -1436,7 +1447,7 @@ void QXmppMessage::setTrustMessageElement(const std::optional<QXmppTrustMessageE
 ///
 std::optional<QXmppMessageReaction> QXmppMessage::reaction() const
 {
-    return d->reaction;
+    return parsed(d)->reaction;
 }
 
 ///
@@ -1452,7 +1463,7 @@ std::optional<QXmppMessageReaction> QXmppMessage::reaction() const
 ///
 void QXmppMessage::setReaction(const std::optional<QXmppMessageReaction> &reaction)
 {
-    d->reaction = reaction;
+    parsed(d)->reaction = reaction;
 }
 
 ///
@@ -1462,7 +1473,7 @@ void QXmppMessage::setReaction(const std::optional<QXmppMessageReaction> &reacti
 ///
 const QVector<QXmppFileShare> &QXmppMessage::sharedFiles() const
 {
-    return d->sharedFiles;
+    return parsed(d)->sharedFiles;
 }
 
 ///
@@ -1472,7 +1483,7 @@ const QVector<QXmppFileShare> &QXmppMessage::sharedFiles() const
 ///
 void QXmppMessage::setSharedFiles(const QVector<QXmppFileShare> &sharedFiles)
 {
-    d->sharedFiles = sharedFiles;
+    parsed(d)->sharedFiles = sharedFiles;
 }
 
 ///
@@ -1483,7 +1494,7 @@ void QXmppMessage::setSharedFiles(const QVector<QXmppFileShare> &sharedFiles)
 ///
 QVector<QXmppFileSourcesAttachment> QXmppMessage::fileSourcesAttachments() const
 {
-    return d->fileSourcesAttachments;
+    return parsed(d)->fileSourcesAttachments;
 }
 
 ///
@@ -1494,7 +1505,7 @@ QVector<QXmppFileSourcesAttachment> QXmppMessage::fileSourcesAttachments() const
 ///
 void QXmppMessage::setFileSourcesAttachments(const QVector<QXmppFileSourcesAttachment> &fileSourcesAttachments)
 {
-    d->fileSourcesAttachments = fileSourcesAttachments;
+    parsed(d)->fileSourcesAttachments = fileSourcesAttachments;
 }
 
 ///
@@ -1504,7 +1515,7 @@ void QXmppMessage::setFileSourcesAttachments(const QVector<QXmppFileSourcesAttac
 ///
 std::optional<QXmpp::Reply> QXmppMessage::reply() const
 {
-    return d->reply;
+    return parsed(d)->reply;
 }
 
 ///
@@ -1514,7 +1525,7 @@ std::optional<QXmpp::Reply> QXmppMessage::reply() const
 ///
 void QXmppMessage::setReply(const std::optional<QXmpp::Reply> &reply)
 {
-    d->reply = reply;
+    parsed(d)->reply = reply;
 }
 
 ///
@@ -1543,7 +1554,7 @@ QString QXmppMessage::readReplyQuoteFromBody() const
 ///
 std::optional<QXmppCallInviteElement> QXmppMessage::callInviteElement() const
 {
-    return d->callInviteElement;
+    return parsed(d)->callInviteElement;
 }
 
 ///
@@ -1551,7 +1562,37 @@ std::optional<QXmppCallInviteElement> QXmppMessage::callInviteElement() const
 ///
 void QXmppMessage::setCallInviteElement(std::optional<QXmppCallInviteElement> callInviteElement)
 {
-    d->callInviteElement = callInviteElement;
+    parsed(d)->callInviteElement = callInviteElement;
+}
+
+///
+/// Parses the message with deferred parsing of its extensions.
+///
+/// Only the stanza attributes, the type and the body are parsed directly. All other child
+/// elements are parsed on the first access to one of them. This saves time and memory if only
+/// few of them are used, e.g. when routing large amounts of messages.
+///
+/// The message keeps a reference to \a element (and its DOM document) until its extensions have
+/// been parsed. Copying the message parses the extensions, concurrent reads of the same object are
+/// synchronized.
+///
+/// \since QXmpp 1.11
+///
+void QXmppMessage::parseLazily(const QDomElement &element, QXmpp::SceMode sceMode)
+{
+    QXmppStanza::parse(element);
+
+    d->type = enumFromString<Type>(MESSAGE_TYPES, element.attribute(u"type"_s))
+                  .value_or(Normal);
+
+    // the body is used by almost everyone
+    if (sceMode & QXmpp::SceSensitive) {
+        d->body = firstChildElement(element, u"body").text();
+    }
+
+    deferExtensionParsing(element, sceMode, [](QXmppStanza *stanza, const QDomElement &element, QXmpp::SceMode sceMode) {
+        static_cast<QXmppMessage *>(stanza)->parseExtensions(element, sceMode);
+    });
 }
 
 /// \cond
@@ -1582,7 +1623,7 @@ void QXmppMessage::toXml(QXmlStreamWriter *writer, QXmpp::SceMode sceMode) const
     writeOptionalXmlAttribute(writer, u"id", id());
     writeOptionalXmlAttribute(writer, u"to", to());
     writeOptionalXmlAttribute(writer, u"from", from());
-    writeOptionalXmlAttribute(writer, u"type", MESSAGE_TYPES.at(size_t(d->type)));
+    writeOptionalXmlAttribute(writer, u"type", MESSAGE_TYPES.at(size_t(parsed(d)->type)));
     error().toXml(writer);
 
     // extensions
@@ -1900,13 +1941,14 @@ bool QXmppMessage::parseExtension(const QDomElement &element, QXmpp::SceMode sce
 ///
 void QXmppMessage::serializeExtensions(QXmlStreamWriter *writer, QXmpp::SceMode sceMode, const QString &baseNamespace) const
 {
+    auto *data = parsed(d);
     if (sceMode & QXmpp::ScePublic) {
-        if (sceMode == QXmpp::ScePublic && !d->e2eeFallbackBody.isEmpty()) {
-            writer->writeTextElement(QSL65("body"), d->e2eeFallbackBody);
+        if (sceMode == QXmpp::ScePublic && !data->e2eeFallbackBody.isEmpty()) {
+            writer->writeTextElement(QSL65("body"), data->e2eeFallbackBody);
         }
 
         // XEP-0280: Message Carbons
-        if (d->privatemsg) {
+        if (data->privatemsg) {
             writer->writeStartElement(QSL65("private"));
             writer->writeDefaultNamespace(toString65(ns_carbons));
             writer->writeEndElement();
@@ -1922,7 +1964,7 @@ void QXmppMessage::serializeExtensions(QXmlStreamWriter *writer, QXmpp::SceMode
         }
 
         // XEP-0359: Unique and Stable Stanza IDs
-        for (const auto &stanzaId : d->stanzaIds) {
+        for (const auto &stanzaId : data->stanzaIds) {
             writer->writeStartElement(QSL65("stanza-id"));
             writer->writeDefaultNamespace(toString65(ns_sid));
             writer->writeAttribute(QSL65("id"), stanzaId.id);
@@ -1930,35 +1972,35 @@ void QXmppMessage::serializeExtensions(QXmlStreamWriter *writer, QXmpp::SceMode
             writer->writeEndElement();
         }
 
-        if (!d->originId.isNull()) {
+        if (!data->originId.isNull()) {
             writer->writeStartElement(QSL65("origin-id"));
             writer->writeDefaultNamespace(toString65(ns_sid));
-            writer->writeAttribute(QSL65("id"), d->originId);
+            writer->writeAttribute(QSL65("id"), data->originId);
             writer->writeEndElement();
         }
 
         // XEP-0369: Mediated Information eXchange (MIX)
-        if (!d->mixUserJid.isEmpty() || !d->mixUserNick.isEmpty()) {
+        if (!data->mixUserJid.isEmpty() || !data->mixUserNick.isEmpty()) {
             writer->writeStartElement(QSL65("mix"));
             writer->writeDefaultNamespace(toString65(ns_mix));
-            writeXmlTextElement(writer, u"jid", d->mixUserJid);
-            writeXmlTextElement(writer, u"nick", d->mixUserNick);
+            writeXmlTextElement(writer, u"jid", data->mixUserJid);
+            writeXmlTextElement(writer, u"nick", data->mixUserNick);
             writer->writeEndElement();
         }
 
         // XEP-0380: Explicit Message Encryption
-        if (!d->encryptionMethod.isEmpty()) {
+        if (!data->encryptionMethod.isEmpty()) {
             writer->writeStartElement(QSL65("encryption"));
             writer->writeDefaultNamespace(toString65(ns_eme));
-            writer->writeAttribute(QSL65("namespace"), d->encryptionMethod);
+            writer->writeAttribute(QSL65("namespace"), data->encryptionMethod);
             writeOptionalXmlAttribute(writer, u"name", encryptionName());
             writer->writeEndElement();
         }
 
 #ifdef BUILD_OMEMO
         // XEP-0384: OMEMO Encryption
-        if (d->omemoElement) {
-            d->omemoElement->toXml(writer);
+        if (data->omemoElement) {
+            data->omemoElement->toXml(writer);
         }
 #endif
     }
@@ -1976,47 +2018,47 @@ void QXmppMessage::serializeExtensions(QXmlStreamWriter *writer, QXmpp::SceMode
         };
 
         // XMPP-Core
-        writeTextElement(QSL65("subject"), d->subject);
-        writeTextElement(QSL65("body"), d->body);
+        writeTextElement(QSL65("subject"), data->subject);
+        writeTextElement(QSL65("body"), data->body);
 
-        if (!d->thread.isEmpty()) {
+        if (!data->thread.isEmpty()) {
             writer->writeStartElement(QSL65("thread"));
             if (!baseNamespace.isNull()) {
                 writer->writeDefaultNamespace(baseNamespace);
             }
-            writeOptionalXmlAttribute(writer, u"parent", d->parentThread);
-            writer->writeCharacters(d->thread);
+            writeOptionalXmlAttribute(writer, u"parent", data->parentThread);
+            writer->writeCharacters(data->thread);
             writer->writeEndElement();
         }
 
         // XEP-0066: Out of Band Data
-        for (const auto &url : d->outOfBandUrls) {
+        for (const auto &url : data->outOfBandUrls) {
             url.toXml(writer);
         }
 
         // XEP-0071: XHTML-IM
-        if (!d->xhtml.isEmpty()) {
+        if (!data->xhtml.isEmpty()) {
             writer->writeStartElement(QSL65("html"));
             writer->writeDefaultNamespace(toString65(ns_xhtml_im));
             writer->writeStartElement(QSL65("body"));
             writer->writeDefaultNamespace(toString65(ns_xhtml));
             writer->writeCharacters(QString());
-            writer->device()->write(d->xhtml.toUtf8());
+            writer->device()->write(data->xhtml.toUtf8());
             writer->writeEndElement();
             writer->writeEndElement();
         }
 
         // XEP-0085: Chat State Notifications
-        if (d->state > None && d->state <= Paused) {
-            writer->writeStartElement(toString65(CHAT_STATES.at(d->state)));
+        if (data->state > None && data->state <= Paused) {
+            writer->writeStartElement(toString65(CHAT_STATES.at(data->state)));
             writer->writeDefaultNamespace(toString65(ns_chat_states));
             writer->writeEndElement();
         }
 
         // XEP-0091: Legacy Delayed Delivery | XEP-0203: Delayed Delivery
-        if (d->stamp.isValid()) {
-            QDateTime utcStamp = d->stamp.toUTC();
-            if (d->stampType == DelayedDelivery) {
+        if (data->stamp.isValid()) {
+            QDateTime utcStamp = data->stamp.toUTC();
+            if (data->stampType == DelayedDelivery) {
                 // XEP-0203: Delayed Delivery
                 writer->writeStartElement(QSL65("delay"));
                 writer->writeDefaultNamespace(toString65(ns_delayed_delivery));
@@ -2035,123 +2077,123 @@ void QXmppMessage::serializeExtensions(QXmlStreamWriter *writer, QXmpp::SceMode
         // An ack message (message containing a "received" element) must not
         // include a receipt request ("request" element) in order to prevent
         // looping.
-        if (!d->receiptId.isEmpty()) {
+        if (!data->receiptId.isEmpty()) {
             writer->writeStartElement(QSL65("received"));
             writer->writeDefaultNamespace(toString65(ns_message_receipts));
-            writer->writeAttribute(QSL65("id"), d->receiptId);
+            writer->writeAttribute(QSL65("id"), data->receiptId);
             writer->writeEndElement();
-        } else if (d->receiptRequested) {
+        } else if (data->receiptRequested) {
             writer->writeStartElement(QSL65("request"));
             writer->writeDefaultNamespace(toString65(ns_message_receipts));
             writer->writeEndElement();
         }
 
         // XEP-0224: Attention
-        if (d->attentionRequested) {
+        if (data->attentionRequested) {
             writer->writeStartElement(QSL65("attention"));
             writer->writeDefaultNamespace(toString65(ns_attention));
             writer->writeEndElement();
         }
 
         // XEP-0249: Direct MUC Invitations
-        if (!d->mucInvitationJid.isEmpty()) {
+        if (!data->mucInvitationJid.isEmpty()) {
             writer->writeStartElement(QSL65("x"));
             writer->writeDefaultNamespace(toString65(ns_conference));
-            writer->writeAttribute(QSL65("jid"), d->mucInvitationJid);
-            if (!d->mucInvitationPassword.isEmpty()) {
-                writer->writeAttribute(QSL65("password"), d->mucInvitationPassword);
+            writer->writeAttribute(QSL65("jid"), data->mucInvitationJid);
+            if (!data->mucInvitationPassword.isEmpty()) {
+                writer->writeAttribute(QSL65("password"), data->mucInvitationPassword);
             }
-            if (!d->mucInvitationReason.isEmpty()) {
-                writer->writeAttribute(QSL65("reason"), d->mucInvitationReason);
+            if (!data->mucInvitationReason.isEmpty()) {
+                writer->writeAttribute(QSL65("reason"), data->mucInvitationReason);
             }
             writer->writeEndElement();
         }
 
         // XEP-0231: Bits of Binary
-        for (const auto &data : std::as_const(d->bitsOfBinaryData)) {
+        for (const auto &data : std::as_const(data->bitsOfBinaryData)) {
             data.toXmlElementFromChild(writer);
         }
 
         // XEP-0308: Last Message Correction
-        if (!d->replaceId.isEmpty()) {
+        if (!data->replaceId.isEmpty()) {
             writer->writeStartElement(QSL65("replace"));
             writer->writeDefaultNamespace(toString65(ns_message_correct));
-            writer->writeAttribute(QSL65("id"), d->replaceId);
+            writer->writeAttribute(QSL65("id"), data->replaceId);
             writer->writeEndElement();
         }
 
         // XEP-0333: Chat Markers
-        if (d->markable) {
+        if (data->markable) {
             writer->writeStartElement(QSL65("markable"));
             writer->writeDefaultNamespace(toString65(ns_chat_markers));
             writer->writeEndElement();
         }
-        if (d->marker != NoMarker) {
-            writer->writeStartElement(toString65(MARKER_TYPES.at(d->marker)));
+        if (data->marker != NoMarker) {
+            writer->writeStartElement(toString65(MARKER_TYPES.at(data->marker)));
             writer->writeDefaultNamespace(toString65(ns_chat_markers));
-            writer->writeAttribute(QSL65("id"), d->markedId);
-            if (!d->markedThread.isNull() && !d->markedThread.isEmpty()) {
-                writer->writeAttribute(QSL65("thread"), d->markedThread);
+            writer->writeAttribute(QSL65("id"), data->markedId);
+            if (!data->markedThread.isNull() && !data->markedThread.isEmpty()) {
+                writer->writeAttribute(QSL65("thread"), data->markedThread);
             }
             writer->writeEndElement();
         }
 
         // XEP-0353: Jingle Message Initiation
-        if (d->jingleMessageInitiationElement) {
-            d->jingleMessageInitiationElement->toXml(writer);
+        if (data->jingleMessageInitiationElement) {
+            data->jingleMessageInitiationElement->toXml(writer);
         }
 
         // XEP-0367: Message Attaching
-        if (!d->attachId.isEmpty()) {
+        if (!data->attachId.isEmpty()) {
             writer->writeStartElement(QSL65("attach-to"));
             writer->writeDefaultNamespace(toString65(ns_message_attaching));
-            writer->writeAttribute(QSL65("id"), d->attachId);
+            writer->writeAttribute(QSL65("id"), data->attachId);
             writer->writeEndElement();
         }
 
         // XEP-0382: Spoiler messages
-        if (d->isSpoiler) {
+        if (data->isSpoiler) {
             writer->writeStartElement(QSL65("spoiler"));
             writer->writeDefaultNamespace(toString65(ns_spoiler));
-            writer->writeCharacters(d->spoilerHint);
+            writer->writeCharacters(data->spoilerHint);
             writer->writeEndElement();
         }
 
         // XEP-0407: Mediated Information eXchange (MIX): Miscellaneous Capabilities
-        if (d->mixInvitation) {
-            d->mixInvitation->toXml(writer);
+        if (data->mixInvitation) {
+            data->mixInvitation->toXml(writer);
         }
 
         // XEP-0434: Trust Messages (TM)
-        if (d->trustMessageElement) {
-            d->trustMessageElement->toXml(writer);
+        if (data->trustMessageElement) {
+            data->trustMessageElement->toXml(writer);
         }
 
         // XEP-0444: Message Reactions
-        if (d->reaction) {
-            d->reaction->toXml(writer);
+        if (data->reaction) {
+            data->reaction->toXml(writer);
         }
 
         // XEP-0447: Stateless file sharing
-        for (const auto &fileShare : d->sharedFiles) {
+        for (const auto &fileShare : data->sharedFiles) {
             fileShare.toXml(writer);
         }
-        for (const auto &fileSources : d->fileSourcesAttachments) {
+        for (const auto &fileSources : data->fileSourcesAttachments) {
             fileSources.toXml(writer);
         }
 
         // XEP-0461: Message Replies
-        if (d->reply) {
+        if (data->reply) {
             writer->writeStartElement(QSL65("reply"));
             writer->writeDefaultNamespace(toString65(ns_reply));
-            writeOptionalXmlAttribute(writer, u"to", d->reply->to);
-            writer->writeAttribute(QSL65("id"), d->reply->id);
+            writeOptionalXmlAttribute(writer, u"to", data->reply->to);
+            writer->writeAttribute(QSL65("id"), data->reply->id);
             writer->writeEndElement();
         }
 
         // XEP-0482: Call Invites
-        if (d->callInviteElement) {
-            d->callInviteElement->toXml(writer);
+        if (data->callInviteElement) {
+            data->callInviteElement->toXml(writer);
         }
     }
 
@@ -2160,7 +2202,7 @@ void QXmppMessage::serializeExtensions(QXmlStreamWriter *writer, QXmpp::SceMode
     // XEP-0428: Fallback Indication
     // fallback markers may be used in the private part (e.g. message replies) but also in the
     // public part (e.g. the fallback body for e2ee messages)
-    for (const auto &fallback : d->fallbackMarkers) {
+    for (const auto &fallback : data->fallbackMarkers) {
         fallback.toXml(writer);
     }
 }
@@ -323,6 +323,8 @@ public:
     std::optional<QXmppCallInviteElement> callInviteElement() const;
     void setCallInviteElement(std::optional<QXmppCallInviteElement> callInviteElement);
 
+    void parseLazily(const QDomElement &element, QXmpp::SceMode sceMode = QXmpp::SceAll);
+
     /// \cond
 #ifdef BUILD_OMEMO
     // XEP-0384: OMEMO Encryption
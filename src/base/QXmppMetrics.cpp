@@ -0,0 +1,399 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "QXmppMetrics.h"
+
+#include "StringLiterals.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <mutex>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <QHash>
+
+namespace {
+
+enum class MetricType {
+    Counter,
+    Gauge,
+    Histogram,
+};
+
+// Upper bounds of the histogram buckets (in seconds for durations), the +Inf bucket is implicit.
+constexpr std::array<double, 14> HISTOGRAM_BUCKETS = {
+    0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10
+};
+constexpr int HISTOGRAM_INF_BUCKET = HISTOGRAM_BUCKETS.size();
+constexpr int HISTOGRAM_SUM = HISTOGRAM_INF_BUCKET + 1;
+constexpr int HISTOGRAM_SLOTS = HISTOGRAM_SUM + 1;
+// Histogram sums are accumulated as integers with this resolution.
+constexpr double HISTOGRAM_SUM_SCALE = 1e6;
+
+constexpr int CHUNK_SIZE = 256;
+constexpr int MAXIMUM_CHUNKS = 256;
+
+struct Metric {
+    MetricType type;
+    int slot;
+};
+
+//
+// Values of the metrics, allocated in chunks so that existing values never move.
+//
+// A chunk is only allocated by a single thread (the owning thread or with the registry locked),
+// but values can be read from any thread at any time.
+//
+class Storage
+{
+public:
+    using Chunk = std::array<std::atomic<qint64>, CHUNK_SIZE>;
+
+    Storage() = default;
+    Storage(const Storage &) = delete;
+    ~Storage()
+    {
+        for (auto &chunk : m_chunks) {
+            delete chunk.load();
+        }
+    }
+
+    std::atomic<qint64> &slot(int index)
+    {
+        auto &chunk = m_chunks[index / CHUNK_SIZE];
+        auto *data = chunk.load(std::memory_order_acquire);
+        if (!data) {
+            data = new Chunk {};
+            chunk.store(data, std::memory_order_release);
+        }
+        return (*data)[index % CHUNK_SIZE];
+    }
+
+    qint64 value(int index) const
+    {
+        const auto *data = m_chunks[index / CHUNK_SIZE].load(std::memory_order_acquire);
+        return data ? (*data)[index % CHUNK_SIZE].load(std::memory_order_relaxed) : 0;
+    }
+
+private:
+    std::array<std::atomic<Chunk *>, MAXIMUM_CHUNKS> m_chunks = {};
+};
+
+// Metrics are looked up by the address of their name first. Names are usually string literals, so
+// this avoids hashing the name on every update. The names are kept, so their data can't be
+// reused for other strings. At most this many names are stored per thread.
+constexpr int MAXIMUM_INTERNED_NAMES = 1024;
+
+struct Registry {
+    Registry();
+    void retire(Storage *storage);
+
+    const quint64 serial;
+
+    // protects all of the following
+    mutable std::mutex mutex;
+    QHash<QString, Metric> metrics;
+    int slotCount = 0;
+    std::vector<std::unique_ptr<Storage>> threadStorages;
+    // values of the threads that have exited
+    Storage retiredValues;
+    // gauges are not accumulated, all threads write into the same storage
+    Storage gauges;
+};
+
+struct ThreadCache {
+    quint64 registrySerial;
+    std::weak_ptr<Registry> registry;
+    Storage *storage;
+    QHash<QString, Metric> metrics;
+    QHash<const QChar *, std::pair<QString, Metric>> internedMetrics;
+};
+
+//
+// Lookup tables of the registries used by the current thread.
+//
+// When the thread exits, its values are moved into the registries, so the storage of the thread
+// can be freed.
+//
+struct ThreadCaches {
+    ~ThreadCaches()
+    {
+        for (const auto &cache : caches) {
+            if (auto registry = cache.registry.lock()) {
+                registry->retire(cache.storage);
+            }
+        }
+    }
+
+    std::vector<ThreadCache> caches;
+};
+
+std::atomic<quint64> nextRegistrySerial = 1;
+
+thread_local ThreadCaches threadCaches;
+
+Registry::Registry()
+    : serial(nextRegistrySerial++)
+{
+}
+
+// Adds the values of the storage of an exiting thread to the retired values and frees it.
+void Registry::retire(Storage *storage)
+{
+    std::lock_guard lock(mutex);
+    for (int slot = 0; slot < slotCount; slot++) {
+        if (const auto value = storage->value(slot)) {
+            retiredValues.slot(slot).fetch_add(value, std::memory_order_relaxed);
+        }
+    }
+    std::erase_if(threadStorages, [=](const auto &threadStorage) { return threadStorage.get() == storage; });
+}
+
+QString prometheusName(const QString &name)
+{
+    QString result = u"qxmpp_"_s;
+    result.reserve(result.size() + name.size());
+    for (const auto c : name) {
+        const auto ch = c.unicode();
+        const bool valid = (ch >= u'a' && ch <= u'z') || (ch >= u'A' && ch <= u'Z') ||
+            (ch >= u'0' && ch <= u'9') || ch == u'_' || ch == u':';
+        result.append(valid ? c : QChar(u'_'));
+    }
+    return result;
+}
+
+}  // namespace
+
+class QXmppMetricsPrivate
+{
+public:
+    ThreadCache &threadCache();
+    std::optional<Metric> metric(ThreadCache &cache, const QString &name, MetricType type);
+    std::optional<Metric> find(const QString &name, MetricType type) const;
+    qint64 sum(int slot) const;
+
+    // shared with the threads, so they can retire their storage on exit
+    const std::shared_ptr<Registry> registry = std::make_shared<Registry>();
+};
+
+ThreadCache &QXmppMetricsPrivate::threadCache()
+{
+    auto &caches = threadCaches.caches;
+    for (auto &cache : caches) {
+        if (cache.registrySerial == registry->serial) {
+            return cache;
+        }
+    }
+
+    // the registries of the other entries may have been destroyed in the meantime
+    std::erase_if(caches, [](const auto &cache) { return cache.registry.expired(); });
+
+    std::lock_guard lock(registry->mutex);
+    auto *storage = registry->threadStorages.emplace_back(std::make_unique<Storage>()).get();
+    return caches.emplace_back(ThreadCache { registry->serial, registry, storage, {}, {} });
+}
+
+// Returns the metric from the cache of the current thread and registers it if needed.
+std::optional<Metric> QXmppMetricsPrivate::metric(ThreadCache &cache, const QString &name, MetricType type)
+{
+    auto interned = cache.internedMetrics.constFind(name.constData());
+    if (interned == cache.internedMetrics.constEnd()) {
+        auto itr = cache.metrics.constFind(name);
+        if (itr == cache.metrics.constEnd()) {
+            std::lock_guard lock(registry->mutex);
+            auto global = registry->metrics.constFind(name);
+            if (global == registry->metrics.constEnd()) {
+                const int slots = type == MetricType::Histogram ? HISTOGRAM_SLOTS : 1;
+                if (registry->slotCount + slots > CHUNK_SIZE * MAXIMUM_CHUNKS) {
+                    return {};
+                }
+                global = registry->metrics.insert(name, Metric { type, registry->slotCount });
+                registry->slotCount += slots;
+
+                // allocate while locked, so gauges can be set from any thread
+                if (type == MetricType::Gauge) {
+                    registry->gauges.slot(global->slot);
+                }
+            }
+            itr = cache.metrics.insert(name, *global);
+        }
+
+        if (cache.internedMetrics.size() >= MAXIMUM_INTERNED_NAMES) {
+            return itr->type == type ? std::optional(*itr) : std::nullopt;
+        }
+        interned = cache.internedMetrics.insert(name.constData(), { name, *itr });
+    }
+
+    // a name can only be used for one type of metric
+    const auto &metric = interned->second;
+    if (metric.type != type) {
+        return {};
+    }
+    return metric;
+}
+
+// Requires the mutex to be locked.
+std::optional<Metric> QXmppMetricsPrivate::find(const QString &name, MetricType type) const
+{
+    if (auto itr = registry->metrics.constFind(name); itr != registry->metrics.constEnd() && itr->type == type) {
+        return *itr;
+    }
+    return {};
+}
+
+// Requires the mutex to be locked.
+qint64 QXmppMetricsPrivate::sum(int slot) const
+{
+    qint64 result = registry->retiredValues.value(slot);
+    for (const auto &storage : registry->threadStorages) {
+        result += storage->value(slot);
+    }
+    return result;
+}
+
+/// Constructs an empty metrics registry.
+QXmppMetrics::QXmppMetrics()
+    : d(std::make_unique<QXmppMetricsPrivate>())
+{
+}
+
+QXmppMetrics::~QXmppMetrics() = default;
+
+///
+/// Adds \a amount to the given \a counter.
+///
+void QXmppMetrics::updateCounter(const QString &counter, qint64 amount)
+{
+    auto &cache = d->threadCache();
+    if (const auto metric = d->metric(cache, counter, MetricType::Counter)) {
+        cache.storage->slot(metric->slot).fetch_add(amount, std::memory_order_relaxed);
+    }
+}
+
+///
+/// Sets the given \a gauge to \a value.
+///
+void QXmppMetrics::setGauge(const QString &gauge, double value)
+{
+    auto &cache = d->threadCache();
+    if (const auto metric = d->metric(cache, gauge, MetricType::Gauge)) {
+        d->registry->gauges.slot(metric->slot).store(std::bit_cast<qint64>(value), std::memory_order_relaxed);
+    }
+}
+
+///
+/// Records \a value in the given \a histogram.
+///
+/// Durations should be reported in seconds.
+///
+void QXmppMetrics::updateHistogram(const QString &histogram, double value)
+{
+    auto &cache = d->threadCache();
+    if (const auto metric = d->metric(cache, histogram, MetricType::Histogram)) {
+        const auto bucket = int(std::lower_bound(HISTOGRAM_BUCKETS.cbegin(), HISTOGRAM_BUCKETS.cend(), value) - HISTOGRAM_BUCKETS.cbegin());
+        cache.storage->slot(metric->slot + bucket).fetch_add(1, std::memory_order_relaxed);
+        cache.storage->slot(metric->slot + HISTOGRAM_SUM).fetch_add(std::llround(value * HISTOGRAM_SUM_SCALE), std::memory_order_relaxed);
+    }
+}
+
+///
+/// Returns the current value of the given \a counter.
+///
+qint64 QXmppMetrics::counter(const QString &counter) const
+{
+    std::lock_guard lock(d->registry->mutex);
+    if (const auto metric = d->find(counter, MetricType::Counter)) {
+        return d->sum(metric->slot);
+    }
+    return 0;
+}
+
+///
+/// Returns the current value of the given \a gauge.
+///
+double QXmppMetrics::gauge(const QString &gauge) const
+{
+    std::lock_guard lock(d->registry->mutex);
+    if (const auto metric = d->find(gauge, MetricType::Gauge)) {
+        return std::bit_cast<double>(d->registry->gauges.value(metric->slot));
+    }
+    return 0;
+}
+
+///
+/// Returns the number of values recorded in the given \a histogram.
+///
+quint64 QXmppMetrics::histogramCount(const QString &histogram) const
+{
+    std::lock_guard lock(d->registry->mutex);
+    quint64 count = 0;
+    if (const auto metric = d->find(histogram, MetricType::Histogram)) {
+        for (int bucket = 0; bucket <= HISTOGRAM_INF_BUCKET; bucket++) {
+            count += d->sum(metric->slot + bucket);
+        }
+    }
+    return count;
+}
+
+///
+/// Returns the sum of the values recorded in the given \a histogram.
+///
+double QXmppMetrics::histogramSum(const QString &histogram) const
+{
+    std::lock_guard lock(d->registry->mutex);
+    if (const auto metric = d->find(histogram, MetricType::Histogram)) {
+        return d->sum(metric->slot + HISTOGRAM_SUM) / HISTOGRAM_SUM_SCALE;
+    }
+    return 0;
+}
+
+///
+/// Renders a snapshot of all metrics in the Prometheus text exposition format.
+///
+/// Metric names are prefixed with "qxmpp_" and all characters that are not allowed are replaced
+/// by underscores, e.g. "socket.written-bytes" becomes "qxmpp_socket_written_bytes_total".
+///
+QString QXmppMetrics::toPrometheusText() const
+{
+    std::lock_guard lock(d->registry->mutex);
+
+    auto names = d->registry->metrics.keys();
+    std::sort(names.begin(), names.end());
+
+    QString text;
+    for (const auto &name : std::as_const(names)) {
+        const auto metric = d->registry->metrics.value(name);
+        const auto id = prometheusName(name);
+
+        switch (metric.type) {
+        case MetricType::Counter:
+            text += u"# TYPE " + id + u"_total counter\n" +
+                id + u"_total " + QString::number(d->sum(metric.slot)) + u'\n';
+            break;
+        case MetricType::Gauge:
+            text += u"# TYPE " + id + u" gauge\n" +
+                id + u' ' + QString::number(std::bit_cast<double>(d->registry->gauges.value(metric.slot)), 'g', 12) + u'\n';
+            break;
+        case MetricType::Histogram: {
+            text += u"# TYPE " + id + u" histogram\n";
+            qint64 count = 0;
+            for (int bucket = 0; bucket <= HISTOGRAM_INF_BUCKET; bucket++) {
+                count += d->sum(metric.slot + bucket);
+                const auto bound = bucket < HISTOGRAM_INF_BUCKET ? QString::number(HISTOGRAM_BUCKETS[bucket]) : u"+Inf"_s;
+                text += id + u"_bucket{le=\"" + bound + u"\"} " + QString::number(count) + u'\n';
+            }
+            text += id + u"_sum " + QString::number(d->sum(metric.slot + HISTOGRAM_SUM) / HISTOGRAM_SUM_SCALE, 'g', 12) + u'\n' +
+                id + u"_count " + QString::number(count) + u'\n';
+            break;
+        }
+        }
+    }
+    return text;
+}
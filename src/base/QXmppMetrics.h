@@ -0,0 +1,54 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef QXMPPMETRICS_H
+#define QXMPPMETRICS_H
+
+#include "QXmppGlobal.h"
+
+#include <memory>
+
+#include <QString>
+
+class QXmppMetricsPrivate;
+
+///
+/// \brief The QXmppMetrics class collects counters, gauges and histograms.
+///
+/// Metrics are identified by their name, e.g. "socket.written-bytes", and are created on first
+/// use. Counters are summed up, gauges keep the last value set and histograms count the values
+/// in buckets that are suitable for durations in seconds (0.5 ms up to 10 s).
+///
+/// All functions are thread-safe. Each thread accumulates into its own storage without locking,
+/// only the first use of a metric in a thread requires a lock.
+///
+/// QXmppLogger records all metrics reported via QXmppLoggable into an instance of this class if
+/// enabled, see QXmppLogger::setMetricsEnabled() and QXmppLogger::metrics().
+///
+/// \ingroup Core
+///
+/// \since QXmpp 1.11
+///
+class QXMPP_EXPORT QXmppMetrics
+{
+public:
+    QXmppMetrics();
+    ~QXmppMetrics();
+
+    void updateCounter(const QString &counter, qint64 amount = 1);
+    void setGauge(const QString &gauge, double value);
+    void updateHistogram(const QString &histogram, double value);
+
+    qint64 counter(const QString &counter) const;
+    double gauge(const QString &gauge) const;
+    quint64 histogramCount(const QString &histogram) const;
+    double histogramSum(const QString &histogram) const;
+
+    QString toPrometheusText() const;
+
+private:
+    const std::unique_ptr<QXmppMetricsPrivate> d;
+};
+
+#endif  // QXMPPMETRICS_H
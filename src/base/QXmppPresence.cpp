@@ -189,7 +189,7 @@ void QXmppPresence::setType(QXmppPresence::Type type)
 /// Returns the photo-hash of the VCardUpdate.
 QByteArray QXmppPresence::photoHash() const
 {
-    return d->photoHash;
+    return parsed(d)->photoHash;
 }
 
 ///
@@ -199,61 +199,61 @@ QByteArray QXmppPresence::photoHash() const
 ///
 void QXmppPresence::setPhotoHash(const QByteArray &photoHash)
 {
-    d->photoHash = photoHash;
+    parsed(d)->photoHash = photoHash;
 }
 
 /// Returns the type of VCardUpdate
 QXmppPresence::VCardUpdateType QXmppPresence::vCardUpdateType() const
 {
-    return d->vCardUpdateType;
+    return parsed(d)->vCardUpdateType;
 }
 
 /// Sets the type of VCardUpdate
 void QXmppPresence::setVCardUpdateType(VCardUpdateType type)
 {
-    d->vCardUpdateType = type;
+    parsed(d)->vCardUpdateType = type;
 }
 
 /// \xep{0115}: Entity Capabilities
 QString QXmppPresence::capabilityHash() const
 {
-    return d->capabilityHash;
+    return parsed(d)->capabilityHash;
 }
 
 /// \xep{0115}: Entity Capabilities
 void QXmppPresence::setCapabilityHash(const QString &hash)
 {
-    d->capabilityHash = hash;
+    parsed(d)->capabilityHash = hash;
 }
 
 /// \xep{0115}: Entity Capabilities
 QString QXmppPresence::capabilityNode() const
 {
-    return d->capabilityNode;
+    return parsed(d)->capabilityNode;
 }
 
 /// \xep{0115}: Entity Capabilities
 void QXmppPresence::setCapabilityNode(const QString &node)
 {
-    d->capabilityNode = node;
+    parsed(d)->capabilityNode = node;
 }
 
 /// \xep{0115}: Entity Capabilities
 QByteArray QXmppPresence::capabilityVer() const
 {
-    return d->capabilityVer;
+    return parsed(d)->capabilityVer;
 }
 
 /// \xep{0115}: Entity Capabilities
 void QXmppPresence::setCapabilityVer(const QByteArray &ver)
 {
-    d->capabilityVer = ver;
+    parsed(d)->capabilityVer = ver;
 }
 
 /// Legacy \xep{0115}: Entity Capabilities
 QStringList QXmppPresence::capabilityExt() const
 {
-    return d->capabilityExt;
+    return parsed(d)->capabilityExt;
 }
 
 ///
@@ -265,7 +265,7 @@ QStringList QXmppPresence::capabilityExt() const
 ///
 bool QXmppPresence::isPreparingMujiSession() const
 {
-    return d->isPreparingMujiSession;
+    return parsed(d)->isPreparingMujiSession;
 }
 
 ///
@@ -277,7 +277,7 @@ bool QXmppPresence::isPreparingMujiSession() const
 ///
 void QXmppPresence::setIsPreparingMujiSession(bool isPreparingMujiSession)
 {
-    d->isPreparingMujiSession = isPreparingMujiSession;
+    parsed(d)->isPreparingMujiSession = isPreparingMujiSession;
 }
 
 ///
@@ -289,7 +289,7 @@ void QXmppPresence::setIsPreparingMujiSession(bool isPreparingMujiSession)
 ///
 QVector<QXmppJingleIq::Content> QXmppPresence::mujiContents() const
 {
-    return d->mujiContents;
+    return parsed(d)->mujiContents;
 }
 
 ///
@@ -301,55 +301,55 @@ QVector<QXmppJingleIq::Content> QXmppPresence::mujiContents() const
 ///
 void QXmppPresence::setMujiContents(const QVector<QXmppJingleIq::Content> &mujiContents)
 {
-    d->mujiContents = mujiContents;
+    parsed(d)->mujiContents = mujiContents;
 }
 
 /// Returns the MUC item.
 QXmppMucItem QXmppPresence::mucItem() const
 {
-    return d->mucItem;
+    return parsed(d)->mucItem;
 }
 
 /// Sets the MUC item.
 void QXmppPresence::setMucItem(const QXmppMucItem &item)
 {
-    d->mucItem = item;
+    parsed(d)->mucItem = item;
 }
 
 /// Returns the password used to join a MUC room.
 QString QXmppPresence::mucPassword() const
 {
-    return d->mucPassword;
+    return parsed(d)->mucPassword;
 }
 
 /// Sets the password used to join a MUC room.
 void QXmppPresence::setMucPassword(const QString &password)
 {
-    d->mucPassword = password;
+    parsed(d)->mucPassword = password;
 }
 
 /// Returns the MUC status codes.
 QList<int> QXmppPresence::mucStatusCodes() const
 {
-    return d->mucStatusCodes;
+    return parsed(d)->mucStatusCodes;
 }
 
 /// Sets the MUC status codes.
 void QXmppPresence::setMucStatusCodes(const QList<int> &codes)
 {
-    d->mucStatusCodes = codes;
+    parsed(d)->mucStatusCodes = codes;
 }
 
 /// Returns true if the sender has indicated MUC support.
 bool QXmppPresence::isMucSupported() const
 {
-    return d->mucSupported;
+    return parsed(d)->mucSupported;
 }
 
 /// Sets whether MUC is \a supported.
 void QXmppPresence::setMucSupported(bool supported)
 {
-    d->mucSupported = supported;
+    parsed(d)->mucSupported = supported;
 }
 
 ///
@@ -359,7 +359,7 @@ void QXmppPresence::setMucSupported(bool supported)
 ///
 QString QXmppPresence::oldJid() const
 {
-    return d->oldJid;
+    return parsed(d)->oldJid;
 }
 
 ///
@@ -369,7 +369,7 @@ QString QXmppPresence::oldJid() const
 ///
 void QXmppPresence::setOldJid(const QString &oldJid)
 {
-    d->oldJid = oldJid;
+    parsed(d)->oldJid = oldJid;
 }
 
 ///
@@ -380,7 +380,7 @@ void QXmppPresence::setOldJid(const QString &oldJid)
 ///
 QDateTime QXmppPresence::lastUserInteraction() const
 {
-    return d->lastUserInteraction;
+    return parsed(d)->lastUserInteraction;
 }
 
 ///
@@ -391,7 +391,7 @@ QDateTime QXmppPresence::lastUserInteraction() const
 ///
 void QXmppPresence::setLastUserInteraction(const QDateTime &lastUserInteraction)
 {
-    d->lastUserInteraction = lastUserInteraction;
+    parsed(d)->lastUserInteraction = lastUserInteraction;
 }
 
 ///
@@ -401,7 +401,7 @@ void QXmppPresence::setLastUserInteraction(const QDateTime &lastUserInteraction)
 ///
 QString QXmppPresence::mixUserJid() const
 {
-    return d->mixUserJid;
+    return parsed(d)->mixUserJid;
 }
 
 ///
@@ -411,7 +411,7 @@ QString QXmppPresence::mixUserJid() const
 ///
 void QXmppPresence::setMixUserJid(const QString &mixUserJid)
 {
-    d->mixUserJid = mixUserJid;
+    parsed(d)->mixUserJid = mixUserJid;
 }
 
 ///
@@ -421,7 +421,7 @@ void QXmppPresence::setMixUserJid(const QString &mixUserJid)
 ///
 QString QXmppPresence::mixUserNick() const
 {
-    return d->mixUserNick;
+    return parsed(d)->mixUserNick;
 }
 
 ///
@@ -431,11 +431,40 @@ QString QXmppPresence::mixUserNick() const
 ///
 void QXmppPresence::setMixUserNick(const QString &mixUserNick)
 {
-    d->mixUserNick = mixUserNick;
+    parsed(d)->mixUserNick = mixUserNick;
 }
 
 /// \cond
 void QXmppPresence::parse(const QDomElement &element)
+{
+    parseCore(element);
+    parseExtensions(element);
+}
+/// \endcond
+
+///
+/// Parses the presence with deferred parsing of its extensions.
+///
+/// Only the stanza attributes, the type, show, status and priority are parsed directly. All other
+/// child elements (e.g. MUC, entity capabilities or vCard updates) are parsed on the first access
+/// to one of them.
+///
+/// The presence keeps a reference to \a element (and its DOM document) until its extensions have
+/// been parsed. Copying the presence parses the extensions, concurrent reads of the same object are
+/// synchronized.
+///
+/// \since QXmpp 1.11
+///
+void QXmppPresence::parseLazily(const QDomElement &element)
+{
+    parseCore(element);
+    deferExtensionParsing(element, QXmpp::SceAll, [](QXmppStanza *stanza, const QDomElement &element, QXmpp::SceMode) {
+        static_cast<QXmppPresence *>(stanza)->parseExtensions(element);
+    });
+}
+
+/// \cond
+void QXmppPresence::parseCore(const QDomElement &element)
 {
     QXmppStanza::parse(element);
 
@@ -443,7 +472,6 @@ void QXmppPresence::parse(const QDomElement &element)
     d->type = enumFromString<Type>(PRESENCE_TYPES, element.attribute(u"type"_s))
                   .value_or(Available);
 
-    QXmppElementList unknownElements;
     for (const auto &childElement : iterChildElements(element)) {
         if (childElement.tagName() == u"show") {
             d->availableStatusType = enumFromString<AvailableStatusType>(AVAILABLE_STATUS_TYPES, childElement.text())
@@ -452,10 +480,19 @@ void QXmppPresence::parse(const QDomElement &element)
             d->statusText = childElement.text();
         } else if (childElement.tagName() == u"priority") {
             d->priority = childElement.text().toInt();
-            // parse presence extensions
-            // XEP-0033: Extended Stanza Addressing and errors are parsed by QXmppStanza
-        } else if (!(childElement.tagName() == u"addresses" && childElement.namespaceURI() == ns_extended_addressing) &&
-                   childElement.tagName() != u"error") {
+        }
+    }
+}
+
+void QXmppPresence::parseExtensions(const QDomElement &element)
+{
+    QXmppElementList unknownElements;
+    for (const auto &childElement : iterChildElements(element)) {
+        const auto tagName = childElement.tagName();
+        // XEP-0033: Extended Stanza Addressing and errors are parsed by QXmppStanza
+        if (tagName != u"show" && tagName != u"status" && tagName != u"priority" &&
+            !(tagName == u"addresses" && childElement.namespaceURI() == ns_extended_addressing) &&
+            tagName != u"error") {
             parseExtension(childElement, unknownElements);
         }
     }
@@ -527,38 +564,39 @@ void QXmppPresence::parseExtension(const QDomElement &element, QXmppElementList
 
 void QXmppPresence::toXml(QXmlStreamWriter *xmlWriter) const
 {
+    auto *data = parsed(d);
     xmlWriter->writeStartElement(QSL65("presence"));
     writeOptionalXmlAttribute(xmlWriter, u"xml:lang", lang());
     writeOptionalXmlAttribute(xmlWriter, u"id", id());
     writeOptionalXmlAttribute(xmlWriter, u"to", to());
     writeOptionalXmlAttribute(xmlWriter, u"from", from());
-    writeOptionalXmlAttribute(xmlWriter, u"type", PRESENCE_TYPES.at(d->type));
+    writeOptionalXmlAttribute(xmlWriter, u"type", PRESENCE_TYPES.at(data->type));
 
-    writeOptionalXmlTextElement(xmlWriter, u"show", AVAILABLE_STATUS_TYPES.at(size_t(d->availableStatusType)));
-    writeOptionalXmlTextElement(xmlWriter, u"status", d->statusText);
-    if (d->priority != 0) {
-        writeXmlTextElement(xmlWriter, u"priority", QString::number(d->priority));
+    writeOptionalXmlTextElement(xmlWriter, u"show", AVAILABLE_STATUS_TYPES.at(size_t(data->availableStatusType)));
+    writeOptionalXmlTextElement(xmlWriter, u"status", data->statusText);
+    if (data->priority != 0) {
+        writeXmlTextElement(xmlWriter, u"priority", QString::number(data->priority));
     }
 
     error().toXml(xmlWriter);
 
     // XEP-0045: Multi-User Chat
-    if (d->mucSupported) {
+    if (data->mucSupported) {
         xmlWriter->writeStartElement(QSL65("x"));
         xmlWriter->writeDefaultNamespace(toString65(ns_muc));
-        if (!d->mucPassword.isEmpty()) {
-            xmlWriter->writeTextElement(QSL65("password"), d->mucPassword);
+        if (!data->mucPassword.isEmpty()) {
+            xmlWriter->writeTextElement(QSL65("password"), data->mucPassword);
         }
         xmlWriter->writeEndElement();
     }
 
-    if (!d->mucItem.isNull() || !d->mucStatusCodes.isEmpty()) {
+    if (!data->mucItem.isNull() || !data->mucStatusCodes.isEmpty()) {
         xmlWriter->writeStartElement(QSL65("x"));
         xmlWriter->writeDefaultNamespace(toString65(ns_muc_user));
-        if (!d->mucItem.isNull()) {
-            d->mucItem.toXml(xmlWriter);
+        if (!data->mucItem.isNull()) {
+            data->mucItem.toXml(xmlWriter);
         }
-        for (const auto code : d->mucStatusCodes) {
+        for (const auto code : data->mucStatusCodes) {
             xmlWriter->writeStartElement(QSL65("status"));
             xmlWriter->writeAttribute(QSL65("code"), QString::number(code));
             xmlWriter->writeEndElement();
@@ -567,27 +605,27 @@ void QXmppPresence::toXml(QXmlStreamWriter *xmlWriter) const
     }
 
     // XEP-0115: Entity Capabilities
-    if (!d->capabilityNode.isEmpty() &&
-        !d->capabilityVer.isEmpty() &&
-        !d->capabilityHash.isEmpty()) {
+    if (!data->capabilityNode.isEmpty() &&
+        !data->capabilityVer.isEmpty() &&
+        !data->capabilityHash.isEmpty()) {
         xmlWriter->writeStartElement(QSL65("c"));
         xmlWriter->writeDefaultNamespace(toString65(ns_capabilities));
-        writeOptionalXmlAttribute(xmlWriter, u"hash", d->capabilityHash);
-        writeOptionalXmlAttribute(xmlWriter, u"node", d->capabilityNode);
-        writeOptionalXmlAttribute(xmlWriter, u"ver", QString::fromUtf8(d->capabilityVer.toBase64()));
+        writeOptionalXmlAttribute(xmlWriter, u"hash", data->capabilityHash);
+        writeOptionalXmlAttribute(xmlWriter, u"node", data->capabilityNode);
+        writeOptionalXmlAttribute(xmlWriter, u"ver", QString::fromUtf8(data->capabilityVer.toBase64()));
         xmlWriter->writeEndElement();
     }
 
     // XEP-0153: vCard-Based Avatars
-    if (d->vCardUpdateType != VCardUpdateNone) {
+    if (data->vCardUpdateType != VCardUpdateNone) {
         xmlWriter->writeStartElement(QSL65("x"));
         xmlWriter->writeDefaultNamespace(toString65(ns_vcard_update));
-        switch (d->vCardUpdateType) {
+        switch (data->vCardUpdateType) {
         case VCardUpdateNoPhoto:
             xmlWriter->writeEmptyElement(u"photo"_s);
             break;
         case VCardUpdateValidPhoto:
-            writeXmlTextElement(xmlWriter, u"photo", QString::fromUtf8(d->photoHash.toHex()));
+            writeXmlTextElement(xmlWriter, u"photo", QString::fromUtf8(data->photoHash.toHex()));
             break;
         default:
             break;
@@ -596,15 +634,15 @@ void QXmppPresence::toXml(QXmlStreamWriter *xmlWriter) const
     }
 
     // XEP-0272: Multiparty Jingle (Muji)
-    if (d->isPreparingMujiSession || !d->mujiContents.isEmpty()) {
+    if (data->isPreparingMujiSession || !data->mujiContents.isEmpty()) {
         xmlWriter->writeStartElement(QSL65("muji"));
         xmlWriter->writeDefaultNamespace(toString65(ns_muji));
 
-        if (d->isPreparingMujiSession) {
+        if (data->isPreparingMujiSession) {
             xmlWriter->writeEmptyElement(u"preparing"_s);
         }
 
-        for (const auto &mujiContent : d->mujiContents) {
+        for (const auto &mujiContent : data->mujiContents) {
             mujiContent.toXml(xmlWriter);
         }
 
@@ -612,30 +650,30 @@ void QXmppPresence::toXml(QXmlStreamWriter *xmlWriter) const
     }
 
     // XEP-0283: Moved
-    if (!d->oldJid.isEmpty()) {
+    if (!data->oldJid.isEmpty()) {
         xmlWriter->writeStartElement(QSL65("moved"));
         xmlWriter->writeDefaultNamespace(ns_moved.toString());
-        writeXmlTextElement(xmlWriter, u"old-jid", d->oldJid);
+        writeXmlTextElement(xmlWriter, u"old-jid", data->oldJid);
         xmlWriter->writeEndElement();
     }
 
     // XEP-0319: Last User Interaction in Presence
-    if (!d->lastUserInteraction.isNull() && d->lastUserInteraction.isValid()) {
+    if (!data->lastUserInteraction.isNull() && data->lastUserInteraction.isValid()) {
         xmlWriter->writeStartElement(QSL65("idle"));
         xmlWriter->writeDefaultNamespace(toString65(ns_idle));
-        writeOptionalXmlAttribute(xmlWriter, u"since", QXmppUtils::datetimeToString(d->lastUserInteraction));
+        writeOptionalXmlAttribute(xmlWriter, u"since", QXmppUtils::datetimeToString(data->lastUserInteraction));
         xmlWriter->writeEndElement();
     }
 
     // XEP-0405: Mediated Information eXchange (MIX): Participant Server Requirements
-    if (!d->mixUserJid.isEmpty() || !d->mixUserNick.isEmpty()) {
+    if (!data->mixUserJid.isEmpty() || !data->mixUserNick.isEmpty()) {
         xmlWriter->writeStartElement(QSL65("mix"));
         xmlWriter->writeDefaultNamespace(toString65(ns_mix_presence));
-        if (!d->mixUserJid.isEmpty()) {
-            writeXmlTextElement(xmlWriter, u"jid", d->mixUserJid);
+        if (!data->mixUserJid.isEmpty()) {
+            writeXmlTextElement(xmlWriter, u"jid", data->mixUserJid);
         }
-        if (!d->mixUserNick.isEmpty()) {
-            writeXmlTextElement(xmlWriter, u"nick", d->mixUserNick);
+        if (!data->mixUserNick.isEmpty()) {
+            writeXmlTextElement(xmlWriter, u"nick", data->mixUserNick);
         }
         xmlWriter->writeEndElement();
     }
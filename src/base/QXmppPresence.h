@@ -131,6 +131,8 @@ public:
     QString mixUserNick() const;
     void setMixUserNick(const QString &);
 
+    void parseLazily(const QDomElement &element);
+
     /// \cond
     void parse(const QDomElement &element) override;
     void toXml(QXmlStreamWriter *writer) const override;
@@ -138,6 +140,8 @@ public:
 
 private:
     /// \cond
+    void parseCore(const QDomElement &element);
+    void parseExtensions(const QDomElement &element);
     void parseExtension(const QDomElement &element, QXmppElementList &unknownElements);
     /// \endcond
 
@@ -8,6 +8,10 @@
 
 #include "QXmppTask.h"
 
+#ifdef QXMPP_TASK_COROUTINES
+#include <exception>
+#endif
+
 ///
 /// \brief Create and update QXmppTask objects to communicate results of asynchronous operations.
 ///
@@ -26,16 +30,37 @@ class QXmppPromise
 public:
     template<typename U = T, std::enable_if_t<std::is_void_v<U>> * = nullptr>
     QXmppPromise()
-        : d(QXmpp::Private::TaskPrivate(nullptr))
+        : d(0, 0, nullptr)
     {
+        d.addPromise();
     }
 
     template<typename U = T, std::enable_if_t<!std::is_void_v<U>> * = nullptr>
     QXmppPromise()
-        : d(QXmpp::Private::TaskPrivate([](void *r) { delete static_cast<T *>(r); }))
+        : d(sizeof(T), alignof(T), [](void *r) { static_cast<T *>(r)->~T(); })
+    {
+        d.addPromise();
+    }
+
+    /// \cond
+    QXmppPromise(const QXmppPromise &other)
+        : d(other.d)
     {
+        d.addPromise();
     }
 
+    QXmppPromise &operator=(const QXmppPromise &other)
+    {
+        auto old = std::exchange(d, other.d);
+        d.addPromise();
+        old.removePromise();
+        return *this;
+    }
+
+    // a coroutine awaiting the task is destroyed if the last promise is destroyed unfinished
+    ~QXmppPromise() { d.removePromise(); }
+    /// \endcond
+
     ///
     /// Report that the asynchronous operation has finished, and call the connected handler of the
     /// QXmppTask<T> belonging to this promise.
@@ -51,12 +76,10 @@ public:
     {
         Q_ASSERT(!d.isFinished());
         d.setFinished(true);
-        if (d.continuation()) {
-            if (d.isContextAlive()) {
-                d.invokeContinuation(&value);
-            }
+        if (d.hasContinuation()) {
+            d.invokeContinuation(&value);
         } else {
-            d.setResult(new U(std::move(value)));
+            d.setResult(new (d.resultStorage()) U(std::move(value)));
         }
     }
 
@@ -66,13 +89,11 @@ public:
     {
         Q_ASSERT(!d.isFinished());
         d.setFinished(true);
-        if (d.continuation()) {
-            if (d.isContextAlive()) {
-                T convertedValue { std::move(value) };
-                d.invokeContinuation(&convertedValue);
-            }
+        if (d.hasContinuation()) {
+            T convertedValue { std::move(value) };
+            d.invokeContinuation(&convertedValue);
         } else {
-            d.setResult(new T(std::move(value)));
+            d.setResult(new (d.resultStorage()) T(std::move(value)));
         }
     }
 
@@ -81,10 +102,8 @@ public:
     {
         Q_ASSERT(!d.isFinished());
         d.setFinished(true);
-        if (d.continuation()) {
-            if (d.isContextAlive()) {
-                d.invokeContinuation(nullptr);
-            }
+        if (d.hasContinuation()) {
+            d.invokeContinuation(nullptr);
         }
     }
     /// \endcond
@@ -102,4 +121,31 @@ private:
     QXmpp::Private::TaskPrivate d;
 };
 
+#if defined(QXMPP_TASK_COROUTINES) && !defined(QXMPP_DOC)
+namespace QXmpp::Private {
+
+// Coroutines returning QXmppTask start immediately and free their frame when they are done.
+template<typename T>
+struct TaskCoroutinePromiseBase {
+    QXmppPromise<T> p;
+
+    QXmppTask<T> get_return_object() { return p.task(); }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void unhandled_exception() { std::terminate(); }
+};
+
+template<typename T>
+struct TaskCoroutinePromise : TaskCoroutinePromiseBase<T> {
+    void return_value(T value) { this->p.finish(std::move(value)); }
+};
+
+template<>
+struct TaskCoroutinePromise<void> : TaskCoroutinePromiseBase<void> {
+    void return_void() { p.finish(); }
+};
+
+}  // namespace QXmpp::Private
+#endif
+
 #endif  // QXMPPPROMISE_H
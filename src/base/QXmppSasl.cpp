@@ -14,6 +14,8 @@
 #include "Algorithms.h"
 #include "StringLiterals.h"
 
+#include <algorithm>
+
 #include <QDomElement>
 #include <QMessageAuthenticationCode>
 #include <QPasswordDigestor>
@@ -186,16 +188,25 @@ void Response::toXml(QXmlStreamWriter *writer) const
 
 std::optional<Success> Success::fromDom(const QDomElement &el)
 {
-    if (el.tagName() == u"success" && el.namespaceURI() == ns_sasl) {
-        return Success();
+    if (el.tagName() != u"success" || el.namespaceURI() != ns_sasl) {
+        return {};
     }
-    return {};
+
+    // additional data with the outcome (RFC 6120, section 6.3.10)
+    Success success;
+    if (const auto text = el.text(); !text.isEmpty()) {
+        success.additionalData = parseBase64(text);
+    }
+    return success;
 }
 
 void Success::toXml(QXmlStreamWriter *writer) const
 {
     writer->writeStartElement(QSL65("success"));
     writer->writeDefaultNamespace(toString65(ns_sasl));
+    if (additionalData) {
+        writer->writeCharacters(serializeBase64(*additionalData));
+    }
     writer->writeEndElement();
 }
 
@@ -846,6 +857,37 @@ void HtToken::toXml(QXmlStreamWriter &w) const
     w.writeEndElement();
 }
 
+std::optional<ScramKeys> ScramKeys::fromXml(QXmlStreamReader &r)
+{
+    if (r.name() != u"scram-keys" || r.namespaceUri() != ns_qxmpp_credentials) {
+        return {};
+    }
+    const auto &attrs = r.attributes();
+    auto mechanism = SaslScramMechanism::fromString(attrs.value("mechanism"_L1));
+    auto keys = ScramKeys {
+        mechanism.value_or(SaslScramMechanism { SaslScramMechanism::Sha1 }),
+        QByteArray::fromBase64(attrs.value("salt"_L1).toLatin1()),
+        attrs.value("iterations"_L1).toInt(),
+        QByteArray::fromBase64(attrs.value("client-key"_L1).toLatin1()),
+        QByteArray::fromBase64(attrs.value("server-key"_L1).toLatin1()),
+    };
+    if (!mechanism || keys.salt.isEmpty() || keys.iterations < 1 || keys.clientKey.isEmpty() || keys.serverKey.isEmpty()) {
+        return {};
+    }
+    return keys;
+}
+
+void ScramKeys::toXml(QXmlStreamWriter &w) const
+{
+    w.writeStartElement(QSL65("scram-keys"));
+    w.writeAttribute(QSL65("mechanism"), mechanism.toString());
+    w.writeAttribute(QSL65("salt"), QString::fromLatin1(salt.toBase64()));
+    w.writeAttribute(QSL65("iterations"), QString::number(iterations));
+    w.writeAttribute(QSL65("client-key"), QString::fromLatin1(clientKey.toBase64()));
+    w.writeAttribute(QSL65("server-key"), QString::fromLatin1(serverKey.toBase64()));
+    w.writeEndElement();
+}
+
 }  // namespace QXmpp::Private
 
 ///
@@ -972,7 +1014,14 @@ bool QXmppSaslClient::isMechanismAvailable(SaslMechanism mechanism, const Creden
                     credentials.htToken->mechanism == ht &&
                     ht.channelBindingType == SaslHtMechanism::None;
             },
-            [&](std::variant<SaslScramMechanism, SaslDigestMd5Mechanism, SaslPlainMechanism>) {
+            [&](SaslScramMechanism scram) {
+                // keys derived from the password are enough
+                return !credentials.password.isEmpty() ||
+                    std::any_of(credentials.scramKeys.cbegin(), credentials.scramKeys.cend(), [&](const auto &keys) {
+                        return keys.mechanism == scram;
+                    });
+            },
+            [&](std::variant<SaslDigestMd5Mechanism, SaslPlainMechanism>) {
                 return !credentials.password.isEmpty();
             },
             [&](SaslXFacebookMechanism) {
@@ -1219,6 +1268,7 @@ QXmppSaslClientScram::QXmppSaslClientScram(SaslScramMechanism mechanism, QObject
 void QXmppSaslClientScram::setCredentials(const QXmpp::Private::Credentials &credentials)
 {
     m_password = credentials.password;
+    m_storedKeys = credentials.scramKeys;
 }
 
 std::optional<QByteArray> QXmppSaslClientScram::respond(const QByteArray &challenge)
@@ -1239,26 +1289,41 @@ std::optional<QByteArray> QXmppSaslClientScram::respond(const QByteArray &challe
             return {};
         }
 
+        // derive keys from the password (expensive) if no stored keys match the salt and the
+        // iteration count of the server
+        QByteArray clientKey, serverKey;
+        const auto stored = std::find_if(m_storedKeys.cbegin(), m_storedKeys.cend(), [&](const ScramKeys &keys) {
+            return keys.mechanism == m_mechanism && keys.salt == salt && keys.iterations == iterations;
+        });
+        if (stored != m_storedKeys.cend()) {
+            clientKey = stored->clientKey;
+            serverKey = stored->serverKey;
+        } else if (!m_password.isEmpty()) {
+            const QByteArray saltedPassword = QPasswordDigestor::deriveKeyPbkdf2(
+                m_mechanism.qtAlgorithm(), m_password.toUtf8(), salt, iterations, m_dklen);
+            clientKey = QMessageAuthenticationCode::hash(QByteArrayLiteral("Client Key"), saltedPassword, m_mechanism.qtAlgorithm());
+            serverKey = QMessageAuthenticationCode::hash(QByteArrayLiteral("Server Key"), saltedPassword, m_mechanism.qtAlgorithm());
+            m_derivedKeys = ScramKeys { m_mechanism, salt, iterations, clientKey, serverKey };
+        } else {
+            warning(u"QXmppSaslClientScram : No password and no stored keys for the salt and iteration count of the server"_s);
+            return {};
+        }
+
         // calculate proofs
         const QByteArray clientFinalMessageBare = QByteArrayLiteral("c=") + m_gs2Header.toBase64() + QByteArrayLiteral(",r=") + nonce;
-        const QByteArray saltedPassword = QPasswordDigestor::deriveKeyPbkdf2(
-            m_mechanism.qtAlgorithm(), m_password.toUtf8(), salt, iterations, m_dklen);
-        const QByteArray clientKey = QMessageAuthenticationCode::hash(QByteArrayLiteral("Client Key"), saltedPassword, m_mechanism.qtAlgorithm());
         const QByteArray storedKey = QCryptographicHash::hash(clientKey, m_mechanism.qtAlgorithm());
         const QByteArray authMessage = m_clientFirstMessageBare + QByteArrayLiteral(",") + challenge + QByteArrayLiteral(",") + clientFinalMessageBare;
         QByteArray clientProof = QMessageAuthenticationCode::hash(authMessage, storedKey, m_mechanism.qtAlgorithm());
         std::transform(clientProof.cbegin(), clientProof.cend(), clientKey.cbegin(),
                        clientProof.begin(), std::bit_xor<char>());
 
-        const QByteArray serverKey = QMessageAuthenticationCode::hash(QByteArrayLiteral("Server Key"), saltedPassword, m_mechanism.qtAlgorithm());
         m_serverSignature = QMessageAuthenticationCode::hash(authMessage, serverKey, m_mechanism.qtAlgorithm());
 
         m_step++;
         return clientFinalMessageBare + QByteArrayLiteral(",p=") + clientProof.toBase64();
     } else if (m_step == 2) {
-        const QMap<char, QByteArray> input = parseGS2(challenge);
         m_step++;
-        if (QByteArray::fromBase64(input.value('v')) == m_serverSignature) {
+        if (verifyServerSignature(challenge)) {
             return QByteArray();
         }
         return {};
@@ -1268,6 +1333,38 @@ std::optional<QByteArray> QXmppSaslClientScram::respond(const QByteArray &challe
     }
 }
 
+bool QXmppSaslClientScram::handleSuccess(const std::optional<QByteArray> &additionalData)
+{
+    // the server final message is sent with the success unless it has been sent as a challenge
+    if (m_step == 2 && additionalData) {
+        m_step++;
+        return verifyServerSignature(*additionalData);
+    }
+    return true;
+}
+
+void QXmppSaslClientScram::updateCredentials(QXmpp::Private::Credentials &credentials) const
+{
+    // keys are only stored if they could be verified by the server, they are useless otherwise
+    if (!m_derivedKeys || !m_serverVerified) {
+        return;
+    }
+
+    // replace the keys of the mechanism, the salt changes with the password
+    auto &scramKeys = credentials.scramKeys;
+    scramKeys.erase(std::remove_if(scramKeys.begin(), scramKeys.end(), [this](const ScramKeys &keys) {
+                        return keys.mechanism == m_mechanism;
+                    }),
+                    scramKeys.end());
+    credentials.scramKeys.append(*m_derivedKeys);
+}
+
+bool QXmppSaslClientScram::verifyServerSignature(const QByteArray &serverFinalMessage)
+{
+    m_serverVerified = QByteArray::fromBase64(parseGS2(serverFinalMessage).value('v')) == m_serverSignature;
+    return m_serverVerified;
+}
+
 QXmppSaslClientWindowsLive::QXmppSaslClientWindowsLive(QObject *parent)
     : QXmppSaslClient(parent), m_step(0)
 {
@@ -95,6 +95,8 @@ struct Response {
 struct Success {
     static std::optional<Success> fromDom(const QDomElement &);
     void toXml(QXmlStreamWriter *writer) const;
+
+    std::optional<QByteArray> additionalData;
 };
 
 }  // namespace Sasl
@@ -348,9 +350,25 @@ struct HtToken {
     QDateTime expiry;
 };
 
+// Keys derived from the password for SCRAM (RFC 5802), can be used instead of the password as
+// long as the server's salt and iteration count stay the same.
+struct ScramKeys {
+    static std::optional<ScramKeys> fromXml(QXmlStreamReader &);
+    void toXml(QXmlStreamWriter &) const;
+    bool operator==(const ScramKeys &other) const = default;
+
+    SaslScramMechanism mechanism;
+    QByteArray salt;
+    int iterations = 0;
+    QByteArray clientKey;
+    QByteArray serverKey;
+};
+
 struct Credentials {
     QString password;
     std::optional<HtToken> htToken;
+    // at most one entry per SCRAM mechanism
+    QList<ScramKeys> scramKeys;
 
     // Facebook
     QString facebookAccessToken;
@@ -381,6 +399,12 @@ public:
     virtual void setCredentials(const QXmpp::Private::Credentials &) = 0;
     virtual QXmpp::Private::SaslMechanism mechanism() const = 0;
     virtual std::optional<QByteArray> respond(const QByteArray &challenge) = 0;
+    // Checks the additional data of the success, returns false if the server could not be
+    // authenticated.
+    virtual bool handleSuccess(const std::optional<QByteArray> &) { return true; }
+    // Stores data for the next authentication after the authentication succeeded and the server
+    // has been authenticated.
+    virtual void updateCredentials(QXmpp::Private::Credentials &) const { }
 
     static bool isMechanismAvailable(QXmpp::Private::SaslMechanism, const QXmpp::Private::Credentials &);
     static std::unique_ptr<QXmppSaslClient> create(const QString &mechanism, QObject *parent = nullptr);
@@ -522,15 +546,22 @@ public:
     void setCredentials(const QXmpp::Private::Credentials &) override;
     QXmpp::Private::SaslMechanism mechanism() const override { return { m_mechanism }; }
     std::optional<QByteArray> respond(const QByteArray &challenge) override;
+    bool handleSuccess(const std::optional<QByteArray> &additionalData) override;
+    void updateCredentials(QXmpp::Private::Credentials &) const override;
 
 private:
+    bool verifyServerSignature(const QByteArray &serverFinalMessage);
+
     QXmpp::Private::SaslScramMechanism m_mechanism;
     int m_step;
     QString m_password;
+    QList<QXmpp::Private::ScramKeys> m_storedKeys;
+    std::optional<QXmpp::Private::ScramKeys> m_derivedKeys;
     uint32_t m_dklen;
     QByteArray m_gs2Header;
     QByteArray m_clientFirstMessageBare;
     QByteArray m_serverSignature;
+    bool m_serverVerified = false;
     QByteArray m_nonce;
 };
 
@@ -16,6 +16,11 @@
 
 #include "StringLiterals.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+
 #include <QDateTime>
 #include <QDomElement>
 #include <QXmlStreamWriter>
@@ -788,6 +793,24 @@ void QXmppE2eeMetadata::setSceTimestamp(const QDateTime &timestamp)
     d->sceTimestamp = timestamp;
 }
 
+namespace QXmpp::Private {
+
+// Extensions of a stanza that have not been parsed yet.
+struct DeferredParsing {
+    using Parser = void (*)(QXmppStanza *, const QDomElement &, QXmpp::SceMode);
+
+    QDomElement element;
+    QXmpp::SceMode sceMode = QXmpp::SceAll;
+    Parser parser = nullptr;
+
+    // recursive, because the parser may call setters that check for deferred extensions again
+    std::recursive_mutex mutex;
+    bool parsing = false;
+    std::atomic<bool> parsed = false;
+};
+
+}  // namespace QXmpp::Private
+
 class QXmppStanzaPrivate : public QSharedData
 {
 public:
@@ -799,6 +822,9 @@ public:
     QXmppElementList extensions;
     QList<QXmppExtendedAddress> extendedAddresses;
     QSharedDataPointer<QXmppE2eeMetadataPrivate> e2eeMetadata;
+
+    // lazy parsing, set until the stanza is parsed again
+    std::shared_ptr<QXmpp::Private::DeferredParsing> deferred;
 };
 
 ///
@@ -815,13 +841,23 @@ QXmppStanza::QXmppStanza(const QString &from, const QString &to)
 }
 
 /// Constructs a copy of \a other.
-QXmppStanza::QXmppStanza(const QXmppStanza &other) = default;
+QXmppStanza::QXmppStanza(const QXmppStanza &other)
+    // unparsed data is never shared, see parseDeferredExtensions()
+    : d((other.parseDeferredExtensions(), other.d))
+{
+}
 /// Move constructor.
 QXmppStanza::QXmppStanza(QXmppStanza &&) = default;
 /// Destroys a QXmppStanza.
 QXmppStanza::~QXmppStanza() = default;
 /// Assigns \a other to this stanza.
-QXmppStanza &QXmppStanza::operator=(const QXmppStanza &other) = default;
+QXmppStanza &QXmppStanza::operator=(const QXmppStanza &other)
+{
+    // unparsed data is never shared, see parseDeferredExtensions()
+    other.parseDeferredExtensions();
+    d = other.d;
+    return *this;
+}
 /// Move-assignment operator.
 QXmppStanza &QXmppStanza::operator=(QXmppStanza &&) = default;
 
@@ -953,7 +989,7 @@ void QXmppStanza::setError(const std::optional<Error> &error)
 ///
 QXmppElementList QXmppStanza::extensions() const
 {
-    return d->extensions;
+    return parsed(d)->extensions;
 }
 
 ///
@@ -963,7 +999,7 @@ QXmppElementList QXmppStanza::extensions() const
 ///
 void QXmppStanza::setExtensions(const QXmppElementList &extensions)
 {
-    d->extensions = extensions;
+    parsed(d)->extensions = extensions;
 }
 
 ///
@@ -1021,6 +1057,8 @@ void QXmppStanza::generateAndSetNextId()
 
 void QXmppStanza::parse(const QDomElement &element)
 {
+    d->deferred.reset();
+
     d->from = element.attribute(u"from"_s);
     d->to = element.attribute(u"to"_s);
     d->id = element.attribute(u"id"_s);
@@ -1045,6 +1083,8 @@ void QXmppStanza::parse(const QDomElement &element)
 
 void QXmppStanza::extensionsToXml(QXmlStreamWriter *xmlWriter, QXmpp::SceMode sceMode) const
 {
+    parseDeferredExtensions();
+
     // XEP-0033: Extended Stanza Addressing
     if (sceMode & QXmpp::ScePublic && !d->extendedAddresses.isEmpty()) {
         xmlWriter->writeStartElement(QSL65("addresses"));
@@ -1061,4 +1101,43 @@ void QXmppStanza::extensionsToXml(QXmlStreamWriter *xmlWriter, QXmpp::SceMode sc
     }
 }
 
+//
+// Stores the element, so its extensions can be parsed by \a parser when they are accessed for the
+// first time.
+//
+// The element keeps its DOM document alive until then.
+//
+void QXmppStanza::deferExtensionParsing(const QDomElement &element, QXmpp::SceMode sceMode, DeferredParser parser)
+{
+    auto deferred = std::make_shared<DeferredParsing>();
+    deferred->element = element;
+    deferred->sceMode = sceMode;
+    deferred->parser = parser;
+    d->deferred = std::move(deferred);
+}
+
+//
+// Parses the deferred extensions, if any.
+//
+// This is called from const getters, so it is thread-safe: concurrent readers wait for the parsing
+// to finish. The parsed values are written into the data of this object, which is never shared
+// while extensions are pending, because copies parse the extensions before sharing the data.
+//
+void QXmppStanza::parseDeferredExtensions() const
+{
+    // only reset by parse(), never while the stanza is read
+    const auto &deferred = d->deferred;
+    if (!deferred || deferred->parsed.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::lock_guard lock(deferred->mutex);
+    if (deferred->parsed.load(std::memory_order_relaxed) || deferred->parsing) {
+        return;
+    }
+    deferred->parsing = true;
+    deferred->parser(const_cast<QXmppStanza *>(this), std::exchange(deferred->element, {}), deferred->sceMode);
+    deferred->parsed.store(true, std::memory_order_release);
+}
+
 /// \endcond
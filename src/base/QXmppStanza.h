@@ -230,6 +230,24 @@ public:
 protected:
     void extensionsToXml(QXmlStreamWriter *writer, QXmpp::SceMode = QXmpp::SceAll) const;
     void generateAndSetNextId();
+
+    using DeferredParser = void (*)(QXmppStanza *, const QDomElement &, QXmpp::SceMode);
+    void deferExtensionParsing(const QDomElement &element, QXmpp::SceMode sceMode, DeferredParser parser);
+    void parseDeferredExtensions() const;
+
+    // Access to data that is only complete after the deferred extensions have been parsed.
+    template<typename T>
+    const T *parsed(const QSharedDataPointer<T> &data) const
+    {
+        parseDeferredExtensions();
+        return data.constData();
+    }
+    template<typename T>
+    T *parsed(QSharedDataPointer<T> &data)
+    {
+        parseDeferredExtensions();
+        return data.data();
+    }
     /// \endcond
 
 private:
@@ -4,14 +4,18 @@
 
 #include "QXmppConstants_p.h"
 #include "QXmppGlobal.h"
+#include "QXmppNonza.h"
 #include "QXmppPacket_p.h"
 #include "QXmppStanza_p.h"
 #include "QXmppStreamManagement_p.h"
 #include "QXmppUtils_p.h"
 
 #include "StringLiterals.h"
+#include "XmlTree.h"
 #include "XmppSocket.h"
 
+#include <QTimer>
+
 namespace QXmpp::Private {
 
 std::optional<SmEnable> SmEnable::fromDom(const QDomElement &el)
@@ -133,14 +137,35 @@ void SmFailed::toXml(QXmlStreamWriter *w) const
     w->writeEndElement();
 }
 
-std::optional<SmAck> SmAck::fromDom(const QDomElement &el)
+static bool isSmElement(const QDomElement &el, QStringView tagName)
+{
+    return el.tagName() == tagName && el.namespaceURI() == ns_stream_management;
+}
+
+static bool isSmElement(const XmlElement &el, QStringView tagName)
 {
-    if (el.tagName() != u"a" || el.namespaceURI() != ns_stream_management) {
+    return el.hasTagName(tagName) && el.hasNamespace(ns_stream_management);
+}
+
+template<typename Element>
+static std::optional<SmAck> parseSmAck(const Element &el)
+{
+    if (!isSmElement(el, u"a")) {
         return {};
     }
     return SmAck { el.attribute(u"h"_s).toUInt() };
 }
 
+std::optional<SmAck> SmAck::fromDom(const QDomElement &el)
+{
+    return parseSmAck(el);
+}
+
+std::optional<SmAck> SmAck::fromDom(const XmlElement &el)
+{
+    return parseSmAck(el);
+}
+
 void SmAck::toXml(QXmlStreamWriter *w) const
 {
     w->writeStartElement(QSL65("a"));
@@ -151,7 +176,15 @@ void SmAck::toXml(QXmlStreamWriter *w) const
 
 std::optional<SmRequest> SmRequest::fromDom(const QDomElement &el)
 {
-    if (el.tagName() == u"r" && el.namespaceURI() == ns_stream_management) {
+    if (isSmElement(el, u"r")) {
+        return SmRequest();
+    }
+    return {};
+}
+
+std::optional<SmRequest> SmRequest::fromDom(const XmlElement &el)
+{
+    if (isSmElement(el, u"r")) {
         return SmRequest();
     }
     return {};
@@ -165,8 +198,61 @@ void SmRequest::toXml(QXmlStreamWriter *w) const
 }
 
 StreamAckManager::StreamAckManager(XmppSocket &socket)
-    : socket(socket)
+    : socket(socket),
+      m_ackRequestTimer(new QTimer(&socket)),
+      m_rateLimitTimer(new QTimer(&socket))
 {
+    m_ackRequestTimer->setSingleShot(true);
+    QObject::connect(m_ackRequestTimer, &QTimer::timeout, m_ackRequestTimer, [this] {
+        if (m_unrequestedStanzas > 0) {
+            sendAcknowledgementRequest();
+        }
+    });
+    QObject::connect(&socket, &XmppSocket::bytesWritten, m_ackRequestTimer, [this] {
+        sendHeldBackPackets(false);
+    });
+
+    m_rateLimitTimer->setSingleShot(true);
+    m_rateLimitTimer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(m_rateLimitTimer, &QTimer::timeout, m_rateLimitTimer, [this] {
+        sendHeldBackPackets(false);
+    });
+}
+
+void StreamAckManager::setAckRequestPolicy(int stanzaInterval, std::chrono::milliseconds delay, bool onIdle)
+{
+    m_ackRequestInterval = std::max(stanzaInterval, 0);
+    m_ackRequestDelay = std::max(delay, std::chrono::milliseconds(0));
+    m_ackRequestOnIdle = onIdle;
+
+    // Without any condition, no acknowledgement would ever be requested and the unacknowledged
+    // stanzas would pile up, so request one for every stanza instead.
+    if (m_ackRequestInterval == 0 && m_ackRequestDelay.count() == 0 && !m_ackRequestOnIdle) {
+        m_ackRequestInterval = 1;
+    }
+}
+
+void StreamAckManager::setWriteBufferHighWaterMark(qint64 bytes)
+{
+    m_writeBufferHighWaterMark = std::max(bytes, qint64(0));
+    sendHeldBackPackets(false);
+}
+
+std::size_t StreamAckManager::heldBackPacketCount() const
+{
+    return m_heldBackPackets[0].size() + m_heldBackPackets[1].size();
+}
+
+void StreamAckManager::setRateLimit(qint64 bytesPerSecond, double stanzasPerSecond, std::chrono::milliseconds burst)
+{
+    const auto burstSeconds = std::chrono::duration<double>(std::max(burst, std::chrono::milliseconds(0))).count();
+
+    // a burst needs to allow at least one stanza
+    m_byteRateLimit = TokenBucket(double(bytesPerSecond), double(bytesPerSecond) * burstSeconds);
+    m_stanzaRateLimit = TokenBucket(stanzasPerSecond, std::max(stanzasPerSecond * burstSeconds, 1.0));
+
+    m_rateLimitTimer->stop();
+    sendHeldBackPackets(false);
 }
 
 bool StreamAckManager::handleStanza(const QDomElement &stanza)
@@ -187,9 +273,27 @@ bool StreamAckManager::handleStanza(const QDomElement &stanza)
     return false;
 }
 
+// Handles acknowledgements and ack requests that have not been parsed into a QDomElement.
+bool StreamAckManager::handleElement(const XmlElement &element)
+{
+    if (auto ack = SmAck::fromDom(element)) {
+        handleAcknowledgement(*ack);
+        return true;
+    }
+    if (SmRequest::fromDom(element)) {
+        sendAcknowledgement();
+        return true;
+    }
+    return false;
+}
+
 void StreamAckManager::onSessionClosed()
 {
+    // held back stanzas are handled as if they had been sent on the closed stream: with stream
+    // management they are resent on resumption, otherwise sending them fails
+    sendHeldBackPackets(true);
     m_enabled = false;
+    m_ackRequestsHeldBack = false;
 }
 
 void StreamAckManager::enableStreamManagement(bool resetSequenceNumber)
@@ -202,74 +306,309 @@ void StreamAckManager::enableStreamManagement(bool resetSequenceNumber)
 
         // resend unacked stanzas
         if (!m_unacknowledgedStanzas.isEmpty()) {
-            auto oldUnackedStanzas = m_unacknowledgedStanzas;
-            m_unacknowledgedStanzas.clear();
+            m_unacknowledgedStanzas.renumber(m_lastOutgoingSequenceNumber + 1);
+            m_lastOutgoingSequenceNumber += m_unacknowledgedStanzas.size();
 
-            for (auto &packet : oldUnackedStanzas) {
-                m_unacknowledgedStanzas.insert(++m_lastOutgoingSequenceNumber, packet);
+            m_unacknowledgedStanzas.forEach([this](QXmppPacket &packet) {
                 socket.sendData(packet.data());
-            }
+            });
 
             sendAcknowledgementRequest();
         }
     } else {
         // resend unacked stanzas
         if (!m_unacknowledgedStanzas.isEmpty()) {
-            for (auto &packet : m_unacknowledgedStanzas) {
+            m_unacknowledgedStanzas.forEach([this](QXmppPacket &packet) {
                 socket.sendData(packet.data());
-            }
+            });
 
             sendAcknowledgementRequest();
         }
     }
 }
 
+void StreamAckManager::enablePendingStreamManagement()
+{
+    // the server counts all stanzas after <enable/>, including resent ones
+    m_ackRequestsHeldBack = true;
+    enableStreamManagement(true);
+}
+
+// The server answered the pipelined <enable/> with <enabled/>.
+void StreamAckManager::confirmStreamManagement()
+{
+    m_ackRequestsHeldBack = false;
+
+    // the server only counts its stanzas from <enabled/> on
+    m_lastIncomingSequenceNumber = 0;
+
+    // request the acknowledgements that have been held back
+    if (!m_unacknowledgedStanzas.isEmpty()) {
+        sendAcknowledgementRequest();
+    }
+}
+
+// Stops counting after stanzas have been sent speculatively on a stream where enabling stream
+// management failed. The stanzas have been sent, but they will never be acknowledged.
+void StreamAckManager::disableStreamManagement()
+{
+    m_enabled = false;
+    m_ackRequestsHeldBack = false;
+    m_lastOutgoingSequenceNumber = 0;
+    m_lastIncomingSequenceNumber = 0;
+    m_unrequestedStanzas = 0;
+    m_ackRequestTimer->stop();
+
+    m_unacknowledgedStanzas.removeAll([](QXmppPacket &packet) {
+        packet.reportFinished(QXmpp::SendSuccess { false });
+    });
+    reportQueueSize();
+}
+
 void StreamAckManager::setAcknowledgedSequenceNumber(unsigned int sequenceNumber)
 {
-    for (auto it = m_unacknowledgedStanzas.begin(); it != m_unacknowledgedStanzas.end();) {
-        if (it.key() <= sequenceNumber) {
-            it->reportFinished(QXmpp::SendSuccess { true });
-            it = m_unacknowledgedStanzas.erase(it);
-        } else {
-            break;
-        }
+    m_unacknowledgedStanzas.removeUntil(sequenceNumber, [](QXmppPacket &packet) {
+        packet.reportFinished(QXmpp::SendSuccess { true });
+    });
+    reportQueueSize();
+}
+
+QList<QByteArray> StreamAckManager::unacknowledgedData() const
+{
+    QList<QByteArray> stanzas;
+    stanzas.reserve(qsizetype(m_unacknowledgedStanzas.size()));
+    m_unacknowledgedStanzas.forEach([&](const QXmppPacket &packet) {
+        stanzas.append(packet.data());
+    });
+    return stanzas;
+}
+
+// Restores the sequence numbers and queued stanzas of a stream that is going to be resumed.
+// The stanzas are resent when the stream is resumed or stream management is enabled again.
+void StreamAckManager::restoreState(unsigned int lastIncomingSequenceNumber, unsigned int lastOutgoingSequenceNumber, const QList<QByteArray> &unacknowledgedStanzas)
+{
+    resetCache();
+
+    m_lastIncomingSequenceNumber = lastIncomingSequenceNumber;
+    m_lastOutgoingSequenceNumber = lastOutgoingSequenceNumber;
+
+    auto sequenceNumber = lastOutgoingSequenceNumber - quint32(unacknowledgedStanzas.size());
+    for (const auto &data : unacknowledgedStanzas) {
+        m_unacknowledgedStanzas.append(++sequenceNumber, QXmppPacket(data, true));
     }
+    reportQueueSize();
+}
+
+QXmppTask<SendResult> StreamAckManager::send(QXmppPacket &&packet, SendPriority priority)
+{
+    return std::get<1>(internalSend(std::move(packet), priority));
+}
+
+QXmppTask<SendResult> StreamAckManager::send(const QXmppNonza &nonza, SendPriority priority)
+{
+    return std::get<1>(internalSend(nonza, priority));
 }
 
-QXmppTask<SendResult> StreamAckManager::send(QXmppPacket &&packet)
+bool StreamAckManager::sendPacketCompat(QXmppPacket &&packet, SendPriority priority)
 {
-    return std::get<1>(internalSend(std::move(packet)));
+    return std::get<0>(internalSend(std::move(packet), priority));
 }
 
-bool StreamAckManager::sendPacketCompat(QXmppPacket &&packet)
+bool StreamAckManager::sendPacketCompat(const QXmppNonza &nonza, SendPriority priority)
 {
-    return std::get<0>(internalSend(std::move(packet)));
+    return std::get<0>(internalSend(nonza, priority));
+}
+
+static SendResult writeResult(bool writtenToSocket)
+{
+    if (writtenToSocket) {
+        return QXmpp::SendSuccess { false };
+    }
+    return QXmppError {
+        u"Couldn't write data to socket. No stream management enabled."_s,
+        QXmpp::SendError::SocketWriteError,
+    };
 }
 
 // Returns written to socket (bool) and QXmppTask
-std::tuple<bool, QXmppTask<SendResult>> StreamAckManager::internalSend(QXmppPacket &&packet)
+std::tuple<bool, QXmppTask<SendResult>> StreamAckManager::internalSend(QXmppPacket &&packet, SendPriority priority)
+{
+    if (shouldHoldBack(priority, packet)) {
+        return holdBack(std::move(packet), priority);
+    }
+    auto result = writePacket(std::move(packet));
+    updateWriteBufferState();
+    return result;
+}
+
+std::tuple<bool, QXmppTask<SendResult>> StreamAckManager::internalSend(const QXmppNonza &nonza, SendPriority priority)
+{
+    // stanzas need to be kept until they are acknowledged and paced data may need to be held
+    // back, copy with the exact size
+    if ((m_enabled && nonza.isXmppStanza()) || (priority != SendPriority::Control && isPacingEnabled())) {
+        auto data = socket.serializationBuffer().serialize(nonza, [](const char *data, qsizetype size) {
+            return QByteArray(data, size);
+        });
+        return internalSend(QXmppPacket(std::move(data), nonza.isXmppStanza()), priority);
+    }
+
+    // otherwise no copy needs to be retained
+    bool writtenToSocket = socket.sendXml(nonza);
+    updateWriteBufferState();
+
+    QXmppPromise<SendResult> promise;
+    promise.finish(writeResult(writtenToSocket));
+    return { writtenToSocket, promise.task() };
+}
+
+// Writes the packet to the socket and assigns a sequence number with stream management.
+std::tuple<bool, QXmppTask<SendResult>> StreamAckManager::writePacket(QXmppPacket &&packet)
 {
+    if (m_byteRateLimit.isEnabled() || m_stanzaRateLimit.isEnabled()) {
+        const auto now = TokenBucket::Clock::now();
+        m_byteRateLimit.take(double(packet.data().size()), now);
+        if (packet.isXmppStanza()) {
+            m_stanzaRateLimit.take(1, now);
+        }
+    }
+
     // the writtenToSocket parameter is just for backwards compat
     bool writtenToSocket = socket.sendData(packet.data());
 
     // handle stream management
     if (m_enabled && packet.isXmppStanza()) {
-        m_unacknowledgedStanzas.insert(++m_lastOutgoingSequenceNumber, packet);
-        sendAcknowledgementRequest();
-    } else {
-        if (writtenToSocket) {
-            packet.reportFinished(QXmpp::SendSuccess { false });
-        } else {
-            packet.reportFinished(QXmppError {
-                u"Couldn't write data to socket. No stream management enabled."_s,
-                QXmpp::SendError::SocketWriteError,
-            });
-        }
+        auto task = packet.task();
+        m_unacknowledgedStanzas.append(++m_lastOutgoingSequenceNumber, std::move(packet));
+        reportQueueSize();
+        scheduleAcknowledgementRequest();
+        return { writtenToSocket, task };
     }
 
+    packet.reportFinished(writeResult(writtenToSocket));
     return { writtenToSocket, packet.task() };
 }
 
+bool StreamAckManager::isPacingEnabled() const
+{
+    return m_writeBufferHighWaterMark > 0 || m_byteRateLimit.isEnabled() || m_stanzaRateLimit.isEnabled();
+}
+
+// Returns whether the write buffer and the rate limits allow writing the packet now.
+bool StreamAckManager::canWrite(const QXmppPacket &packet) const
+{
+    if (m_writeBufferHighWaterMark > 0 && socket.bytesToWrite() >= m_writeBufferHighWaterMark) {
+        return false;
+    }
+    const auto now = TokenBucket::Clock::now();
+    return m_byteRateLimit.isAvailable(double(packet.data().size()), now) &&
+        (!packet.isXmppStanza() || m_stanzaRateLimit.isAvailable(1, now));
+}
+
+bool StreamAckManager::shouldHoldBack(SendPriority priority, const QXmppPacket &packet) const
+{
+    if (priority == SendPriority::Control || !isPacingEnabled()) {
+        return false;
+    }
+
+    // keep the order of stanzas with the same priority and let higher priorities pass first
+    const auto queue = priority == SendPriority::Bulk ? 1 : 0;
+    for (int i = 0; i <= queue; i++) {
+        if (!m_heldBackPackets[i].empty()) {
+            return true;
+        }
+    }
+    return !canWrite(packet);
+}
+
+std::tuple<bool, QXmppTask<SendResult>> StreamAckManager::holdBack(QXmppPacket &&packet, SendPriority priority)
+{
+    auto task = packet.task();
+    m_heldBackBytes += packet.data().size();
+    // the time is only needed for the delay metric
+    const bool metricsEnabled = socket.isMetricsEnabled();
+    m_heldBackPackets[priority == SendPriority::Bulk ? 1 : 0].push_back({ std::move(packet), metricsEnabled ? TokenBucket::Clock::now() : TokenBucket::Clock::time_point() });
+
+    if (metricsEnabled) {
+        Q_EMIT socket.updateCounter(u"send-queue.held-back-packets"_s);
+        Q_EMIT socket.setGauge(u"send-queue.bytes"_s, double(m_heldBackBytes));
+    }
+    scheduleRateLimitTimer();
+    updateWriteBufferState();
+
+    // the packet is going to be written, report success for backwards compat
+    return { true, task };
+}
+
+// Writes held back packets in order of their priority until the high-water mark or the rate
+// limit is reached again or, if \a all is set, regardless of both.
+void StreamAckManager::sendHeldBackPackets(bool all)
+{
+    if (heldBackPacketCount() > 0) {
+        const bool metricsEnabled = socket.isMetricsEnabled();
+
+        // new packets may be appended while writing (e.g. from continuations of finished tasks)
+        for (auto &queue : m_heldBackPackets) {
+            while (!queue.empty() && (all || canWrite(queue.front().packet))) {
+                auto heldBack = std::move(queue.front());
+                queue.pop_front();
+                m_heldBackBytes -= heldBack.packet.data().size();
+
+                // metrics may have been enabled after holding the packet back
+                if (metricsEnabled && heldBack.time != TokenBucket::Clock::time_point()) {
+                    const auto delay = std::chrono::duration<double>(TokenBucket::Clock::now() - heldBack.time);
+                    Q_EMIT socket.updateHistogram(u"send-queue.delay"_s, delay.count());
+                }
+                writePacket(std::move(heldBack.packet));
+            }
+            // lower priorities need to wait
+            if (!queue.empty()) {
+                break;
+            }
+        }
+        if (metricsEnabled) {
+            Q_EMIT socket.setGauge(u"send-queue.bytes"_s, double(m_heldBackBytes));
+        }
+        scheduleRateLimitTimer();
+    }
+    updateWriteBufferState();
+}
+
+// Starts the timer for writing the next held back packet once the rate limit allows it. Packets
+// that are held back because of a full write buffer are written when the socket made progress.
+void StreamAckManager::scheduleRateLimitTimer()
+{
+    const auto queue = std::find_if(m_heldBackPackets.cbegin(), m_heldBackPackets.cend(), [](const auto &queue) {
+        return !queue.empty();
+    });
+    if (queue == m_heldBackPackets.cend() || m_rateLimitTimer->isActive()) {
+        return;
+    }
+
+    const auto &packet = queue->front().packet;
+    const auto now = TokenBucket::Clock::now();
+    auto delay = m_byteRateLimit.delay(double(packet.data().size()), now);
+    if (packet.isXmppStanza()) {
+        delay = std::max(delay, m_stanzaRateLimit.delay(1, now));
+    }
+    if (delay > TokenBucket::Clock::duration::zero()) {
+        m_rateLimitTimer->start(std::chrono::ceil<std::chrono::milliseconds>(delay));
+    }
+}
+
+// Tracks whether the high-water mark has been reached and emits XmppSocket::writeBufferLow()
+// once the buffered data has dropped to the low-water mark (half of the high-water mark).
+void StreamAckManager::updateWriteBufferState()
+{
+    if (!m_writeBufferFull) {
+        m_writeBufferFull = m_writeBufferHighWaterMark > 0 &&
+            socket.bytesToWrite() + m_heldBackBytes >= m_writeBufferHighWaterMark;
+    } else if (m_writeBufferHighWaterMark == 0 ||
+               socket.bytesToWrite() + m_heldBackBytes <= m_writeBufferHighWaterMark / 2) {
+        m_writeBufferFull = false;
+        Q_EMIT socket.writeBufferLow();
+    }
+}
+
 void StreamAckManager::handleAcknowledgement(SmAck ack)
 {
     if (!m_enabled) {
@@ -285,28 +624,73 @@ void StreamAckManager::sendAcknowledgement()
         return;
     }
 
-    socket.sendData(serializeXml(SmAck { m_lastIncomingSequenceNumber }));
+    socket.sendXml(SmAck { m_lastIncomingSequenceNumber });
 }
 
 void StreamAckManager::sendAcknowledgementRequest()
 {
-    if (!m_enabled) {
+    // held back requests are sent by confirmStreamManagement()
+    if (!m_enabled || m_ackRequestsHeldBack) {
         return;
     }
 
+    m_unrequestedStanzas = 0;
+    m_ackRequestTimer->stop();
+
     // send packet
-    socket.sendData(serializeXml(SmRequest {}));
+    socket.sendXml(SmRequest {});
+}
+
+// Sends an ack request for a newly queued stanza according to the ack request policy.
+void StreamAckManager::scheduleAcknowledgementRequest()
+{
+    m_unrequestedStanzas++;
+    if (m_ackRequestInterval > 0 && m_unrequestedStanzas >= m_ackRequestInterval) {
+        sendAcknowledgementRequest();
+        return;
+    }
+
+    if (m_ackRequestOnIdle) {
+        // an idle request always comes earlier than a delayed one
+        if (!m_ackRequestTimer->isActive() || m_ackRequestTimer->interval() != 0) {
+            m_ackRequestTimer->start(0);
+        }
+    } else if (m_ackRequestDelay.count() > 0 && !m_ackRequestTimer->isActive()) {
+        m_ackRequestTimer->start(m_ackRequestDelay);
+    }
 }
 
 void StreamAckManager::resetCache()
 {
-    for (auto &packet : m_unacknowledgedStanzas) {
+    m_ackRequestsHeldBack = false;
+    m_unrequestedStanzas = 0;
+    m_ackRequestTimer->stop();
+
+    m_rateLimitTimer->stop();
+    for (auto &queue : m_heldBackPackets) {
+        for (auto &heldBack : std::exchange(queue, {})) {
+            heldBack.packet.reportFinished(QXmppError {
+                u"Disconnected"_s,
+                QXmpp::SendError::Disconnected });
+        }
+    }
+    m_heldBackBytes = 0;
+    updateWriteBufferState();
+
+    m_unacknowledgedStanzas.removeAll([](QXmppPacket &packet) {
         packet.reportFinished(QXmppError {
             u"Disconnected"_s,
             QXmpp::SendError::Disconnected });
-    }
+    });
+    reportQueueSize();
+}
 
-    m_unacknowledgedStanzas.clear();
+void StreamAckManager::reportQueueSize()
+{
+    if (!socket.isMetricsEnabled()) {
+        return;
+    }
+    Q_EMIT socket.setGauge(u"stream-management.unacknowledged-stanzas"_s, double(m_unacknowledgedStanzas.size()));
 }
 
 }  // namespace QXmpp::Private
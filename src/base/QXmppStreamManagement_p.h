@@ -6,16 +6,29 @@
 #define QXMPPSTREAMMANAGEMENT_P_H
 
 #include "QXmppGlobal.h"
+#include "QXmppPacket_p.h"
 #include "QXmppSendResult.h"
 #include "QXmppStanza.h"
 #include "QXmppTask.h"
 
+#include "TokenBucket.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <vector>
+
+#include <QDateTime>
 #include <QDomDocument>
 #include <QXmlStreamWriter>
 
-class QXmppPacket;
+class QTimer;
+class QXmppNonza;
 
 namespace QXmpp::Private {
+class XmlElement;
 class XmppSocket;
 }
 
@@ -77,6 +90,7 @@ struct SmFailed {
 
 struct SmAck {
     static std::optional<SmAck> fromDom(const QDomElement &);
+    static std::optional<SmAck> fromDom(const XmlElement &);
     void toXml(QXmlStreamWriter *w) const;
 
     quint32 seqNo = 0;
@@ -84,32 +98,181 @@ struct SmAck {
 
 struct SmRequest {
     static std::optional<SmRequest> fromDom(const QDomElement &);
+    static std::optional<SmRequest> fromDom(const XmlElement &);
     void toXml(QXmlStreamWriter *w) const;
 };
 
+//
+// Everything needed to resume a stream after a restart, see QXmppStreamResumptionState.
+//
+struct StreamResumptionData {
+    QString id;
+    // full JID bound in the stream
+    QString jid;
+    QString host;
+    quint16 port = 0;
+    QDateTime expiry;
+    quint32 lastIncomingSequenceNumber = 0;
+    quint32 lastOutgoingSequenceNumber = 0;
+    QList<QByteArray> unacknowledgedStanzas;
+
+    bool operator==(const StreamResumptionData &) const = default;
+};
+
+//
+// Queue of sent stanzas waiting for an acknowledgement.
+//
+// The stanzas are stored in a ring buffer and addressed by their sequence number, which is
+// consecutive for all queued stanzas. Sequence numbers wrap around at 2^32 as described in
+// XEP-0198, so they are compared using serial number arithmetic.
+//
+template<typename T>
+class UnacknowledgedQueue
+{
+public:
+    bool isEmpty() const { return m_size == 0; }
+    std::size_t size() const { return m_size; }
+    std::size_t capacity() const { return m_items.size(); }
+    // only valid if the queue is not empty
+    quint32 firstSequenceNumber() const { return m_firstSequenceNumber; }
+
+    void append(quint32 sequenceNumber, T &&item)
+    {
+        Q_ASSERT(isEmpty() || sequenceNumber == m_firstSequenceNumber + quint32(m_size));
+        if (m_size == m_items.size()) {
+            grow();
+        }
+        if (isEmpty()) {
+            m_firstSequenceNumber = sequenceNumber;
+        }
+        m_items[index(m_size)].emplace(std::move(item));
+        m_size++;
+    }
+
+    // Removes all items up to and including the given sequence number. Acknowledgements of
+    // sequence numbers before the first item are ignored.
+    template<typename Function>
+    void removeUntil(quint32 sequenceNumber, Function onRemoved)
+    {
+        const auto acknowledged = qint32(sequenceNumber - m_firstSequenceNumber + 1);
+        if (acknowledged <= 0) {
+            return;
+        }
+        const auto count = std::min(std::size_t(acknowledged), m_size);
+        for (std::size_t i = 0; i < count; i++) {
+            // detach the item first, the callback may append new items
+            T item = std::move(*m_items[m_head]);
+            m_items[m_head].reset();
+            m_head = (m_head + 1) & (m_items.size() - 1);
+            m_firstSequenceNumber++;
+            m_size--;
+
+            onRemoved(item);
+        }
+        if (isEmpty()) {
+            m_head = 0;
+        }
+    }
+
+    template<typename Function>
+    void removeAll(Function onRemoved)
+    {
+        removeUntil(m_firstSequenceNumber + quint32(m_size) - 1, std::move(onRemoved));
+    }
+
+    // Assigns new consecutive sequence numbers starting with the given one.
+    void renumber(quint32 firstSequenceNumber) { m_firstSequenceNumber = firstSequenceNumber; }
+
+    template<typename Function>
+    void forEach(Function function)
+    {
+        for (std::size_t i = 0; i < m_size; i++) {
+            function(*m_items[index(i)]);
+        }
+    }
+
+    template<typename Function>
+    void forEach(Function function) const
+    {
+        for (std::size_t i = 0; i < m_size; i++) {
+            function(*m_items[index(i)]);
+        }
+    }
+
+private:
+    std::size_t index(std::size_t offset) const { return (m_head + offset) & (m_items.size() - 1); }
+
+    void grow()
+    {
+        // keep the capacity a power of two, so indices can be masked
+        std::vector<std::optional<T>> items(std::max<std::size_t>(m_items.size() * 2, 16));
+        for (std::size_t i = 0; i < m_size; i++) {
+            items[i] = std::move(m_items[index(i)]);
+        }
+        m_items = std::move(items);
+        m_head = 0;
+    }
+
+    std::vector<std::optional<T>> m_items;
+    std::size_t m_head = 0;
+    std::size_t m_size = 0;
+    quint32 m_firstSequenceNumber = 0;
+};
+
 //
 // This manager handles sending and receiving of stream management acks.
 // Enabling of stream management and stream resumption is done in the C2sStreamManager.
 //
-class StreamAckManager
+class QXMPP_AUTOTEST_EXPORT StreamAckManager
 {
 public:
     explicit StreamAckManager(XmppSocket &socket);
 
+    // An acknowledgement is requested after the given number of stanzas, after the delay since
+    // the first stanza not covered by a request or once the event loop is idle, whichever
+    // happens first. Zero values disable the respective condition, if all are disabled an
+    // acknowledgement is requested for every stanza.
+    void setAckRequestPolicy(int stanzaInterval, std::chrono::milliseconds delay, bool onIdle);
+    std::size_t unacknowledgedStanzaCount() const { return m_unacknowledgedStanzas.size(); }
+
+    // Stanzas (except for control traffic) are held back while at least the given amount of
+    // outgoing data is buffered, 0 disables this.
+    void setWriteBufferHighWaterMark(qint64 bytes);
+    qint64 writeBufferHighWaterMark() const { return m_writeBufferHighWaterMark; }
+    bool isWriteBufferFull() const { return m_writeBufferFull; }
+    std::size_t heldBackPacketCount() const;
+
+    // Paces outgoing stanzas (except for control traffic) to the given rates with bursts of the
+    // given duration, 0 disables the respective limit.
+    void setRateLimit(qint64 bytesPerSecond, double stanzasPerSecond, std::chrono::milliseconds burst);
+
     bool enabled() const { return m_enabled; }
     unsigned int lastIncomingSequenceNumber() const { return m_lastIncomingSequenceNumber; }
+    unsigned int lastOutgoingSequenceNumber() const { return m_lastOutgoingSequenceNumber; }
+
+    QList<QByteArray> unacknowledgedData() const;
+    void restoreState(unsigned int lastIncomingSequenceNumber, unsigned int lastOutgoingSequenceNumber, const QList<QByteArray> &unacknowledgedStanzas);
 
     void handlePacketSent(QXmppPacket &packet, bool sentData);
     bool handleStanza(const QDomElement &stanza);
+    bool handleElement(const XmlElement &element);
     void onSessionClosed();
 
     void resetCache();
     void enableStreamManagement(bool resetSequenceNumber);
+    // A pipelined <enable/> has been sent. Stanzas are counted from now on, but acknowledgements
+    // are only requested after the server confirmed it with <enabled/>.
+    void enablePendingStreamManagement();
+    void confirmStreamManagement();
+    void disableStreamManagement();
     void setAcknowledgedSequenceNumber(unsigned int sequenceNumber);
 
-    QXmppTask<QXmpp::SendResult> send(QXmppPacket &&);
-    bool sendPacketCompat(QXmppPacket &&);
-    std::tuple<bool, QXmppTask<QXmpp::SendResult>> internalSend(QXmppPacket &&);
+    QXmppTask<QXmpp::SendResult> send(QXmppPacket &&, QXmpp::SendPriority = QXmpp::SendPriority::Interactive);
+    QXmppTask<QXmpp::SendResult> send(const QXmppNonza &, QXmpp::SendPriority = QXmpp::SendPriority::Interactive);
+    bool sendPacketCompat(QXmppPacket &&, QXmpp::SendPriority = QXmpp::SendPriority::Interactive);
+    bool sendPacketCompat(const QXmppNonza &, QXmpp::SendPriority = QXmpp::SendPriority::Interactive);
+    std::tuple<bool, QXmppTask<QXmpp::SendResult>> internalSend(QXmppPacket &&, QXmpp::SendPriority = QXmpp::SendPriority::Interactive);
+    std::tuple<bool, QXmppTask<QXmpp::SendResult>> internalSend(const QXmppNonza &, QXmpp::SendPriority = QXmpp::SendPriority::Interactive);
 
     void sendAcknowledgementRequest();
 
@@ -117,13 +280,49 @@ private:
     void handleAcknowledgement(SmAck ack);
 
     void sendAcknowledgement();
+    void scheduleAcknowledgementRequest();
+    void reportQueueSize();
+
+    std::tuple<bool, QXmppTask<QXmpp::SendResult>> writePacket(QXmppPacket &&);
+    bool isPacingEnabled() const;
+    bool canWrite(const QXmppPacket &) const;
+    bool shouldHoldBack(QXmpp::SendPriority, const QXmppPacket &) const;
+    std::tuple<bool, QXmppTask<QXmpp::SendResult>> holdBack(QXmppPacket &&, QXmpp::SendPriority);
+    void sendHeldBackPackets(bool all);
+    void scheduleRateLimitTimer();
+    void updateWriteBufferState();
 
     QXmpp::Private::XmppSocket &socket;
 
     bool m_enabled = false;
-    QMap<unsigned int, QXmppPacket> m_unacknowledgedStanzas;
+    // stream management has not been confirmed by the server yet, <r/> must not be sent
+    bool m_ackRequestsHeldBack = false;
+    UnacknowledgedQueue<QXmppPacket> m_unacknowledgedStanzas;
     unsigned int m_lastOutgoingSequenceNumber = 0;
     unsigned int m_lastIncomingSequenceNumber = 0;
+
+    // ack request policy
+    int m_ackRequestInterval = 1;
+    std::chrono::milliseconds m_ackRequestDelay = {};
+    bool m_ackRequestOnIdle = false;
+    int m_unrequestedStanzas = 0;
+    QTimer *m_ackRequestTimer;
+
+    struct HeldBackPacket {
+        QXmppPacket packet;
+        TokenBucket::Clock::time_point time;
+    };
+
+    // stanzas held back while the write buffer is full or the rate limit is reached, one queue
+    // for interactive and bulk priority each
+    std::array<std::deque<HeldBackPacket>, 2> m_heldBackPackets;
+    qint64 m_heldBackBytes = 0;
+    qint64 m_writeBufferHighWaterMark = 0;
+    bool m_writeBufferFull = false;
+
+    TokenBucket m_byteRateLimit;
+    TokenBucket m_stanzaRateLimit;
+    QTimer *m_rateLimitTimer;
 };
 
 }  // namespace QXmpp::Private
@@ -9,26 +9,177 @@
 namespace QXmpp::Private {
 
 struct TaskData {
+    bool finished = false;
+    // whether the continuation is only called while the context is alive
+    bool contextRequired = true;
     QPointer<const QObject> context;
-    std::function<void(TaskPrivate &, void *)> continuation;
+    TaskContinuation continuation;
     void *result = nullptr;
-    void (*freeResult)(void *);
-    bool finished = false;
+    void (*destroyResult)(void *) = nullptr;
+    // behind the task data in the same block, if the result has a fixed size
+    void *resultStorage = nullptr;
+    // number of QXmppPromise objects, the task is abandoned if the last one is destroyed before
+    // finishing it
+    int promises = 0;
+    bool abandoned = false;
+    // called when the task is abandoned, e.g. to destroy an awaiting coroutine
+    void (*abandonedHandler)(void *) = nullptr;
+    void *abandonedHandlerData = nullptr;
 
     ~TaskData()
     {
-        if (freeResult) {
-            freeResult(result);
+        if (result && destroyResult) {
+            destroyResult(result);
+        }
+    }
+};
+
+// Blocks are pooled in size classes of PoolGranularity bytes.
+constexpr std::size_t PoolGranularity = 64;
+constexpr std::size_t PoolSizeClasses = 8;
+// per size class and thread
+constexpr std::size_t PoolMaxBlocks = 256;
+
+//
+// Freed blocks of task data, reused by the next task of the thread.
+//
+// Tasks are not thread-safe, but a task may be freed in another thread than it was created in.
+// The block then simply moves to the pool of that thread.
+//
+struct TaskDataPool {
+    struct Block {
+        Block *next;
+    };
+
+    Block *blocks[PoolSizeClasses] = {};
+    std::size_t blockCount[PoolSizeClasses] = {};
+
+    ~TaskDataPool();
+};
+
+// trivially destructible, so it can still be checked while the thread is exiting
+thread_local bool taskDataPoolDestroyed = false;
+thread_local TaskDataPool taskDataPool;
+
+TaskDataPool::~TaskDataPool()
+{
+    taskDataPoolDestroyed = true;
+    for (auto *block : blocks) {
+        while (block) {
+            ::operator delete(std::exchange(block, block->next));
+        }
+    }
+}
+
+static void *allocateTaskData(std::size_t size)
+{
+    const auto sizeClass = size / PoolGranularity;
+    if (sizeClass < PoolSizeClasses && !taskDataPoolDestroyed) {
+        auto &pool = taskDataPool;
+        if (auto *block = pool.blocks[sizeClass]) {
+            pool.blocks[sizeClass] = block->next;
+            pool.blockCount[sizeClass]--;
+            return block;
+        }
+    }
+    return allocateTaskMemory(size, alignof(std::max_align_t));
+}
+
+static void freeTaskData(void *data, std::size_t size)
+{
+    const auto sizeClass = size / PoolGranularity;
+    if (sizeClass < PoolSizeClasses && !taskDataPoolDestroyed) {
+        auto &pool = taskDataPool;
+        if (pool.blockCount[sizeClass] < PoolMaxBlocks) {
+            pool.blocks[sizeClass] = new (data) TaskDataPool::Block { pool.blocks[sizeClass] };
+            pool.blockCount[sizeClass]++;
+            return;
+        }
+    }
+    freeTaskMemory(data, size, alignof(std::max_align_t));
+}
+
+//
+// Allocates the control block of the shared pointer and the task data in one pooled block,
+// followed by the storage for the result.
+//
+template<typename T>
+struct TaskDataAllocator {
+    using value_type = T;
+
+    std::size_t resultSize = 0;
+    std::size_t resultAlignment = 1;
+    // receives the address of the result storage, only used by the first allocation
+    void **resultStorage = nullptr;
+
+    TaskDataAllocator(std::size_t size, std::size_t alignment, void **storage)
+        : resultSize(size), resultAlignment(alignment), resultStorage(storage)
+    {
+    }
+    template<typename U>
+    TaskDataAllocator(const TaskDataAllocator<U> &other)
+        : resultSize(other.resultSize), resultAlignment(other.resultAlignment), resultStorage(other.resultStorage)
+    {
+    }
+
+    // rounded up, so blocks of one size class are interchangeable
+    std::size_t blockSize(std::size_t n) const
+    {
+        // over-aligned results need extra space to be aligned manually
+        const auto padding = resultSize ? resultAlignment - 1 : 0;
+        return (n * sizeof(T) + padding + resultSize + PoolGranularity - 1) / PoolGranularity * PoolGranularity;
+    }
+
+    T *allocate(std::size_t n)
+    {
+        const auto size = blockSize(n);
+        auto *block = allocateTaskData(size);
+        if (resultSize && resultStorage) {
+            void *storage = static_cast<std::byte *>(block) + n * sizeof(T);
+            auto space = size - n * sizeof(T);
+            *std::exchange(resultStorage, nullptr) = std::align(resultAlignment, resultSize, storage, space);
         }
+        return static_cast<T *>(block);
+    }
+    void deallocate(T *p, std::size_t n)
+    {
+        freeTaskData(p, blockSize(n));
+    }
+
+    template<typename U>
+    bool operator==(const TaskDataAllocator<U> &) const
+    {
+        return true;
     }
 };
 
+void *allocateTaskMemory(std::size_t size, std::size_t alignment)
+{
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        return ::operator new(size, std::align_val_t(alignment));
+    }
+    return ::operator new(size);
+}
+
+void freeTaskMemory(void *memory, std::size_t, std::size_t alignment)
+{
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        ::operator delete(memory, std::align_val_t(alignment));
+    } else {
+        ::operator delete(memory);
+    }
+}
+
 }  // namespace QXmpp::Private
 
-QXmpp::Private::TaskPrivate::TaskPrivate(void (*freeResult)(void *))
-    : d(std::make_shared<QXmpp::Private::TaskData>())
+using namespace QXmpp::Private;
+
+QXmpp::Private::TaskPrivate::TaskPrivate(std::size_t resultSize, std::size_t resultAlignment, void (*destroyResult)(void *))
 {
-    d->freeResult = freeResult;
+    void *storage = nullptr;
+    d = std::allocate_shared<TaskData>(TaskDataAllocator<TaskData>(resultSize, resultAlignment, &storage));
+    d->destroyResult = destroyResult;
+    d->resultStorage = storage;
 }
 
 QXmpp::Private::TaskPrivate::~TaskPrivate()
@@ -43,16 +194,25 @@ bool QXmpp::Private::TaskPrivate::isFinished() const
 void QXmpp::Private::TaskPrivate::setFinished(bool finished)
 {
     d->finished = finished;
+    if (finished) {
+        d->abandonedHandler = nullptr;
+    }
 }
 
 bool QXmpp::Private::TaskPrivate::isContextAlive()
 {
-    return !d->context.isNull();
+    return !d->contextRequired || !d->context.isNull();
 }
 
 void QXmpp::Private::TaskPrivate::setContext(const QObject *obj)
 {
     d->context = obj;
+    d->contextRequired = true;
+}
+
+void QXmpp::Private::TaskPrivate::setContextRequired(bool required)
+{
+    d->contextRequired = required;
 }
 
 void *QXmpp::Private::TaskPrivate::result() const
@@ -62,23 +222,65 @@ void *QXmpp::Private::TaskPrivate::result() const
 
 void QXmpp::Private::TaskPrivate::setResult(void *result)
 {
-    if (d->freeResult) {
-        d->freeResult(d->result);
+    if (d->result && d->destroyResult) {
+        d->destroyResult(d->result);
     }
     d->result = result;
 }
 
-const std::function<void(QXmpp::Private::TaskPrivate &, void *)> QXmpp::Private::TaskPrivate::continuation() const
+void *QXmpp::Private::TaskPrivate::resultStorage()
 {
-    return d->continuation;
+    return d->resultStorage;
 }
 
-void QXmpp::Private::TaskPrivate::setContinuation(std::function<void(TaskPrivate &, void *)> &&continuation)
+void QXmpp::Private::TaskPrivate::addPromise()
 {
-    d->continuation = continuation;
+    d->promises++;
+}
+
+void QXmpp::Private::TaskPrivate::removePromise()
+{
+    if (--d->promises > 0 || d->finished) {
+        return;
+    }
+
+    d->abandoned = true;
+    if (auto handler = std::exchange(d->abandonedHandler, nullptr)) {
+        // keeps the data alive in case the handler releases the last reference
+        TaskPrivate task(*this);
+        task.d->continuation.reset();
+        handler(task.d->abandonedHandlerData);
+    }
+}
+
+bool QXmpp::Private::TaskPrivate::isAbandoned() const
+{
+    return d->abandoned;
+}
+
+void QXmpp::Private::TaskPrivate::setAbandonedHandler(void (*handler)(void *), void *data)
+{
+    d->abandonedHandler = handler;
+    d->abandonedHandlerData = data;
+}
+
+bool QXmpp::Private::TaskPrivate::hasContinuation() const
+{
+    return bool(d->continuation);
+}
+
+TaskContinuation &QXmpp::Private::TaskPrivate::continuationStorage() const
+{
+    return d->continuation;
 }
 
 void QXmpp::Private::TaskPrivate::invokeContinuation(void *result)
 {
-    d->continuation(*this, result);
+    // keeps the data alive in case the continuation deletes the promise
+    TaskPrivate task(*this);
+    if (task.isContextAlive()) {
+        task.d->continuation(task, result);
+    }
+    // clear continuation to avoid "deadlocks" in case the user captured this QXmppTask
+    task.d->continuation.reset();
 }
@@ -8,41 +8,192 @@
 
 #include "qxmpp_export.h"
 
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <new>
 #include <optional>
+#include <utility>
 
 #include <QFuture>
 #include <QPointer>
 
+#if QXMPP_COROUTINES && defined(__cpp_impl_coroutine)
+#define QXMPP_TASK_COROUTINES 1
+#include <coroutine>
+#endif
+
 template<typename T>
 class QXmppPromise;
 
 namespace QXmpp::Private {
 
 struct TaskData;
+class TaskPrivate;
+
+// Heap memory of tasks and their continuations
+QXMPP_EXPORT void *allocateTaskMemory(std::size_t size, std::size_t alignment);
+QXMPP_EXPORT void freeTaskMemory(void *memory, std::size_t size, std::size_t alignment);
+
+//
+// Type-erased storage for the continuation of a task.
+//
+// Unlike std::function, the function is never copied or moved after it has been set. Functions
+// up to InlineSize bytes are stored inline, only larger functions are allocated.
+//
+class TaskContinuation
+{
+public:
+    static constexpr std::size_t InlineSize = 8 * sizeof(void *);
+
+    TaskContinuation() = default;
+    TaskContinuation(const TaskContinuation &) = delete;
+    TaskContinuation &operator=(const TaskContinuation &) = delete;
+    ~TaskContinuation() { reset(); }
+
+    explicit operator bool() const { return m_invoke != nullptr; }
+    void operator()(TaskPrivate &task, void *result) { m_invoke(m_function, task, result); }
+
+    template<typename F>
+    void emplace(F &&function)
+    {
+        using Function = std::decay_t<F>;
+
+        reset();
+        if constexpr (sizeof(Function) <= InlineSize && alignof(Function) <= alignof(std::max_align_t)) {
+            m_function = new (&m_storage) Function(std::forward<F>(function));
+            m_destroy = [](void *f) { static_cast<Function *>(f)->~Function(); };
+        } else {
+            m_function = new (allocateTaskMemory(sizeof(Function), alignof(Function))) Function(std::forward<F>(function));
+            m_destroy = [](void *f) {
+                static_cast<Function *>(f)->~Function();
+                freeTaskMemory(f, sizeof(Function), alignof(Function));
+            };
+        }
+        m_invoke = [](void *f, TaskPrivate &task, void *result) { (*static_cast<Function *>(f))(task, result); };
+    }
 
+    void reset()
+    {
+        if (auto destroy = std::exchange(m_destroy, nullptr)) {
+            m_invoke = nullptr;
+            destroy(m_function);
+        }
+    }
+
+private:
+    alignas(std::max_align_t) std::byte m_storage[InlineSize];
+    void *m_function = nullptr;
+    void (*m_invoke)(void *, TaskPrivate &, void *) = nullptr;
+    void (*m_destroy)(void *) = nullptr;
+};
+
+//
+// Shared state of a QXmppTask and its QXmppPromise.
+//
+// The task data is allocated in one block together with the storage for the result. Freed blocks
+// are reused by the thread.
+//
 class QXMPP_EXPORT TaskPrivate
 {
 public:
-    TaskPrivate(void (*freeResult)(void *));
+    TaskPrivate(std::size_t resultSize, std::size_t resultAlignment, void (*destroyResult)(void *));
     ~TaskPrivate();
 
     bool isFinished() const;
     void setFinished(bool);
     bool isContextAlive();
     void setContext(const QObject *);
+    void setContextRequired(bool);
     void *result() const;
     void setResult(void *);
     void resetResult() { setResult(nullptr); }
+    void *resultStorage();
+    bool hasContinuation() const;
+    template<typename F>
+    void setContinuation(F &&function)
+    {
+        continuationStorage().emplace(std::forward<F>(function));
+    }
+    void invokeContinuation(void *result);
+    // counted by QXmppPromise, the task is abandoned if the last one is destroyed unfinished
+    void addPromise();
+    void removePromise();
+    bool isAbandoned() const;
+    void setAbandonedHandler(void (*handler)(void *), void *data);
+
+    // used by code compiled against QXmpp 1.10 and older, see compat/removed_api.cpp
+    TaskPrivate(void (*freeResult)(void *));
     const std::function<void(TaskPrivate &, void *)> continuation() const;
     void setContinuation(std::function<void(TaskPrivate &, void *)> &&);
-    void invokeContinuation(void *result);
 
 private:
+    TaskContinuation &continuationStorage() const;
+
     std::shared_ptr<TaskData> d;
 };
 
+#ifdef QXMPP_TASK_COROUTINES
+template<typename T>
+struct TaskCoroutinePromise;
+
+//
+// Suspends a coroutine until the task is finished.
+//
+// The coroutine is resumed directly by QXmppPromise::finish(). The continuation only captures a
+// pointer to the awaiter, so it is stored inline in the task and the result is moved directly
+// from the promise into the coroutine. If the task is abandoned instead, the coroutine is
+// destroyed by the last QXmppPromise.
+//
+template<typename T>
+class TaskAwaiter
+{
+public:
+    explicit TaskAwaiter(TaskPrivate task)
+        : d(std::move(task))
+    {
+    }
+
+    bool await_ready() const noexcept { return d.isFinished(); }
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        // never resumed, the awaiter is part of the destroyed frame
+        if (d.isAbandoned()) {
+            handle.destroy();
+            return;
+        }
+
+        m_handle = handle;
+        // the frame of the coroutine is kept alive by its owner, not by a QObject
+        d.setContextRequired(false);
+        d.setContinuation([this](TaskPrivate &, void *result) {
+            m_result = result;
+            m_handle.resume();
+        });
+        d.setAbandonedHandler([](void *address) { std::coroutine_handle<>::from_address(address).destroy(); }, handle.address());
+    }
+    T await_resume()
+    {
+        if constexpr (!std::is_void_v<T>) {
+            // finished before the coroutine was suspended: the result is stored in the task
+            if (!m_result) {
+                Q_ASSERT(d.result());
+                T result = std::move(*reinterpret_cast<T *>(d.result()));
+                d.resetResult();
+                return result;
+            }
+            return std::move(*reinterpret_cast<T *>(m_result));
+        }
+    }
+
+private:
+    TaskPrivate d;
+    std::coroutine_handle<> m_handle;
+    // only valid while the coroutine is resumed by the promise
+    void *m_result = nullptr;
+};
+#endif
+
 }  // namespace QXmpp::Private
 
 ///
@@ -53,6 +204,27 @@ private:
 /// Unlike QFuture, this is not thread-safe. This avoids the need to do mutex locking at every
 /// access though.
 ///
+/// If QXmpp has been built with coroutine support (the default with the CMake option
+/// WITH_COROUTINES), tasks can be awaited with \c co_await in C++20 coroutines and coroutines
+/// can return QXmppTask:
+/// ```
+/// QXmppTask<QString> Manager::fetchName(const QString &jid)
+/// {
+///     auto result = co_await client->sendIq(createRequest(jid));
+///     if (auto *element = std::get_if<QDomElement>(&result)) {
+///         co_return parseName(*element);
+///     }
+///     co_return QString();
+/// }
+/// ```
+/// The coroutine runs until the first \c co_await of an unfinished task and is resumed directly
+/// when that task is finished, without an event loop iteration. Unlike then(), awaiting does
+/// not take a context object: the caller must make sure that everything the coroutine uses
+/// (e.g. the captured \c this) is still alive when it is resumed. If all QXmppPromise objects of
+/// an awaited task are destroyed without finishing it, the coroutine is destroyed without being
+/// resumed and the task returned by it is never finished. A coroutine awaiting a task whose
+/// promise is kept, but never finished, is never resumed and its frame is never freed.
+///
 /// \ingroup Core classes
 ///
 /// \since QXmpp 1.5
@@ -61,6 +233,13 @@ template<typename T>
 class QXmppTask
 {
 public:
+#if defined(QXMPP_TASK_COROUTINES) && !defined(QXMPP_DOC)
+    using promise_type = QXmpp::Private::TaskCoroutinePromise<T>;
+
+    /// Awaits the result of the task in a coroutine, see the class description.
+    QXmpp::Private::TaskAwaiter<T> operator co_await() { return QXmpp::Private::TaskAwaiter<T>(d); }
+#endif
+
     ~QXmppTask() = default;
 
     ///
@@ -119,17 +298,13 @@ public:
             }
         } else {
             d.setContext(context);
-            d.setContinuation([f = std::forward<Continuation>(continuation)](TaskPrivate &d, void *result) mutable {
-                if (d.isContextAlive()) {
-                    if constexpr (std::is_void_v<T>) {
-                        f();
-                    } else {
-                        f(std::move(*reinterpret_cast<T *>(result)));
-                    }
+            // only called while the context is alive, the continuation is cleared afterwards
+            d.setContinuation([f = std::forward<Continuation>(continuation)](TaskPrivate &, void *result) mutable {
+                if constexpr (std::is_void_v<T>) {
+                    f();
+                } else {
+                    f(std::move(*reinterpret_cast<T *>(result)));
                 }
-
-                // clear continuation to avoid "deadlocks" in case the user captured this QXmppTask
-                d.setContinuation({});
             });
         }
     }
@@ -221,4 +396,9 @@ private:
     QXmpp::Private::TaskPrivate d;
 };
 
+#ifdef QXMPP_TASK_COROUTINES
+// the promise type of coroutines returning QXmppTask is defined there
+#include "QXmppPromise.h"
+#endif
+
 #endif  // QXMPPTASK_H
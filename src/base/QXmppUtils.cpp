@@ -11,6 +11,8 @@
 #include "Algorithms.h"
 #include "StringLiterals.h"
 
+#include <algorithm>
+
 #include <QBuffer>
 #include <QByteArray>
 #include <QCryptographicHash>
@@ -482,6 +484,45 @@ QByteArray QXmpp::Private::serializeXml(const void *packet, void (*toXml)(const
     return data;
 }
 
+// Most stanzas are smaller than this.
+constexpr qsizetype INITIAL_SERIALIZATION_SIZE_HINT = 1024;
+// The buffer is shrunk after exceptionally large packets if it is larger than this and four
+// times the size hint.
+constexpr qsizetype MAXIMUM_RETAINED_SERIALIZATION_BUFFER = 64 * 1024;
+
+SerializationBuffer::SerializationBuffer()
+    : m_device(std::make_unique<QBuffer>(&m_data)),
+      m_sizeHint(INITIAL_SERIALIZATION_SIZE_HINT)
+{
+    m_data.reserve(m_sizeHint);
+    m_device->open(QIODevice::WriteOnly);
+    m_writer = std::make_unique<QXmlStreamWriter>(m_device.get());
+}
+
+SerializationBuffer::~SerializationBuffer() = default;
+
+std::pair<const char *, qsizetype> SerializationBuffer::serializeData(const void *packet, void (*toXml)(const void *, QXmlStreamWriter *))
+{
+    // the data is never shared, so this keeps the capacity
+    m_data.resize(0);
+    if (m_data.capacity() < m_sizeHint) {
+        m_data.reserve(m_sizeHint);
+    }
+    m_device->seek(0);
+
+    toXml(packet, m_writer.get());
+
+    // The hint follows the largest recent packets and decays slowly after a large one.
+    const auto size = m_data.size();
+    m_sizeHint = std::max({ size, m_sizeHint - m_sizeHint / 8, INITIAL_SERIALIZATION_SIZE_HINT });
+
+    if (m_data.capacity() > std::max(4 * m_sizeHint, MAXIMUM_RETAINED_SERIALIZATION_BUFFER)) {
+        // release the memory of a buffer that grew for an exceptionally large packet
+        m_data = QByteArray(m_data.constData(), size);
+    }
+    return { m_data.constData(), size };
+}
+
 //
 // Generates a random count of random bytes.
 //
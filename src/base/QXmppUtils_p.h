@@ -10,12 +10,15 @@
 
 #include <array>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <stdint.h>
+#include <utility>
 
 #include <QByteArray>
 #include <QDomElement>
 
+class QBuffer;
 class QDomElement;
 class QXmlStreamWriter;
 class QXmppNonza;
@@ -138,7 +141,7 @@ inline DomChildElements iterChildElements(const QDomElement &el, QStringView tag
 
 std::vector<QString> parseTextElements(DomChildElements elements);
 
-QByteArray serializeXml(const void *packet, void (*toXml)(const void *, QXmlStreamWriter *));
+QXMPP_EXPORT QByteArray serializeXml(const void *packet, void (*toXml)(const void *, QXmlStreamWriter *));
 template<typename T>
 inline QByteArray serializeXml(const T &packet)
 {
@@ -147,6 +150,57 @@ inline QByteArray serializeXml(const T &packet)
     });
 }
 
+//
+// Serializes packets into one buffer that is reused for all packets of a connection. The buffer
+// keeps a capacity learned from the previous packets, so usually no memory needs to be allocated.
+//
+// The serialized data is passed to a function and is only valid during that call, the function
+// needs to copy the bytes if it wants to keep them. If another packet is serialized from within
+// the function (e.g. by a receiver of a log message), it is serialized into a new buffer. Only
+// complete elements can be serialized because the XML writer is shared by all packets (i.e. not
+// the stream header).
+//
+class QXMPP_EXPORT SerializationBuffer
+{
+public:
+    SerializationBuffer();
+    ~SerializationBuffer();
+
+    // Calls function(const char *data, qsizetype size) with the serialized packet and returns its
+    // result.
+    template<typename T, typename Function>
+    auto serialize(const T &packet, Function function)
+    {
+        if (m_inUse) {
+            const auto data = serializeXml(packet);
+            return function(data.constData(), data.size());
+        }
+
+        InUse inUse(m_inUse);
+        const auto [data, size] = serializeData(&packet, [](const void *packet, QXmlStreamWriter *w) {
+            std::invoke(&T::toXml, reinterpret_cast<const T *>(packet), w);
+        });
+        return function(data, size);
+    }
+
+    qsizetype sizeHint() const { return m_sizeHint; }
+
+private:
+    struct InUse {
+        explicit InUse(bool &inUse) : inUse(inUse) { inUse = true; }
+        ~InUse() { inUse = false; }
+        bool &inUse;
+    };
+
+    std::pair<const char *, qsizetype> serializeData(const void *packet, void (*toXml)(const void *, QXmlStreamWriter *));
+
+    QByteArray m_data;
+    std::unique_ptr<QBuffer> m_device;
+    std::unique_ptr<QXmlStreamWriter> m_writer;
+    qsizetype m_sizeHint;
+    bool m_inUse = false;
+};
+
 QXMPP_EXPORT QByteArray generateRandomBytes(size_t minimumByteCount, size_t maximumByteCount);
 QXMPP_EXPORT void generateRandomBytes(uint8_t *bytes, size_t byteCount);
 float calculateProgress(qint64 transferred, qint64 total);
@@ -11,14 +11,26 @@
 #include "QXmppUtils_p.h"
 
 #include "StringLiterals.h"
+#include "XmlTree.h"
 #include "XmppSocket.h"
 
+#include <algorithm>
+#include <utility>
+
 #include <QDomDocument>
 #include <QHostAddress>
-#include <QRegularExpression>
 #include <QSslSocket>
+#include <QTcpSocket>
+#include <QTimer>
 #include <QXmlStreamWriter>
 
+#ifdef Q_OS_WIN
+#include <winsock2.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 using namespace QXmpp;
 using namespace QXmpp::Private;
 
@@ -139,11 +151,45 @@ std::variant<StreamErrorElement, QXmppError> StreamErrorElement::fromDom(const Q
         std::move(errorText),
     };
 }
+
+void StreamErrorElement::toXml(QXmlStreamWriter *writer) const
+{
+    writer->writeStartElement(QSL65("stream:error"));
+    if (auto *redirect = std::get_if<SeeOtherHost>(&condition)) {
+        // IPv6 addresses need to be enclosed in brackets
+        const QString host = redirect->host.contains(u':') ? QString(u'[' + redirect->host + u']') : redirect->host;
+        writeXmlTextElement(writer, u"see-other-host", ns_stream_error, QString(host + u':' + QString::number(redirect->port)));
+    } else {
+        writeEmptyElement(writer, streamErrorToString(std::get<StreamError>(condition)), ns_stream_error);
+    }
+    if (!text.isEmpty()) {
+        writeXmlTextElement(writer, u"text", ns_stream_error, text);
+    }
+    writer->writeEndElement();
+}
 /// \endcond
 
+// Defaults for the limits of the incoming stream, large enough for any regular traffic (e.g.
+// avatars or MAM pages), but small enough to not let a peer exhaust the memory.
+constexpr qint64 DEFAULT_MAXIMUM_STANZA_SIZE = 10 * 1024 * 1024;
+constexpr qint64 DEFAULT_MAXIMUM_BUFFER_SIZE = 16 * 1024 * 1024;
+// The socket always needs to be allowed to read some data, a read buffer size of 0 means unlimited.
+constexpr qint64 MINIMUM_READ_BUFFER_SIZE = 16 * 1024;
+// Maximum payload of a TLS record
+constexpr qint64 DEFAULT_WRITE_COALESCING_THRESHOLD = 16 * 1024;
+
 XmppSocket::XmppSocket(QObject *parent)
-    : QXmppLoggable(parent)
+    : QXmppLoggable(parent),
+      m_maximumBufferSize(DEFAULT_MAXIMUM_BUFFER_SIZE),
+      m_writeCoalescingThreshold(DEFAULT_WRITE_COALESCING_THRESHOLD),
+      m_flushTimer(new QTimer(this))
 {
+    m_parser.setMaximumElementSize(DEFAULT_MAXIMUM_STANZA_SIZE);
+
+    // with an interval of 0 the timer fires when the current event loop iteration is done
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(0);
+    connect(m_flushTimer, &QTimer::timeout, this, &XmppSocket::flush);
 }
 
 void XmppSocket::setSocket(QSslSocket *socket)
@@ -153,22 +199,11 @@ void XmppSocket::setSocket(QSslSocket *socket)
         return;
     }
 
-    QObject::connect(socket, &QAbstractSocket::connected, this, [this]() {
-        info(u"Socket connected to %1 %2"_s
-                 .arg(m_socket->peerAddress().toString(),
-                      QString::number(m_socket->peerPort())));
-
-        // do not emit started() with direct TLS (this happens in encrypted())
-        if (!m_directTls) {
-            m_dataBuffer.clear();
-            m_streamOpenElement.clear();
-            Q_EMIT started();
-        }
-    });
+    QObject::connect(socket, &QAbstractSocket::connected, this, &XmppSocket::handleConnected);
     QObject::connect(socket, &QSslSocket::encrypted, this, [this]() {
         debug(u"Socket encrypted"_s);
         // this happens with direct TLS or STARTTLS
-        m_dataBuffer.clear();
+        m_parser.reset();
         m_streamOpenElement.clear();
         Q_EMIT started();
     });
@@ -176,8 +211,16 @@ void XmppSocket::setSocket(QSslSocket *socket)
         warning(u"Socket error: "_s + m_socket->errorString());
     });
     QObject::connect(socket, &QSslSocket::readyRead, this, [this]() {
-        processData(QString::fromUtf8(m_socket->readAll()));
+        const auto data = m_socket->readAll();
+        if (isMetricsEnabled()) {
+            Q_EMIT updateCounter(u"socket.read-bytes"_s, data.size());
+        }
+        processData(data);
+        updateReadBufferSize();
     });
+    QObject::connect(socket, &QSslSocket::bytesWritten, this, &XmppSocket::bytesWritten);
+    QObject::connect(socket, &QSslSocket::encryptedBytesWritten, this, &XmppSocket::bytesWritten);
+    updateReadBufferSize();
 }
 
 bool XmppSocket::isConnected() const
@@ -203,11 +246,63 @@ void XmppSocket::connectToHost(const ServerAddress &address)
     }
 }
 
+//
+// Takes over the connection of a socket that has already been connected to the address (e.g. by
+// ConnectionRacer), so no new TCP handshake is needed. The passed socket can be deleted
+// afterwards, it does not close the connection anymore.
+//
+// Returns false if the connection could not be taken over.
+//
+bool XmppSocket::connectToSocket(const ServerAddress &address, QTcpSocket *connectedSocket)
+{
+    if (!connectedSocket || connectedSocket->state() != QAbstractSocket::ConnectedState) {
+        return false;
+    }
+
+    // the descriptor is duplicated, so the other socket can be closed independently
+#ifdef Q_OS_WIN
+    WSAPROTOCOL_INFOW protocolInfo;
+    if (WSADuplicateSocketW(SOCKET(connectedSocket->socketDescriptor()), GetCurrentProcessId(), &protocolInfo) != 0) {
+        return false;
+    }
+    const auto socket = WSASocketW(FROM_PROTOCOL_INFO, FROM_PROTOCOL_INFO, FROM_PROTOCOL_INFO, &protocolInfo, 0, WSA_FLAG_OVERLAPPED);
+    if (socket == INVALID_SOCKET) {
+        return false;
+    }
+    const auto descriptor = qintptr(socket);
+    const auto closeDescriptor = [](qintptr descriptor) { closesocket(SOCKET(descriptor)); };
+#else
+    const qintptr descriptor = ::fcntl(int(connectedSocket->socketDescriptor()), F_DUPFD_CLOEXEC, 0);
+    if (descriptor < 0) {
+        return false;
+    }
+    const auto closeDescriptor = [](qintptr descriptor) { ::close(int(descriptor)); };
+#endif
+
+    m_directTls = address.type == ServerAddress::Tls;
+    if (!m_socket->setSocketDescriptor(descriptor)) {
+        closeDescriptor(descriptor);
+        return false;
+    }
+
+    info(u"Using established connection to %1:%2 (%3)"_s
+             .arg(address.host, QString::number(address.port), m_directTls ? u"TLS"_s : u"TCP"_s));
+
+    // QSslSocket does not emit connected() for an adopted descriptor
+    handleConnected();
+    if (m_directTls) {
+        Q_ASSERT(QSslSocket::supportsSsl());
+        m_socket->startClientEncryption();
+    }
+    return true;
+}
+
 void XmppSocket::disconnectFromHost()
 {
     if (m_socket) {
         if (m_socket->state() == QAbstractSocket::ConnectedState) {
             sendData(QByteArrayLiteral("</stream:stream>"));
+            flush();
             m_socket->flush();
         }
         // FIXME: according to RFC 6120 section 4.4, we should wait for
@@ -216,52 +311,185 @@ void XmppSocket::disconnectFromHost()
     }
 }
 
+void XmppSocket::handleConnected()
+{
+    info(u"Socket connected to %1 %2"_s
+             .arg(m_socket->peerAddress().toString(),
+                  QString::number(m_socket->peerPort())));
+
+    // drop data of a previous connection
+    m_writeBuffer.clear();
+    m_flushTimer->stop();
+
+    // do not emit started() with direct TLS (this happens in encrypted())
+    if (!m_directTls) {
+        m_parser.reset();
+        m_streamOpenElement.clear();
+        Q_EMIT started();
+    }
+}
+
 bool XmppSocket::sendData(const QByteArray &data)
 {
-    logSent(QString::fromUtf8(data));
+    return sendData(data.constData(), data.size());
+}
+
+//
+// Sends the data or appends a copy of it to the write buffer, the data does not need to stay
+// valid after this call.
+//
+bool XmppSocket::sendData(const char *data, qsizetype size)
+{
+    if (isLoggingEnabled(QXmppLogger::SentMessage)) {
+        logSent(QString::fromUtf8(data, size));
+    }
     if (!m_socket || m_socket->state() != QAbstractSocket::ConnectedState) {
         return false;
     }
-    return m_socket->write(data) == data.size();
+
+    if (!m_writeCoalescingEnabled) {
+        return writeToSocket(data, size);
+    }
+
+    // copies the bytes, appending a QByteArray to the empty buffer would only share it
+    m_writeBuffer.append(data, size);
+    m_coalescedPackets++;
+    if (m_writeBuffer.size() >= m_writeCoalescingThreshold) {
+        return flush();
+    }
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+    return true;
 }
 
-void XmppSocket::processData(const QString &data)
+//
+// Enables collecting all data sent within one event loop iteration (or the configured delay) and
+// writing it to the socket at once. This results in less TLS records and TCP segments for bursts
+// of small packets (e.g. stream management acks, receipts and chat states).
+//
+void XmppSocket::setWriteCoalescingEnabled(bool enabled)
 {
-    // As we may only have partial XML content, we need to cache the received
-    // data until it has been successfully parsed. In case it can't be parsed,
-    //
-    // There are only two small problems with the current strategy:
-    //  * When we receive a full stanza + a partial one, we can't parse the
-    //    first stanza until another stanza arrives that is complete.
-    //  * We don't know when we received invalid XML (would cause a growing
-    //    cache and a timeout after some time).
-    // However, both issues could only be solved using an XML stream reader
-    // which would cause many other problems since we don't actually use it for
-    // parsing the content.
-    m_dataBuffer.append(data);
+    m_writeCoalescingEnabled = enabled;
+    if (!enabled) {
+        flush();
+    }
+}
+
+std::chrono::milliseconds XmppSocket::writeCoalescingDelay() const
+{
+    return m_flushTimer->intervalAsDuration();
+}
+
+//
+// Maximum time data is held back for coalescing. 0 means until the current event loop
+// iteration is done.
+//
+void XmppSocket::setWriteCoalescingDelay(std::chrono::milliseconds delay)
+{
+    m_flushTimer->setInterval(delay);
+}
+
+//
+// Writes all held back data to the socket.
+//
+bool XmppSocket::flush()
+{
+    m_flushTimer->stop();
+    if (m_writeBuffer.isEmpty()) {
+        return true;
+    }
+    const auto data = std::exchange(m_writeBuffer, {});
+    if (const auto packets = std::exchange(m_coalescedPackets, 0); isMetricsEnabled()) {
+        Q_EMIT updateCounter(u"socket.coalesced-packets"_s, packets);
+    }
+    if (!m_socket || m_socket->state() != QAbstractSocket::ConnectedState) {
+        return false;
+    }
+    return writeToSocket(data.constData(), data.size());
+}
+
+qint64 XmppSocket::bytesToWrite() const
+{
+    // data of a closed connection is never written
+    if (!isConnected()) {
+        return 0;
+    }
+    return m_writeBuffer.size() + m_socket->bytesToWrite() + m_socket->encryptedBytesToWrite();
+}
+
+bool XmppSocket::writeToSocket(const char *data, qsizetype size)
+{
+    if (isMetricsEnabled()) {
+        Q_EMIT updateCounter(u"socket.writes"_s);
+        Q_EMIT updateCounter(u"socket.written-bytes"_s, size);
+    }
+    return m_socket->write(data, size) == size;
+}
+
+//
+// Maximum size of a single top-level element (stanza or nonza) in bytes. A peer sending a larger
+// element gets a policy-violation stream error and is disconnected. 0 disables the limit.
+//
+qint64 XmppSocket::maximumStanzaSize() const
+{
+    return m_parser.maximumElementSize();
+}
+
+void XmppSocket::setMaximumStanzaSize(qint64 size)
+{
+    m_parser.setMaximumElementSize(qMax<qint64>(size, 0));
+}
+
+//
+// Maximum amount of received data in bytes that is buffered in total (socket buffer and partially
+// received elements). When reached, reading from the socket is paused, so the peer is slowed down
+// by TCP flow control. 0 disables the limit.
+//
+void XmppSocket::setMaximumBufferSize(qint64 size)
+{
+    m_maximumBufferSize = qMax<qint64>(size, 0);
+    updateReadBufferSize();
+}
+
+void XmppSocket::updateReadBufferSize()
+{
+    if (!m_socket) {
+        return;
+    }
+    if (m_maximumBufferSize == 0) {
+        m_socket->setReadBufferSize(0);
+        return;
+    }
+    // only allow the socket to buffer what is left after the data held back by the parser
+    const auto remaining = m_maximumBufferSize - qint64(m_parser.bufferedSize());
+    m_socket->setReadBufferSize(qMax(remaining, MINIMUM_READ_BUFFER_SIZE));
+}
+
+void XmppSocket::sendStreamError(StreamError condition, const QString &text)
+{
+    warning(text);
+    sendXml(StreamErrorElement { condition, text });
+    Q_EMIT streamErrorSent(condition, text);
+    disconnectFromHost();
+}
 
+static bool isXmlWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+void XmppSocket::processData(const QByteArray &data)
+{
     //
     // Check for whitespace pings
     //
-    if (m_dataBuffer.isEmpty() || m_dataBuffer.trimmed().isEmpty()) {
-        m_dataBuffer.clear();
-
+    if (!m_parser.hasPendingData() && std::all_of(data.cbegin(), data.cend(), isXmlWhitespace)) {
         logReceived({});
         Q_EMIT stanzaReceived(QDomElement());
         return;
     }
 
-    //
-    // Check whether we received a stream open or closing tag
-    //
-    static const QRegularExpression streamStartRegex(uR"(^(<\?xml.*\?>)?\s*<stream:stream[^>]*>)"_s);
-    static const QRegularExpression streamEndRegex(u"</stream:stream>$"_s);
-
-    auto streamOpenMatch = streamStartRegex.match(m_dataBuffer);
-    bool hasStreamOpen = streamOpenMatch.hasMatch();
-
-    bool hasStreamClose = streamEndRegex.match(m_dataBuffer).hasMatch();
-
     //
     // The stream start/end and stanza packets can't be parsed without any
     // modifications with QDomDocument. This is because of multiple reasons:
@@ -273,60 +501,252 @@ void XmppSocket::processData(const QString &data)
     //     * For having the correct namespace (e.g. 'jabber:client') set to
     //       stanzas and their child elements (e.g. <body/> of a message).
     //
-    // The wrapping strategy looks like this:
+    // The stream parser splits the incoming data into the stream open tag,
+    // complete top-level elements and the stream close tag. Each of them is
+    // then wrapped:
     //  * The stream open tag is cached once it arrives, for later access
-    //  * Incoming XML that has no <stream> open tag will be prepended by the
-    //    cached <stream> tag.
-    //  * Incoming XML that has no <stream> close tag will be appended by a
-    //    generic string "</stream:stream>"
+    //  * Each top-level element is prepended by the cached <stream> tag and
+    //    appended by a generic string "</stream:stream>"
     //
-    // The result is parsed by QDomDocument and the child elements of the stream
-    // are processed. In case the received data contained a stream open tag,
-    // the stream is processed (before the stanzas are processed). In case we
-    // received a </stream> closing tag, the connection is closed.
+    // Every element is only parsed once by QDomDocument, directly after its
+    // end tag has been received. The data stays UTF-8 encoded until then.
+    // QDomDocument decodes all text nodes while parsing, they can't be
+    // decoded lazily as long as the stanza parsers work on QDomElements.
     //
-    auto wrappedStanzas = m_dataBuffer;
-    if (!hasStreamOpen) {
-        wrappedStanzas.prepend(m_streamOpenElement);
-    }
-    if (!hasStreamClose) {
-        wrappedStanzas.append(u"</stream:stream>"_s);
-    }
-
-    //
-    // Try to parse the wrapped XML
-    //
-    QDomDocument doc;
+    auto parse = [](const QByteArray &xml) {
+        QDomDocument doc;
 #if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
-    if (!doc.setContent(wrappedStanzas, QDomDocument::ParseOption::UseNamespaceProcessing)) {
+        doc.setContent(xml, QDomDocument::ParseOption::UseNamespaceProcessing);
 #else
-    if (!doc.setContent(wrappedStanzas, true)) {
+        doc.setContent(xml, true);
 #endif
-        return;
+        return doc.documentElement();
+    };
+
+    const bool metricsEnabled = isMetricsEnabled();
+    for (auto &event : m_parser.parse(data)) {
+        if (auto *streamOpen = std::get_if<StreamParser::StreamOpen>(&event)) {
+            if (isLoggingEnabled(QXmppLogger::ReceivedMessage)) {
+                logReceived(QString::fromUtf8(streamOpen->xml));
+            }
+            m_streamOpenElement = std::move(streamOpen->xml);
+            if (m_emptyElementHandler) {
+                // the namespace of an element without xmlns attribute
+                auto doc = XmlDocument::parse(m_streamOpenElement + "<x/></stream:stream>");
+                auto child = doc ? doc->documentElement().firstChildElement() : XmlElement();
+                m_streamNamespace = QByteArray(child.namespaceUtf8().data(), qsizetype(child.namespaceUtf8().size()));
+            }
+
+            // process stream start
+            Q_EMIT streamReceived(parse(m_streamOpenElement + "</stream:stream>"));
+        } else if (auto *element = std::get_if<StreamParser::Element>(&event)) {
+            if (metricsEnabled) {
+                Q_EMIT updateCounter(u"socket.parsed-elements"_s);
+            }
+            if (isLoggingEnabled(QXmppLogger::ReceivedMessage)) {
+                logReceived(QString::fromUtf8(element->xml));
+            }
+
+            // empty elements are cheap to parse into the lightweight tree, most of them are
+            // handled without building a QDomDocument
+            if (element->empty && m_emptyElementHandler) {
+                auto doc = XmlDocument::parse(element->xml, std::string_view(m_streamNamespace.constData(), size_t(m_streamNamespace.size())));
+                if (doc && m_emptyElementHandler(doc->documentElement())) {
+                    continue;
+                }
+            }
+
+            auto stanza = parse(m_streamOpenElement + element->xml + "</stream:stream>").firstChildElement();
+            if (stanza.isNull()) {
+                // the element has already been counted by the other side, skipping it would break
+                // stream management
+                m_parser.fail();
+                sendStreamError(StreamError::NotWellFormed, u"Received invalid XML element."_s);
+                return;
+            }
+
+            // process stanza
+            Q_EMIT stanzaReceived(stanza);
+        } else if (std::holds_alternative<StreamParser::StreamClose>(event)) {
+            logReceived(u"</stream:stream>"_s);
+
+            // process stream end
+            Q_EMIT streamClosed();
+        } else if (std::holds_alternative<StreamParser::SizeLimitExceeded>(event)) {
+            sendStreamError(StreamError::PolicyViolation,
+                            u"Received element exceeds the maximum size of %1 bytes."_s.arg(maximumStanzaSize()));
+            return;
+        }
     }
+}
 
-    //
-    // Success: We can clear the buffer and send a 'received' log message
-    //
-    logReceived(m_dataBuffer);
-    m_dataBuffer.clear();
+std::vector<StreamParser::Event> StreamParser::parse(const QByteArray &data)
+{
+    std::vector<Event> events;
+    if (m_failed) {
+        return events;
+    }
+    m_buffer.append(data);
+
+    const auto size = m_buffer.size();
+    bool incomplete = false;
+    while (m_position < size && !incomplete) {
+        // enforce the size limit while the element is still being received
+        if (m_maximumElementSize > 0 && pendingElementSize() >= m_maximumElementSize) {
+            fail();
+            events.push_back(SizeLimitExceeded {});
+            return events;
+        }
+
+        const auto c = m_buffer.at(m_position);
+
+        switch (m_state) {
+        case Text:
+            if (c == '<') {
+                m_tagStart = m_position;
+                m_state = TagOpen;
+            }
+            break;
+        case TagOpen:
+            if (c == '/') {
+                m_state = EndTag;
+            } else if (c == '?') {
+                m_state = ProcessingInstruction;
+            } else if (c == '!') {
+                const auto tag = QByteArray::fromRawData(m_buffer.constData() + m_tagStart, m_buffer.size() - m_tagStart);
+                if (tag.startsWith("<!--")) {
+                    m_state = Comment;
+                    m_position = m_tagStart + 3;
+                } else if (tag.startsWith("<![CDATA[")) {
+                    m_state = CData;
+                    m_position = m_tagStart + 8;
+                } else if (QByteArrayLiteral("<!--").startsWith(tag) || QByteArrayLiteral("<![CDATA[").startsWith(tag)) {
+                    // wait for more data to decide
+                    incomplete = true;
+                    continue;
+                } else {
+                    m_state = Declaration;
+                }
+            } else {
+                m_state = StartTag;
+            }
+            break;
+        case StartTag:
+        case EndTag:
+        case Declaration:
+            if (m_quote) {
+                if (c == m_quote) {
+                    m_quote = 0;
+                }
+            } else if (c == '"' || c == '\'') {
+                m_quote = c;
+            } else if (c == '>') {
+                handleTagEnd(events);
+            }
+            break;
+        case ProcessingInstruction:
+            if (c == '>' && m_position > m_tagStart + 2 && m_buffer.at(m_position - 1) == '?') {
+                m_state = Text;
+            }
+            break;
+        case Comment:
+            if (c == '>' && m_position > m_tagStart + 5 && m_buffer.at(m_position - 1) == '-' && m_buffer.at(m_position - 2) == '-') {
+                m_state = Text;
+            }
+            break;
+        case CData:
+            if (c == '>' && m_position > m_tagStart + 10 && m_buffer.at(m_position - 1) == ']' && m_buffer.at(m_position - 2) == ']') {
+                m_state = Text;
+            }
+            break;
+        }
+        m_position++;
+    }
 
-    // process stream start
-    if (hasStreamOpen) {
-        m_streamOpenElement = streamOpenMatch.captured();
-        Q_EMIT streamReceived(doc.documentElement());
+    // drop everything that is not part of an incomplete element
+    qsizetype consumed = m_position;
+    if (m_depth > 1) {
+        consumed = m_elementStart;
+    } else if (m_state != Text) {
+        consumed = m_tagStart;
     }
 
-    // process stanzas
-    auto stanza = doc.documentElement().firstChildElement();
-    for (; !stanza.isNull(); stanza = stanza.nextSiblingElement()) {
-        Q_EMIT stanzaReceived(stanza);
+    if (consumed > 0) {
+        m_buffer.remove(0, consumed);
+        m_position -= consumed;
+        m_tagStart -= consumed;
+        m_elementStart -= consumed;
+    }
+    return events;
+}
+
+// Ignores all further data until the stream is reset.
+void StreamParser::fail()
+{
+    reset();
+    m_failed = true;
+}
+
+void StreamParser::reset()
+{
+    m_buffer.clear();
+    m_position = 0;
+    m_tagStart = 0;
+    m_elementStart = 0;
+    m_depth = 0;
+    m_state = Text;
+    m_quote = 0;
+    m_failed = false;
+}
+
+qsizetype StreamParser::pendingElementSize() const
+{
+    if (m_depth > 1) {
+        return m_position - m_elementStart;
+    }
+    if (m_state != Text) {
+        return m_position - m_tagStart;
     }
+    return 0;
+}
 
-    // process stream end
-    if (hasStreamClose) {
-        Q_EMIT streamClosed();
+void StreamParser::handleTagEnd(std::vector<Event> &events)
+{
+    const auto tagEnd = m_position + 1;
+    auto tag = [&]() { return m_buffer.mid(m_tagStart, tagEnd - m_tagStart); };
+
+    if (m_state == EndTag) {
+        if (m_depth <= 1) {
+            m_depth = 0;
+            events.push_back(StreamClose {});
+        } else if (--m_depth == 1) {
+            events.push_back(Element { m_buffer.mid(m_elementStart, tagEnd - m_elementStart) });
+        }
+    } else if (m_state == StartTag) {
+        const bool selfClosing = m_buffer.at(m_position - 1) == '/';
+        // a new stream header at the top-level restarts the stream (e.g. after SASL)
+        auto isStreamTag = [&]() {
+            const auto nameEnd = m_tagStart + 1 + 13;
+            if (nameEnd > m_position || qstrncmp(m_buffer.constData() + m_tagStart + 1, "stream:stream", 13) != 0) {
+                return false;
+            }
+            const auto c = m_buffer.at(nameEnd);
+            return isXmlWhitespace(c) || c == '>' || c == '/';
+        };
+        const bool isStreamOpen = m_depth == 0 || (m_depth == 1 && isStreamTag());
+
+        if (isStreamOpen) {
+            m_depth = 1;
+            events.push_back(StreamOpen { tag() });
+        } else if (m_depth == 1 && selfClosing) {
+            events.push_back(Element { tag(), true });
+        } else if (!selfClosing) {
+            if (++m_depth == 2) {
+                m_elementStart = m_tagStart;
+            }
+        }
     }
+    m_state = Text;
 }
 
 }  // namespace QXmpp::Private
@@ -0,0 +1,187 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include <QtGlobal>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QXmpp API.
+//
+// This header file may change from version to version without notice,
+// or even be removed.
+//
+// We mean it.
+//
+
+namespace QXmpp::Private {
+
+//
+// Hashed timer wheel for large numbers of timeouts.
+//
+// Deadlines are rounded up to ticks of a fixed resolution and stored in the slot of their tick,
+// deadlines more than one rotation ahead stay in their slot until their tick is reached. Adding
+// and removing timers is O(1) and does not allocate once the node pool has grown.
+//
+// The wheel does not run a timer itself, expire() needs to be called regularly (usually with
+// the resolution as interval while the wheel is not empty).
+//
+template<typename T>
+class TimerWheel
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Handle {
+        quint32 index = NONE;
+        quint32 generation = 0;
+
+        bool isNull() const { return index == NONE; }
+    };
+
+    explicit TimerWheel(std::chrono::milliseconds resolution = std::chrono::milliseconds(100), std::size_t slots = 512, Clock::time_point start = Clock::now())
+        : m_resolution(resolution),
+          m_start(start),
+          m_slots(slots, NONE)
+    {
+        Q_ASSERT(resolution.count() > 0);
+        Q_ASSERT(slots > 0 && (slots & (slots - 1)) == 0);
+    }
+
+    std::chrono::milliseconds resolution() const { return m_resolution; }
+    bool isEmpty() const { return m_size == 0; }
+    std::size_t size() const { return m_size; }
+
+    Handle add(Clock::time_point deadline, T value)
+    {
+        // never schedule into the past, expired deadlines fire on the next tick
+        const auto tick = std::max(tickAt(deadline, true), m_currentTick + 1);
+
+        quint32 index;
+        if (m_freeNodes != NONE) {
+            index = m_freeNodes;
+            m_freeNodes = m_nodes[index].next;
+        } else {
+            index = quint32(m_nodes.size());
+            m_nodes.emplace_back();
+        }
+
+        auto &node = m_nodes[index];
+        node.value.emplace(std::move(value));
+        node.tick = tick;
+        link(index);
+        m_size++;
+        return { index, node.generation };
+    }
+
+    // Returns false if the timer has already expired or been removed.
+    bool remove(Handle handle)
+    {
+        if (handle.index >= m_nodes.size() || m_nodes[handle.index].generation != handle.generation || !m_nodes[handle.index].value) {
+            return false;
+        }
+        release(handle.index);
+        return true;
+    }
+
+    // Removes and returns the values of all timers with a deadline up to \a now.
+    std::vector<T> expire(Clock::time_point now = Clock::now())
+    {
+        std::vector<T> expired;
+        const auto nowTick = tickAt(now, false);
+        if (nowTick <= m_currentTick) {
+            return expired;
+        }
+
+        // each slot only needs to be visited once, even if more than one rotation has passed
+        const auto ticks = std::min<quint64>(nowTick - m_currentTick, m_slots.size());
+        for (quint64 tick = m_currentTick + 1; tick <= m_currentTick + ticks; tick++) {
+            auto index = m_slots[tick & (m_slots.size() - 1)];
+            while (index != NONE) {
+                const auto next = m_nodes[index].next;
+                if (m_nodes[index].tick <= nowTick) {
+                    expired.push_back(std::move(*m_nodes[index].value));
+                    release(index);
+                }
+                index = next;
+            }
+        }
+        m_currentTick = nowTick;
+        return expired;
+    }
+
+private:
+    static constexpr quint32 NONE = std::numeric_limits<quint32>::max();
+
+    struct Node {
+        std::optional<T> value;
+        quint64 tick = 0;
+        quint32 generation = 0;
+        quint32 previous = NONE;
+        quint32 next = NONE;
+    };
+
+    quint64 tickAt(Clock::time_point time, bool roundUp) const
+    {
+        if (time <= m_start) {
+            return 0;
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(time - m_start).count();
+        return quint64((elapsed + (roundUp ? m_resolution.count() - 1 : 0)) / m_resolution.count());
+    }
+
+    void link(quint32 index)
+    {
+        auto &node = m_nodes[index];
+        auto &head = m_slots[node.tick & (m_slots.size() - 1)];
+        node.previous = NONE;
+        node.next = head;
+        if (head != NONE) {
+            m_nodes[head].previous = index;
+        }
+        head = index;
+    }
+
+    void release(quint32 index)
+    {
+        auto &node = m_nodes[index];
+        if (node.previous != NONE) {
+            m_nodes[node.previous].next = node.next;
+        } else {
+            m_slots[node.tick & (m_slots.size() - 1)] = node.next;
+        }
+        if (node.next != NONE) {
+            m_nodes[node.next].previous = node.previous;
+        }
+
+        node.value.reset();
+        node.generation++;
+        node.previous = NONE;
+        node.next = m_freeNodes;
+        m_freeNodes = index;
+        m_size--;
+    }
+
+    std::chrono::milliseconds m_resolution;
+    Clock::time_point m_start;
+    quint64 m_currentTick = 0;
+    std::vector<quint32> m_slots;
+    std::vector<Node> m_nodes;
+    quint32 m_freeNodes = NONE;
+    std::size_t m_size = 0;
+};
+
+}  // namespace QXmpp::Private
+
+#endif  // TIMERWHEEL_H
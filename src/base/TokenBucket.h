@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef TOKENBUCKET_H
+#define TOKENBUCKET_H
+
+#include <algorithm>
+#include <chrono>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QXmpp API.
+//
+// This header file may change from version to version without notice,
+// or even be removed.
+//
+// We mean it.
+//
+
+namespace QXmpp::Private {
+
+//
+// Token bucket for rate limiting.
+//
+// The bucket is refilled with a constant rate up to its capacity, which is the maximum burst.
+// Amounts larger than the capacity can be taken once the bucket is full, the bucket then goes
+// into debt so that the average rate is kept.
+//
+class TokenBucket
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TokenBucket() = default;
+    // A rate of 0 disables the bucket, i.e. tokens are always available.
+    TokenBucket(double rate, double capacity, Clock::time_point now = Clock::now())
+        : m_rate(std::max(rate, 0.0)),
+          m_capacity(std::max(capacity, 0.0)),
+          m_tokens(m_capacity),
+          m_lastRefill(now)
+    {
+    }
+
+    bool isEnabled() const { return m_rate > 0; }
+    double rate() const { return m_rate; }
+    double capacity() const { return m_capacity; }
+    double tokens(Clock::time_point now = Clock::now()) const
+    {
+        return std::min(m_capacity, m_tokens + m_rate * std::chrono::duration<double>(now - m_lastRefill).count());
+    }
+
+    bool isAvailable(double amount, Clock::time_point now = Clock::now()) const
+    {
+        return !isEnabled() || tokens(now) >= std::min(amount, m_capacity);
+    }
+
+    // Time until isAvailable() returns true for the amount.
+    Clock::duration delay(double amount, Clock::time_point now = Clock::now()) const
+    {
+        const auto missing = std::min(amount, m_capacity) - tokens(now);
+        if (!isEnabled() || missing <= 0) {
+            return Clock::duration::zero();
+        }
+        return std::chrono::ceil<Clock::duration>(std::chrono::duration<double>(missing / m_rate));
+    }
+
+    // Takes the amount regardless of the available tokens.
+    void take(double amount, Clock::time_point now = Clock::now())
+    {
+        if (isEnabled()) {
+            m_tokens = tokens(now) - amount;
+            m_lastRefill = now;
+        }
+    }
+
+private:
+    double m_rate = 0;
+    double m_capacity = 0;
+    double m_tokens = 0;
+    Clock::time_point m_lastRefill;
+};
+
+}  // namespace QXmpp::Private
+
+#endif  // TOKENBUCKET_H
@@ -0,0 +1,576 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "XmlTree.h"
+
+#include <algorithm>
+
+namespace QXmpp::Private {
+
+constexpr std::string_view XML_NAMESPACE = "http://www.w3.org/XML/1998/namespace";
+constexpr std::string_view STREAM_NAMESPACE = "http://etherx.jabber.org/streams";
+
+static QString fromUtf8(std::string_view str)
+{
+    return QString::fromUtf8(str.data(), int(str.size()));
+}
+
+static bool isAscii(std::string_view str)
+{
+    return std::all_of(str.begin(), str.end(), [](char c) { return uchar(c) < 0x80; });
+}
+
+// Compares UTF-8 with UTF-16 without decoding in the common case of ASCII strings
+static bool equals(std::string_view utf8, QStringView str)
+{
+    if (utf8.size() != size_t(str.size())) {
+        // the length can only differ if there are non-ASCII characters
+        return !isAscii(utf8) && fromUtf8(utf8) == str;
+    }
+    for (size_t i = 0; i < utf8.size(); i++) {
+        const auto c = uchar(utf8[i]);
+        if (c >= 0x80) {
+            return fromUtf8(utf8) == str;
+        }
+        if (c != str[qsizetype(i)].unicode()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool isNameEnd(char c)
+{
+    return isSpace(c) || c == '/' || c == '>' || c == '=';
+}
+
+static std::pair<std::string_view, std::string_view> splitName(std::string_view qualifiedName)
+{
+    const auto colon = qualifiedName.find(':');
+    if (colon == std::string_view::npos) {
+        return { {}, qualifiedName };
+    }
+    return { qualifiedName.substr(0, colon), qualifiedName.substr(colon + 1) };
+}
+
+// Decodes entity references and normalizes line endings (and whitespace of attribute values)
+static void appendDecoded(QString &out, std::string_view raw, bool attributeValue)
+{
+    size_t segmentStart = 0;
+    auto flush = [&](size_t end) {
+        if (end > segmentStart) {
+            out += fromUtf8(raw.substr(segmentStart, end - segmentStart));
+        }
+    };
+
+    for (size_t i = 0; i < raw.size(); i++) {
+        const char c = raw[i];
+        if (c == '&') {
+            const auto end = raw.find(';', i);
+            if (end == std::string_view::npos) {
+                continue;
+            }
+            flush(i);
+
+            const auto entity = raw.substr(i + 1, end - i - 1);
+            if (entity == "lt") {
+                out += u'<';
+            } else if (entity == "gt") {
+                out += u'>';
+            } else if (entity == "amp") {
+                out += u'&';
+            } else if (entity == "quot") {
+                out += u'"';
+            } else if (entity == "apos") {
+                out += u'\'';
+            } else if (entity.size() > 1 && entity[0] == '#') {
+                const bool hex = entity[1] == 'x';
+                const auto digits = entity.substr(hex ? 2 : 1);
+                bool ok = false;
+                const auto codePoint = QByteArray::fromRawData(digits.data(), int(digits.size())).toUInt(&ok, hex ? 16 : 10);
+                if (ok && QChar::requiresSurrogates(codePoint)) {
+                    out += QChar(QChar::highSurrogate(codePoint));
+                    out += QChar(QChar::lowSurrogate(codePoint));
+                } else if (ok) {
+                    out += QChar(codePoint);
+                }
+            } else {
+                // unknown entity, keep as is
+                out += fromUtf8(raw.substr(i, end - i + 1));
+            }
+            i = end;
+            segmentStart = end + 1;
+        } else if (c == '\r') {
+            flush(i);
+            out += attributeValue ? u' ' : u'\n';
+            if (i + 1 < raw.size() && raw[i + 1] == '\n') {
+                i++;
+            }
+            segmentStart = i + 1;
+        } else if (attributeValue && (c == '\n' || c == '\t')) {
+            flush(i);
+            out += u' ';
+            segmentStart = i + 1;
+        }
+    }
+    flush(raw.size());
+}
+
+static void appendText(QString &out, const XmlNode *node)
+{
+    for (auto *child = node->firstChild; child; child = child->nextSibling) {
+        switch (child->type) {
+        case XmlNode::Element:
+            appendText(out, child);
+            break;
+        case XmlNode::Text:
+            appendDecoded(out, child->name, false);
+            break;
+        case XmlNode::CData:
+            out += fromUtf8(child->name);
+            break;
+        }
+    }
+}
+
+static bool matches(const XmlNode *node, QStringView tagName, QStringView namespaceUri)
+{
+    return node->type == XmlNode::Element &&
+        (namespaceUri.isEmpty() || equals(node->namespaceUri, namespaceUri)) &&
+        (tagName.isEmpty() || equals(node->name, tagName));
+}
+
+XmlArena::XmlArena(std::size_t initialBlockSize)
+    : m_blockSize(std::max<std::size_t>(initialBlockSize, 256))
+{
+}
+
+void *XmlArena::allocate(std::size_t size, std::size_t alignment)
+{
+    auto offset = (m_used + alignment - 1) & ~(alignment - 1);
+    if (m_blocks.empty() || offset + size > m_blockSize) {
+        // grow geometrically, so large elements only need a few blocks
+        if (!m_blocks.empty()) {
+            m_blockSize *= 2;
+        }
+        m_blockSize = std::max(m_blockSize, size);
+        m_blocks.push_back(std::unique_ptr<std::byte[]>(new std::byte[m_blockSize]));
+        offset = 0;
+    }
+    m_used = offset + size;
+    return m_blocks.back().get() + offset;
+}
+
+//
+// Non-validating parser for one complete element. DTDs are not supported as they are not allowed
+// in XMPP.
+//
+class XmlParser
+{
+public:
+    XmlParser(std::string_view data, XmlArena &arena, std::string_view defaultNamespace)
+        : m_data(data),
+          m_arena(arena),
+          m_namespaces { { {}, defaultNamespace }, { "xml", XML_NAMESPACE }, { "stream", STREAM_NAMESPACE } }
+    {
+    }
+
+    XmlNode *parse();
+
+private:
+    struct OpenElement {
+        XmlNode *node;
+        XmlNode *lastChild;
+        std::string_view qualifiedName;
+        size_t namespaceCount;
+    };
+
+    bool skipUntil(std::string_view terminator);
+    void skipSpaces();
+    std::string_view readName();
+    bool parseStartTag();
+    bool parseEndTag();
+    void appendChild(XmlNode *node);
+    std::optional<std::string_view> resolve(std::string_view prefix) const;
+
+    std::string_view m_data;
+    size_t m_pos = 0;
+    XmlArena &m_arena;
+    XmlNode *m_root = nullptr;
+    std::vector<OpenElement> m_stack;
+    std::vector<std::pair<std::string_view, std::string_view>> m_namespaces;
+};
+
+XmlNode *XmlParser::parse()
+{
+    while (m_pos < m_data.size()) {
+        if (m_data[m_pos] != '<') {
+            auto end = std::min(m_data.find('<', m_pos), m_data.size());
+            const auto text = m_data.substr(m_pos, end - m_pos);
+            m_pos = end;
+
+            if (std::all_of(text.begin(), text.end(), isSpace)) {
+                continue;
+            }
+            // text is only allowed inside of the root element
+            if (m_stack.empty()) {
+                return nullptr;
+            }
+
+            auto *node = m_arena.create<XmlNode>();
+            node->type = XmlNode::Text;
+            node->name = text;
+            appendChild(node);
+            continue;
+        }
+
+        const auto rest = m_data.substr(m_pos);
+        if (rest.starts_with("<!--")) {
+            m_pos += 4;
+            if (!skipUntil("-->")) {
+                return nullptr;
+            }
+        } else if (rest.starts_with("<![CDATA[")) {
+            const auto start = m_pos + 9;
+            const auto end = m_data.find("]]>", start);
+            if (m_stack.empty() || end == std::string_view::npos) {
+                return nullptr;
+            }
+
+            auto *node = m_arena.create<XmlNode>();
+            node->type = XmlNode::CData;
+            node->name = m_data.substr(start, end - start);
+            appendChild(node);
+            m_pos = end + 3;
+        } else if (rest.starts_with("<?")) {
+            m_pos += 2;
+            if (!skipUntil("?>")) {
+                return nullptr;
+            }
+        } else if (rest.starts_with("</")) {
+            if (!parseEndTag()) {
+                return nullptr;
+            }
+        } else if (rest.starts_with("<!")) {
+            return nullptr;
+        } else if (!parseStartTag()) {
+            return nullptr;
+        }
+    }
+
+    // all elements need to be closed
+    return m_stack.empty() ? m_root : nullptr;
+}
+
+bool XmlParser::skipUntil(std::string_view terminator)
+{
+    const auto end = m_data.find(terminator, m_pos);
+    if (end == std::string_view::npos) {
+        return false;
+    }
+    m_pos = end + terminator.size();
+    return true;
+}
+
+void XmlParser::skipSpaces()
+{
+    while (m_pos < m_data.size() && isSpace(m_data[m_pos])) {
+        m_pos++;
+    }
+}
+
+std::string_view XmlParser::readName()
+{
+    const auto start = m_pos;
+    while (m_pos < m_data.size() && !isNameEnd(m_data[m_pos])) {
+        m_pos++;
+    }
+    return m_data.substr(start, m_pos - start);
+}
+
+bool XmlParser::parseStartTag()
+{
+    // only one root element is allowed
+    if (m_stack.empty() && m_root) {
+        return false;
+    }
+
+    m_pos++;
+    const auto qualifiedName = readName();
+    if (qualifiedName.empty()) {
+        return false;
+    }
+
+    auto *node = m_arena.create<XmlNode>();
+    const auto namespaceCount = m_namespaces.size();
+    XmlAttributeNode *lastAttribute = nullptr;
+    bool selfClosing = false;
+
+    while (true) {
+        skipSpaces();
+        if (m_pos >= m_data.size()) {
+            return false;
+        }
+        if (m_data[m_pos] == '>') {
+            m_pos++;
+            break;
+        }
+        if (m_data[m_pos] == '/') {
+            if (m_pos + 1 >= m_data.size() || m_data[m_pos + 1] != '>') {
+                return false;
+            }
+            m_pos += 2;
+            selfClosing = true;
+            break;
+        }
+
+        const auto name = readName();
+        skipSpaces();
+        if (name.empty() || m_pos >= m_data.size() || m_data[m_pos] != '=') {
+            return false;
+        }
+        m_pos++;
+        skipSpaces();
+        if (m_pos >= m_data.size() || (m_data[m_pos] != '"' && m_data[m_pos] != '\'')) {
+            return false;
+        }
+        const auto valueEnd = m_data.find(m_data[m_pos], m_pos + 1);
+        if (valueEnd == std::string_view::npos) {
+            return false;
+        }
+        const auto value = m_data.substr(m_pos + 1, valueEnd - m_pos - 1);
+        m_pos = valueEnd + 1;
+
+        if (name == "xmlns") {
+            m_namespaces.push_back({ {}, value });
+        } else if (name.starts_with("xmlns:")) {
+            m_namespaces.push_back({ name.substr(6), value });
+        } else {
+            auto *attribute = m_arena.create<XmlAttributeNode>();
+            attribute->qualifiedName = name;
+            attribute->name = name;
+            attribute->value = value;
+            if (lastAttribute) {
+                lastAttribute->next = attribute;
+            } else {
+                node->attributes = attribute;
+            }
+            lastAttribute = attribute;
+        }
+    }
+
+    // namespace declarations of the element also apply to itself and its attributes
+    const auto [prefix, localName] = splitName(qualifiedName);
+    const auto namespaceUri = resolve(prefix);
+    if (!namespaceUri) {
+        return false;
+    }
+    node->name = localName;
+    node->namespaceUri = *namespaceUri;
+
+    for (auto *attribute = node->attributes; attribute; attribute = attribute->next) {
+        const auto [attributePrefix, attributeName] = splitName(attribute->qualifiedName);
+        attribute->name = attributeName;
+        // attributes without prefix do not have a namespace
+        if (!attributePrefix.empty()) {
+            const auto attributeNamespace = resolve(attributePrefix);
+            if (!attributeNamespace) {
+                return false;
+            }
+            attribute->namespaceUri = *attributeNamespace;
+        }
+    }
+
+    appendChild(node);
+    if (selfClosing) {
+        m_namespaces.resize(namespaceCount);
+    } else {
+        m_stack.push_back({ node, nullptr, qualifiedName, namespaceCount });
+    }
+    return true;
+}
+
+bool XmlParser::parseEndTag()
+{
+    m_pos += 2;
+    const auto qualifiedName = readName();
+    skipSpaces();
+    if (m_pos >= m_data.size() || m_data[m_pos] != '>') {
+        return false;
+    }
+    m_pos++;
+
+    if (m_stack.empty() || m_stack.back().qualifiedName != qualifiedName) {
+        return false;
+    }
+    m_namespaces.resize(m_stack.back().namespaceCount);
+    m_stack.pop_back();
+    return true;
+}
+
+void XmlParser::appendChild(XmlNode *node)
+{
+    if (m_stack.empty()) {
+        m_root = node;
+        return;
+    }
+
+    auto &parent = m_stack.back();
+    node->parent = parent.node;
+    if (parent.lastChild) {
+        parent.lastChild->nextSibling = node;
+    } else {
+        parent.node->firstChild = node;
+    }
+    parent.lastChild = node;
+}
+
+std::optional<std::string_view> XmlParser::resolve(std::string_view prefix) const
+{
+    for (auto itr = m_namespaces.rbegin(); itr != m_namespaces.rend(); ++itr) {
+        if (itr->first == prefix) {
+            return itr->second;
+        }
+    }
+    return {};
+}
+
+QString XmlElement::tagName() const
+{
+    return n ? fromUtf8(n->name) : QString();
+}
+
+QString XmlElement::namespaceURI() const
+{
+    return n ? fromUtf8(n->namespaceUri) : QString();
+}
+
+bool XmlElement::hasTagName(QStringView tagName) const
+{
+    return n && equals(n->name, tagName);
+}
+
+bool XmlElement::hasNamespace(QStringView namespaceUri) const
+{
+    return n && equals(n->namespaceUri, namespaceUri);
+}
+
+bool XmlElement::hasAttribute(QStringView name) const
+{
+    return findAttribute(name) != nullptr;
+}
+
+QString XmlElement::attribute(QStringView name, const QString &defaultValue) const
+{
+    if (const auto *attribute = findAttribute(name)) {
+        QString value;
+        appendDecoded(value, attribute->value, true);
+        return value;
+    }
+    return defaultValue;
+}
+
+QString XmlElement::attributeNS(QStringView namespaceUri, QStringView localName, const QString &defaultValue) const
+{
+    if (const auto *attribute = findAttribute(namespaceUri, localName)) {
+        QString value;
+        appendDecoded(value, attribute->value, true);
+        return value;
+    }
+    return defaultValue;
+}
+
+QString XmlElement::text() const
+{
+    QString text;
+    if (n) {
+        appendText(text, n);
+    }
+    return text;
+}
+
+XmlElement XmlElement::firstChildElement(QStringView tagName, QStringView namespaceUri) const
+{
+    for (auto *child = n ? n->firstChild : nullptr; child; child = child->nextSibling) {
+        if (matches(child, tagName, namespaceUri)) {
+            return XmlElement(child);
+        }
+    }
+    return {};
+}
+
+XmlElement XmlElement::nextSiblingElement(QStringView tagName, QStringView namespaceUri) const
+{
+    for (auto *sibling = n ? n->nextSibling : nullptr; sibling; sibling = sibling->nextSibling) {
+        if (matches(sibling, tagName, namespaceUri)) {
+            return XmlElement(sibling);
+        }
+    }
+    return {};
+}
+
+const XmlAttributeNode *XmlElement::findAttribute(QStringView name) const
+{
+    for (auto *attribute = n ? n->attributes : nullptr; attribute; attribute = attribute->next) {
+        if (equals(attribute->qualifiedName, name)) {
+            return attribute;
+        }
+    }
+    return nullptr;
+}
+
+const XmlAttributeNode *XmlElement::findAttribute(QStringView namespaceUri, QStringView localName) const
+{
+    for (auto *attribute = n ? n->attributes : nullptr; attribute; attribute = attribute->next) {
+        if (equals(attribute->name, localName) && equals(attribute->namespaceUri, namespaceUri)) {
+            return attribute;
+        }
+    }
+    return nullptr;
+}
+
+XmlDocument::XmlDocument(const QByteArray &data, std::string_view defaultNamespace)
+    : m_data(data),
+      m_defaultNamespace(defaultNamespace.data(), int(defaultNamespace.size())),
+      // the tree of an element is usually smaller than its serialized form
+      m_arena(std::make_unique<XmlArena>(size_t(data.size())))
+{
+}
+
+///
+/// Parses a complete element from UTF-8 data.
+///
+/// The tree points into \a data, which is shared (not copied) by the document.
+///
+std::optional<XmlDocument> XmlDocument::parse(const QByteArray &data, std::string_view defaultNamespace)
+{
+    XmlDocument document(data, defaultNamespace);
+    XmlParser parser(
+        std::string_view(document.m_data.constData(), size_t(document.m_data.size())),
+        *document.m_arena,
+        std::string_view(document.m_defaultNamespace.constData(), size_t(document.m_defaultNamespace.size())));
+
+    document.m_root = parser.parse();
+    if (!document.m_root) {
+        return {};
+    }
+    return std::move(document);
+}
+
+XmlElement firstChildElement(const XmlElement &el, QStringView tagName, QStringView xmlNs)
+{
+    return el.firstChildElement(tagName, xmlNs);
+}
+
+XmlElement nextSiblingElement(const XmlElement &el, QStringView tagName, QStringView xmlNs)
+{
+    return el.nextSiblingElement(tagName, xmlNs);
+}
+
+}  // namespace QXmpp::Private
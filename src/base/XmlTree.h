@@ -0,0 +1,174 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef XMLTREE_H
+#define XMLTREE_H
+
+#include "QXmppGlobal.h"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QXmpp API.
+//
+// This header file may change from version to version without notice,
+// or even be removed.
+//
+// We mean it.
+//
+
+namespace QXmpp::Private {
+
+//
+// Simple bump allocator. Memory is only released when the arena is destroyed, so only trivially
+// destructible objects can be created in it.
+//
+class XmlArena
+{
+public:
+    explicit XmlArena(std::size_t initialBlockSize = 1024);
+
+    template<typename T>
+    T *create()
+    {
+        static_assert(std::is_trivially_destructible_v<T>);
+        return new (allocate(sizeof(T), alignof(T))) T {};
+    }
+
+private:
+    void *allocate(std::size_t size, std::size_t alignment);
+
+    std::vector<std::unique_ptr<std::byte[]>> m_blocks;
+    std::size_t m_blockSize;
+    std::size_t m_used = 0;
+};
+
+struct XmlAttributeNode {
+    // name including the prefix, e.g. "xml:lang"
+    std::string_view qualifiedName;
+    std::string_view name;
+    std::string_view namespaceUri;
+    std::string_view value;
+    XmlAttributeNode *next = nullptr;
+};
+
+struct XmlNode {
+    enum Type : quint8 {
+        Element,
+        Text,
+        CData,
+    };
+
+    Type type = Element;
+    // local name for elements, raw content for text nodes
+    std::string_view name;
+    std::string_view namespaceUri;
+    XmlAttributeNode *attributes = nullptr;
+    XmlNode *parent = nullptr;
+    XmlNode *firstChild = nullptr;
+    XmlNode *nextSibling = nullptr;
+};
+
+//
+// Read-only handle to an element of an XmlDocument, mirrors the parts of QDomElement that are used
+// by the stanza parsers. All strings are stored as UTF-8 views into the parsed data and are only
+// decoded when requested.
+//
+class QXMPP_AUTOTEST_EXPORT XmlElement
+{
+public:
+    XmlElement() = default;
+    explicit XmlElement(const XmlNode *node) : n(node) { }
+
+    bool isNull() const { return n == nullptr; }
+
+    QString tagName() const;
+    QString namespaceURI() const;
+    std::string_view tagNameUtf8() const { return n ? n->name : std::string_view(); }
+    std::string_view namespaceUtf8() const { return n ? n->namespaceUri : std::string_view(); }
+    bool hasTagName(QStringView tagName) const;
+    bool hasNamespace(QStringView namespaceUri) const;
+
+    // attributes are looked up by their qualified name, like in QDomElement
+    bool hasAttribute(QStringView name) const;
+    QString attribute(QStringView name, const QString &defaultValue = {}) const;
+    QString attributeNS(QStringView namespaceUri, QStringView localName, const QString &defaultValue = {}) const;
+    QString text() const;
+
+    XmlElement parentElement() const { return XmlElement(n ? n->parent : nullptr); }
+    XmlElement firstChildElement(QStringView tagName = {}, QStringView namespaceUri = {}) const;
+    XmlElement nextSiblingElement(QStringView tagName = {}, QStringView namespaceUri = {}) const;
+
+    bool operator==(const XmlElement &other) const { return n == other.n; }
+
+private:
+    const XmlAttributeNode *findAttribute(QStringView name) const;
+    const XmlAttributeNode *findAttribute(QStringView namespaceUri, QStringView localName) const;
+
+    const XmlNode *n = nullptr;
+};
+
+//
+// Owns the tree of one parsed element (usually one stanza) and the data the tree points into.
+//
+class QXMPP_AUTOTEST_EXPORT XmlDocument
+{
+public:
+    static std::optional<XmlDocument> parse(const QByteArray &data, std::string_view defaultNamespace = {});
+
+    XmlElement documentElement() const { return XmlElement(m_root); }
+
+private:
+    XmlDocument(const QByteArray &data, std::string_view defaultNamespace);
+
+    QByteArray m_data;
+    QByteArray m_defaultNamespace;
+    std::unique_ptr<XmlArena> m_arena;
+    const XmlNode *m_root = nullptr;
+};
+
+QXMPP_AUTOTEST_EXPORT XmlElement firstChildElement(const XmlElement &, QStringView tagName = {}, QStringView xmlNs = {});
+QXMPP_AUTOTEST_EXPORT XmlElement nextSiblingElement(const XmlElement &, QStringView tagName = {}, QStringView xmlNs = {});
+
+struct XmlChildElements {
+    XmlElement parent;
+    QStringView tagName;
+    QStringView namespaceUri;
+
+    struct EndIterator { };
+    struct Iterator {
+        Iterator operator++()
+        {
+            el = nextSiblingElement(el, tagName, namespaceUri);
+            return *this;
+        }
+        bool operator!=(EndIterator) const { return !el.isNull(); }
+        const XmlElement &operator*() const { return el; }
+
+        XmlElement el;
+        QStringView tagName;
+        QStringView namespaceUri;
+    };
+
+    Iterator begin() const { return { firstChildElement(parent, tagName, namespaceUri), tagName, namespaceUri }; }
+    EndIterator end() const { return {}; }
+};
+
+inline XmlChildElements iterChildElements(const XmlElement &el, QStringView tagName = {}, QStringView namespaceUri = {}) { return XmlChildElements { el, tagName, namespaceUri }; }
+
+}  // namespace QXmpp::Private
+
+#endif  // XMLTREE_H
@@ -6,14 +6,25 @@
 #define XMPPSOCKET_H
 
 #include "QXmppLogger.h"
+#include "QXmppStreamError.h"
+#include "QXmppUtils_p.h"
+
+#include <chrono>
+#include <functional>
+#include <variant>
+#include <vector>
 
 class QDomElement;
 class QSslSocket;
+class QTcpSocket;
+class QTimer;
 class TestStream;
 class tst_QXmppStream;
 
 namespace QXmpp::Private {
 
+class XmlElement;
+
 struct ServerAddress {
     enum ConnectionType {
         Tcp,
@@ -25,6 +36,66 @@ struct ServerAddress {
     quint16 port;
 };
 
+//
+// Incremental parser for the incoming XML stream.
+//
+// Received UTF-8 data is appended to an internal buffer and every byte is scanned exactly once.
+// Each top-level element of the stream is reported as soon as its end tag has arrived; data that
+// belongs to a partially received element is kept for the next call. All XML delimiters are ASCII,
+// so the data never needs to be decoded for splitting.
+//
+class StreamParser
+{
+public:
+    struct StreamOpen {
+        QByteArray xml;
+    };
+    struct Element {
+        QByteArray xml;
+        // self-closing top-level element without children
+        bool empty = false;
+    };
+    struct StreamClose { };
+    struct SizeLimitExceeded { };
+    using Event = std::variant<StreamOpen, Element, StreamClose, SizeLimitExceeded>;
+
+    std::vector<Event> parse(const QByteArray &data);
+    void fail();
+    void reset();
+
+    bool hasPendingData() const { return !m_buffer.isEmpty(); }
+    qsizetype bufferedSize() const { return m_buffer.size(); }
+
+    // Maximum size of a single top-level element (or tag) in bytes, 0 means unlimited.
+    qsizetype maximumElementSize() const { return m_maximumElementSize; }
+    void setMaximumElementSize(qsizetype size) { m_maximumElementSize = size; }
+
+private:
+    enum State {
+        Text,
+        TagOpen,
+        StartTag,
+        EndTag,
+        ProcessingInstruction,
+        Comment,
+        CData,
+        Declaration,
+    };
+
+    void handleTagEnd(std::vector<Event> &events);
+    qsizetype pendingElementSize() const;
+
+    QByteArray m_buffer;
+    qsizetype m_position = 0;
+    qsizetype m_tagStart = 0;
+    qsizetype m_elementStart = 0;
+    int m_depth = 0;
+    State m_state = Text;
+    char m_quote = 0;
+    qsizetype m_maximumElementSize = 0;
+    bool m_failed = false;
+};
+
 class SendDataInterface
 {
 public:
@@ -43,25 +114,81 @@ public:
 
     bool isConnected() const;
     void connectToHost(const ServerAddress &);
+    bool connectToSocket(const ServerAddress &, QTcpSocket *connectedSocket);
     void disconnectFromHost();
     bool sendData(const QByteArray &) override;
+    bool sendData(const char *data, qsizetype size);
+    // Sends a complete element, serialized into the buffer of this connection.
+    template<typename Packet>
+    bool sendXml(const Packet &packet)
+    {
+        return m_serializationBuffer.serialize(packet, [this](const char *data, qsizetype size) {
+            return sendData(data, size);
+        });
+    }
+    SerializationBuffer &serializationBuffer() { return m_serializationBuffer; }
+
+    // Called with empty top-level elements (e.g. stream management acks) before they are parsed
+    // into a QDomElement. Returns whether the element has been handled, otherwise stanzaReceived()
+    // is emitted as usual.
+    using ElementHandler = std::function<bool(const XmlElement &)>;
+    void setEmptyElementHandler(ElementHandler handler) { m_emptyElementHandler = std::move(handler); }
+
+    qint64 maximumStanzaSize() const;
+    void setMaximumStanzaSize(qint64 size);
+    qint64 maximumBufferSize() const { return m_maximumBufferSize; }
+    void setMaximumBufferSize(qint64 size);
+
+    bool isWriteCoalescingEnabled() const { return m_writeCoalescingEnabled; }
+    void setWriteCoalescingEnabled(bool enabled);
+    qint64 writeCoalescingThreshold() const { return m_writeCoalescingThreshold; }
+    void setWriteCoalescingThreshold(qint64 bytes) { m_writeCoalescingThreshold = bytes; }
+    std::chrono::milliseconds writeCoalescingDelay() const;
+    void setWriteCoalescingDelay(std::chrono::milliseconds delay);
+    bool flush();
+    // Outgoing data that has not been written to the network yet, including held back data.
+    qint64 bytesToWrite() const;
 
     Q_SIGNAL void started();
     Q_SIGNAL void stanzaReceived(const QDomElement &);
     Q_SIGNAL void streamReceived(const QDomElement &);
     Q_SIGNAL void streamClosed();
+    // Emitted when a stream error has been sent to the peer, the stream is closed afterwards.
+    Q_SIGNAL void streamErrorSent(QXmpp::StreamError condition, const QString &text);
+    // Emitted when the socket has written (plain or encrypted) data to the network.
+    Q_SIGNAL void bytesWritten();
+    // Emitted by StreamAckManager when the buffered outgoing data has dropped below the
+    // low-water mark after the high-water mark had been reached.
+    Q_SIGNAL void writeBufferLow();
 
 private:
-    void processData(const QString &data);
+    void handleConnected();
+    void processData(const QByteArray &data);
+    void sendStreamError(StreamError condition, const QString &text);
+    void updateReadBufferSize();
+    bool writeToSocket(const char *data, qsizetype size);
 
     friend class ::tst_QXmppStream;
 
-    QString m_dataBuffer;
     bool m_directTls = false;
     QSslSocket *m_socket = nullptr;
+    qint64 m_maximumBufferSize;
+
+    SerializationBuffer m_serializationBuffer;
+
+    // outgoing data that is written with the next flush()
+    bool m_writeCoalescingEnabled = false;
+    qint64 m_writeCoalescingThreshold;
+    QByteArray m_writeBuffer;
+    qint64 m_coalescedPackets = 0;
+    QTimer *m_flushTimer;
 
     // incoming stream state
-    QString m_streamOpenElement;
+    StreamParser m_parser;
+    QByteArray m_streamOpenElement;
+    // default namespace of the stream, e.g. 'jabber:client'
+    QByteArray m_streamNamespace;
+    ElementHandler m_emptyElementHandler;
 };
 
 }  // namespace QXmpp::Private
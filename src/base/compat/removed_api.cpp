@@ -9,6 +9,7 @@
 #include "QXmppPubSubItem.h"
 #include "QXmppSessionIq.h"
 #include "QXmppStartTlsPacket.h"
+#include "QXmppTask.h"
 #include "QXmppUtils_p.h"
 
 #include "StringLiterals.h"
@@ -383,3 +384,31 @@ bool QXmppStartTlsPacket::isStartTlsPacket(const QDomElement &element, Type type
 }
 
 QT_WARNING_POP
+
+// TaskPrivate
+
+// Inline code compiled against QXmpp 1.10 and older allocates the result itself and stores the
+// continuation as std::function.
+QXmpp::Private::TaskPrivate::TaskPrivate(void (*freeResult)(void *))
+    : TaskPrivate(0, 0, freeResult)
+{
+}
+
+const std::function<void(TaskPrivate &, void *)> QXmpp::Private::TaskPrivate::continuation() const
+{
+    if (!hasContinuation()) {
+        return {};
+    }
+    return [](TaskPrivate &task, void *result) {
+        task.continuationStorage()(task, result);
+    };
+}
+
+void QXmpp::Private::TaskPrivate::setContinuation(std::function<void(TaskPrivate &, void *)> &&continuation)
+{
+    if (continuation) {
+        continuationStorage().emplace(std::move(continuation));
+    } else {
+        continuationStorage().reset();
+    }
+}
@@ -21,19 +21,24 @@
 #include "QXmppPacket_p.h"
 #include "QXmppPromise.h"
 #include "QXmppRosterManager.h"
+#include "QXmppStanzaRoute.h"
 #include "QXmppStreamManagement_p.h"
+#include "QXmppStreamResumptionState.h"
 #include "QXmppTask.h"
 #include "QXmppUtils.h"
+#include "QXmppUtils_p.h"
 #include "QXmppVCardManager.h"
 #include "QXmppVersionManager.h"
 
 #include "StringLiterals.h"
 #include "XmppSocket.h"
 
+#include <algorithm>
 #include <chrono>
 
 #include <QDomElement>
 #include <QSslSocket>
+#include <QThread>
 #include <QTimer>
 
 using namespace std::chrono_literals;
@@ -49,6 +54,80 @@ static bool isIqResponse(const QDomElement &el)
 }
 
 /// \cond
+static QXmppError clientDeletedError()
+{
+    return QXmppError { u"The client has been deleted."_s, QXmpp::SendError::Disconnected };
+}
+
+PostedResultInbox::PostedResultInbox()
+    : m_threadId(QThread::currentThreadId()),
+      m_context(new QObject())
+{
+}
+
+std::shared_ptr<PostedResultInbox> PostedResultInbox::forCurrentThread()
+{
+    struct Holder {
+        std::shared_ptr<PostedResultInbox> inbox = std::make_shared<PostedResultInbox>();
+        ~Holder() { inbox->detach(); }
+    };
+    thread_local Holder holder;
+    return holder.inbox;
+}
+
+void PostedResultInbox::finish(QXmppPromise<SendResult> &&promise, SendResult &&result)
+{
+    if (QThread::currentThreadId() == m_threadId) {
+        promise.finish(std::move(result));
+        return;
+    }
+
+    m_results.push({ std::move(promise), std::move(result) });
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!m_scheduled.exchange(true)) {
+        QMutexLocker locker(&m_mutex);
+        if (m_context) {
+            QMetaObject::invokeMethod(m_context, [inbox = shared_from_this()] { inbox->finishAll(); }, Qt::QueuedConnection);
+        }
+    }
+}
+
+void PostedResultInbox::finishAll()
+{
+    m_scheduled.store(false);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    while (auto result = m_results.pop()) {
+        result->first.finish(std::move(result->second));
+    }
+}
+
+// Called when the thread exits, results that arrive later are dropped.
+void PostedResultInbox::detach()
+{
+    QMutexLocker locker(&m_mutex);
+    delete std::exchange(m_context, nullptr);
+}
+
+PostedResult::PostedResult(QXmppPromise<SendResult> &&promise, std::shared_ptr<PostedResultInbox> &&inbox)
+    : m_promise(std::move(promise)),
+      m_inbox(std::move(inbox))
+{
+}
+
+PostedResult::~PostedResult()
+{
+    if (m_inbox) {
+        m_inbox->finish(std::move(m_promise), clientDeletedError());
+    }
+}
+
+void PostedResult::finish(SendResult &&result)
+{
+    std::exchange(m_inbox, nullptr)->finish(std::move(m_promise), std::move(result));
+}
+
 QXmppClientPrivate::QXmppClientPrivate(QXmppClient *qq)
     : clientPresence(QXmppPresence::Available),
       logger(nullptr),
@@ -61,6 +140,46 @@ QXmppClientPrivate::QXmppClientPrivate(QXmppClient *qq)
 {
 }
 
+QXmppClientPrivate::~QXmppClientPrivate()
+{
+    while (auto packet = postedPackets.pop()) {
+        packet->inbox->finish(std::move(packet->promise), clientDeletedError());
+    }
+}
+
+QXmppTask<QXmpp::SendResult> QXmppClientPrivate::post(QByteArray &&data, QXmpp::SendPriority priority)
+{
+    QXmppPromise<QXmpp::SendResult> promise;
+    auto task = promise.task();
+    postedPackets.push({ std::move(data), priority, std::move(promise), PostedResultInbox::forCurrentThread() });
+
+    // the client thread is only woken up if it is not going to send the posted packets anyway
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!postedPacketsScheduled.exchange(true)) {
+        QMetaObject::invokeMethod(q, [this] { sendPostedPackets(); }, Qt::QueuedConnection);
+    }
+    return task;
+}
+
+void QXmppClientPrivate::sendPostedPackets()
+{
+    // reset before taking the packets, so packets posted in the meantime cause a new wake-up
+    postedPacketsScheduled.store(false);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    qint64 count = 0;
+    while (auto packet = postedPackets.pop()) {
+        // the continuation is skipped if the client is deleted first, the result reports an error then
+        stream->streamAckManager().send(QXmppPacket(packet->data, true), packet->priority).then(q, [result = PostedResult(std::move(packet->promise), std::move(packet->inbox))](QXmpp::SendResult &&sendResult) mutable {
+            result.finish(std::move(sendResult));
+        });
+        count++;
+    }
+    if (count && q->isMetricsEnabled()) {
+        Q_EMIT q->updateCounter(u"send-queue.posted-packets"_s, count);
+    }
+}
+
 void QXmppClientPrivate::addProperCapability(QXmppPresence &presence)
 {
     auto *ext = q->findExtension<QXmppDiscoveryManager>();
@@ -155,51 +274,147 @@ void QXmppClientPrivate::onErrorOccurred(const QString &text, const QXmppOutgoin
 }
 /// \endcond
 
+namespace QXmpp::Private {
+
+void StanzaRouter::setExtensions(const QList<QXmppClientExtension *> &extensions)
+{
+    m_extensions = extensions;
+
+    // drop routes and counters of removed extensions
+    std::erase_if(m_declaredRoutes, [&](const auto &entry) {
+        return !m_extensions.contains(const_cast<QXmppClientExtension *>(entry.first));
+    });
+    std::erase_if(m_hits, [&](const auto &entry) {
+        return !m_extensions.contains(const_cast<QXmppClientExtension *>(entry.first));
+    });
+
+    updateIndex();
+}
+
+void StanzaRouter::setRoutes(const QXmppClientExtension *extension, const QVector<QXmppStanzaRoute> &routes)
+{
+    m_declaredRoutes[extension] = routes;
+    updateIndex();
+}
+
+void StanzaRouter::updateIndex()
+{
+    m_routes.clear();
+    m_unroutedExtensions = {};
+    m_messageHandlers.clear();
+
+    for (qsizetype i = 0; i < m_extensions.size(); i++) {
+        auto *extension = m_extensions.at(i);
+        if (auto itr = m_declaredRoutes.find(extension); itr != m_declaredRoutes.end()) {
+            for (const auto &route : std::as_const(itr->second)) {
+                m_routes[StanzaRouteKey { route.tagName, route.childNamespace, route.iqType }].insert(i);
+            }
+        } else {
+            m_unroutedExtensions.insert(i);
+        }
+
+        if (auto *messageHandler = dynamic_cast<QXmppMessageHandler *>(extension)) {
+            m_messageHandlers.push_back(messageHandler);
+        }
+    }
+}
+
+StanzaRouter::Candidates StanzaRouter::candidates(const QDomElement &stanza) const
+{
+    Candidates candidates { m_extensions, m_unroutedExtensions };
+    if (m_routes.isEmpty()) {
+        return candidates;
+    }
+
+    // the key only holds shared copies of the strings of the DOM nodes
+    StanzaRouteKey key { stanza.tagName(), {}, {} };
+    const auto iqType = key.tagName == u"iq" ? stanza.attribute(u"type"_s) : QString();
+
+    auto lookup = [&]() {
+        if (auto itr = m_routes.constFind(key); itr != m_routes.cend()) {
+            candidates.indices.unite(*itr);
+        }
+        if (!iqType.isEmpty()) {
+            key.iqType = iqType;
+            if (auto itr = m_routes.constFind(key); itr != m_routes.cend()) {
+                candidates.indices.unite(*itr);
+            }
+            key.iqType = QString();
+        }
+    };
+
+    // routes without child namespace
+    lookup();
+
+    for (auto child = stanza.firstChildElement(); !child.isNull(); child = child.nextSiblingElement()) {
+        key.childNamespace = child.namespaceURI();
+        if (!key.childNamespace.isEmpty()) {
+            lookup();
+        }
+    }
+    return candidates;
+}
+
+void StanzaRouter::addHit(const QXmppClientExtension *extension)
+{
+    m_hits[extension]++;
+}
+
+quint64 StanzaRouter::hitCount(const QXmppClientExtension *extension) const
+{
+    if (auto itr = m_hits.find(extension); itr != m_hits.end()) {
+        return itr->second;
+    }
+    return 0;
+}
+
+}  // namespace QXmpp::Private
+
 namespace QXmpp::Private::StanzaPipeline {
 
-bool process(const QList<QXmppClientExtension *> &extensions, const QDomElement &element, const std::optional<QXmppE2eeMetadata> &e2eeMetadata)
+bool process(StanzaRouter &router, const QDomElement &element, const std::optional<QXmppE2eeMetadata> &e2eeMetadata)
 {
     const bool unencrypted = !e2eeMetadata.has_value();
-    for (auto *extension : extensions) {
+    return router.candidates(element).anyOf([&](QXmppClientExtension *extension) {
         // e2e encrypted stanzas are not passed to the old handleStanza() overload, because such
         // managers are likely not handling the encrypted contents correctly (e.g. sending
         // unencrypted replies and thereby leaking information).
         if (extension->handleStanza(element, e2eeMetadata) ||
             (unencrypted && extension->handleStanza(element))) {
+            router.addHit(extension);
             return true;
         }
-    }
-    return false;
+        return false;
+    });
 }
 
 }  // namespace QXmpp::Private::StanzaPipeline
 
 namespace QXmpp::Private::MessagePipeline {
 
-bool process(QXmppClient *client, const QList<QXmppClientExtension *> &extensions, QXmppMessage &&message)
+bool process(QXmppClient *client, StanzaRouter &router, QXmppMessage &&message)
 {
-    for (auto *extension : extensions) {
-        if (auto *messageHandler = dynamic_cast<QXmppMessageHandler *>(extension)) {
-            if (messageHandler->handleMessage(message)) {
-                return true;
-            }
+    for (auto *messageHandler : router.messageHandlers()) {
+        if (messageHandler->handleMessage(message)) {
+            return true;
         }
     }
     return false;
 }
 
-bool process(QXmppClient *client, const QList<QXmppClientExtension *> &extensions, QXmppE2eeExtension *e2eeExt, const QDomElement &element)
+bool process(QXmppClient *client, StanzaRouter &router, QXmppE2eeExtension *e2eeExt, const QDomElement &element)
 {
-    if (element.tagName() != u"message") {
+    if (element.tagName() != u"message" || router.messageHandlers().empty()) {
         return false;
     }
+    const auto sceMode = e2eeExt ? (e2eeExt->isEncrypted(element) ? ScePublic : SceSensitive) : SceAll;
     QXmppMessage message;
-    if (e2eeExt) {
-        message.parse(element, e2eeExt->isEncrypted(element) ? ScePublic : SceSensitive);
+    if (client->configuration().lazyStanzaParsing()) {
+        message.parseLazily(element, sceMode);
     } else {
-        message.parse(element);
+        message.parse(element, sceMode);
     }
-    return process(client, extensions, std::move(message));
+    return process(client, router, std::move(message));
 }
 
 }  // namespace QXmpp::Private::MessagePipeline
@@ -329,6 +544,9 @@ QXmppClient::QXmppClient(InitialExtensions initialExtensions, QObject *parent)
         d->onErrorOccurred(text, error, oldError);
     });
 
+    connect(&d->stream->xmppSocket(), &XmppSocket::writeBufferLow,
+            this, &QXmppClient::writeBufferLow);
+
     // reconnection
     d->reconnectionTimer = new QTimer(this);
     d->reconnectionTimer->setSingleShot(true);
@@ -389,6 +607,7 @@ bool QXmppClient::insertExtension(int index, QXmppClientExtension *extension)
     extension->setParent(this);
     d->extensions.insert(index, extension);
     extension->setClient(this);
+    d->router.setExtensions(d->extensions);
     return true;
 }
 
@@ -400,6 +619,7 @@ bool QXmppClient::removeExtension(QXmppClientExtension *extension)
 {
     if (d->extensions.contains(extension)) {
         d->extensions.removeAll(extension);
+        d->router.setExtensions(d->extensions);
         extension->setClient(nullptr);
         delete extension;
         return true;
@@ -435,6 +655,19 @@ QList<QXmppClientExtension *> QXmppClient::extensions() const
     return d->extensions;
 }
 
+///
+/// Returns how many incoming stanzas the given extension has handled.
+///
+/// This can be used to find out which extensions are hot. The counter is reset when the
+/// extension is removed.
+///
+/// \since QXmpp 1.11
+///
+quint64 QXmppClient::handledStanzaCount(const QXmppClientExtension *extension) const
+{
+    return d->router.hitCount(extension);
+}
+
 /// Returns a modifiable reference to the current configuration of QXmppClient.
 QXmppConfiguration &QXmppClient::configuration()
 {
@@ -454,9 +687,10 @@ QXmppConfiguration &QXmppClient::configuration()
 void QXmppClient::connectToServer(const QXmppConfiguration &config,
                                   const QXmppPresence &initialPresence)
 {
-    // reset package cache from last connection
+    // reset package cache and stream management state from last connection
     if (d->stream->configuration().jidBare() != config.jidBare()) {
         d->stream->streamAckManager().resetCache();
+        d->stream->c2sStreamManager().onStreamClosed();
     }
 
     d->stream->configuration() = config;
@@ -522,19 +756,20 @@ bool QXmppClient::sendPacket(const QXmppNonza &packet)
 ///
 QXmppTask<QXmpp::SendResult> QXmppClient::sendSensitive(QXmppStanza &&stanza, const std::optional<QXmppSendStanzaParams> &params)
 {
-    const auto sendEncrypted = [this](auto &&task) {
+    const auto priority = params ? params->priority() : QXmpp::SendPriority::Interactive;
+    const auto sendEncrypted = [this, priority](auto &&task) {
         QXmppPromise<QXmpp::SendResult> interface;
-        task.then(this, [this, interface](auto &&result) mutable {
+        task.then(this, [this, interface, priority](auto &&result) mutable {
             std::visit(overloaded {
                            [&](std::unique_ptr<QXmppMessage> &&message) {
                                QByteArray xml;
                                QXmlStreamWriter writer(&xml);
                                message->toXml(&writer, QXmpp::ScePublic);
 
-                               d->stream->streamAckManager().send(QXmppPacket(xml, true, std::move(interface)));
+                               d->stream->streamAckManager().send(QXmppPacket(xml, true, std::move(interface)), priority);
                            },
                            [&](std::unique_ptr<QXmppIq> &&iq) {
-                               d->stream->streamAckManager().send(QXmppPacket(*iq, std::move(interface)));
+                               d->stream->streamAckManager().send(QXmppPacket(*iq, std::move(interface)), priority);
                            },
                            [&](QXmppError &&error) {
                                interface.finish(std::move(error));
@@ -556,7 +791,7 @@ QXmppTask<QXmpp::SendResult> QXmppClient::sendSensitive(QXmppStanza &&stanza, co
                     std::move(dynamic_cast<QXmppIq &&>(stanza)), params));
         }
     }
-    return d->stream->streamAckManager().send(stanza);
+    return d->stream->streamAckManager().send(stanza, priority);
 }
 
 ///
@@ -571,9 +806,9 @@ QXmppTask<QXmpp::SendResult> QXmppClient::sendSensitive(QXmppStanza &&stanza, co
 ///
 /// \since QXmpp 1.5
 ///
-QXmppTask<QXmpp::SendResult> QXmppClient::send(QXmppStanza &&stanza, const std::optional<QXmppSendStanzaParams> &)
+QXmppTask<QXmpp::SendResult> QXmppClient::send(QXmppStanza &&stanza, const std::optional<QXmppSendStanzaParams> &params)
 {
-    return d->stream->streamAckManager().send(stanza);
+    return d->stream->streamAckManager().send(stanza, params ? params->priority() : QXmpp::SendPriority::Interactive);
 }
 
 ///
@@ -595,6 +830,37 @@ QXmppTask<QXmpp::SendResult> QXmppClient::reply(QXmppStanza &&stanza, const std:
     return send(std::move(stanza), params);
 }
 
+///
+/// Sends the stanza without end-to-end encryption, can be called from any thread.
+///
+/// The stanza is serialized in the calling thread and added to a lock-free queue of the client.
+/// The client sends all queued packets at once when its thread processes events again, so the
+/// thread of the client is only woken up once per batch of packets. Posted packets are sent in the
+/// order they were posted, but may be sent after packets that were sent directly with send().
+///
+/// The returned task is finished in the calling thread, which needs to run an event loop for this
+/// (unless it is the thread of the client). It must only be used in the calling thread.
+///
+/// \since QXmpp 1.11
+///
+QXmppTask<QXmpp::SendResult> QXmppClient::post(const QXmppStanza &stanza, QXmpp::SendPriority priority)
+{
+    return d->post(serializeXml(stanza), priority);
+}
+
+///
+/// Sends serialized data, can be called from any thread.
+///
+/// The data must contain exactly one complete stanza, it is counted by stream management. See
+/// post() for details.
+///
+/// \since QXmpp 1.11
+///
+QXmppTask<QXmpp::SendResult> QXmppClient::postData(const QByteArray &data, QXmpp::SendPriority priority)
+{
+    return d->post(QByteArray(data), priority);
+}
+
 ///
 /// Sends an IQ packet and returns the response asynchronously.
 ///
@@ -607,14 +873,20 @@ QXmppTask<QXmpp::SendResult> QXmppClient::reply(QXmppStanza &&stanza, const std:
 ///
 /// This does not do any end-to-encryption on the IQ.
 ///
+/// If no response is received within the timeout set in the \a params or the
+/// QXmppConfiguration, the task finishes with a QXmppError containing QXmpp::TimeoutError.
+///
 /// \sa sendSensitiveIq()
 ///
 /// \warning THIS API IS NOT FINALIZED YET!
 ///
 /// \since QXmpp 1.5
 ///
-QXmppTask<QXmppClient::IqResult> QXmppClient::sendIq(QXmppIq &&iq, const std::optional<QXmppSendStanzaParams> &)
+QXmppTask<QXmppClient::IqResult> QXmppClient::sendIq(QXmppIq &&iq, const std::optional<QXmppSendStanzaParams> &params)
 {
+    if (params) {
+        return d->stream->sendIq(std::move(iq), params->iqTimeout(), params->priority());
+    }
     return d->stream->sendIq(std::move(iq));
 }
 
@@ -639,11 +911,13 @@ QXmppTask<QXmppClient::IqResult> QXmppClient::sendSensitiveIq(QXmppIq &&iq, cons
     if (d->encryptionExtension) {
         QXmppPromise<IqResult> p;
         auto task = p.task();
-        d->encryptionExtension->encryptIq(std::move(iq), params).then(this, [this, p = std::move(p)](IqEncryptResult result) mutable {
+        auto timeout = params ? params->iqTimeout() : std::nullopt;
+        auto priority = params ? params->priority() : QXmpp::SendPriority::Interactive;
+        d->encryptionExtension->encryptIq(std::move(iq), params).then(this, [this, p = std::move(p), timeout, priority](IqEncryptResult result) mutable {
             std::visit(overloaded {
                            [&](std::unique_ptr<QXmppIq> &&iq) {
                                // success (encrypted)
-                               d->stream->sendIq(std::move(*iq)).then(this, [this, p = std::move(p)](auto &&result) mutable {
+                               d->stream->sendIq(std::move(*iq), timeout, priority).then(this, [this, p = std::move(p)](auto &&result) mutable {
                                    // iq sent, response received
                                    std::visit(overloaded {
                                                   [&](QDomElement &&el) {
@@ -692,7 +966,7 @@ QXmppTask<QXmppClient::IqResult> QXmppClient::sendSensitiveIq(QXmppIq &&iq, cons
 
         return task;
     }
-    return d->stream->sendIq(std::move(iq));
+    return sendIq(std::move(iq), params);
 }
 
 ///
@@ -708,9 +982,9 @@ QXmppTask<QXmppClient::IqResult> QXmppClient::sendSensitiveIq(QXmppIq &&iq, cons
 ///
 /// \since QXmpp 1.5
 ///
-QXmppTask<QXmppClient::EmptyResult> QXmppClient::sendGenericIq(QXmppIq &&iq, const std::optional<QXmppSendStanzaParams> &)
+QXmppTask<QXmppClient::EmptyResult> QXmppClient::sendGenericIq(QXmppIq &&iq, const std::optional<QXmppSendStanzaParams> &params)
 {
-    return chainIq(sendIq(std::move(iq)), this, [](const QXmppIq &) -> EmptyResult {
+    return chainIq(sendIq(std::move(iq), params), this, [](const QXmppIq &) -> EmptyResult {
         return QXmpp::Success();
     });
 }
@@ -749,6 +1023,21 @@ bool QXmppClient::isConnected() const
     return d->stream->isConnected();
 }
 
+///
+/// Returns whether the buffered outgoing data has reached the limit set with
+/// QXmppConfiguration::setWriteBufferHighWaterMark().
+///
+/// While the limit is exceeded, stanzas are held back according to their
+/// QXmpp::SendPriority. writeBufferLow() is emitted once the buffered data has dropped to half
+/// of the limit.
+///
+/// \since QXmpp 1.11
+///
+bool QXmppClient::isWriteBufferFull() const
+{
+    return d->stream->streamAckManager().isWriteBufferFull();
+}
+
 ///
 /// Returns true if the current client state is "active", false if it is
 /// "inactive". See \xep{0352, Client State Indication} for details.
@@ -792,6 +1081,48 @@ QXmppClient::StreamManagementState QXmppClient::streamManagementState() const
     return NoStreamManagement;
 }
 
+///
+/// Returns a snapshot of the current \xep{0198, Stream Management} session that can be stored
+/// to resume the stream after the application has been restarted.
+///
+/// The returned state is null if the stream cannot be resumed. The snapshot should be taken
+/// right before the application quits without disconnecting from the server:
+/// disconnectFromServer() closes the stream, so it cannot be resumed anymore.
+///
+/// \since QXmpp 1.11
+///
+QXmppStreamResumptionState QXmppClient::streamResumptionState() const
+{
+    if (auto data = d->stream->c2sStreamManager().resumptionData()) {
+        return QXmppStreamResumptionState(*data);
+    }
+    return {};
+}
+
+///
+/// Restores a stored \xep{0198, Stream Management} session.
+///
+/// When connecting to the server the next time, the stream is resumed instead of starting a new
+/// session. Stanzas that have not been acknowledged before are sent again. This needs to be
+/// called before connectToServer() and has no effect while the client is connected.
+///
+/// \since QXmpp 1.11
+///
+void QXmppClient::setStreamResumptionState(const QXmppStreamResumptionState &state)
+{
+    if (d->stream->isConnected()) {
+        warning(u"Can't restore stream management state while connected"_s);
+        return;
+    }
+    if (state.isNull()) {
+        return;
+    }
+
+    // avoid that the state is reset when connecting with the same account
+    d->stream->configuration().setJid(state.jid());
+    d->stream->c2sStreamManager().restoreResumptionData(state.data());
+}
+
 ///
 /// Utility function to send message to all the resources associated with the
 /// specified bareJid. If there are no resources available, that is the contact
@@ -907,7 +1238,7 @@ void QXmppClient::injectIq(const QDomElement &element, const std::optional<QXmpp
     if (element.tagName() != u"iq") {
         return;
     }
-    if (!StanzaPipeline::process(d->extensions, element, e2eeMetadata)) {
+    if (!StanzaPipeline::process(d->router, element, e2eeMetadata)) {
         const auto iqType = element.attribute(u"type"_s);
         if (iqType == u"get" || iqType == u"set") {
             // send error IQ
@@ -931,7 +1262,7 @@ void QXmppClient::injectIq(const QDomElement &element, const std::optional<QXmpp
 ///
 bool QXmppClient::injectMessage(QXmppMessage &&message)
 {
-    auto handled = MessagePipeline::process(this, d->extensions, std::move(message));
+    auto handled = MessagePipeline::process(this, d->router, std::move(message));
     if (!handled) {
         // no extension handled the message
         Q_EMIT messageReceived(message);
@@ -956,16 +1287,29 @@ void QXmppClient::setIgnoredStreamErrors(const QVector<QXmpp::StreamError> &erro
 ///
 void QXmppClient::_q_elementReceived(const QDomElement &element, bool &handled)
 {
-    // The stanza comes directly from the XMPP stream, so it's not end-to-end
-    // encrypted and there's no e2ee metadata (std::nullopt).
-    handled = StanzaPipeline::process(d->extensions, element, std::nullopt) ||
-        MessagePipeline::process(this, d->extensions, d->encryptionExtension, element);
+    const auto process = [&] {
+        // The stanza comes directly from the XMPP stream, so it's not end-to-end
+        // encrypted and there's no e2ee metadata (std::nullopt).
+        return StanzaPipeline::process(d->router, element, std::nullopt) ||
+            MessagePipeline::process(this, d->router, d->encryptionExtension, element);
+    };
+
+    if (!isMetricsEnabled()) {
+        handled = process();
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    handled = process();
+    const std::chrono::duration<double> handlingTime = std::chrono::steady_clock::now() - start;
+    Q_EMIT updateHistogram(u"client.extension-handling-time"_s, handlingTime.count());
 }
 
 void QXmppClient::_q_reconnect()
 {
     if (d->stream->configuration().autoReconnectionEnabled()) {
         debug(u"Reconnecting to server"_s);
+        Q_EMIT updateCounter(u"client.reconnects"_s);
         d->stream->connectToHost();
     }
 }
@@ -983,7 +1327,7 @@ void QXmppClient::_q_streamConnected(const QXmpp::Private::SessionBegin &session
     d->reconnectionTries = 0;
 
     // notify managers
-    if (session.fastTokenChanged) {
+    if (session.credentialsChanged) {
         Q_EMIT credentialsChanged();
     }
     Q_EMIT connected();
@@ -1011,24 +1355,8 @@ QXmppLogger *QXmppClient::logger() const
 void QXmppClient::setLogger(QXmppLogger *logger)
 {
     if (logger != d->logger) {
-        if (d->logger) {
-            disconnect(this, &QXmppLoggable::logMessage,
-                       d->logger, &QXmppLogger::log);
-            disconnect(this, &QXmppLoggable::setGauge,
-                       d->logger, &QXmppLogger::setGauge);
-            disconnect(this, &QXmppLoggable::updateCounter,
-                       d->logger, &QXmppLogger::updateCounter);
-        }
-
         d->logger = logger;
-        if (d->logger) {
-            connect(this, &QXmppLoggable::logMessage,
-                    d->logger, &QXmppLogger::log);
-            connect(this, &QXmppLoggable::setGauge,
-                    d->logger, &QXmppLogger::setGauge);
-            connect(this, &QXmppLoggable::updateCounter,
-                    d->logger, &QXmppLogger::updateCounter);
-        }
+        connectLogger(logger);
 
         Q_EMIT loggerChanged(d->logger);
     }
@@ -31,6 +31,7 @@ class QXmppMessage;
 class QXmppOutgoingClient;
 class QXmppPresence;
 class QXmppIq;
+class QXmppStreamResumptionState;
 
 // managers
 class QXmppDiscoveryIq;
@@ -127,6 +128,7 @@ public:
     void setEncryptionExtension(QXmppE2eeExtension *);
 
     QList<QXmppClientExtension *> extensions() const;
+    quint64 handledStanzaCount(const QXmppClientExtension *extension) const;
 
     ///
     /// \brief Returns the extension which can be cast into type T*, or 0
@@ -183,11 +185,14 @@ public:
 
     bool isAuthenticated() const;
     bool isConnected() const;
+    bool isWriteBufferFull() const;
 
     bool isActive() const;
     void setActive(bool active);
 
     StreamManagementState streamManagementState() const;
+    QXmppStreamResumptionState streamResumptionState() const;
+    void setStreamResumptionState(const QXmppStreamResumptionState &state);
 
     QXmppPresence clientPresence() const;
     void setClientPresence(const QXmppPresence &presence);
@@ -210,6 +215,8 @@ public:
     QXmppTask<QXmpp::SendResult> sendSensitive(QXmppStanza &&, const std::optional<QXmppSendStanzaParams> & = {});
     QXmppTask<QXmpp::SendResult> send(QXmppStanza &&, const std::optional<QXmppSendStanzaParams> & = {});
     QXmppTask<QXmpp::SendResult> reply(QXmppStanza &&stanza, const std::optional<QXmppE2eeMetadata> &e2eeMetadata, const std::optional<QXmppSendStanzaParams> & = {});
+    QXmppTask<QXmpp::SendResult> post(const QXmppStanza &stanza, QXmpp::SendPriority priority = QXmpp::SendPriority::Interactive);
+    QXmppTask<QXmpp::SendResult> postData(const QByteArray &data, QXmpp::SendPriority priority = QXmpp::SendPriority::Interactive);
     QXmppTask<IqResult> sendIq(QXmppIq &&, const std::optional<QXmppSendStanzaParams> & = {});
     QXmppTask<IqResult> sendSensitiveIq(QXmppIq &&, const std::optional<QXmppSendStanzaParams> & = {});
     QXmppTask<EmptyResult> sendGenericIq(QXmppIq &&, const std::optional<QXmppSendStanzaParams> & = {});
@@ -301,13 +308,24 @@ Q_SIGNALS:
     /// This signal is emitted when the client state changes.
     void stateChanged(QXmppClient::State state);
 
-    /// Emitted when the credentials, e.g. tokens have changed.
+    /// Emitted when the credentials, e.g. tokens or SCRAM keys, have changed.
     ///
     /// This means that the QXmppCredentials in the QXmppConfiguration of this client has changed.
     ///
     /// \since QXmpp 1.8
     Q_SIGNAL void credentialsChanged();
 
+    /// Emitted when the buffered outgoing data has dropped to half of the write buffer limit
+    /// after the limit had been reached.
+    ///
+    /// Producers of large amounts of stanzas can pause while isWriteBufferFull() returns true
+    /// and continue once this signal is emitted.
+    ///
+    /// \sa QXmppConfiguration::setWriteBufferHighWaterMark()
+    ///
+    /// \since QXmpp 1.11
+    Q_SIGNAL void writeBufferLow();
+
 public Q_SLOTS:
     void connectToServer(const QXmppConfiguration &,
                          const QXmppPresence &initialPresence =
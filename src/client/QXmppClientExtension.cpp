@@ -5,6 +5,7 @@
 #include "QXmppClientExtension.h"
 
 #include "QXmppClient.h"
+#include "QXmppClient_p.h"
 
 ///
 /// Constructs a QXmppClient extension.
@@ -97,6 +98,26 @@ void QXmppClientExtension::onUnregistered(QXmppClient *client)
     Q_UNUSED(client);
 }
 
+///
+/// Declares the stanzas this extension handles.
+///
+/// The client then only passes stanzas matching one of the routes to handleStanza(). Extensions
+/// that never call this still receive every stanza. The order of the extensions in the client is
+/// preserved in both cases.
+///
+/// The extension must not handle (or otherwise rely on) any stanzas not matching one of the
+/// routes. This needs to be called from onRegistered(), the routes are dropped when the
+/// extension is removed from the client.
+///
+/// \since QXmpp 1.11
+///
+void QXmppClientExtension::setStanzaRoutes(const QVector<QXmppStanzaRoute> &routes)
+{
+    if (m_client) {
+        m_client->d->router.setRoutes(this, routes);
+    }
+}
+
 ///
 /// Injects an IQ element into the client.
 ///
@@ -8,6 +8,7 @@
 #include "QXmppDiscoveryIq.h"
 #include "QXmppExtension.h"
 #include "QXmppLogger.h"
+#include "QXmppStanzaRoute.h"
 
 #include <memory>
 
@@ -49,6 +50,8 @@ protected:
     virtual void onRegistered(QXmppClient *client);
     virtual void onUnregistered(QXmppClient *client);
 
+    void setStanzaRoutes(const QVector<QXmppStanzaRoute> &routes);
+
     void injectIq(const QDomElement &element, const std::optional<QXmppE2eeMetadata> &e2eeMetadata);
     bool injectMessage(QXmppMessage &&message);
 
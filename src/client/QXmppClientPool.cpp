@@ -0,0 +1,383 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "QXmppClientPool.h"
+
+#include "QXmppClient.h"
+#include "QXmppConfiguration.h"
+#include "QXmppLogger.h"
+#include "QXmppMetrics.h"
+
+#include "StringLiterals.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include <QFutureInterface>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+struct ClientPoolWorker {
+    QThread *thread;
+    // lives in the worker thread, parent of the logger and all clients
+    QObject *context;
+    // records the metrics of the clients in the metrics of the pool
+    QXmppLogger *logger;
+    int clientCount = 0;
+};
+
+struct ClientPoolEntry {
+    std::size_t worker;
+    // nullptr until the client has been created in the worker thread
+    QXmppClient *client = nullptr;
+    bool connected = false;
+};
+
+class QXmppClientPoolPrivate
+{
+public:
+    QXmppMetrics metrics;
+    std::vector<ClientPoolWorker> workers;
+
+    mutable QMutex mutex;
+    QHash<quint64, ClientPoolEntry> clients;
+    quint64 nextId = 1;
+    std::atomic<int> connectedCount = 0;
+};
+
+///
+/// \class QXmppClientPool
+///
+/// \brief The QXmppClientPool class runs many clients on a fixed number of worker threads.
+///
+/// Each worker thread runs its own event loop. A client is created in the worker thread with the
+/// fewest clients and stays there, all of its objects (extensions, sockets, timers) live in that
+/// thread.
+///
+/// Clients are identified by the ID returned by addClient(). All functions of the pool are
+/// thread-safe. Clients must only be accessed from their worker thread, use invoke() to run code
+/// there. The signals of the pool are emitted from the worker threads, receivers in other
+/// threads are called via queued connections.
+///
+/// The metrics of all clients are collected in metrics(). For this the clients use a logger of
+/// the pool, setting another logger in the setup function of addClient() excludes the client.
+///
+/// \code
+/// QXmppClientPool pool(4);
+/// connect(&pool, &QXmppClientPool::messageReceived, this, [](quint64 id, const QXmppMessage &message) {
+///     // handle message
+/// });
+///
+/// QXmppConfiguration config;
+/// config.setJid(u"bot@example.org"_s);
+/// config.setPassword(u"secret"_s);
+/// auto id = pool.addClient(config);
+///
+/// pool.send(id, QXmppMessage({}, u"user@example.org"_s, u"Hello!"_s));
+/// \endcode
+///
+/// \ingroup Core
+///
+/// \since QXmpp 1.11
+///
+
+///
+/// Constructs a pool with one worker thread per CPU core.
+///
+QXmppClientPool::QXmppClientPool(QObject *parent)
+    : QXmppClientPool(QThread::idealThreadCount(), parent)
+{
+}
+
+///
+/// Constructs a pool with \a threadCount worker threads (at least one).
+///
+QXmppClientPool::QXmppClientPool(int threadCount, QObject *parent)
+    : QObject(parent),
+      d(std::make_unique<QXmppClientPoolPrivate>())
+{
+    // the clients use the default logger until the logger of the pool is set, create it in this
+    // thread and not in one of the workers
+    QXmppLogger::getLogger();
+
+    qRegisterMetaType<QXmppError>("QXmppError");
+    qRegisterMetaType<QXmppMessage>("QXmppMessage");
+    qRegisterMetaType<QXmppPresence>("QXmppPresence");
+
+    threadCount = std::max(threadCount, 1);
+    d->workers.reserve(threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        auto *thread = new QThread(this);
+        thread->setObjectName(u"QXmppClientPool-%1"_s.arg(i));
+
+        auto *context = new QObject();
+        auto *logger = new QXmppLogger();
+        logger->setMetricsRegistry(&d->metrics);
+        logger->setMetricsEnabled(true);
+        logger->setParent(context);
+        context->moveToThread(thread);
+        connect(thread, &QThread::finished, context, &QObject::deleteLater);
+
+        d->workers.push_back(ClientPoolWorker { thread, context, logger });
+        thread->start();
+    }
+}
+
+///
+/// Disconnects and deletes all clients and stops the worker threads.
+///
+QXmppClientPool::~QXmppClientPool()
+{
+    // the clients are deleted with the context objects when the threads finish
+    for (const auto &worker : d->workers) {
+        worker.thread->quit();
+    }
+    for (const auto &worker : d->workers) {
+        worker.thread->wait();
+    }
+}
+
+///
+/// Returns the number of worker threads.
+///
+int QXmppClientPool::threadCount() const
+{
+    return int(d->workers.size());
+}
+
+///
+/// Returns the number of clients in the pool.
+///
+int QXmppClientPool::clientCount() const
+{
+    QMutexLocker locker(&d->mutex);
+    return int(d->clients.size());
+}
+
+///
+/// Returns the number of clients that are currently connected.
+///
+int QXmppClientPool::connectedClientCount() const
+{
+    return d->connectedCount;
+}
+
+///
+/// Returns the metrics of all clients of the pool.
+///
+/// Counters and histograms are summed up over all clients, gauges contain the value last set by
+/// any client.
+///
+QXmppMetrics *QXmppClientPool::metrics() const
+{
+    return &d->metrics;
+}
+
+///
+/// Adds a client with the configuration and connects it.
+///
+/// The client is created in a worker thread. \a setup is called there before connecting, it can
+/// be used to add extensions or to connect to signals of the client.
+///
+/// Returns the ID of the client.
+///
+quint64 QXmppClientPool::addClient(const QXmppConfiguration &config, std::function<void(QXmppClient *)> setup)
+{
+    QMutexLocker locker(&d->mutex);
+    const auto id = d->nextId++;
+
+    auto worker = std::min_element(d->workers.begin(), d->workers.end(), [](const auto &a, const auto &b) {
+        return a.clientCount < b.clientCount;
+    });
+    worker->clientCount++;
+    d->clients.insert(id, ClientPoolEntry { std::size_t(worker - d->workers.begin()) });
+
+    auto *context = worker->context;
+    auto *logger = worker->logger;
+    locker.unlock();
+
+    QMetaObject::invokeMethod(
+        context,
+        [this, id, config, setup = std::move(setup), context, logger] {
+            {
+                QMutexLocker locker(&d->mutex);
+                if (!d->clients.contains(id)) {
+                    return;
+                }
+            }
+
+            auto *client = new QXmppClient(context);
+            client->setLogger(logger);
+
+            connect(client, &QXmppClient::connected, context, [this, id] {
+                QMutexLocker locker(&d->mutex);
+                if (auto itr = d->clients.find(id); itr != d->clients.end() && !std::exchange(itr->connected, true)) {
+                    d->connectedCount++;
+                }
+                locker.unlock();
+                Q_EMIT clientConnected(id);
+            });
+            connect(client, &QXmppClient::disconnected, context, [this, id] {
+                QMutexLocker locker(&d->mutex);
+                if (auto itr = d->clients.find(id); itr != d->clients.end() && std::exchange(itr->connected, false)) {
+                    d->connectedCount--;
+                }
+                locker.unlock();
+                Q_EMIT clientDisconnected(id);
+            });
+            connect(client, &QXmppClient::errorOccurred, context, [this, id](const QXmppError &error) {
+                Q_EMIT clientErrorOccurred(id, error);
+            });
+            connect(client, &QXmppClient::messageReceived, context, [this, id](const QXmppMessage &message) {
+                Q_EMIT messageReceived(id, message);
+            });
+            connect(client, &QXmppClient::presenceReceived, context, [this, id](const QXmppPresence &presence) {
+                Q_EMIT presenceReceived(id, presence);
+            });
+
+            if (setup) {
+                setup(client);
+            }
+
+            {
+                QMutexLocker locker(&d->mutex);
+                d->clients[id].client = client;
+            }
+            client->connectToServer(config);
+        },
+        Qt::QueuedConnection);
+
+    return id;
+}
+
+///
+/// Disconnects and deletes the client.
+///
+void QXmppClientPool::removeClient(quint64 id)
+{
+    QMutexLocker locker(&d->mutex);
+    auto itr = d->clients.find(id);
+    if (itr == d->clients.end()) {
+        return;
+    }
+    auto *context = d->workers[itr->worker].context;
+    locker.unlock();
+
+    // the entry is removed in the worker thread, after the client has been created
+    QMetaObject::invokeMethod(
+        context,
+        [this, id, context] {
+            QMutexLocker locker(&d->mutex);
+            auto itr = d->clients.find(id);
+            if (itr == d->clients.end()) {
+                return;
+            }
+            auto entry = *itr;
+            d->clients.erase(itr);
+            d->workers[entry.worker].clientCount--;
+            if (entry.connected) {
+                d->connectedCount--;
+            }
+            locker.unlock();
+
+            if (entry.client) {
+                disconnect(entry.client, nullptr, context, nullptr);
+                entry.client->disconnectFromServer();
+                entry.client->deleteLater();
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+///
+/// Calls \a function with the client in its worker thread.
+///
+/// The function is not called if the client has been removed.
+///
+void QXmppClientPool::invoke(quint64 id, std::function<void(QXmppClient *)> function)
+{
+    runOnClient(id, [function = std::move(function)](QXmppClient *client) {
+        if (client) {
+            function(client);
+        }
+    });
+}
+
+///
+/// Sends the message with the client.
+///
+/// The returned future is finished in the worker thread of the client, see QXmppClient::send().
+///
+QFuture<QXmpp::SendResult> QXmppClientPool::send(quint64 id, QXmppMessage &&message)
+{
+    QFutureInterface<QXmpp::SendResult> interface(QFutureInterfaceBase::Started);
+    auto future = interface.future();
+
+    runOnClient(id, [interface, message = std::move(message)](QXmppClient *client) mutable {
+        if (!client) {
+            interface.reportResult(QXmppError { u"Unknown client."_s, QXmpp::SendError::Disconnected });
+            interface.reportFinished();
+            return;
+        }
+        client->send(std::move(message)).then(client, [interface](QXmpp::SendResult &&result) mutable {
+            interface.reportResult(result);
+            interface.reportFinished();
+        });
+    });
+    return future;
+}
+
+///
+/// Sends the presence with the client.
+///
+/// The returned future is finished in the worker thread of the client, see QXmppClient::send().
+///
+QFuture<QXmpp::SendResult> QXmppClientPool::send(quint64 id, QXmppPresence &&presence)
+{
+    QFutureInterface<QXmpp::SendResult> interface(QFutureInterfaceBase::Started);
+    auto future = interface.future();
+
+    runOnClient(id, [interface, presence = std::move(presence)](QXmppClient *client) mutable {
+        if (!client) {
+            interface.reportResult(QXmppError { u"Unknown client."_s, QXmpp::SendError::Disconnected });
+            interface.reportFinished();
+            return;
+        }
+        client->send(std::move(presence)).then(client, [interface](QXmpp::SendResult &&result) mutable {
+            interface.reportResult(result);
+            interface.reportFinished();
+        });
+    });
+    return future;
+}
+
+// Calls the function in the worker thread of the client, with nullptr if the client does not
+// exist (anymore).
+void QXmppClientPool::runOnClient(quint64 id, std::function<void(QXmppClient *)> function)
+{
+    QMutexLocker locker(&d->mutex);
+    auto itr = d->clients.constFind(id);
+    if (itr == d->clients.constEnd()) {
+        locker.unlock();
+        function(nullptr);
+        return;
+    }
+    auto *context = d->workers[itr->worker].context;
+    locker.unlock();
+
+    QMetaObject::invokeMethod(
+        context,
+        [this, id, function = std::move(function)] {
+            QMutexLocker locker(&d->mutex);
+            auto itr = d->clients.constFind(id);
+            auto *client = itr != d->clients.constEnd() ? itr->client : nullptr;
+            locker.unlock();
+
+            function(client);
+        },
+        Qt::QueuedConnection);
+}
@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef QXMPPCLIENTPOOL_H
+#define QXMPPCLIENTPOOL_H
+
+#include "QXmppError.h"
+#include "QXmppMessage.h"
+#include "QXmppPresence.h"
+#include "QXmppSendResult.h"
+
+#include <functional>
+#include <memory>
+
+#include <QFuture>
+#include <QObject>
+
+class QXmppClient;
+class QXmppClientPoolPrivate;
+class QXmppConfiguration;
+class QXmppMetrics;
+
+class QXMPP_EXPORT QXmppClientPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit QXmppClientPool(QObject *parent = nullptr);
+    explicit QXmppClientPool(int threadCount, QObject *parent = nullptr);
+    ~QXmppClientPool() override;
+
+    int threadCount() const;
+    int clientCount() const;
+    int connectedClientCount() const;
+    QXmppMetrics *metrics() const;
+
+    quint64 addClient(const QXmppConfiguration &config, std::function<void(QXmppClient *)> setup = {});
+    void removeClient(quint64 id);
+
+    void invoke(quint64 id, std::function<void(QXmppClient *)> function);
+    QFuture<QXmpp::SendResult> send(quint64 id, QXmppMessage &&message);
+    QFuture<QXmpp::SendResult> send(quint64 id, QXmppPresence &&presence);
+
+    /// This signal is emitted when the client with the ID has connected.
+    Q_SIGNAL void clientConnected(quint64 id);
+
+    /// This signal is emitted when the client with the ID has disconnected.
+    Q_SIGNAL void clientDisconnected(quint64 id);
+
+    /// This signal is emitted when the connection of the client with the ID failed.
+    Q_SIGNAL void clientErrorOccurred(quint64 id, const QXmppError &error);
+
+    /// This signal is emitted when the client with the ID has received a message.
+    Q_SIGNAL void messageReceived(quint64 id, const QXmppMessage &message);
+
+    /// This signal is emitted when the client with the ID has received a presence.
+    Q_SIGNAL void presenceReceived(quint64 id, const QXmppPresence &presence);
+
+private:
+    void runOnClient(quint64 id, std::function<void(QXmppClient *)> function);
+
+    const std::unique_ptr<QXmppClientPoolPrivate> d;
+};
+
+#endif  // QXMPPCLIENTPOOL_H
@@ -21,23 +21,204 @@
 
 #include "QXmppOutgoingClient.h"
 #include "QXmppPresence.h"
+#include "QXmppPromise.h"
+#include "QXmppSendResult.h"
+#include "QXmppStanzaRoute.h"
 
+#include "MpscQueue.h"
+
+#include <atomic>
+#include <bit>
 #include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <QHash>
+#include <QMutex>
+#include <QVarLengthArray>
 
+class QDomElement;
 class QXmppClient;
 class QXmppClientExtension;
 class QXmppE2eeExtension;
 class QXmppLogger;
+class QXmppMessageHandler;
 class QTimer;
 
+namespace QXmpp::Private {
+
+struct StanzaRouteKey {
+    QString tagName;
+    QString childNamespace;
+    QString iqType;
+
+    bool operator==(const StanzaRouteKey &other) const = default;
+};
+
+inline size_t qHash(const StanzaRouteKey &key, size_t seed = 0) noexcept
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return qHashMulti(seed, key.tagName, key.childNamespace, key.iqType);
+#else
+    QtPrivate::QHashCombine hash;
+    seed = hash(seed, key.tagName);
+    seed = hash(seed, key.childNamespace);
+    return hash(seed, key.iqType);
+#endif
+}
+
+//
+// Set of extensions, by their index in the client. Up to 256 extensions are stored inline.
+//
+class ExtensionSet
+{
+public:
+    void insert(qsizetype index)
+    {
+        const auto word = index / 64;
+        while (m_words.size() <= word) {
+            m_words.append(0);
+        }
+        m_words[word] |= quint64(1) << (index % 64);
+    }
+    void unite(const ExtensionSet &other)
+    {
+        while (m_words.size() < other.m_words.size()) {
+            m_words.append(0);
+        }
+        for (qsizetype i = 0; i < other.m_words.size(); i++) {
+            m_words[i] |= other.m_words[i];
+        }
+    }
+
+    // Calls the function with the indices in ascending order until it returns true.
+    template<typename Function>
+    bool anyOf(Function function) const
+    {
+        for (qsizetype word = 0; word < m_words.size(); word++) {
+            for (auto bits = m_words[word]; bits; bits &= bits - 1) {
+                if (function(word * 64 + std::countr_zero(bits))) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+private:
+    QVarLengthArray<quint64, 4> m_words;
+};
+
+//
+// Dispatch index for incoming stanzas.
+//
+// Extensions that declared stanza routes (QXmppClientExtension::setStanzaRoutes()) are looked
+// up by their routes, all other extensions are always candidates. Candidates are returned in the
+// order of the extensions in the client.
+//
+class StanzaRouter
+{
+public:
+    struct Candidates {
+        // shared copy, stays valid if extensions are added or removed while handling the stanza
+        QList<QXmppClientExtension *> extensions;
+        ExtensionSet indices;
+
+        template<typename Function>
+        bool anyOf(Function function) const
+        {
+            return indices.anyOf([&](qsizetype index) { return function(extensions.at(index)); });
+        }
+    };
+
+    void setExtensions(const QList<QXmppClientExtension *> &extensions);
+    void setRoutes(const QXmppClientExtension *extension, const QVector<QXmppStanzaRoute> &routes);
+
+    Candidates candidates(const QDomElement &stanza) const;
+    const std::vector<QXmppMessageHandler *> &messageHandlers() const { return m_messageHandlers; }
+
+    void addHit(const QXmppClientExtension *extension);
+    quint64 hitCount(const QXmppClientExtension *extension) const;
+
+private:
+    void updateIndex();
+
+    QList<QXmppClientExtension *> m_extensions;
+    std::unordered_map<const QXmppClientExtension *, QVector<QXmppStanzaRoute>> m_declaredRoutes;
+    QHash<StanzaRouteKey, ExtensionSet> m_routes;
+    ExtensionSet m_unroutedExtensions;
+    std::vector<QXmppMessageHandler *> m_messageHandlers;
+    std::unordered_map<const QXmppClientExtension *, quint64> m_hits;
+};
+
+//
+// Finishes the tasks of posted packets in the thread that posted them.
+//
+// There is one inbox per thread. The results are collected in a lock-free queue, the thread is
+// only woken up once per batch of results.
+//
+class PostedResultInbox : public std::enable_shared_from_this<PostedResultInbox>
+{
+public:
+    PostedResultInbox();
+
+    static std::shared_ptr<PostedResultInbox> forCurrentThread();
+
+    void finish(QXmppPromise<SendResult> &&promise, SendResult &&result);
+
+private:
+    void finishAll();
+    void detach();
+
+    MpscQueue<std::pair<QXmppPromise<SendResult>, SendResult>> m_results;
+    std::atomic<bool> m_scheduled = false;
+    Qt::HANDLE m_threadId;
+    QMutex m_mutex;
+    // lives in the thread of the inbox, nullptr after the thread has exited
+    QObject *m_context;
+};
+
+//
+// Finishes the task of a posted packet via its inbox.
+//
+// Owned by the continuation of the sent packet. If it is destroyed without a result, e.g. because
+// the client has been deleted before the packet was acknowledged, an error is reported instead.
+//
+class PostedResult
+{
+public:
+    PostedResult(QXmppPromise<SendResult> &&promise, std::shared_ptr<PostedResultInbox> &&inbox);
+    PostedResult(PostedResult &&) = default;
+    ~PostedResult();
+
+    void finish(SendResult &&result);
+
+private:
+    QXmppPromise<SendResult> m_promise;
+    std::shared_ptr<PostedResultInbox> m_inbox;
+};
+
+struct PostedPacket {
+    // one serialized stanza
+    QByteArray data;
+    SendPriority priority;
+    QXmppPromise<SendResult> promise;
+    std::shared_ptr<PostedResultInbox> inbox;
+};
+
+}  // namespace QXmpp::Private
+
 class QXmppClientPrivate
 {
 public:
     QXmppClientPrivate(QXmppClient *qq);
+    ~QXmppClientPrivate();
 
     /// Current presence of the client
     QXmppPresence clientPresence;
     QList<QXmppClientExtension *> extensions;
+    QXmpp::Private::StanzaRouter router;
     QXmppLogger *logger;
     /// Pointer to the XMPP stream
     QXmppOutgoingClient *stream;
@@ -50,6 +231,13 @@ public:
     int reconnectionTries;
     QTimer *reconnectionTimer;
 
+    // packets posted from any thread, sent in batches in the thread of the client
+    QXmpp::Private::MpscQueue<QXmpp::Private::PostedPacket> postedPackets;
+    std::atomic<bool> postedPacketsScheduled = false;
+
+    QXmppTask<QXmpp::SendResult> post(QByteArray &&data, QXmpp::SendPriority priority);
+    void sendPostedPackets();
+
     void addProperCapability(QXmppPresence &presence);
     std::chrono::milliseconds getNextReconnectTime() const;
 
@@ -8,6 +8,7 @@
 #include "QXmppCredentials.h"
 #include "QXmppSasl2UserAgent.h"
 #include "QXmppSasl_p.h"
+#include "QXmppTlsSessionCache.h"
 #include "QXmppUtils.h"
 #include "QXmppUtils_p.h"
 
@@ -34,6 +35,13 @@ struct QXmppCredentialsPrivate : QSharedData, Credentials { };
 ///
 /// The XML output currently may contain:
 ///  * an HT token for \xep{0484, Fast Authentication Streamlining Tokens}
+///  * the client and server keys for SCRAM authentication (since QXmpp 1.11)
+///
+/// The SCRAM keys are derived from the password using PBKDF2 during the first login, which is
+/// expensive with high iteration counts. Later logins reuse them as long as the server uses the
+/// same salt and iteration count, the password is then not needed anymore. Note that the keys
+/// allow logging in to the account (but not on other servers with the same password) and need to
+/// be stored as securely as the password.
 ///
 /// \since QXmpp 1.8
 ///
@@ -61,7 +69,13 @@ std::optional<QXmppCredentials> QXmppCredentials::fromXml(QXmlStreamReader &r)
             if (auto htToken = HtToken::fromXml(r)) {
                 credentials.d->htToken = std::move(*htToken);
             }
+        } else if (r.name() == u"scram-keys") {
+            if (auto scramKeys = ScramKeys::fromXml(r)) {
+                credentials.d->scramKeys.append(std::move(*scramKeys));
+            }
         }
+        // continue with the next child element
+        r.skipCurrentElement();
     }
     return credentials;
 }
@@ -76,12 +90,15 @@ void QXmppCredentials::toXml(QXmlStreamWriter &writer) const
     if (d->htToken) {
         d->htToken->toXml(writer);
     }
+    for (const auto &scramKeys : std::as_const(d->scramKeys)) {
+        scramKeys.toXml(writer);
+    }
     writer.writeEndElement();
 }
 
 bool QXmppCredentials::operator==(const QXmppCredentials &other) const
 {
-    return d->htToken == other.d->htToken;
+    return d->htToken == other.d->htToken && d->scramKeys == other.d->scramKeys;
 }
 
 class QXmppConfigurationPrivate : public QSharedData
@@ -120,6 +137,35 @@ public:
     QNetworkProxy networkProxy;
 
     QList<QSslCertificate> caCertificates;
+
+    // limits of the incoming stream in bytes, zero means unlimited
+    qint64 maximumStanzaSize = 10 * 1024 * 1024;
+    qint64 maximumReceiveBufferSize = 16 * 1024 * 1024;
+
+    bool lazyStanzaParsing = false;
+    bool writeCoalescingEnabled = false;
+    // zero means outgoing stanzas are never held back
+    qint64 writeBufferHighWaterMark = 0;
+    // pacing of outgoing stanzas, zero rates mean unlimited
+    qint64 rateLimitBytesPerSecond = 0;
+    double rateLimitStanzasPerSecond = 0;
+    std::chrono::milliseconds rateLimitBurst = std::chrono::seconds(1);
+
+    // zero means server addresses are tried one after another
+    std::chrono::milliseconds connectionAttemptDelay = std::chrono::milliseconds(250);
+
+    // shared by all copies of the configuration
+    std::shared_ptr<QXmppTlsSessionCache> tlsSessionCache;
+
+    bool streamPipeliningEnabled = false;
+
+    // when to request stream management acknowledgements
+    int ackRequestInterval = 1;
+    std::chrono::milliseconds ackRequestDelay = {};
+    bool ackRequestOnIdle = false;
+
+    // zero means no timeout
+    std::chrono::milliseconds iqTimeout = {};
 };
 
 /// Creates a QXmppConfiguration object.
@@ -722,6 +768,459 @@ QList<QSslCertificate> QXmppConfiguration::caCertificates() const
     return d->caCertificates;
 }
 
+///
+/// Returns the maximum size in bytes of a single stanza (or other top-level element) received from
+/// the server.
+///
+/// The default value is 10 MiB.
+///
+/// \since QXmpp 1.11
+///
+qint64 QXmppConfiguration::maximumStanzaSize() const
+{
+    return d->maximumStanzaSize;
+}
+
+///
+/// Sets the maximum size in bytes of a single stanza (or other top-level element) received from
+/// the server.
+///
+/// If the server sends a larger element, a policy-violation stream error is sent and the
+/// connection is closed. This is checked while the data is received, so an oversized element is
+/// never held in memory completely.
+///
+/// If set to zero, no limit is applied.
+///
+/// The default value is 10 MiB.
+///
+/// \since QXmpp 1.11
+///
+void QXmppConfiguration::setMaximumStanzaSize(qint64 bytes)
+{
+    d->maximumStanzaSize = bytes;
+}
+
+///
+/// Returns the maximum amount of received data in bytes that is buffered before it is processed.
+///
+/// The default value is 16 MiB.
+///
+/// \since QXmpp 1.11
+///
+qint64 QXmppConfiguration::maximumReceiveBufferSize() const
+{
+    return d->maximumReceiveBufferSize;
+}
+
+///
+/// Sets the maximum amount of received data in bytes that is buffered before it is processed.
+///
+/// This includes the data of partially received stanzas. Once reached, no more data is read from
+/// the socket until a stanza has been completed, so the server is slowed down by TCP flow control.
+///
+/// If set to zero, no limit is applied.
+///
+/// The default value is 16 MiB.
+///
+/// \since QXmpp 1.11
+///
+void QXmppConfiguration::setMaximumReceiveBufferSize(qint64 bytes)
+{
+    d->maximumReceiveBufferSize = bytes;
+}
+
+///
+/// Returns whether the extensions of received messages and presences are only parsed on first
+/// access.
+///
+/// The default value is false.
+///
+/// \since QXmpp 1.11
+///
+bool QXmppConfiguration::lazyStanzaParsing() const
+{
+    return d->lazyStanzaParsing;
+}
+
+///
+/// Sets whether the extensions of received messages and presences are only parsed on first
+/// access.
+///
+/// This can save a lot of time and memory when most stanzas are only routed or filtered by
+/// their basic attributes. See QXmppMessage::parseLazily() and QXmppPresence::parseLazily() for
+/// the restrictions.
+///
+/// The default value is false.
+///
+/// \since QXmpp 1.11
+///
+void QXmppConfiguration::setLazyStanzaParsing(bool enabled)
+{
+    d->lazyStanzaParsing = enabled;
+}
+
+///
+/// Returns whether outgoing data is collected and written to the socket at once.
+///
+/// The default value is false.
+///
+/// \since QXmpp 1.11
+///
+bool QXmppConfiguration::writeCoalescingEnabled() const
+{
+    return d->writeCoalescingEnabled;
+}
+
+///
+/// Sets whether outgoing data is collected and written to the socket at once.
+///
+/// When enabled, all stanzas sent within one event loop iteration are written to the socket
+/// together (or earlier if 16 KiB are reached). With TLS this results in one record instead of
+/// one per stanza, which reduces CPU and bandwidth overhead for bursts of small stanzas.
+///
+/// The default value is false.
+///
+/// \since QXmpp 1.11
+///
+void QXmppConfiguration::setWriteCoalescingEnabled(bool enabled)
+{
+    d->writeCoalescingEnabled = enabled;
+}
+
+///
+/// Returns the amount of buffered outgoing data in bytes from which on stanzas are held back.
+///
+/// The default value is 0, i.e. stanzas are never held back.
+///
+/// \since QXmpp 1.11
+///
+qint64 QXmppConfiguration::writeBufferHighWaterMark() const
+{
+    return d->writeBufferHighWaterMark;
+}
+
+///
+/// Sets the amount of buffered outgoing data in bytes from which on stanzas are held back.
+///
+/// While more data than this is waiting to be written to the network, stanzas are queued
+/// according to their QXmpp::SendPriority and written as soon as the socket has made progress.
+/// Stanzas with a higher priority are written first. QXmppClient::isWriteBufferFull() reports
+/// whether the limit has been reached and QXmppClient::writeBufferLow() is emitted once the
+/// buffered data has dropped to half of the limit again, so producers of large amounts of
+/// stanzas can throttle themselves.
+///
+/// The default value is 0, i.e. stanzas are never held back and are buffered by the socket.
+///
+/// \since QXmpp 1.11
+///
+void QXmppConfiguration::setWriteBufferHighWaterMark(qint64 bytes)
+{
+    d->writeBufferHighWaterMark = bytes;
+}
+
+///
+/// Returns the maximum average rate of outgoing data in bytes per second.
+///
+/// The default value is 0, i.e. the rate is not limited.
+///
+/// \since QXmpp 1.11
+///
+qint64 QXmppConfiguration::rateLimitBytesPerSecond() const
+{
+    return d->rateLimitBytesPerSecond;
+}
+
+///
+/// Sets the maximum average rate of outgoing data in bytes per second.
+///
+/// Many servers limit the rate at which they read from client connections (e.g. ejabberd's
+/// shapers) and stop reading when it is exceeded, which delays all further traffic including
+/// stream management acknowledgements. With a rate limit, stanzas are held back and written
+/// according to their QXmpp::SendPriority so that the limit is kept. Bursts are allowed, see
+/// setRateLimitBurst(). Control traffic like pings is never held back, but counts towards the
+/// limit.
+///
+/// The time stanzas have been held back is recorded in the "send-queue.delay" histogram of
+/// QXmppLogger::metrics().
+///
+/// The default value is 0, i.e. the rate is not limited.
+///
+/// \since QXmpp 1.11
+///
+void QXmppConfiguration::setRateLimitBytesPerSecond(qint64 bytes)
+{
+    d->rateLimitBytesPerSecond = bytes;
+}
+
+///
+/// Returns the maximum average rate of outgoing stanzas per second.
+///
+/// The default value is 0, i.e. the rate is not limited.
+///
+/// \since QXmpp 1.11
+///
+double QXmppConfiguration::rateLimitStanzasPerSecond() const
+{
+    return d->rateLimitStanzasPerSecond;
+}
+
+///
+/// Sets the maximum average rate of outgoing stanzas per second.
+///
+/// This works like setRateLimitBytesPerSecond(), both limits can be combined.
+///
+/// The default value is 0, i.e. the rate is not limited.
+///
+/// \since QXmpp 1.11
+///
+void QXmppConfiguration::setRateLimitStanzasPerSecond(double stanzas)
+{
+    d->rateLimitStanzasPerSecond = stanzas;
+}
+
+///
+/// Returns the duration of traffic at the limited rates that may be sent at once.
+///
+/// The default value is one second.
+///
+/// \since QXmpp 1.11
+///
+std::chrono::milliseconds QXmppConfiguration::rateLimitBurst() const
+{
+    return d->rateLimitBurst;
+}
+
+///
+/// Sets the duration of traffic at the limited rates that may be sent at once.
+///
+/// After a period without traffic, up to rate * burst bytes (or stanzas) are written without
+/// delay, e.g. a limit of 1000 bytes per second with a burst of 2 seconds allows writing 2000
+/// bytes at once. At least one stanza is always allowed.
+///
+/// The default value is one second.
+///
+/// \since QXmpp 1.11
+///
+void QXmppConfiguration::setRateLimitBurst(std::chrono::milliseconds burst)
+{
+    d->rateLimitBurst = burst;
+}
+
+///
+/// Returns the delay after which the next server address is tried while a connection attempt is
+/// still in progress.
+///
+/// The default value is 250 ms.
+///
+/// \since QXmpp 1.11
+///
+std::chrono::milliseconds QXmppConfiguration::connectionAttemptDelay() const
+{
+    return d->connectionAttemptDelay;
+}
+
+///
+/// Sets the delay after which the next server address is tried while a connection attempt is
+/// still in progress.
+///
+/// When the server addresses are looked up via DNS SRV records (or the domain is used as a
+/// fallback), all of them are resolved in parallel (A and AAAA records) and TCP connection
+/// attempts are started one after another with this delay, alternating between IPv6 and IPv4
+/// (RFC 8305, "Happy Eyeballs"). The first address that accepts the connection is used for the
+/// stream and all other attempts are cancelled. This way an unreachable server address does not
+/// delay the login until the connection attempt has timed out.
+///
+/// The latency of successful attempts is recorded in the "connect.latency" histogram of
+/// QXmppLogger::metrics().
+///
+/// A delay of 0 disables racing, the server addresses are then tried one after another. Racing is
+/// also not used with a network proxy or an explicitly configured host.
+///
+/// \since QXmpp 1.11
+///
+void QXmppConfiguration::setConnectionAttemptDelay(std::chrono::milliseconds delay)
+{
+    d->connectionAttemptDelay = delay;
+}
+
+///
+/// Returns the cache for TLS session tickets.
+///
+/// By default, no cache is set and TLS sessions are not resumed.
+///
+/// \since QXmpp 1.11
+///
+std::shared_ptr<QXmppTlsSessionCache> QXmppConfiguration::tlsSessionCache() const
+{
+    return d->tlsSessionCache;
+}
+
+///
+/// Sets the cache for TLS session tickets.
+///
+/// After each successful TLS handshake the session ticket is stored in the cache and offered to
+/// the server on the next connection to the same server address for the same domain, so the TLS
+/// session can be resumed without a full handshake. A cache can be shared by multiple clients.
+/// Copies of the configuration share the cache.
+///
+/// The counters "tls.session-cache.hits" and "tls.session-cache.misses" of
+/// QXmppLogger::metrics() record whether a ticket could be offered.
+///
+/// Passing nullptr disables TLS session resumption.
+///
+/// \since QXmpp 1.11
+///
+void QXmppConfiguration::setTlsSessionCache(std::shared_ptr<QXmppTlsSessionCache> cache)
+{
+    d->tlsSessionCache = std::move(cache);
+}
+
+///
+/// Returns whether stream negotiation steps are pipelined.
+///
+/// \since QXmpp 1.11
+///
+bool QXmppConfiguration::streamPipeliningEnabled() const
+{
+    return d->streamPipeliningEnabled;
+}
+
+///
+/// Sets whether stream negotiation steps are pipelined.
+///
+/// By default, the client waits for the response of each negotiation step before starting the
+/// next one. With pipelining enabled, the stream features the server announced after the last
+/// authentication are remembered (similar to \xep{0305, XMPP Quickstart}) and the following
+/// steps are sent without waiting:
+///  - resource binding is requested together with the stream restart after SASL authentication,
+///  - stream management is enabled and the session is opened (e.g. the roster is requested and
+///    the initial presence is sent) in the same flight as the resource binding result.
+///
+/// If the server does not accept stream management, stanzas sent before its answer are reported
+/// as sent without acknowledgement.
+///
+/// Pipelining is not used for SASL 2, which already combines these steps, and when a stream is
+/// resumed.
+///
+/// The time from connecting until the session is opened is recorded in the
+/// "connect.session-latency" histogram of QXmppLogger::metrics().
+///
+/// \since QXmpp 1.11
+///
+void QXmppConfiguration::setStreamPipeliningEnabled(bool enabled)
+{
+    d->streamPipeliningEnabled = enabled;
+}
+
+///
+/// Returns after how many sent stanzas an acknowledgement is requested when stream management
+/// is enabled.
+///
+/// The default value is 1, i.e. an acknowledgement is requested for each stanza.
+///
+/// \since QXmpp 1.11
+///
+int QXmppConfiguration::streamManagementAckRequestInterval() const
+{
+    return d->ackRequestInterval;
+}
+
+///
+/// Sets after how many sent stanzas an acknowledgement is requested when stream management is
+/// enabled.
+///
+/// Higher values reduce the number of requests and acknowledgements exchanged with the server,
+/// but stanzas are kept in memory for longer and more stanzas need to be resent after a
+/// reconnect. 0 disables requests based on the number of stanzas, in that case one of the other
+/// conditions should be enabled (see setStreamManagementAckRequestDelay() and
+/// setStreamManagementAckRequestOnIdle()). If none of them is enabled, an acknowledgement is
+/// requested for each stanza.
+///
+/// \since QXmpp 1.11
+///
+void QXmppConfiguration::setStreamManagementAckRequestInterval(int stanzas)
+{
+    d->ackRequestInterval = stanzas;
+}
+
+///
+/// Returns the maximum time after sending a stanza until an acknowledgement is requested.
+///
+/// The default value is 0, i.e. disabled.
+///
+/// \since QXmpp 1.11
+///
+std::chrono::milliseconds QXmppConfiguration::streamManagementAckRequestDelay() const
+{
+    return d->ackRequestDelay;
+}
+
+///
+/// Sets the maximum time after sending a stanza until an acknowledgement is requested.
+///
+/// This limits how long stanzas stay unacknowledged when the interval set with
+/// setStreamManagementAckRequestInterval() is not reached. 0 disables the delay.
+///
+/// \since QXmpp 1.11
+///
+void QXmppConfiguration::setStreamManagementAckRequestDelay(std::chrono::milliseconds delay)
+{
+    d->ackRequestDelay = delay;
+}
+
+///
+/// Returns whether an acknowledgement is requested once control returns to the event loop.
+///
+/// The default value is false.
+///
+/// \since QXmpp 1.11
+///
+bool QXmppConfiguration::streamManagementAckRequestOnIdle() const
+{
+    return d->ackRequestOnIdle;
+}
+
+///
+/// Sets whether an acknowledgement is requested once control returns to the event loop.
+///
+/// This sends a single request for all stanzas sent in one burst. Combined with a high
+/// interval, this results in few requests without delaying acknowledgements.
+///
+/// \since QXmpp 1.11
+///
+void QXmppConfiguration::setStreamManagementAckRequestOnIdle(bool enabled)
+{
+    d->ackRequestOnIdle = enabled;
+}
+
+///
+/// Returns the default time after which IQ requests fail with a QXmpp::TimeoutError if no
+/// response has been received.
+///
+/// The default value is 0, i.e. IQ requests do not time out.
+///
+/// \since QXmpp 1.11
+///
+std::chrono::milliseconds QXmppConfiguration::iqTimeout() const
+{
+    return d->iqTimeout;
+}
+
+///
+/// Sets the default time after which IQ requests fail with a QXmpp::TimeoutError if no
+/// response has been received.
+///
+/// Without a timeout, requests whose response got lost are only cancelled when the stream is
+/// closed. The timeout can be overridden per request using QXmppSendStanzaParams::setIqTimeout().
+/// The deadlines have a resolution of 100 ms.
+///
+/// \since QXmpp 1.11
+///
+void QXmppConfiguration::setIqTimeout(std::chrono::milliseconds timeout)
+{
+    d->iqTimeout = timeout;
+}
+
 /// \cond
 const Credentials &QXmppConfiguration::credentialData() const
 {
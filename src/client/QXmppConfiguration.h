@@ -7,6 +7,8 @@
 
 #include "QXmppGlobal.h"
 
+#include <chrono>
+#include <memory>
 #include <optional>
 
 #include <QSharedDataPointer>
@@ -17,6 +19,7 @@ class QSslCertificate;
 class QXmppConfigurationPrivate;
 class QXmppCredentials;
 class QXmppSasl2UserAgent;
+class QXmppTlsSessionCache;
 
 namespace QXmpp::Private {
 struct Credentials;
@@ -153,6 +156,51 @@ public:
     QList<QSslCertificate> caCertificates() const;
     void setCaCertificates(const QList<QSslCertificate> &);
 
+    qint64 maximumStanzaSize() const;
+    void setMaximumStanzaSize(qint64 bytes);
+
+    qint64 maximumReceiveBufferSize() const;
+    void setMaximumReceiveBufferSize(qint64 bytes);
+
+    bool lazyStanzaParsing() const;
+    void setLazyStanzaParsing(bool);
+
+    bool writeCoalescingEnabled() const;
+    void setWriteCoalescingEnabled(bool);
+
+    qint64 writeBufferHighWaterMark() const;
+    void setWriteBufferHighWaterMark(qint64 bytes);
+
+    qint64 rateLimitBytesPerSecond() const;
+    void setRateLimitBytesPerSecond(qint64 bytes);
+
+    double rateLimitStanzasPerSecond() const;
+    void setRateLimitStanzasPerSecond(double stanzas);
+
+    std::chrono::milliseconds rateLimitBurst() const;
+    void setRateLimitBurst(std::chrono::milliseconds burst);
+
+    std::chrono::milliseconds connectionAttemptDelay() const;
+    void setConnectionAttemptDelay(std::chrono::milliseconds delay);
+
+    std::shared_ptr<QXmppTlsSessionCache> tlsSessionCache() const;
+    void setTlsSessionCache(std::shared_ptr<QXmppTlsSessionCache> cache);
+
+    bool streamPipeliningEnabled() const;
+    void setStreamPipeliningEnabled(bool);
+
+    int streamManagementAckRequestInterval() const;
+    void setStreamManagementAckRequestInterval(int stanzas);
+
+    std::chrono::milliseconds streamManagementAckRequestDelay() const;
+    void setStreamManagementAckRequestDelay(std::chrono::milliseconds delay);
+
+    bool streamManagementAckRequestOnIdle() const;
+    void setStreamManagementAckRequestOnIdle(bool);
+
+    std::chrono::milliseconds iqTimeout() const;
+    void setIqTimeout(std::chrono::milliseconds timeout);
+
     /// \cond
     const QXmpp::Private::Credentials &credentialData() const;
     QXmpp::Private::Credentials &credentialData();
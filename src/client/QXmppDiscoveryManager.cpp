@@ -312,6 +312,14 @@ QStringList QXmppDiscoveryManager::discoveryFeatures() const
     return { ns_disco_info.toString() };
 }
 
+void QXmppDiscoveryManager::onRegistered(QXmppClient *)
+{
+    setStanzaRoutes({
+        { u"iq"_s, ns_disco_info.toString() },
+        { u"iq"_s, ns_disco_items.toString() },
+    });
+}
+
 bool QXmppDiscoveryManager::handleStanza(const QDomElement &element)
 {
     if (QXmpp::handleIqRequests<QXmppDiscoveryIq>(element, client(), this)) {
@@ -69,6 +69,11 @@ Q_SIGNALS:
     /// This signal is emitted when an items response is received.
     void itemsReceived(const QXmppDiscoveryIq &);
 
+protected:
+    /// \cond
+    void onRegistered(QXmppClient *client) override;
+    /// \endcond
+
 private:
     const std::unique_ptr<QXmppDiscoveryManagerPrivate> d;
 };
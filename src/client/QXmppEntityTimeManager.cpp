@@ -73,6 +73,13 @@ QStringList QXmppEntityTimeManager::discoveryFeatures() const
     return { ns_entity_time.toString() };
 }
 
+void QXmppEntityTimeManager::onRegistered(QXmppClient *)
+{
+    setStanzaRoutes({
+        { u"iq"_s, ns_entity_time.toString() },
+    });
+}
+
 bool QXmppEntityTimeManager::handleStanza(const QDomElement &element)
 {
     if (QXmpp::handleIqRequests<QXmppEntityTimeIq>(element, client(), this)) {
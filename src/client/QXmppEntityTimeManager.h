@@ -41,6 +41,11 @@ Q_SIGNALS:
     /// \brief This signal is emitted when a time response is received. It's not
     /// emitted when the QFuture-based request is used.
     void timeReceived(const QXmppEntityTimeIq &);
+
+protected:
+    /// \cond
+    void onRegistered(QXmppClient *client) override;
+    /// \endcond
 };
 
 #endif  // QXMPPENTITYTIMEMANAGER_H
@@ -172,6 +172,14 @@ bool QXmppMamManager::handleStanza(const QDomElement &element)
 }
 /// \endcond
 
+// Archive queries are catch-up traffic that should not delay interactive stanzas.
+static QXmppSendStanzaParams bulkParams()
+{
+    QXmppSendStanzaParams params;
+    params.setPriority(QXmpp::SendPriority::Bulk);
+    return params;
+}
+
 static QXmppMamQueryIq buildRequest(const QString &to,
                                     const QString &node,
                                     const QString &jid,
@@ -252,8 +260,9 @@ QString QXmppMamManager::retrieveArchivedMessages(const QString &to,
                                                   const QXmppResultSetQuery &resultSetQuery)
 {
     auto queryIq = buildRequest(to, node, jid, start, end, resultSetQuery);
-    client()->sendPacket(queryIq);
-    return queryIq.id();
+    const auto id = queryIq.id();
+    client()->send(std::move(queryIq), bulkParams());
+    return id;
 }
 
 ///
@@ -289,7 +298,7 @@ QXmppTask<QXmppMamManager::RetrieveResult> QXmppMamManager::retrieveMessages(con
     auto task = itr->second.promise.task();
 
     // retrieve messages
-    client()->sendIq(std::move(queryIq)).then(this, [this, queryId](QXmppClient::IqResult result) {
+    client()->sendIq(std::move(queryIq), bulkParams()).then(this, [this, queryId](QXmppClient::IqResult result) {
         auto itr = d->ongoingRequests.find(queryId.toStdString());
         if (itr == d->ongoingRequests.end()) {
             return;
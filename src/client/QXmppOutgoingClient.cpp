@@ -15,12 +15,15 @@
 #include "QXmppPacket_p.h"
 #include "QXmppPingIq.h"
 #include "QXmppStreamFeatures.h"
+#include "QXmppTlsSessionCache.h"
 #include "QXmppUtils.h"
 #include "QXmppUtils_p.h"
 
 #include "Algorithms.h"
+#include "DnsCache.h"
 #include "Stream.h"
 #include "StringLiterals.h"
+#include "XmlTree.h"
 
 #include <unordered_map>
 
@@ -55,22 +58,16 @@ using ServerAddressesResult = std::variant<std::vector<ServerAddress>, QXmppErro
 
 static QXmppTask<ServerAddressesResult> lookupXmppSrvRecords(const QString &domain, const QString &serviceName, ServerAddress::ConnectionType connectionType, QObject *context)
 {
-    QXmppPromise<ServerAddressesResult> p;
-    auto task = p.task();
-
-    auto *dns = new QDnsLookup(QDnsLookup::SRV, u"_" + serviceName + u"._tcp." + domain, context);
-    QObject::connect(dns, &QDnsLookup::finished, context, [dns, connectionType, p = std::move(p)]() mutable {
-        if (auto error = dns->error(); error != QDnsLookup::NoError) {
-            p.finish(QXmppError { dns->errorString(), error });
-        } else {
-            p.finish(transform<std::vector<ServerAddress>>(dns->serviceRecords(), [connectionType](auto record) {
-                return ServerAddress { connectionType, record.target(), record.port() };
-            }));
+    // shared by all connections, reconnects do not hit the resolver until the records expire
+    auto lookup = DnsCache::instance().lookupSrv(u"_" + serviceName + u"._tcp." + domain);
+    return chain<ServerAddressesResult>(std::move(lookup), context, [connectionType](DnsCache::SrvResult &&result) -> ServerAddressesResult {
+        if (auto *error = std::get_if<QXmppError>(&result)) {
+            return std::move(*error);
         }
+        return transform<std::vector<ServerAddress>>(std::get<QList<QDnsServiceRecord>>(result), [connectionType](const auto &record) {
+            return ServerAddress { connectionType, record.target(), record.port() };
+        });
     });
-
-    dns->lookup();
-    return task;
 }
 
 static QXmppTask<ServerAddressesResult> lookupXmppClientRecords(const QString &domain, QObject *context)
@@ -119,6 +116,7 @@ QXmppOutgoingClientPrivate::QXmppOutgoingClientPrivate(QXmppOutgoingClient *qq)
     : socket(qq),
       streamAckManager(socket),
       iqManager(qq, streamAckManager),
+      connectionRacer(qq),
       listener(qq),
       fastTokenManager(config),
       c2sStreamManager(qq),
@@ -128,7 +126,7 @@ QXmppOutgoingClientPrivate::QXmppOutgoingClientPrivate(QXmppOutgoingClient *qq)
 {
 }
 
-void QXmppOutgoingClientPrivate::connectToHost(const ServerAddress &address)
+void QXmppOutgoingClientPrivate::connectToHost(const ServerAddress &address, const QString &tlsSessionHost, QTcpSocket *connectedSocket)
 {
     auto sslConfig = QSslConfiguration::defaultConfiguration();
 
@@ -139,6 +137,19 @@ void QXmppOutgoingClientPrivate::connectToHost(const ServerAddress &address)
     // ALPN protocol 'xmpp-client'
     sslConfig.setAllowedNextProtocols({ QByteArrayLiteral("xmpp-client") });
 
+    // offer the session ticket of the last connection to skip the full TLS handshake
+    this->tlsSessionHost = tlsSessionHost.isEmpty() ? address.host : tlsSessionHost;
+    tlsSessionPort = address.port;
+    if (auto cache = config.tlsSessionCache(); cache && config.streamSecurityMode() != QXmppConfiguration::TLSDisabled) {
+        sslConfig.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+        if (auto ticket = cache->sessionTicket(config.domain(), this->tlsSessionHost, tlsSessionPort); !ticket.isEmpty()) {
+            sslConfig.setSessionTicket(ticket);
+            Q_EMIT q->updateCounter(u"tls.session-cache.hits"_s);
+        } else {
+            Q_EMIT q->updateCounter(u"tls.session-cache.misses"_s);
+        }
+    }
+
     // set new ssl config
     q->socket()->setSslConfiguration(sslConfig);
 
@@ -147,14 +158,55 @@ void QXmppOutgoingClientPrivate::connectToHost(const ServerAddress &address)
     // set the name the SSL certificate should match
     q->socket()->setPeerVerifyName(config.domain());
 
-    socket.connectToHost(address);
+    // limits for the incoming stream
+    socket.setMaximumStanzaSize(config.maximumStanzaSize());
+    socket.setMaximumBufferSize(config.maximumReceiveBufferSize());
+    socket.setWriteCoalescingEnabled(config.writeCoalescingEnabled());
+    streamAckManager.setAckRequestPolicy(config.streamManagementAckRequestInterval(),
+                                         config.streamManagementAckRequestDelay(),
+                                         config.streamManagementAckRequestOnIdle());
+    streamAckManager.setWriteBufferHighWaterMark(config.writeBufferHighWaterMark());
+    streamAckManager.setRateLimit(config.rateLimitBytesPerSecond(),
+                                  config.rateLimitStanzasPerSecond(),
+                                  config.rateLimitBurst());
+
+    // take over an established connection if possible
+    if (!socket.connectToSocket(address, connectedSocket)) {
+        socket.connectToHost(address);
+    }
 }
 
 void QXmppOutgoingClientPrivate::connectToAddressList(std::vector<ServerAddress> &&addresses)
 {
     serverAddresses = std::move(addresses);
     nextServerAddressIndex = 0;
-    connectToNextAddress();
+
+    // with a proxy, host names are resolved by the proxy and can't be raced
+    auto proxyType = config.networkProxy().type();
+    if (proxyType == QNetworkProxy::DefaultProxy) {
+        proxyType = QNetworkProxy::applicationProxy().type();
+    }
+    if (config.connectionAttemptDelay().count() <= 0 || proxyType != QNetworkProxy::NoProxy) {
+        connectToNextAddress();
+        return;
+    }
+
+    connectionRacer.setAttemptDelay(config.connectionAttemptDelay());
+    connectionRacer.race(serverAddresses).then(q, [this](ConnectionRacer::Result &&result) {
+        if (auto *winner = std::get_if<ConnectionRacer::Winner>(&result)) {
+            // continue on the established connection, the following server addresses are tried
+            // one by one if the stream can't be established
+            auto address = serverAddresses.at(winner->index);
+            address.host = winner->address.toString();
+            nextServerAddressIndex = winner->index + 1;
+            nextAddressState = Current;
+            // TLS sessions are stored by host name, the IP address may differ next time
+            connectToHost(address, serverAddresses.at(winner->index).host, winner->socket.get());
+        } else {
+            q->setError(u"Could not connect to any of the server addresses"_s,
+                        std::get<QAbstractSocket::SocketError>(result));
+        }
+    });
 }
 
 void QXmppOutgoingClientPrivate::connectToNextAddress()
@@ -163,6 +215,21 @@ void QXmppOutgoingClientPrivate::connectToNextAddress()
     connectToHost(serverAddresses.at(nextServerAddressIndex++));
 }
 
+void QXmppOutgoingClientPrivate::storeTlsSession()
+{
+    auto cache = config.tlsSessionCache();
+    if (!cache || tlsSessionHost.isEmpty()) {
+        return;
+    }
+
+    const auto sslConfig = q->socket()->sslConfiguration();
+    if (const auto ticket = sslConfig.sessionTicket(); !ticket.isEmpty()) {
+        // without a lifetime hint from the server the ticket is kept for one hour
+        const auto lifetimeHint = sslConfig.sessionTicketLifeTimeHint();
+        cache->insert(config.domain(), tlsSessionHost, tlsSessionPort, ticket, lifetimeHint > 0 ? std::chrono::seconds(lifetimeHint) : std::chrono::hours(1));
+    }
+}
+
 ///
 /// Constructs an outgoing client stream.
 ///
@@ -178,10 +245,29 @@ QXmppOutgoingClient::QXmppOutgoingClient(QObject *parent)
     connect(socket, QOverload<const QList<QSslError> &>::of(&QSslSocket::sslErrors), this, &QXmppOutgoingClient::socketSslErrors);
     connect(socket, &QSslSocket::errorOccurred, this, &QXmppOutgoingClient::socketError);
 
+    // remember the TLS session, with TLS 1.3 tickets are only sent after the handshake
+    connect(socket, &QSslSocket::encrypted, this, [this] {
+        d->storeTlsSession();
+    });
+    connect(socket, &QSslSocket::newSessionTicketReceived, this, [this] {
+        d->storeTlsSession();
+    });
+
     connect(&d->socket, &XmppSocket::started, this, &QXmppOutgoingClient::handleStart);
     connect(&d->socket, &XmppSocket::stanzaReceived, this, &QXmppOutgoingClient::handlePacketReceived);
+    // stream management acks are handled without building a QDomDocument
+    d->socket.setEmptyElementHandler([this](const XmlElement &element) {
+        if (!std::holds_alternative<QXmppOutgoingClient *>(d->listener) || !streamAckManager().handleElement(element)) {
+            return false;
+        }
+        d->pingManager.onDataReceived();
+        return true;
+    });
     connect(&d->socket, &XmppSocket::streamReceived, this, &QXmppOutgoingClient::handleStream);
     connect(&d->socket, &XmppSocket::streamClosed, this, &QXmppOutgoingClient::disconnectFromHost);
+    connect(&d->socket, &XmppSocket::streamErrorSent, this, [this](StreamError condition, const QString &text) {
+        setError(text, condition);
+    });
 }
 
 QXmppOutgoingClient::~QXmppOutgoingClient()
@@ -236,6 +322,8 @@ CsiManager &QXmppOutgoingClient::csiManager() const
 /// Attempts to connect to the XMPP server.
 void QXmppOutgoingClient::connectToHost()
 {
+    d->connectStart = std::chrono::steady_clock::now();
+
     // if a host for resumption is available, connect to it
     if (d->c2sStreamManager.hasResumeAddress()) {
         auto [host, port] = d->c2sStreamManager.resumeAddress();
@@ -310,6 +398,7 @@ void QXmppOutgoingClient::connectToHost()
 ///
 void QXmppOutgoingClient::disconnectFromHost()
 {
+    d->connectionRacer.abort();
     d->c2sStreamManager.onStreamClosed();
     d->socket.disconnectFromHost();
 }
@@ -335,10 +424,34 @@ bool QXmppOutgoingClient::isConnected() const
 /// \since QXmpp 1.5
 ///
 QXmppTask<IqResult> QXmppOutgoingClient::sendIq(QXmppIq &&iq)
+{
+    return sendIq(std::move(iq), std::nullopt);
+}
+
+///
+/// Sends an IQ and reports the response asynchronously.
+///
+/// If no \a timeout is given, QXmppConfiguration::iqTimeout() is used.
+///
+/// \since QXmpp 1.11
+///
+QXmppTask<IqResult> QXmppOutgoingClient::sendIq(QXmppIq &&iq, std::optional<std::chrono::milliseconds> timeout)
+{
+    return sendIq(std::move(iq), timeout, SendPriority::Interactive);
+}
+
+///
+/// Sends an IQ with the given \a priority and reports the response asynchronously.
+///
+/// If no \a timeout is given, QXmppConfiguration::iqTimeout() is used.
+///
+/// \since QXmpp 1.11
+///
+QXmppTask<IqResult> QXmppOutgoingClient::sendIq(QXmppIq &&iq, std::optional<std::chrono::milliseconds> timeout, SendPriority priority)
 {
     // If 'to' is empty the user's bare JID is meant implicitly (see RFC6120, section 10.3.3.).
     auto to = iq.to();
-    return d->iqManager.sendIq(std::move(iq), to.isEmpty() ? d->config.jidBare() : to);
+    return d->iqManager.sendIq(std::move(iq), to.isEmpty() ? d->config.jidBare() : to, timeout.value_or(d->config.iqTimeout()), priority);
 }
 
 QSslSocket *QXmppOutgoingClient::socket() const
@@ -401,11 +514,12 @@ void QXmppOutgoingClient::startSasl2Auth(const Sasl2::StreamFeature &sasl2Featur
     d->c2sStreamManager.onSasl2Authenticate(sasl2Request, sasl2Feature);
 
     // start authentication
-    d->setListener<Sasl2Manager>(&d->socket).authenticate(std::move(sasl2Request), d->config, sasl2Feature, this).then(this, [this](auto result) {
+    d->setListener<Sasl2Manager>(&d->socket).authenticate(std::move(sasl2Request), d->config, sasl2Feature, this).then(this, [this, scramKeys = d->config.credentialData().scramKeys](auto result) {
         if (auto success = std::get_if<Sasl2::Success>(&result)) {
             debug(u"Authenticated"_s);
             d->isAuthenticated = true;
             d->authenticationMethod = AuthenticationMethod::Sasl2;
+            d->scramKeysChanged = d->config.credentialData().scramKeys != scramKeys;
             d->config.setJid(success->authorizationIdentifier);
             d->bind2Bound = std::move(success->bound);
 
@@ -498,6 +612,13 @@ void QXmppOutgoingClient::startSmResume()
 
 void QXmppOutgoingClient::startSmEnable()
 {
+    if (d->config.streamPipeliningEnabled()) {
+        // open the session in the same flight, the answer is handled by handleElement()
+        d->c2sStreamManager.requestEnablePipelined();
+        openSession();
+        return;
+    }
+
     d->listener = &d->c2sStreamManager;
     d->c2sStreamManager.requestEnable().then(this, [this] {
         // enabling of stream management may or may not have succeeded
@@ -532,20 +653,49 @@ void QXmppOutgoingClient::startResourceBinding()
     });
 }
 
+//
+// Requests resource binding directly after the stream restart using the stream features of the
+// last connection, without waiting for the features of the new stream.
+//
+void QXmppOutgoingClient::startPipelinedResourceBinding()
+{
+    if (!d->cachedStreamFeatures || d->cachedStreamFeatures->domain != d->config.domain()) {
+        return;
+    }
+    // resumption depends on the current features
+    if (d->c2sStreamManager.canResume()) {
+        return;
+    }
+
+    const auto features = d->cachedStreamFeatures->features;
+    if (features.bindMode() == QXmppStreamFeatures::Disabled) {
+        return;
+    }
+
+    debug(u"Requesting resource binding before receiving the stream features"_s);
+    d->pipelinedFeaturesPending = true;
+    applyStreamFeatures(features);
+    startResourceBinding();
+}
+
 void QXmppOutgoingClient::openSession()
 {
     info(u"Session established"_s);
     Q_ASSERT(!d->sessionStarted);
     d->sessionStarted = true;
 
+    Q_EMIT updateHistogram(u"connect.session-latency"_s,
+                           std::chrono::duration<double>(std::chrono::steady_clock::now() - d->connectStart).count());
+
     SessionBegin session {
         d->c2sStreamManager.enabled(),
         d->c2sStreamManager.streamResumed(),
         d->bind2Bound.has_value(),
-        d->authenticationMethod == AuthenticationMethod::Sasl2 && d->fastTokenManager.tokenChanged(),
+        (d->authenticationMethod == AuthenticationMethod::Sasl2 && d->fastTokenManager.tokenChanged()) || d->scramKeysChanged,
         d->authenticationMethod,
     };
     d->bind2Bound.reset();
+    d->scramKeysChanged = false;
 
     d->iqManager.onSessionOpened(session);
     d->carbonManager.onSessionOpened(session);
@@ -629,6 +779,7 @@ void QXmppOutgoingClient::handleStart()
 
     // reset active manager (e.g. authentication)
     d->listener = this;
+    d->pipelinedFeaturesPending = false;
 
     d->c2sStreamManager.onStreamStart();
 
@@ -664,6 +815,16 @@ void QXmppOutgoingClient::handlePacketReceived(const QDomElement &nodeRecv)
     // if we receive any kind of data, stop the timeout timer
     d->pingManager.onDataReceived();
 
+    // resource binding has already been started with the cached features
+    if (d->pipelinedFeaturesPending && QXmppStreamFeatures::isStreamFeatures(nodeRecv)) {
+        d->pipelinedFeaturesPending = false;
+
+        QXmppStreamFeatures features;
+        features.parse(nodeRecv);
+        handlePipelinedStreamFeatures(features);
+        return;
+    }
+
     auto index = d->listener.index();
 
     switch (visit(overloaded {
@@ -688,6 +849,11 @@ void QXmppOutgoingClient::handlePacketReceived(const QDomElement &nodeRecv)
 
 HandleElementResult QXmppOutgoingClient::handleElement(const QDomElement &nodeRecv)
 {
+    // answer to a pipelined <enable/>
+    if (d->c2sStreamManager.handlePipelinedEnableResponse(nodeRecv)) {
+        return Accepted;
+    }
+
     // handle SM acks, stanza counter and IQ responses
     if (streamAckManager().handleStanza(nodeRecv) || iqManager().handleStanza(nodeRecv)) {
         return Accepted;
@@ -737,12 +903,16 @@ void QXmppOutgoingClient::handleStreamFeatures(const QXmppStreamFeatures &featur
     }
     // SASL
     if (saslAvailable && configuration().useSASLAuthentication()) {
-        d->setListener<SaslManager>(&d->socket).authenticate(d->config, features.authMechanisms(), this).then(this, [this](auto result) {
+        d->setListener<SaslManager>(&d->socket).authenticate(d->config, features.authMechanisms(), this).then(this, [this, scramKeys = d->config.credentialData().scramKeys](auto result) {
             if (std::holds_alternative<Success>(result)) {
                 debug(u"Authenticated"_s);
                 d->isAuthenticated = true;
                 d->authenticationMethod = AuthenticationMethod::Sasl;
+                d->scramKeysChanged = d->config.credentialData().scramKeys != scramKeys;
                 handleStart();
+                if (d->config.streamPipeliningEnabled()) {
+                    startPipelinedResourceBinding();
+                }
             } else {
                 auto [text, err] = std::get<SaslManager::AuthError>(std::move(result));
                 setError(text, std::move(err));
@@ -758,9 +928,7 @@ void QXmppOutgoingClient::handleStreamFeatures(const QXmppStreamFeatures &featur
     }
 
     // store which features are available
-    d->bindModeAvailable = (features.bindMode() != QXmppStreamFeatures::Disabled);
-    d->c2sStreamManager.onStreamFeatures(features);
-    d->csiManager.onStreamFeatures(features);
+    applyStreamFeatures(features);
 
     // check whether the stream can be resumed
     if (d->c2sStreamManager.canRequestResume()) {
@@ -784,6 +952,39 @@ void QXmppOutgoingClient::handleStreamFeatures(const QXmppStreamFeatures &featur
     openSession();
 }
 
+//
+// Checks the actual stream features after the negotiation has been continued with the cached
+// ones. Steps that have not been started yet use the actual features.
+//
+void QXmppOutgoingClient::handlePipelinedStreamFeatures(const QXmppStreamFeatures &features)
+{
+    const auto &cached = d->cachedStreamFeatures->features;
+    if (features.bindMode() != cached.bindMode() ||
+        features.streamManagementMode() != cached.streamManagementMode() ||
+        features.clientStateIndicationMode() != cached.clientStateIndicationMode()) {
+        info(u"Stream features changed since the last connection"_s);
+    }
+
+    // also updates the cache for the next connection
+    applyStreamFeatures(features);
+
+    // stream management has not been offered by the cached features, enable it now
+    if (d->sessionStarted && d->c2sStreamManager.canRequestEnable()) {
+        d->c2sStreamManager.requestEnablePipelined();
+    }
+}
+
+void QXmppOutgoingClient::applyStreamFeatures(const QXmppStreamFeatures &features)
+{
+    d->bindModeAvailable = (features.bindMode() != QXmppStreamFeatures::Disabled);
+    d->c2sStreamManager.onStreamFeatures(features);
+    d->csiManager.onStreamFeatures(features);
+
+    if (d->isAuthenticated) {
+        d->cachedStreamFeatures = QXmppOutgoingClientPrivate::CachedStreamFeatures { d->config.domain(), features };
+    }
+}
+
 void QXmppOutgoingClient::handleStreamError(const QXmpp::Private::StreamErrorElement &streamError)
 {
     if (auto *redirect = std::get_if<StreamErrorElement::SeeOtherHost>(&streamError.condition)) {
@@ -829,14 +1030,22 @@ bool QXmppOutgoingClient::handleStanza(const QDomElement &stanza)
         }
     } else if (stanza.tagName() == u"presence") {
         QXmppPresence presence;
-        presence.parse(stanza);
+        if (d->config.lazyStanzaParsing()) {
+            presence.parseLazily(stanza);
+        } else {
+            presence.parse(stanza);
+        }
 
         // emit presence
         Q_EMIT presenceReceived(presence);
         return true;
     } else if (stanza.tagName() == u"message") {
         QXmppMessage message;
-        message.parse(stanza);
+        if (d->config.lazyStanzaParsing()) {
+            message.parseLazily(stanza);
+        } else {
+            message.parse(stanza);
+        }
 
         // emit message
         Q_EMIT messageReceived(message);
@@ -1116,7 +1325,7 @@ void PingManager::sendPing()
         // send ping packet
         QXmppPingIq ping;
         ping.setTo(q->configuration().domain());
-        q->streamAckManager().send(ping);
+        q->streamAckManager().send(ping, SendPriority::Control);
     }
 
     // start timeout timer
@@ -1129,13 +1338,16 @@ void PingManager::sendPing()
 
 OutgoingIqManager::OutgoingIqManager(QXmppLoggable *l, StreamAckManager &streamAckManager)
     : l(l),
-      m_streamAckManager(streamAckManager)
+      m_streamAckManager(streamAckManager),
+      m_deadlineTimer(new QTimer(l))
 {
+    m_deadlineTimer->setInterval(m_deadlines.resolution());
+    QObject::connect(m_deadlineTimer, &QTimer::timeout, l, [this] { expireDeadlines(); });
 }
 
 OutgoingIqManager::~OutgoingIqManager() = default;
 
-QXmppTask<IqResult> OutgoingIqManager::sendIq(QXmppIq &&iq, const QString &to)
+QXmppTask<IqResult> OutgoingIqManager::sendIq(QXmppIq &&iq, const QString &to, std::optional<std::chrono::milliseconds> timeout, SendPriority priority)
 {
     if (iq.id().isEmpty()) {
         warning(u"QXmpp: sendIq() error: ID is empty. Using random ID."_s);
@@ -1148,12 +1360,12 @@ QXmppTask<IqResult> OutgoingIqManager::sendIq(QXmppIq &&iq, const QString &to)
         iq.setId(QXmppUtils::generateStanzaUuid());
     }
 
-    return sendIq(QXmppPacket(iq), iq.id(), to);
+    return sendIq(QXmppPacket(iq), iq.id(), to, timeout, priority);
 }
 
-QXmppTask<IqResult> OutgoingIqManager::sendIq(QXmppPacket &&packet, const QString &id, const QString &to)
+QXmppTask<IqResult> OutgoingIqManager::sendIq(QXmppPacket &&packet, const QString &id, const QString &to, std::optional<std::chrono::milliseconds> timeout, SendPriority priority)
 {
-    auto task = start(id, to);
+    auto task = start(id, to, timeout);
 
     // the task only finishes instantly if there was an error
     if (task.isFinished()) {
@@ -1161,7 +1373,7 @@ QXmppTask<IqResult> OutgoingIqManager::sendIq(QXmppPacket &&packet, const QStrin
     }
 
     // send request IQ and report sending errors (sending success is not reported in any way)
-    m_streamAckManager.send(std::move(packet)).then(l, [this, id](SendResult result) {
+    m_streamAckManager.send(std::move(packet), priority).then(l, [this, id](SendResult result) {
         if (std::holds_alternative<QXmppError>(result)) {
             finish(id, std::get<QXmppError>(std::move(result)));
         }
@@ -1180,7 +1392,7 @@ bool OutgoingIqManager::isIdValid(const QString &id) const
     return !id.isEmpty() && !hasId(id);
 }
 
-QXmppTask<IqResult> OutgoingIqManager::start(const QString &id, const QString &to)
+QXmppTask<IqResult> OutgoingIqManager::start(const QString &id, const QString &to, std::optional<std::chrono::milliseconds> timeout)
 {
     if (!isIdValid(id)) {
         return makeReadyTask<IqResult>(
@@ -1195,25 +1407,41 @@ QXmppTask<IqResult> OutgoingIqManager::start(const QString &id, const QString &t
     }
 
     auto [itr, success] = m_requests.emplace(id, IqState { {}, to });
+
+    const bool hasTimeout = timeout && timeout->count() > 0;
+    if (hasTimeout || l->isMetricsEnabled()) {
+        itr->second.sent = std::chrono::steady_clock::now();
+    }
+    if (hasTimeout) {
+        itr->second.deadline = m_deadlines.add(itr->second.sent + *timeout, id);
+        if (!m_deadlineTimer->isActive()) {
+            m_deadlineTimer->start();
+        }
+    }
     return itr->second.interface.task();
 }
 
 void OutgoingIqManager::finish(const QString &id, IqResult &&result)
 {
     if (auto itr = m_requests.find(id); itr != m_requests.end()) {
-        itr->second.interface.finish(std::move(result));
+        m_deadlines.remove(itr->second.deadline);
+        auto promise = std::move(itr->second.interface);
         m_requests.erase(itr);
+        promise.finish(std::move(result));
     }
 }
 
 void OutgoingIqManager::cancelAll()
 {
-    for (auto &[id, state] : m_requests) {
+    auto requests = std::exchange(m_requests, {});
+    m_deadlines = TimerWheel<QString>(m_deadlines.resolution());
+    m_deadlineTimer->stop();
+
+    for (auto &[id, state] : requests) {
         state.interface.finish(QXmppError {
             u"IQ has been cancelled."_s,
             QXmpp::SendError::Disconnected });
     }
-    m_requests.clear();
 }
 
 void OutgoingIqManager::onSessionOpened(const SessionBegin &session)
@@ -1250,7 +1478,6 @@ bool OutgoingIqManager::handleStanza(const QDomElement &stanza)
         return false;
     }
 
-    auto &promise = itr->second.interface;
     const auto &expectedFrom = itr->second.jid;
 
     // Check that the sender of the response matches the recipient of the request.
@@ -1264,6 +1491,16 @@ bool OutgoingIqManager::handleStanza(const QDomElement &stanza)
         return false;
     }
 
+    // metrics may have been enabled after sending the request
+    if (l->isMetricsEnabled() && itr->second.sent != std::chrono::steady_clock::time_point()) {
+        const std::chrono::duration<double> roundTripTime = std::chrono::steady_clock::now() - itr->second.sent;
+        Q_EMIT l->updateHistogram(u"iq.round-trip-time"_s, roundTripTime.count());
+    }
+
+    m_deadlines.remove(itr->second.deadline);
+    auto promise = std::move(itr->second.interface);
+    m_requests.erase(itr);
+
     // report IQ errors as QXmppError (this makes it impossible to parse the full error IQ,
     // but that is okay for now)
     if (iqType == u"error") {
@@ -1281,8 +1518,6 @@ bool OutgoingIqManager::handleStanza(const QDomElement &stanza)
         // report stanza element for parsing
         promise.finish(stanza);
     }
-
-    m_requests.erase(itr);
     return true;
 }
 
@@ -1291,6 +1526,27 @@ void OutgoingIqManager::warning(const QString &message)
     Q_EMIT l->logMessage(QXmppLogger::WarningMessage, message);
 }
 
+void OutgoingIqManager::expireDeadlines()
+{
+    const auto expired = m_deadlines.expire();
+    if (m_deadlines.isEmpty()) {
+        m_deadlineTimer->stop();
+    }
+
+    for (const auto &id : expired) {
+        if (auto itr = m_requests.find(id); itr != m_requests.end()) {
+            auto promise = std::move(itr->second.interface);
+            const auto jid = itr->second.jid;
+            m_requests.erase(itr);
+
+            Q_EMIT l->updateCounter(u"iq.timeouts"_s);
+            promise.finish(QXmppError {
+                u"IQ request '%1' to '%2' timed out."_s.arg(id, jid),
+                QXmpp::TimeoutError() });
+        }
+    }
+}
+
 C2sStreamManager::C2sStreamManager(QXmppOutgoingClient *q)
     : q(q)
 {
@@ -1340,6 +1596,7 @@ void C2sStreamManager::onStreamStart()
 {
     m_streamResumed = false;
     m_enabled = false;
+    m_pipelinedEnable = false;
     m_request = {};
 }
 
@@ -1409,28 +1666,76 @@ QXmppTask<void> C2sStreamManager::requestEnable()
     return std::get<EnableRequest>(m_request).p.task();
 }
 
+//
+// Enables stream management without waiting for the answer of the server.
+//
+// Stanzas sent afterwards are counted already, but acknowledgements are only requested after the
+// server confirmed stream management. The answer is handled by handlePipelinedEnableResponse().
+//
+void C2sStreamManager::requestEnablePipelined()
+{
+    Q_ASSERT(std::holds_alternative<NoRequest>(m_request));
+    q->xmppSocket().sendData(serializeXml(SmEnable { true }));
+
+    m_enabled = true;
+    m_pipelinedEnable = true;
+    q->streamAckManager().enablePendingStreamManagement();
+}
+
+bool C2sStreamManager::handlePipelinedEnableResponse(const QDomElement &el)
+{
+    if (!m_pipelinedEnable) {
+        return false;
+    }
+
+    if (auto enabled = SmEnabled::fromDom(el)) {
+        onEnabled(*enabled);
+        return true;
+    }
+    if (auto failed = SmFailed::fromDom(el)) {
+        onEnableFailed(*failed);
+        return true;
+    }
+    return false;
+}
+
 void C2sStreamManager::onEnabled(const SmEnabled &enabled)
 {
     // Called whenever stream management is enabled, either by requestEnable() or by onBind2Bound()
     q->debug(u"Stream management enabled"_s);
     m_smId = enabled.id;
+    m_smMax = enabled.max;
     m_canResume = enabled.resume;
+    m_restoredJid.clear();
     if (enabled.resume && !enabled.location.isEmpty()) {
         setResumeAddress(enabled.location);
     }
 
     m_enabled = true;
-    q->streamAckManager().enableStreamManagement(true);
+    if (std::exchange(m_pipelinedEnable, false)) {
+        // outgoing stanzas have been counted since <enable/>
+        q->streamAckManager().confirmStreamManagement();
+    } else {
+        q->streamAckManager().enableStreamManagement(true);
+    }
 }
 
 void C2sStreamManager::onEnableFailed(const SmFailed &)
 {
     q->warning(u"Failed to enable stream management"_s);
+    if (std::exchange(m_pipelinedEnable, false)) {
+        m_enabled = false;
+        q->streamAckManager().disableStreamManagement();
+    }
 }
 
 void C2sStreamManager::onResumed(const SmResumed &resumed)
 {
     q->debug(u"Stream resumed"_s);
+    if (!m_restoredJid.isEmpty()) {
+        q->configuration().setJid(m_restoredJid);
+        m_restoredJid.clear();
+    }
     q->streamAckManager().setAcknowledgedSequenceNumber(resumed.h);
     m_streamResumed = true;
     m_enabled = true;
@@ -1440,6 +1745,48 @@ void C2sStreamManager::onResumed(const SmResumed &resumed)
 void C2sStreamManager::onResumeFailed(const SmFailed &)
 {
     q->debug(u"Stream resumption failed"_s);
+    m_restoredJid.clear();
+}
+
+// Returns the state of the stream if it can be resumed later.
+std::optional<StreamResumptionData> C2sStreamManager::resumptionData() const
+{
+    if (!m_canResume || m_smId.isEmpty()) {
+        return {};
+    }
+
+    const auto &ackManager = q->streamAckManager();
+    return StreamResumptionData {
+        m_smId,
+        m_restoredJid.isEmpty() ? q->configuration().jid() : m_restoredJid,
+        m_resumeHost,
+        m_resumePort,
+        m_smMax ? QDateTime::currentDateTimeUtc().addSecs(qint64(m_smMax)) : QDateTime(),
+        ackManager.lastIncomingSequenceNumber(),
+        ackManager.lastOutgoingSequenceNumber(),
+        ackManager.unacknowledgedData(),
+    };
+}
+
+// Restores a previously stored stream state, the next connection attempt tries to resume it.
+void C2sStreamManager::restoreResumptionData(const StreamResumptionData &data)
+{
+    q->streamAckManager().restoreState(data.lastIncomingSequenceNumber,
+                                       data.lastOutgoingSequenceNumber,
+                                       data.unacknowledgedStanzas);
+
+    // the queued stanzas are still resent after the stream management has been enabled
+    if (data.expiry.isValid() && data.expiry < QDateTime::currentDateTimeUtc()) {
+        q->debug(u"Stored stream management session has expired"_s);
+        return;
+    }
+
+    m_smId = data.id;
+    m_smMax = 0;
+    m_canResume = true;
+    m_restoredJid = data.jid;
+    m_resumeHost = data.host;
+    m_resumePort = data.host.isEmpty() ? 0 : data.port;
 }
 
 bool C2sStreamManager::setResumeAddress(const QString &address)
@@ -1530,8 +1877,8 @@ void CsiManager::onBind2Request(Bind2Request &request, const std::vector<QString
 void CsiManager::sendState()
 {
     if (m_client->isAuthenticated() && m_featureAvailable) {
-        auto xml = m_state == Active ? serializeXml(CsiActive()) : serializeXml(CsiInactive());
-        m_synced = m_client->xmppSocket().sendData(xml);
+        auto &socket = m_client->xmppSocket();
+        m_synced = m_state == Active ? socket.sendXml(CsiActive()) : socket.sendXml(CsiInactive());
     } else {
         m_synced = false;
     }
@@ -14,6 +14,8 @@
 #include "QXmppStanza.h"
 #include "QXmppStreamError.h"
 
+#include <chrono>
+
 #include <QAbstractSocket>
 
 class QDomElement;
@@ -42,6 +44,7 @@ struct Bind2Bound;
 struct SmEnabled;
 struct SmFailed;
 struct SmResumed;
+struct StreamResumptionData;
 struct StreamErrorElement;
 
 enum HandleElementResult {
@@ -60,7 +63,7 @@ struct SessionBegin {
     bool smEnabled;
     bool smResumed;
     bool bind2Used;
-    bool fastTokenChanged;
+    bool credentialsChanged;
     AuthenticationMethod authenticationMethod;
 };
 
@@ -92,6 +95,8 @@ public:
     bool isAuthenticated() const;
     bool isConnected() const;
     QXmppTask<IqResult> sendIq(QXmppIq &&);
+    QXmppTask<IqResult> sendIq(QXmppIq &&, std::optional<std::chrono::milliseconds> timeout);
+    QXmppTask<IqResult> sendIq(QXmppIq &&, std::optional<std::chrono::milliseconds> timeout, QXmpp::SendPriority priority);
 
     /// Returns the used socket
     QSslSocket *socket() const;
@@ -137,6 +142,8 @@ private:
     void handlePacketReceived(const QDomElement &element);
     QXmpp::Private::HandleElementResult handleElement(const QDomElement &nodeRecv);
     void handleStreamFeatures(const QXmppStreamFeatures &features);
+    void applyStreamFeatures(const QXmppStreamFeatures &features);
+    void handlePipelinedStreamFeatures(const QXmppStreamFeatures &features);
     void handleStreamError(const QXmpp::Private::StreamErrorElement &streamError);
     bool handleStanza(const QDomElement &);
     bool handleStarttls(const QXmppStreamFeatures &features);
@@ -150,6 +157,7 @@ private:
     void startSmResume();
     void startSmEnable();
     void startResourceBinding();
+    void startPipelinedResourceBinding();
     void openSession();
     void closeSession();
     void setError(const QString &text, ConnectionError &&details);
@@ -194,6 +202,10 @@ public:
     QXmppTask<void> requestResume();
     bool canRequestEnable() const { return m_smAvailable && !m_enabled; }
     QXmppTask<void> requestEnable();
+    void requestEnablePipelined();
+    bool handlePipelinedEnableResponse(const QDomElement &);
+    std::optional<StreamResumptionData> resumptionData() const;
+    void restoreResumptionData(const StreamResumptionData &data);
 
 private:
     friend class ::TestClient;
@@ -219,11 +231,17 @@ private:
     std::variant<NoRequest, ResumeRequest, EnableRequest> m_request;
     bool m_smAvailable = false;
     QString m_smId;
+    // maximum resumption time in seconds offered by the server
+    quint64 m_smMax = 0;
     bool m_canResume = false;
+    // full JID of a restored stream, applied when the stream is resumed
+    QString m_restoredJid;
     QString m_resumeHost;
     quint16 m_resumePort = 0;
     bool m_enabled = false;
     bool m_streamResumed = false;
+    // <enable/> has been sent without waiting for the answer
+    bool m_pipelinedEnable = false;
 };
 
 // XEP-0280: Message Carbons
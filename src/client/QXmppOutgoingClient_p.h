@@ -10,13 +10,19 @@
 #include "QXmppSaslManager_p.h"
 #include "QXmppSasl_p.h"
 #include "QXmppStreamError_p.h"
+#include "QXmppStreamFeatures.h"
 #include "QXmppStreamManagement_p.h"
 
+#include "ConnectionRacer.h"
+#include "TimerWheel.h"
 #include "XmppSocket.h"
 
+#include <chrono>
+
 #include <QDnsLookup>
 #include <QDomElement>
 
+class QTcpSocket;
 class QTimer;
 class QXmppPacket;
 
@@ -119,6 +125,9 @@ using IqResult = QXmppOutgoingClient::IqResult;
 struct IqState {
     QXmppPromise<IqResult> interface;
     QString jid;
+    // only set if needed for the timeout or the round-trip time metric
+    std::chrono::steady_clock::time_point sent;
+    TimerWheel<QString>::Handle deadline = {};
 };
 
 // Manager for creating tasks for outgoing IQ requests
@@ -128,13 +137,14 @@ public:
     OutgoingIqManager(QXmppLoggable *l, StreamAckManager &streamAckMananger);
     ~OutgoingIqManager();
 
-    QXmppTask<IqResult> sendIq(QXmppIq &&, const QString &to);
-    QXmppTask<IqResult> sendIq(QXmppPacket &&, const QString &id, const QString &to);
+    // no timeout or a timeout of zero means the request never times out
+    QXmppTask<IqResult> sendIq(QXmppIq &&, const QString &to, std::optional<std::chrono::milliseconds> timeout = {}, QXmpp::SendPriority priority = QXmpp::SendPriority::Interactive);
+    QXmppTask<IqResult> sendIq(QXmppPacket &&, const QString &id, const QString &to, std::optional<std::chrono::milliseconds> timeout = {}, QXmpp::SendPriority priority = QXmpp::SendPriority::Interactive);
 
     bool hasId(const QString &id) const;
     bool isIdValid(const QString &id) const;
 
-    QXmppTask<IqResult> start(const QString &id, const QString &to);
+    QXmppTask<IqResult> start(const QString &id, const QString &to, std::optional<std::chrono::milliseconds> timeout = {});
     void finish(const QString &id, IqResult &&result);
     void cancelAll();
 
@@ -144,10 +154,14 @@ public:
 
 private:
     void warning(const QString &message);
+    void expireDeadlines();
 
     QXmppLoggable *l;
     StreamAckManager &m_streamAckManager;
     std::unordered_map<QString, IqState> m_requests;
+    // one timer for the deadlines of all requests
+    TimerWheel<QString> m_deadlines;
+    QTimer *m_deadlineTimer;
 };
 
 }  // namespace QXmpp::Private
@@ -162,9 +176,10 @@ public:
     };
 
     explicit QXmppOutgoingClientPrivate(QXmppOutgoingClient *q);
-    void connectToHost(const ServerAddress &);
+    void connectToHost(const ServerAddress &, const QString &tlsSessionHost = {}, QTcpSocket *connectedSocket = nullptr);
     void connectToAddressList(std::vector<ServerAddress> &&);
     void connectToNextAddress();
+    void storeTlsSession();
 
     // This object provides the configuration
     // required for connecting to the XMPP server.
@@ -177,6 +192,7 @@ public:
     OutgoingIqManager iqManager;
 
     // DNS
+    ConnectionRacer connectionRacer;
     std::vector<ServerAddress> serverAddresses;
     std::size_t nextServerAddressIndex = 0;
     enum {
@@ -184,6 +200,10 @@ public:
         TryNext,
     } nextAddressState = Current;
 
+    // TLS session resumption
+    QString tlsSessionHost;
+    quint16 tlsSessionPort = 0;
+
     // Stream
     QString streamId;
     QString streamFrom;
@@ -197,7 +217,20 @@ public:
     bool bindModeAvailable = false;
     bool sessionStarted = false;
     AuthenticationMethod authenticationMethod = AuthenticationMethod::Sasl;
+    // SCRAM keys have been derived from the password during the authentication
+    bool scramKeysChanged = false;
     std::optional<Bind2Bound> bind2Bound;
+    std::chrono::steady_clock::time_point connectStart;
+
+    // Pipelining
+    struct CachedStreamFeatures {
+        QString domain;
+        QXmppStreamFeatures features;
+    };
+    // stream features announced after the last authentication
+    std::optional<CachedStreamFeatures> cachedStreamFeatures;
+    // the cached features are used, the features of the restarted stream have not been received yet
+    bool pipelinedFeaturesPending = false;
 
     std::variant<QXmppOutgoingClient *, StarttlsManager, NonSaslAuthManager, SaslManager, Sasl2Manager, C2sStreamManager *, BindManager> listener;
     FastTokenManager fastTokenManager;
@@ -550,6 +550,10 @@ bool QXmppRosterManager::unsubscribe(const QString &bareJid, const QString &reas
 
 void QXmppRosterManager::onRegistered(QXmppClient *client)
 {
+    setStanzaRoutes({
+        { u"iq"_s, ns_roster.toString() },
+    });
+
     // data import/export
     if (auto manager = client->findExtension<QXmppAccountMigrationManager>()) {
         using ImportResult = std::variant<Success, QXmppError>;
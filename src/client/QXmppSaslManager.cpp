@@ -144,7 +144,7 @@ static AuthenticationError::Type mapSaslCondition(std::optional<Sasl::ErrorCondi
     return Auth::NotAuthorized;
 }
 
-QXmppTask<SaslManager::AuthResult> SaslManager::authenticate(const QXmppConfiguration &config, const QList<QString> &availableMechanisms, QXmppLoggable *parent)
+QXmppTask<SaslManager::AuthResult> SaslManager::authenticate(QXmppConfiguration &config, const QList<QString> &availableMechanisms, QXmppLoggable *parent)
 {
     Q_ASSERT(!m_promise.has_value());
 
@@ -156,6 +156,7 @@ QXmppTask<SaslManager::AuthResult> SaslManager::authenticate(const QXmppConfigur
     m_socket->sendData(serializeXml(Sasl::Auth { result.saslClient->mechanism().toString(), result.initialResponse }));
 
     m_promise = QXmppPromise<AuthResult>();
+    m_config = &config;
     m_saslClient = std::move(result.saslClient);
     return m_promise->task();
 }
@@ -174,7 +175,15 @@ HandleElementResult SaslManager::handleElement(const QDomElement &el)
         return Rejected;
     }
 
-    if (Success::fromDom(el)) {
+    if (auto success = Success::fromDom(el)) {
+        if (!m_saslClient->handleSuccess(success->additionalData)) {
+            finish(AuthError {
+                u"Could not authenticate the server"_s,
+                AuthenticationError { AuthenticationError::ProcessingError, {}, {} },
+            });
+            return Finished;
+        }
+        m_saslClient->updateCredentials(m_config->credentialData());
         finish(QXmpp::Success());
         return Finished;
     } else if (auto challenge = Challenge::fromDom(el)) {
@@ -202,7 +211,7 @@ HandleElementResult SaslManager::handleElement(const QDomElement &el)
     return Rejected;
 }
 
-QXmppTask<Sasl2Manager::AuthResult> Sasl2Manager::authenticate(Sasl2::Authenticate &&auth, const QXmppConfiguration &config, const Sasl2::StreamFeature &feature, QXmppLoggable *loggable)
+QXmppTask<Sasl2Manager::AuthResult> Sasl2Manager::authenticate(Sasl2::Authenticate &&auth, QXmppConfiguration &config, const Sasl2::StreamFeature &feature, QXmppLoggable *loggable)
 {
     Q_ASSERT(!m_state.has_value());
 
@@ -244,6 +253,7 @@ QXmppTask<Sasl2Manager::AuthResult> Sasl2Manager::authenticate(Sasl2::Authentica
     m_socket->sendData(serializeXml(auth));
 
     m_state = State();
+    m_state->config = &config;
     m_state->sasl = std::move(result.saslClient);
     return m_state->p.task();
 }
@@ -275,6 +285,14 @@ HandleElementResult Sasl2Manager::handleElement(const QDomElement &el)
             return Finished;
         }
     } else if (auto success = Success::fromDom(el)) {
+        if (!m_state->sasl->handleSuccess(success->additionalData)) {
+            finish(AuthError {
+                u"Could not authenticate the server"_s,
+                AuthenticationError { AuthenticationError::ProcessingError, {}, {} },
+            });
+            return Finished;
+        }
+        m_state->sasl->updateCredentials(m_state->config->credentialData());
         finish(std::move(*success));
         return Finished;
     } else if (auto failure = Failure::fromDom(el)) {
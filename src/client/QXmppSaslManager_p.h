@@ -30,11 +30,14 @@ public:
 
     explicit SaslManager(SendDataInterface *socket) : m_socket(socket) { }
 
-    QXmppTask<AuthResult> authenticate(const QXmppConfiguration &config, const QList<QString> &availableMechanisms, QXmppLoggable *parent);
+    // Data for the next authentication (e.g. SCRAM keys) is stored in the configuration's
+    // credentials on success.
+    QXmppTask<AuthResult> authenticate(QXmppConfiguration &config, const QList<QString> &availableMechanisms, QXmppLoggable *parent);
     HandleElementResult handleElement(const QDomElement &el);
 
 private:
     SendDataInterface *m_socket;
+    QXmppConfiguration *m_config = nullptr;
     std::unique_ptr<QXmppSaslClient> m_saslClient;
     std::optional<QXmppPromise<AuthResult>> m_promise;
 };
@@ -48,11 +51,12 @@ public:
 
     explicit Sasl2Manager(SendDataInterface *socket) : m_socket(socket) { }
 
-    QXmppTask<AuthResult> authenticate(Sasl2::Authenticate &&authenticate, const QXmppConfiguration &config, const Sasl2::StreamFeature &feature, QXmppLoggable *loggable);
+    QXmppTask<AuthResult> authenticate(Sasl2::Authenticate &&authenticate, QXmppConfiguration &config, const Sasl2::StreamFeature &feature, QXmppLoggable *loggable);
     HandleElementResult handleElement(const QDomElement &);
 
 private:
     struct State {
+        QXmppConfiguration *config = nullptr;
         std::unique_ptr<QXmppSaslClient> sasl;
         QXmppPromise<AuthResult> p;
         std::optional<Sasl2::Continue> unsupportedContinue;
@@ -21,6 +21,8 @@ class QXmppSendStanzaParamsPrivate : public QSharedData
 public:
     TrustLevels acceptedTrustLevels;
     QVector<QString> encryptionJids;
+    std::optional<std::chrono::milliseconds> iqTimeout;
+    SendPriority priority = SendPriority::Interactive;
 };
 
 QXmppSendStanzaParams::QXmppSendStanzaParams()
@@ -86,3 +88,55 @@ void QXmppSendStanzaParams::setAcceptedTrustLevels(std::optional<TrustLevels> tr
 {
     d->acceptedTrustLevels = trustLevels.value_or(QXmpp::TrustLevels());
 }
+
+///
+/// Returns the time after which an IQ request fails with a QXmpp::TimeoutError if no response
+/// has been received.
+///
+/// If no timeout is set, QXmppConfiguration::iqTimeout() is used.
+///
+/// \since QXmpp 1.11
+///
+std::optional<std::chrono::milliseconds> QXmppSendStanzaParams::iqTimeout() const
+{
+    return d->iqTimeout;
+}
+
+///
+/// Sets the time after which an IQ request fails with a QXmpp::TimeoutError if no response
+/// has been received.
+///
+/// This is only used for IQ requests. A timeout of zero disables the timeout for the request.
+///
+/// \since QXmpp 1.11
+///
+void QXmppSendStanzaParams::setIqTimeout(std::optional<std::chrono::milliseconds> timeout)
+{
+    d->iqTimeout = timeout;
+}
+
+///
+/// Returns the priority of the stanza.
+///
+/// The default priority is QXmpp::SendPriority::Interactive.
+///
+/// \since QXmpp 1.11
+///
+SendPriority QXmppSendStanzaParams::priority() const
+{
+    return d->priority;
+}
+
+///
+/// Sets the priority of the stanza.
+///
+/// The priority is only relevant while the write buffer limit configured with
+/// QXmppConfiguration::setWriteBufferHighWaterMark() is exceeded: stanzas with a lower priority
+/// are held back until all stanzas with a higher priority have been written.
+///
+/// \since QXmpp 1.11
+///
+void QXmppSendStanzaParams::setPriority(SendPriority priority)
+{
+    d->priority = priority;
+}
@@ -8,6 +8,7 @@
 #include "QXmppGlobal.h"
 #include "QXmppTrustLevel.h"
 
+#include <chrono>
 #include <optional>
 
 #include <QSharedDataPointer>
@@ -30,6 +31,12 @@ public:
     std::optional<QXmpp::TrustLevels> acceptedTrustLevels() const;
     void setAcceptedTrustLevels(std::optional<QXmpp::TrustLevels> trustLevels);
 
+    std::optional<std::chrono::milliseconds> iqTimeout() const;
+    void setIqTimeout(std::optional<std::chrono::milliseconds> timeout);
+
+    QXmpp::SendPriority priority() const;
+    void setPriority(QXmpp::SendPriority priority);
+
 private:
     QSharedDataPointer<QXmppSendStanzaParamsPrivate> d;
 };
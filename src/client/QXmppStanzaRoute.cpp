@@ -0,0 +1,34 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+///
+/// \class QXmppStanzaRoute
+///
+/// Describes a kind of stanza a client extension handles, see
+/// QXmppClientExtension::setStanzaRoutes().
+///
+/// A stanza matches the route if its tag name equals tagName, one of its direct child elements
+/// has the namespace childNamespace and, for IQs, its type attribute equals iqType. Empty
+/// childNamespace or iqType values match any stanza.
+///
+/// \since QXmpp 1.11
+///
+
+///
+/// \var QXmppStanzaRoute::tagName
+///
+/// Tag name of the stanza, e.g. "iq", "message" or "presence".
+///
+
+///
+/// \var QXmppStanzaRoute::childNamespace
+///
+/// Namespace of a direct child element of the stanza, e.g. "jabber:iq:version".
+///
+
+///
+/// \var QXmppStanzaRoute::iqType
+///
+/// Type of the IQ, e.g. "get" or "result".
+///
@@ -0,0 +1,19 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef QXMPPSTANZAROUTE_H
+#define QXMPPSTANZAROUTE_H
+
+#include "QXmppGlobal.h"
+
+#include <QString>
+#include <QVector>
+
+struct QXmppStanzaRoute {
+    QString tagName;
+    QString childNamespace;
+    QString iqType;
+};
+
+#endif  // QXMPPSTANZAROUTE_H
@@ -0,0 +1,148 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "QXmppStreamResumptionState.h"
+
+#include "QXmppConstants_p.h"
+#include "QXmppStreamManagement_p.h"
+#include "QXmppUtils.h"
+#include "QXmppUtils_p.h"
+
+#include "StringLiterals.h"
+
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+using namespace QXmpp::Private;
+
+struct QXmppStreamResumptionStatePrivate : QSharedData, StreamResumptionData { };
+
+///
+/// \class QXmppStreamResumptionState
+///
+/// \brief Snapshot of a \xep{0198, Stream Management} session that can be resumed after the
+/// application has been restarted.
+///
+/// Resuming a stream only requires a single round trip, while a new session needs resource
+/// binding, fetching the roster and sending initial presence again. The state can be obtained
+/// with QXmppClient::streamResumptionState(), stored permanently in its XML form and passed to
+/// QXmppClient::setStreamResumptionState() before connecting again.
+///
+/// The state also contains the stanzas that have not been acknowledged by the server yet. They
+/// are resent after the stream has been resumed (or after stream management has been enabled
+/// again if resumption fails). The QXmppTask results of these stanzas are not restored.
+///
+/// The XML format is QXmpp specific and is not specified.
+///
+/// \since QXmpp 1.11
+///
+
+/// Default constructor, creates a null state.
+QXmppStreamResumptionState::QXmppStreamResumptionState()
+    : d(new QXmppStreamResumptionStatePrivate)
+{
+}
+
+QXMPP_PRIVATE_DEFINE_RULE_OF_SIX(QXmppStreamResumptionState)
+
+/// \cond
+QXmppStreamResumptionState::QXmppStreamResumptionState(const StreamResumptionData &data)
+    : d(new QXmppStreamResumptionStatePrivate)
+{
+    static_cast<StreamResumptionData &>(*d) = data;
+}
+
+const StreamResumptionData &QXmppStreamResumptionState::data() const
+{
+    return *d;
+}
+/// \endcond
+
+///
+/// Returns true if the state does not contain a resumable stream.
+///
+bool QXmppStreamResumptionState::isNull() const
+{
+    return d->id.isEmpty();
+}
+
+///
+/// Returns the full JID that was bound in the stream.
+///
+QString QXmppStreamResumptionState::jid() const
+{
+    return d->jid;
+}
+
+///
+/// Returns the number of stanzas that have not been acknowledged by the server.
+///
+int QXmppStreamResumptionState::unacknowledgedStanzaCount() const
+{
+    return int(d->unacknowledgedStanzas.size());
+}
+
+///
+/// Tries to parse an XML-serialized stream resumption state.
+///
+std::optional<QXmppStreamResumptionState> QXmppStreamResumptionState::fromXml(QXmlStreamReader &r)
+{
+    if (!r.isStartElement() || r.name() != u"stream-resumption" || r.namespaceUri() != ns_qxmpp_stream_resumption) {
+        return {};
+    }
+
+    const auto attrs = r.attributes();
+    QXmppStreamResumptionState state;
+    state.d->id = attrs.value("id"_L1).toString();
+    state.d->jid = attrs.value("jid"_L1).toString();
+    state.d->host = attrs.value("host"_L1).toString();
+    state.d->port = attrs.value("port"_L1).toUShort();
+    if (const auto expiry = attrs.value("expiry"_L1); !expiry.isEmpty()) {
+        state.d->expiry = QXmppUtils::datetimeFromString(toString60(expiry));
+    }
+    state.d->lastIncomingSequenceNumber = attrs.value("h"_L1).toUInt();
+    state.d->lastOutgoingSequenceNumber = attrs.value("sent"_L1).toUInt();
+
+    while (r.readNextStartElement()) {
+        if (r.name() == u"stanza") {
+            state.d->unacknowledgedStanzas.append(r.readElementText().toUtf8());
+        } else {
+            r.skipCurrentElement();
+        }
+    }
+
+    if (state.d->id.isEmpty()) {
+        return {};
+    }
+    return state;
+}
+
+///
+/// Serializes the stream resumption state to XML.
+///
+void QXmppStreamResumptionState::toXml(QXmlStreamWriter &writer) const
+{
+    writer.writeStartElement(QSL65("stream-resumption"));
+    writer.writeDefaultNamespace(toString65(ns_qxmpp_stream_resumption));
+    writer.writeAttribute(QSL65("id"), d->id);
+    writer.writeAttribute(QSL65("jid"), d->jid);
+    if (!d->host.isEmpty()) {
+        writer.writeAttribute(QSL65("host"), d->host);
+        writer.writeAttribute(QSL65("port"), QString::number(d->port));
+    }
+    if (d->expiry.isValid()) {
+        writer.writeAttribute(QSL65("expiry"), QXmppUtils::datetimeToString(d->expiry));
+    }
+    writer.writeAttribute(QSL65("h"), QString::number(d->lastIncomingSequenceNumber));
+    writer.writeAttribute(QSL65("sent"), QString::number(d->lastOutgoingSequenceNumber));
+    for (const auto &stanza : std::as_const(d->unacknowledgedStanzas)) {
+        writer.writeTextElement(QSL65("stanza"), QString::fromUtf8(stanza));
+    }
+    writer.writeEndElement();
+}
+
+bool QXmppStreamResumptionState::operator==(const QXmppStreamResumptionState &other) const
+{
+    return static_cast<const StreamResumptionData &>(*d) == static_cast<const StreamResumptionData &>(*other.d);
+}
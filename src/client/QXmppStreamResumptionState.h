@@ -0,0 +1,49 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef QXMPPSTREAMRESUMPTIONSTATE_H
+#define QXMPPSTREAMRESUMPTIONSTATE_H
+
+#include "QXmppGlobal.h"
+
+#include <optional>
+
+#include <QSharedDataPointer>
+
+struct QXmppStreamResumptionStatePrivate;
+class QXmlStreamReader;
+class QXmlStreamWriter;
+
+namespace QXmpp::Private {
+struct StreamResumptionData;
+}
+
+class QXMPP_EXPORT QXmppStreamResumptionState
+{
+public:
+    QXmppStreamResumptionState();
+    QXMPP_PRIVATE_DECLARE_RULE_OF_SIX(QXmppStreamResumptionState)
+
+    bool isNull() const;
+    QString jid() const;
+    int unacknowledgedStanzaCount() const;
+
+    static std::optional<QXmppStreamResumptionState> fromXml(QXmlStreamReader &);
+    void toXml(QXmlStreamWriter &) const;
+
+    /// Comparison operator
+    bool operator==(const QXmppStreamResumptionState &other) const;
+    /// Comparison operator
+    bool operator!=(const QXmppStreamResumptionState &other) const = default;
+
+    /// \cond
+    explicit QXmppStreamResumptionState(const QXmpp::Private::StreamResumptionData &);
+    const QXmpp::Private::StreamResumptionData &data() const;
+    /// \endcond
+
+private:
+    QSharedDataPointer<QXmppStreamResumptionStatePrivate> d;
+};
+
+#endif  // QXMPPSTREAMRESUMPTIONSTATE_H
@@ -0,0 +1,119 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "QXmppTlsSessionCache.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+using Clock = std::chrono::steady_clock;
+
+struct TlsSession {
+    QByteArray ticket;
+    Clock::time_point expiry;
+};
+
+class QXmppTlsSessionCachePrivate
+{
+public:
+    mutable QMutex mutex;
+    QHash<QString, TlsSession> sessions;
+};
+
+// The domain is the name the certificate has been verified against, a ticket must not be offered
+// to a server that serves it for a different domain.
+static QString sessionKey(const QString &domain, const QString &host, quint16 port)
+{
+    return domain.toLower() + u'/' + host.toLower() + u':' + QString::number(port);
+}
+
+///
+/// \class QXmppTlsSessionCache
+///
+/// \brief Stores TLS session tickets to resume TLS sessions when reconnecting.
+///
+/// Resuming a TLS session saves the certificate exchange and one round trip in most cases. The
+/// cache is only used by QXmppClient if it is set in QXmppConfiguration::setTlsSessionCache(). The
+/// tickets are stored after each successful handshake (and when the server sends a new ticket)
+/// and offered when connecting to the same server address for the same domain again.
+///
+/// The cache is thread-safe, it can be shared by multiple clients. Only share it between
+/// configurations with the same certificate settings: a resumed session is not verified again.
+/// It is not persistent.
+///
+/// \since QXmpp 1.11
+///
+
+/// Constructs an empty cache.
+QXmppTlsSessionCache::QXmppTlsSessionCache()
+    : d(std::make_unique<QXmppTlsSessionCachePrivate>())
+{
+}
+
+QXmppTlsSessionCache::~QXmppTlsSessionCache() = default;
+
+///
+/// Returns the session ticket for the domain and server address or an empty byte array if no
+/// valid ticket is available.
+///
+QByteArray QXmppTlsSessionCache::sessionTicket(const QString &domain, const QString &host, quint16 port) const
+{
+    QMutexLocker locker(&d->mutex);
+    if (auto itr = d->sessions.constFind(sessionKey(domain, host, port)); itr != d->sessions.constEnd() && itr->expiry > Clock::now()) {
+        return itr->ticket;
+    }
+    return {};
+}
+
+///
+/// Stores a session ticket for the domain and server address, replacing the previous one.
+///
+/// \param domain name the server certificate has been verified against (the XMPP domain)
+/// \param host host name of the server
+/// \param port port of the server
+/// \param sessionTicket the serialized session ticket, see QSslConfiguration::sessionTicket()
+/// \param lifetime time after which the ticket is not used anymore
+///
+void QXmppTlsSessionCache::insert(const QString &domain, const QString &host, quint16 port, const QByteArray &sessionTicket, std::chrono::seconds lifetime)
+{
+    QMutexLocker locker(&d->mutex);
+
+    // drop expired tickets
+    const auto now = Clock::now();
+    for (auto itr = d->sessions.begin(); itr != d->sessions.end();) {
+        if (itr->expiry <= now) {
+            itr = d->sessions.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+
+    if (sessionTicket.isEmpty() || lifetime.count() <= 0) {
+        d->sessions.remove(sessionKey(domain, host, port));
+    } else {
+        d->sessions.insert(sessionKey(domain, host, port), TlsSession { sessionTicket, now + lifetime });
+    }
+}
+
+/// Removes the session ticket of the domain and server address.
+void QXmppTlsSessionCache::remove(const QString &domain, const QString &host, quint16 port)
+{
+    QMutexLocker locker(&d->mutex);
+    d->sessions.remove(sessionKey(domain, host, port));
+}
+
+/// Removes all session tickets.
+void QXmppTlsSessionCache::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->sessions.clear();
+}
+
+/// Returns the number of stored session tickets, including expired ones.
+int QXmppTlsSessionCache::size() const
+{
+    QMutexLocker locker(&d->mutex);
+    return int(d->sessions.size());
+}
@@ -0,0 +1,36 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef QXMPPTLSSESSIONCACHE_H
+#define QXMPPTLSSESSIONCACHE_H
+
+#include "QXmppGlobal.h"
+
+#include <chrono>
+#include <memory>
+
+#include <QByteArray>
+#include <QString>
+
+class QXmppTlsSessionCachePrivate;
+
+class QXMPP_EXPORT QXmppTlsSessionCache
+{
+public:
+    QXmppTlsSessionCache();
+    ~QXmppTlsSessionCache();
+
+    QByteArray sessionTicket(const QString &domain, const QString &host, quint16 port) const;
+    void insert(const QString &domain, const QString &host, quint16 port, const QByteArray &sessionTicket, std::chrono::seconds lifetime);
+    void remove(const QString &domain, const QString &host, quint16 port);
+    void clear();
+    int size() const;
+
+private:
+    Q_DISABLE_COPY(QXmppTlsSessionCache)
+
+    const std::unique_ptr<QXmppTlsSessionCachePrivate> d;
+};
+
+#endif  // QXMPPTLSSESSIONCACHE_H
@@ -1078,7 +1078,11 @@ void QXmppTransferManager::ibbResponseReceived(const QXmppIq &iq)
             dataIq.setSequence(job->d->ibbSequence++);
             dataIq.setPayload(buffer);
             job->d->requestId = dataIq.id();
-            client()->sendPacket(dataIq);
+
+            // file data should not delay interactive stanzas
+            QXmppSendStanzaParams params;
+            params.setPriority(QXmpp::SendPriority::Bulk);
+            client()->send(std::move(dataIq), params);
 
             job->d->done += buffer.size();
             Q_EMIT job->progress(job->d->done, job->fileSize());
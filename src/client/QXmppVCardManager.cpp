@@ -172,6 +172,10 @@ bool QXmppVCardManager::handleStanza(const QDomElement &element)
 
 void QXmppVCardManager::onRegistered(QXmppClient *client)
 {
+    setStanzaRoutes({
+        { u"iq"_s, ns_vcard.toString() },
+    });
+
     if (auto manager = client->findExtension<QXmppAccountMigrationManager>()) {
         using DataResult = std::variant<VCardData, QXmppError>;
 
@@ -115,6 +115,13 @@ QStringList QXmppVersionManager::discoveryFeatures() const
     };
 }
 
+void QXmppVersionManager::onRegistered(QXmppClient *)
+{
+    setStanzaRoutes({
+        { u"iq"_s, ns_version.toString() },
+    });
+}
+
 bool QXmppVersionManager::handleStanza(const QDomElement &element)
 {
     if (QXmpp::handleIqRequests<QXmppVersionIq>(element, client(), this)) {
@@ -48,6 +48,11 @@ Q_SIGNALS:
     /// \brief This signal is emitted when a version response is received.
     void versionReceived(const QXmppVersionIq &);
 
+protected:
+    /// \cond
+    void onRegistered(QXmppClient *client) override;
+    /// \endcond
+
 private:
     const std::unique_ptr<QXmppVersionManagerPrivate> d;
 };
@@ -148,7 +148,7 @@ QString QXmppIncomingClient::jid() const
 /// Sends an XMPP packet to the peer.
 bool QXmppIncomingClient::sendPacket(const QXmppNonza &packet)
 {
-    return d->socket.sendData(serializeXml(packet));
+    return d->socket.sendXml(packet);
 }
 
 /// Sends raw data to the peer.
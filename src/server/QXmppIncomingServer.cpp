@@ -105,7 +105,7 @@ QString QXmppIncomingServer::localStreamId() const
 /// Sends an XMPP packet to the peer.
 bool QXmppIncomingServer::sendPacket(const QXmppNonza &nonza)
 {
-    return d->socket.sendData(serializeXml(nonza));
+    return d->socket.sendXml(nonza);
 }
 
 /// Sends raw data to the peer.
@@ -10,13 +10,13 @@
 #include "QXmppUtils.h"
 #include "QXmppUtils_p.h"
 
+#include "DnsCache.h"
 #include "Stream.h"
 #include "StringLiterals.h"
 #include "XmppSocket.h"
 
 #include <chrono>
 
-#include <QDnsLookup>
 #include <QDomElement>
 #include <QList>
 #include <QSslError>
@@ -34,7 +34,6 @@ public:
 
     XmppSocket socket;
     QList<QByteArray> dataQueue;
-    QDnsLookup dns;
     QString localDomain;
     QString localStreamKey;
     QString remoteDomain;
@@ -70,9 +69,6 @@ QXmppOutgoingServer::QXmppOutgoingServer(const QString &domain, QObject *parent)
     connect(socket, &QAbstractSocket::disconnected, this, &QXmppOutgoingServer::onSocketDisconnected);
     connect(socket, &QSslSocket::errorOccurred, this, &QXmppOutgoingServer::socketError);
 
-    // DNS lookups
-    connect(&d->dns, &QDnsLookup::finished, this, &QXmppOutgoingServer::onDnsLookupFinished);
-
     d->dialbackTimer = new QTimer(this);
     d->dialbackTimer->setInterval(5s);
     d->dialbackTimer->setSingleShot(true);
@@ -97,35 +93,31 @@ void QXmppOutgoingServer::connectToHost(const QString &domain)
 
     // lookup server for domain
     debug(u"Looking up server for domain %1"_s.arg(domain));
-    d->dns.setName(u"_xmpp-server._tcp."_s + domain);
-    d->dns.setType(QDnsLookup::SRV);
-    d->dns.lookup();
-}
-
-void QXmppOutgoingServer::onDnsLookupFinished()
-{
-    QString host;
-    quint16 port = 0;
-
-    const auto dnsRecords = d->dns.serviceRecords();
-    if (d->dns.error() == QDnsLookup::NoError && !dnsRecords.isEmpty()) {
-        // take the first returned record
-        host = dnsRecords.first().target();
-        port = dnsRecords.first().port();
-    } else {
-        // as a fallback, use domain as the host name
-        warning(u"Lookup for domain %1 failed: %2"_s
-                    .arg(d->dns.name(), d->dns.errorString()));
-        host = d->remoteDomain;
-        port = XMPP_SERVER_DEFAULT_PORT;
-    }
+    const auto name = u"_xmpp-server._tcp."_s + domain;
+    DnsCache::instance().lookupSrv(name).then(this, [this, name](DnsCache::SrvResult &&result) {
+        QString host;
+        quint16 port = 0;
+
+        if (auto *records = std::get_if<QList<QDnsServiceRecord>>(&result); records && !records->isEmpty()) {
+            // take the first returned record
+            host = records->first().target();
+            port = records->first().port();
+        } else {
+            // as a fallback, use domain as the host name
+            auto *error = std::get_if<QXmppError>(&result);
+            warning(u"Lookup for domain %1 failed: %2"_s
+                        .arg(name, error ? error->description : u"No records found"_s));
+            host = d->remoteDomain;
+            port = XMPP_SERVER_DEFAULT_PORT;
+        }
 
-    // set the name the SSL certificate should match
-    d->socket.socket()->setPeerVerifyName(d->remoteDomain);
+        // set the name the SSL certificate should match
+        d->socket.socket()->setPeerVerifyName(d->remoteDomain);
 
-    // connect to server
-    info(u"Connecting to %1:%2"_s.arg(host, QString::number(port)));
-    d->socket.socket()->connectToHost(host, port);
+        // connect to server
+        info(u"Connecting to %1:%2"_s.arg(host, QString::number(port)));
+        d->socket.socket()->connectToHost(host, port);
+    });
 }
 
 void QXmppOutgoingServer::onSocketDisconnected()
@@ -239,7 +231,7 @@ bool QXmppOutgoingServer::sendData(const QByteArray &data)
 /// Sends an XMPP packet to the peer.
 bool QXmppOutgoingServer::sendPacket(const QXmppNonza &nonza)
 {
-    return d->socket.sendData(serializeXml(nonza));
+    return d->socket.sendXml(nonza);
 }
 
 /// Returns the stream's local dialback key.
@@ -55,7 +55,6 @@ private:
     void handleStream(const QDomElement &streamElement);
     void handleStanza(const QDomElement &stanzaElement);
 
-    void onDnsLookupFinished();
     void onSocketDisconnected();
     void sendDialback();
     void slotSslErrors(const QList<QSslError> &errors);
@@ -344,24 +344,8 @@ QXmppLogger *QXmppServer::logger()
 void QXmppServer::setLogger(QXmppLogger *logger)
 {
     if (logger != d->logger) {
-        if (d->logger) {
-            disconnect(this, &QXmppLoggable::logMessage,
-                       d->logger, &QXmppLogger::log);
-            disconnect(this, &QXmppLoggable::setGauge,
-                       d->logger, &QXmppLogger::setGauge);
-            disconnect(this, &QXmppLoggable::updateCounter,
-                       d->logger, &QXmppLogger::updateCounter);
-        }
-
         d->logger = logger;
-        if (d->logger) {
-            connect(this, &QXmppLoggable::logMessage,
-                    d->logger, &QXmppLogger::log);
-            connect(this, &QXmppLoggable::setGauge,
-                    d->logger, &QXmppLogger::setGauge);
-            connect(this, &QXmppLoggable::updateCounter,
-                    d->logger, &QXmppLogger::updateCounter);
-        }
+        connectLogger(logger);
 
         Q_EMIT loggerChanged(d->logger);
     }
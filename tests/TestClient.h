@@ -24,6 +24,7 @@ public:
         // clear extensions
         qDeleteAll(d->extensions);
         d->extensions.clear();
+        d->router.setExtensions(d->extensions);
         // enable stream management (so IQ requests are not stopped)
         d->stream->enableStreamManagement(true);
         // setup logging (for expect())
@@ -10,19 +10,25 @@
 #include "QXmppFutureUtils_p.h"
 #include "QXmppLogger.h"
 #include "QXmppMessage.h"
+#include "QXmppMetrics.h"
 #include "QXmppOutgoingClient.h"
 #include "QXmppOutgoingClient_p.h"
 #include "QXmppPromise.h"
 #include "QXmppRegisterIq.h"
 #include "QXmppRosterManager.h"
 #include "QXmppStreamFeatures.h"
+#include "QXmppStreamManagement_p.h"
+#include "QXmppStreamResumptionState.h"
 #include "QXmppVCardManager.h"
 #include "QXmppVersionManager.h"
 
 #include "TestClient.h"
 #include "util.h"
 
+#include <atomic>
+
 #include <QObject>
+#include <QThread>
 
 using namespace QXmpp::Private;
 
@@ -32,8 +38,13 @@ class tst_QXmppClient : public QObject
 
 private:
     Q_SLOT void testSendMessage();
+    Q_SLOT void testLoggingEnabled();
     Q_SLOT void testIndexOfExtension();
+    Q_SLOT void testStanzaRouting();
     Q_SLOT void testE2eeExtension();
+    Q_SLOT void testIqTimeout();
+    Q_SLOT void postFromThreads();
+    Q_SLOT void postBeforeDeletion();
     Q_SLOT void testTaskDirect();
     Q_SLOT void testTaskStore();
     Q_SLOT void colorGeneration();
@@ -44,9 +55,12 @@ private:
     // outgoing client
 #if BUILD_INTERNAL_TESTS
     Q_SLOT void csiManager();
+    Q_SLOT void pipelinedStreamManagementEnabled();
+    Q_SLOT void pipelinedStreamManagementFailed();
 #endif
 
     Q_SLOT void credentialsSerialization();
+    Q_SLOT void streamResumptionState();
 };
 
 void tst_QXmppClient::testSendMessage()
@@ -77,6 +91,79 @@ void tst_QXmppClient::testSendMessage()
     client->setLogger(nullptr);
 }
 
+class TestLoggable : public QXmppLoggable
+{
+public:
+    using QXmppLoggable::QXmppLoggable;
+    using QXmppLoggable::connectLogger;
+    using QXmppLoggable::debug;
+    using QXmppLoggable::isLoggingEnabled;
+};
+
+void tst_QXmppClient::testLoggingEnabled()
+{
+    QXmppClient client;
+    auto *loggable = new TestLoggable(&client);
+    QSignalSpy onLogMessage(&client, &QXmppLoggable::logMessage);
+
+    // the spy is a receiver
+    QVERIFY(loggable->isLoggingEnabled(QXmppLogger::DebugMessage));
+    loggable->debug(u"a"_s);
+    QCOMPARE(onLogMessage.size(), 1);
+
+    // only the default logger with logging disabled
+    {
+        QXmppClient other;
+        auto *otherLoggable = new TestLoggable(&other);
+        QVERIFY(!otherLoggable->isLoggingEnabled(QXmppLogger::SentMessage));
+
+        QXmppLogger logger;
+        logger.setLoggingType(QXmppLogger::SignalLogging);
+        logger.setMessageTypes(QXmppLogger::SentMessage | QXmppLogger::ReceivedMessage);
+        other.setLogger(&logger);
+        QVERIFY(otherLoggable->isLoggingEnabled(QXmppLogger::SentMessage));
+        QVERIFY(!otherLoggable->isLoggingEnabled(QXmppLogger::DebugMessage));
+
+        logger.setLoggingType(QXmppLogger::NoLogging);
+        QVERIFY(!otherLoggable->isLoggingEnabled(QXmppLogger::SentMessage));
+
+        other.setLogger(nullptr);
+        QVERIFY(!otherLoggable->isLoggingEnabled(QXmppLogger::SentMessage));
+
+        // messages are relayed to the new parent
+        otherLoggable->setParent(&client);
+        QVERIFY(otherLoggable->isLoggingEnabled(QXmppLogger::SentMessage));
+        otherLoggable->setParent(nullptr);
+        QVERIFY(!otherLoggable->isLoggingEnabled(QXmppLogger::SentMessage));
+        delete otherLoggable;
+    }
+
+    // changes are passed on to all children
+    {
+        TestLoggable parent;
+        auto *child = new TestLoggable(&parent);
+        auto *grandChild = new TestLoggable(child);
+        QVERIFY(!grandChild->isLoggingEnabled(QXmppLogger::WarningMessage));
+
+        auto logger = std::make_unique<QXmppLogger>();
+        logger->setLoggingType(QXmppLogger::SignalLogging);
+        logger->setMessageTypes(QXmppLogger::WarningMessage);
+        parent.connectLogger(logger.get());
+        QVERIFY(grandChild->isLoggingEnabled(QXmppLogger::WarningMessage));
+        QVERIFY(!grandChild->isLoggingEnabled(QXmppLogger::DebugMessage));
+
+        logger->setMessageTypes(QXmppLogger::DebugMessage);
+        QVERIFY(grandChild->isLoggingEnabled(QXmppLogger::DebugMessage));
+
+        logger.reset();
+        QVERIFY(!grandChild->isLoggingEnabled(QXmppLogger::DebugMessage));
+
+        QSignalSpy spy(child, &QXmppLoggable::logMessage);
+        QVERIFY(grandChild->isLoggingEnabled(QXmppLogger::DebugMessage));
+        QVERIFY(!parent.isLoggingEnabled(QXmppLogger::DebugMessage));
+    }
+}
+
 void tst_QXmppClient::testIndexOfExtension()
 {
     auto client = std::make_unique<QXmppClient>();
@@ -99,6 +186,71 @@ void tst_QXmppClient::testIndexOfExtension()
     QCOMPARE(client->indexOfExtension<QXmppVCardManager>(), 1);
 }
 
+class CountingExtension : public QXmppClientExtension
+{
+public:
+    bool handleStanza(const QDomElement &element) override
+    {
+        stanzas << element.attribute(u"id"_s);
+        return element.attribute(u"id"_s) == handledId;
+    }
+
+    QStringList stanzas;
+    QString handledId;
+};
+
+class RoutedExtension : public CountingExtension
+{
+protected:
+    void onRegistered(QXmppClient *) override
+    {
+        setStanzaRoutes({
+            { u"iq"_s, u"urn:example:a"_s, u"get"_s },
+            { u"message"_s, u"urn:example:b"_s, {} },
+        });
+    }
+};
+
+void tst_QXmppClient::testStanzaRouting()
+{
+    TestClient client;
+    auto *routed = new RoutedExtension;
+    auto *legacy = new CountingExtension;
+    client.addExtension(routed);
+    client.addExtension(legacy);
+    legacy->handledId = u"legacy"_s;
+
+    auto process = [&](const QString &xml) {
+        bool handled = false;
+        Q_EMIT client.stream()->elementReceived(xmlToDom(xml), handled);
+        return handled;
+    };
+
+    // wrong IQ type and unknown namespace: only the legacy extension is called
+    QVERIFY(!process(u"<iq id='1' type='set'><query xmlns='urn:example:a'/></iq>"_s));
+    QVERIFY(!process(u"<iq id='2' type='get'><query xmlns='urn:example:c'/></iq>"_s));
+    QVERIFY(routed->stanzas.isEmpty());
+    QCOMPARE(legacy->stanzas, (QStringList { u"1"_s, u"2"_s }));
+
+    // matching routes, child namespace does not need to be the first child
+    QVERIFY(!process(u"<iq id='3' type='get'><query xmlns='urn:example:a'/></iq>"_s));
+    QVERIFY(!process(u"<message id='4'><body>Hi</body><x xmlns='urn:example:b'/></message>"_s));
+    QCOMPARE(routed->stanzas, (QStringList { u"3"_s, u"4"_s }));
+
+    // order of the extensions is kept: a routed extension handling the stanza stops processing
+    routed->handledId = u"5"_s;
+    QVERIFY(process(u"<iq id='5' type='get'><query xmlns='urn:example:a'/></iq>"_s));
+    QCOMPARE(legacy->stanzas.size(), 4);
+    QVERIFY(process(u"<presence id='legacy'/>"_s));
+
+    QCOMPARE(client.handledStanzaCount(routed), quint64(1));
+    QCOMPARE(client.handledStanzaCount(legacy), quint64(1));
+
+    client.removeExtension(routed);
+    QVERIFY(process(u"<presence id='legacy'/>"_s));
+    QCOMPARE(client.handledStanzaCount(legacy), quint64(2));
+}
+
 class EncryptionExtension : public QXmppE2eeExtension
 {
 public:
@@ -172,6 +324,121 @@ void tst_QXmppClient::testE2eeExtension()
     encrypter.iqCalled = false;
 }
 
+void tst_QXmppClient::testIqTimeout()
+{
+    using namespace std::chrono_literals;
+
+    TestClient client;
+
+    auto createRequest = [](const QString &id) {
+        QXmppDiscoveryIq request;
+        request.setId(id);
+        request.setType(QXmppIq::Get);
+        request.setQueryType(QXmppDiscoveryIq::InfoQuery);
+        request.setTo(u"component.qxmpp.org"_s);
+        return request;
+    };
+
+    // per request
+    QXmppSendStanzaParams params;
+    params.setIqTimeout(50ms);
+    auto task = client.sendIq(createRequest(u"r1"_s), params);
+    QVERIFY(!task.isFinished());
+    QTRY_VERIFY(task.isFinished());
+    auto error = expectFutureVariant<QXmppError>(task);
+    QVERIFY(error.holdsType<QXmpp::TimeoutError>());
+
+    // the late response is not handled anymore
+    bool handled = client.stream()->iqManager().handleStanza(xmlToDom(
+        "<iq id='r1' from='component.qxmpp.org' type='result'/>"));
+    QVERIFY(!handled);
+
+    // default from the configuration, a response in time stops the deadline
+    client.configuration().setIqTimeout(50ms);
+    task = client.sendIq(createRequest(u"r2"_s));
+    client.inject(u"<iq id='r2' from='component.qxmpp.org' type='result'/>"_s);
+    QVERIFY(task.isFinished());
+    expectFutureVariant<QDomElement>(task);
+
+    // a timeout of zero disables the default
+    params.setIqTimeout(0ms);
+    task = client.sendIq(createRequest(u"r3"_s), params);
+    QTest::qWait(200);
+    QVERIFY(!task.isFinished());
+}
+
+void tst_QXmppClient::postFromThreads()
+{
+    constexpr int threadCount = 4;
+    constexpr int packetCount = 100;
+
+    QXmppLogger logger;
+    logger.setMetricsEnabled(true);
+    QXmppClient client;
+    client.setLogger(&logger);
+
+    // the client is not connected, so sending fails, but all tasks are finished in their threads
+    std::atomic<int> finished = 0;
+    std::atomic<int> wrongThread = 0;
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back(QThread::create([&] {
+            QEventLoop loop;
+            int count = 0;
+            for (int j = 0; j < packetCount; j++) {
+                auto task = j % 2
+                    ? client.post(QXmppMessage(u"me@qxmpp.org"_s, u"somebody@qxmpp.org"_s, u"Hello"_s))
+                    : client.postData(QByteArrayLiteral("<presence/>"));
+                task.then(&loop, [&, thread = QThread::currentThread()](QXmpp::SendResult &&result) {
+                    if (QThread::currentThread() != thread || !std::holds_alternative<QXmppError>(result)) {
+                        wrongThread++;
+                    }
+                    finished++;
+                    if (++count == packetCount) {
+                        loop.quit();
+                    }
+                });
+            }
+            loop.exec();
+        }));
+        threads.back()->start();
+    }
+
+    // the tasks of packets posted from the client thread are finished directly
+    auto task = client.post(QXmppPresence(QXmppPresence::Available));
+    QVERIFY(!task.isFinished());
+    QTRY_VERIFY(task.isFinished());
+    expectFutureVariant<QXmppError>(task);
+
+    for (const auto &thread : threads) {
+        QTRY_VERIFY(thread->isFinished());
+    }
+    QCOMPARE(finished.load(), threadCount * packetCount);
+    QCOMPARE(wrongThread.load(), 0);
+    QCOMPARE(logger.metrics()->counter(u"send-queue.posted-packets"_s), threadCount * packetCount + 1);
+}
+
+void tst_QXmppClient::postBeforeDeletion()
+{
+    auto client = std::make_unique<TestClient>();
+
+    // sent, but not acknowledged yet
+    auto sentTask = client->postData(QByteArrayLiteral("<presence/>"));
+    QCoreApplication::processEvents();
+    client->expect(u"<presence/>"_s);
+    QVERIFY(!sentTask.isFinished());
+
+    // not sent yet
+    auto postedTask = client->postData(QByteArrayLiteral("<presence/>"));
+    QVERIFY(!postedTask.isFinished());
+
+    client.reset();
+    QVERIFY(sentTask.isFinished());
+    QVERIFY(postedTask.isFinished());
+    QVERIFY(expectFutureVariant<QXmppError>(sentTask).value<QXmpp::SendError>() == QXmpp::SendError::Disconnected);
+    QVERIFY(expectFutureVariant<QXmppError>(postedTask).value<QXmpp::SendError>() == QXmpp::SendError::Disconnected);
+}
+
 void tst_QXmppClient::testTaskDirect()
 {
     QXmppPromise<QXmppIq> p;
@@ -292,6 +559,91 @@ void tst_QXmppClient::csiManager()
     csi.onSessionOpened(session);
     client.expectNoPacket();
 }
+
+// TestClient does not record <r/>, count them separately
+static void countAckRequests(TestClient &client, int &count)
+{
+    QObject::connect(client.logger(), &QXmppLogger::message, &client, [&count](QXmppLogger::MessageType type, const QString &text) {
+        if (type == QXmppLogger::SentMessage && text == u"<r xmlns=\"urn:xmpp:sm:3\"/>") {
+            count++;
+        }
+    });
+}
+
+void tst_QXmppClient::pipelinedStreamManagementEnabled()
+{
+    TestClient client;
+    auto &sm = client.stream()->c2sStreamManager();
+    auto &acks = client.stream()->streamAckManager();
+    acks.setAckRequestPolicy(1, {}, false);
+    int ackRequests = 0;
+    countAckRequests(client, ackRequests);
+
+    sm.onStreamStart();
+    sm.requestEnablePipelined();
+    client.expect("<enable xmlns='urn:xmpp:sm:3' resume='true'/>");
+
+    auto task = acks.send(QXmppMessage({}, u"juliet@capulet.lit"_s, u"a"_s));
+    client.ignore();
+    acks.send(QXmppMessage({}, u"juliet@capulet.lit"_s, u"b"_s));
+    client.ignore();
+    QCoreApplication::processEvents();
+
+    // stanzas are counted, but <r/> is not sent before <enabled/>
+    QCOMPARE(acks.unacknowledgedStanzaCount(), std::size_t(2));
+    QCOMPARE(acks.lastOutgoingSequenceNumber(), 2u);
+    QCOMPARE(ackRequests, 0);
+
+    QVERIFY(sm.handlePipelinedEnableResponse(xmlToDom("<enabled xmlns='urn:xmpp:sm:3' id='sm-1' resume='true'/>")));
+    QVERIFY(sm.enabled());
+    QVERIFY(sm.canResume());
+    QCOMPARE(ackRequests, 1);
+
+    QVERIFY(acks.handleStanza(xmlToDom("<a xmlns='urn:xmpp:sm:3' h='2'/>")));
+    QCOMPARE(acks.unacknowledgedStanzaCount(), std::size_t(0));
+    QVERIFY(task.isFinished());
+    QVERIFY(std::get<QXmpp::SendSuccess>(task.result()).acknowledged);
+    client.expectNoPacket();
+}
+
+void tst_QXmppClient::pipelinedStreamManagementFailed()
+{
+    TestClient client;
+    auto &sm = client.stream()->c2sStreamManager();
+    auto &acks = client.stream()->streamAckManager();
+    acks.setAckRequestPolicy(1, {}, false);
+    int ackRequests = 0;
+    countAckRequests(client, ackRequests);
+
+    sm.onStreamStart();
+    sm.requestEnablePipelined();
+    client.expect("<enable xmlns='urn:xmpp:sm:3' resume='true'/>");
+
+    auto task = acks.send(QXmppMessage({}, u"juliet@capulet.lit"_s, u"a"_s));
+    client.ignore();
+    QCOMPARE(acks.unacknowledgedStanzaCount(), std::size_t(1));
+    QVERIFY(!task.isFinished());
+
+    QVERIFY(sm.handlePipelinedEnableResponse(xmlToDom(
+        "<failed xmlns='urn:xmpp:sm:3'><unexpected-request xmlns='urn:ietf:params:xml:ns:xmpp-stanzas'/></failed>")));
+    QVERIFY(!sm.enabled());
+    QVERIFY(!acks.enabled());
+
+    // the stanza has been sent, but it is never going to be acknowledged
+    QCOMPARE(acks.unacknowledgedStanzaCount(), std::size_t(0));
+    QCOMPARE(acks.lastOutgoingSequenceNumber(), 0u);
+    QVERIFY(task.isFinished());
+    QVERIFY(!std::get<QXmpp::SendSuccess>(task.result()).acknowledged);
+
+    // later stanzas are not counted anymore
+    acks.send(QXmppMessage({}, u"juliet@capulet.lit"_s, u"b"_s));
+    client.ignore();
+    QCoreApplication::processEvents();
+    QCOMPARE(acks.unacknowledgedStanzaCount(), std::size_t(0));
+    QCOMPARE(acks.lastOutgoingSequenceNumber(), 0u);
+    QCOMPARE(ackRequests, 0);
+    client.expectNoPacket();
+}
 #endif
 
 void tst_QXmppClient::credentialsSerialization()
@@ -299,6 +651,7 @@ void tst_QXmppClient::credentialsSerialization()
     QByteArray xml =
         "<credentials xmlns=\"org.qxmpp.credentials\">"
         "<ht-token mechanism=\"HT-SHA3-384-UNIQ\" secret=\"t0k3n1234\" expiry=\"2024-09-21T18:00:00Z\"/>"
+        "<scram-keys mechanism=\"SCRAM-SHA-256\" salt=\"QSXCR+Q6sek8bf92\" iterations=\"4096\" client-key=\"Y2xpZW50\" server-key=\"c2VydmVy\"/>"
         "</credentials>";
     QXmlStreamReader r(xml);
     r.readNextStartElement();
@@ -310,5 +663,50 @@ void tst_QXmppClient::credentialsSerialization()
     QCOMPARE(output, xml);
 }
 
+void tst_QXmppClient::streamResumptionState()
+{
+    QByteArray xml =
+        "<stream-resumption xmlns=\"org.qxmpp.stream-resumption\" id=\"sm-1\" jid=\"juliet@capulet.example/balcony\" host=\"sm.capulet.example\" port=\"5222\" h=\"12\" sent=\"7\">"
+        "<stanza>&lt;message&gt;&lt;body&gt;1&lt;/body&gt;&lt;/message&gt;</stanza>"
+        "<stanza>&lt;message&gt;&lt;body&gt;2&lt;/body&gt;&lt;/message&gt;</stanza>"
+        "</stream-resumption>";
+    QXmlStreamReader r(xml);
+    r.readNextStartElement();
+    auto state = unwrap(QXmppStreamResumptionState::fromXml(r));
+    QVERIFY(!state.isNull());
+    QCOMPARE(state.jid(), u"juliet@capulet.example/balcony"_s);
+    QCOMPARE(state.unacknowledgedStanzaCount(), 2);
+    QCOMPARE(state.data().unacknowledgedStanzas.constLast(), QByteArray("<message><body>2</body></message>"));
+
+    // round trip
+    QString output;
+    QXmlStreamWriter w(&output);
+    state.toXml(w);
+    QXmlStreamReader r2(output);
+    r2.readNextStartElement();
+    QCOMPARE(unwrap(QXmppStreamResumptionState::fromXml(r2)), state);
+
+    // restore in a client
+    QXmppClient client;
+    QVERIFY(client.streamResumptionState().isNull());
+    client.setStreamResumptionState(state);
+
+    auto *stream = client.findChild<QXmppOutgoingClient *>();
+    QVERIFY(stream);
+    QVERIFY(stream->c2sStreamManager().canResume());
+    QVERIFY(stream->c2sStreamManager().hasResumeAddress());
+    QCOMPARE(stream->streamAckManager().lastIncomingSequenceNumber(), 12u);
+    QCOMPARE(stream->streamAckManager().unacknowledgedStanzaCount(), std::size_t(2));
+    QCOMPARE(client.streamResumptionState(), state);
+
+    // expired sessions are not resumed, but the stanzas are kept
+    QXmppClient client2;
+    auto data = state.data();
+    data.expiry = QDateTime::currentDateTimeUtc().addSecs(-60);
+    client2.setStreamResumptionState(QXmppStreamResumptionState(data));
+    QVERIFY(client2.streamResumptionState().isNull());
+    QCOMPARE(client2.findChild<QXmppOutgoingClient *>()->streamAckManager().unacknowledgedStanzaCount(), std::size_t(2));
+}
+
 QTEST_GUILESS_MAIN(tst_QXmppClient)
 #include "tst_qxmppclient.moc"
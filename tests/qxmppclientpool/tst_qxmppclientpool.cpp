@@ -0,0 +1,174 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "QXmppClient.h"
+#include "QXmppClientPool.h"
+#include "QXmppMetrics.h"
+#include "QXmppServer.h"
+
+#include "util.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include <QThread>
+
+using namespace QXmpp;
+
+class tst_QXmppClientPool : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void initTestCase();
+    Q_SLOT void cleanupTestCase();
+    Q_SLOT void threads();
+    Q_SLOT void connectAndSend();
+    Q_SLOT void removeClient();
+    Q_SLOT void unknownClient();
+
+    QXmppConfiguration configuration(const QString &user) const;
+
+    TestPasswordChecker m_passwordChecker;
+    QXmppServer *m_server = nullptr;
+};
+
+static const auto testDomain = u"localhost"_s;
+static const quint16 testPort = 12347;
+
+void tst_QXmppClientPool::initTestCase()
+{
+    m_passwordChecker.addCredentials(u"alice"_s, u"alicepwd"_s);
+    m_passwordChecker.addCredentials(u"bob"_s, u"bobpwd"_s);
+
+    m_server = new QXmppServer(this);
+    m_server->setDomain(testDomain);
+    m_server->setPasswordChecker(&m_passwordChecker);
+    QVERIFY(m_server->listenForClients(QHostAddress::LocalHost, testPort));
+}
+
+void tst_QXmppClientPool::cleanupTestCase()
+{
+    delete m_server;
+}
+
+QXmppConfiguration tst_QXmppClientPool::configuration(const QString &user) const
+{
+    QXmppConfiguration config;
+    config.setDomain(testDomain);
+    config.setHost(QHostAddress(QHostAddress::LocalHost).toString());
+    config.setPort(testPort);
+    config.setUser(user);
+    config.setPassword(user + u"pwd");
+    config.setSaslAuthMechanism(u"PLAIN"_s);
+    return config;
+}
+
+void tst_QXmppClientPool::threads()
+{
+    QXmppClientPool pool(2);
+    QCOMPARE(pool.threadCount(), 2);
+    QCOMPARE(QXmppClientPool(0).threadCount(), 1);
+
+    // nothing is listening on the port
+    QXmppConfiguration config;
+    config.setHost(QHostAddress(QHostAddress::LocalHost).toString());
+    config.setPort(1);
+    config.setAutoReconnectionEnabled(false);
+
+    const auto a = pool.addClient(config);
+    const auto b = pool.addClient(config);
+    const auto c = pool.addClient(config);
+    QCOMPARE(pool.clientCount(), 3);
+
+    // clients are spread over the worker threads and stay there
+    QMutex mutex;
+    QHash<quint64, QList<QThread *>> threads;
+    std::atomic<int> calls = 0;
+    for (auto id : { a, b, c, a }) {
+        pool.invoke(id, [id, &mutex, &threads, &calls](QXmppClient *client) {
+            QMutexLocker locker(&mutex);
+            threads[id].append(client->thread());
+            threads[id].append(QThread::currentThread());
+            calls++;
+        });
+    }
+    QTRY_COMPARE(calls.load(), 4);
+
+    QMutexLocker locker(&mutex);
+    QCOMPARE(threads.value(a).size(), 4);
+    QVERIFY(std::all_of(threads.value(a).cbegin(), threads.value(a).cend(), [&](auto *thread) {
+        return thread == threads.value(a).first();
+    }));
+    QCOMPARE(threads.value(b).at(0), threads.value(b).at(1));
+    QCOMPARE(threads.value(c).at(0), threads.value(c).at(1));
+    QVERIFY(threads.value(a).first() != QThread::currentThread());
+    QVERIFY(threads.value(a).first() != threads.value(b).first());
+    QCOMPARE(threads.value(a).first(), threads.value(c).first());
+}
+
+void tst_QXmppClientPool::connectAndSend()
+{
+    QXmppClientPool pool(2);
+
+    // the signals are emitted in the worker threads, the slots are called in this thread
+    int connected = 0;
+    QList<std::pair<quint64, QXmppMessage>> messages;
+    connect(&pool, &QXmppClientPool::clientConnected, this, [&] { connected++; });
+    connect(&pool, &QXmppClientPool::messageReceived, this, [&](quint64 id, const QXmppMessage &message) {
+        messages.append({ id, message });
+    });
+
+    const auto alice = pool.addClient(configuration(u"alice"_s));
+    const auto bob = pool.addClient(configuration(u"bob"_s));
+
+    QTRY_COMPARE(connected, 2);
+    QCOMPARE(pool.connectedClientCount(), 2);
+    QVERIFY(pool.metrics()->counter(u"socket.written-bytes"_s) > 0);
+
+    auto future = pool.send(alice, QXmppMessage(u"alice@localhost/QXmpp"_s, u"bob@localhost/QXmpp"_s, u"Hello"_s));
+    QTRY_VERIFY(future.isFinished());
+    QVERIFY(std::holds_alternative<SendSuccess>(future.result()));
+
+    QTRY_COMPARE(messages.size(), 1);
+    QCOMPARE(messages.first().first, bob);
+    QCOMPARE(messages.first().second.body(), u"Hello"_s);
+}
+
+void tst_QXmppClientPool::removeClient()
+{
+    QXmppClientPool pool(1);
+
+    int connected = 0;
+    connect(&pool, &QXmppClientPool::clientConnected, this, [&] { connected++; });
+
+    const auto alice = pool.addClient(configuration(u"alice"_s));
+    QTRY_COMPARE(connected, 1);
+    QCOMPARE(pool.connectedClientCount(), 1);
+
+    pool.removeClient(alice);
+    QTRY_COMPARE(pool.clientCount(), 0);
+    QCOMPARE(pool.connectedClientCount(), 0);
+
+    // removing a client that has not been created yet
+    pool.removeClient(pool.addClient(configuration(u"bob"_s)));
+    QTRY_COMPARE(pool.clientCount(), 0);
+    QCOMPARE(pool.connectedClientCount(), 0);
+}
+
+void tst_QXmppClientPool::unknownClient()
+{
+    QXmppClientPool pool(1);
+
+    bool called = false;
+    pool.invoke(42, [&](QXmppClient *) { called = true; });
+
+    auto future = pool.send(42, QXmppPresence());
+    QTRY_VERIFY(future.isFinished());
+    QVERIFY(std::holds_alternative<QXmppError>(future.result()));
+    QVERIFY(!called);
+}
+
+QTEST_MAIN(tst_QXmppClientPool)
+#include "tst_qxmppclientpool.moc"
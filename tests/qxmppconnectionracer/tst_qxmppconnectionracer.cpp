@@ -0,0 +1,161 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "ConnectionRacer.h"
+#include "util.h"
+
+#include <QSslSocket>
+#include <QTcpServer>
+
+using namespace QXmpp::Private;
+using namespace std::chrono_literals;
+
+static quint16 closedPort()
+{
+    QTcpServer server;
+    server.listen(QHostAddress::LocalHost);
+    return server.serverPort();
+}
+
+class tst_QXmppConnectionRacer : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void interleave();
+    Q_SLOT void firstFails();
+    Q_SLOT void firstUnreachable();
+    Q_SLOT void allFail();
+    Q_SLOT void abort();
+    Q_SLOT void takeOver();
+};
+
+void tst_QXmppConnectionRacer::interleave()
+{
+    const QHostAddress v6a(u"2001:db8::1"_s), v6b(u"2001:db8::2"_s), v6c(u"2001:db8::3"_s);
+    const QHostAddress v4a(u"192.0.2.1"_s), v4b(u"192.0.2.2"_s);
+
+    QCOMPARE(interleaveAddressFamilies({ v6a, v6b, v4a, v6c, v4b }), (QList<QHostAddress> { v6a, v4a, v6b, v4b, v6c }));
+    QCOMPARE(interleaveAddressFamilies({ v4a, v4b, v6a }), (QList<QHostAddress> { v4a, v6a, v4b }));
+    QCOMPARE(interleaveAddressFamilies({ v6a, v6b }), (QList<QHostAddress> { v6a, v6b }));
+    QVERIFY(interleaveAddressFamilies({}).isEmpty());
+}
+
+void tst_QXmppConnectionRacer::firstFails()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    QXmppLoggable logger;
+    ConnectionRacer racer(&logger, 10s);
+    QSignalSpy latencySpy(&logger, &QXmppLoggable::updateHistogram);
+
+    // the refused connection starts the next attempt without waiting for the delay
+    auto task = racer.race({
+        ServerAddress { ServerAddress::Tls, u"127.0.0.1"_s, closedPort() },
+        ServerAddress { ServerAddress::Tcp, u"127.0.0.1"_s, server.serverPort() },
+    });
+    QVERIFY(racer.isRunning());
+    QTRY_VERIFY_WITH_TIMEOUT(task.isFinished(), 5000);
+
+    auto winner = expectFutureVariant<ConnectionRacer::Winner>(task);
+    QCOMPARE(winner.index, std::size_t(1));
+    QCOMPARE(winner.address, QHostAddress(QHostAddress::LocalHost));
+    QVERIFY(!racer.isRunning());
+
+    QCOMPARE(latencySpy.size(), 1);
+    QCOMPARE(latencySpy.at(0).at(0).toString(), u"connect.latency"_s);
+}
+
+void tst_QXmppConnectionRacer::firstUnreachable()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    QXmppLoggable logger;
+    ConnectionRacer racer(&logger, 50ms);
+
+    // connecting to the documentation address either hangs or fails, the next address is tried
+    // after the delay at the latest
+    auto task = racer.race({
+        ServerAddress { ServerAddress::Tcp, u"192.0.2.1"_s, 5222 },
+        ServerAddress { ServerAddress::Tcp, u"127.0.0.1"_s, server.serverPort() },
+    });
+    QTRY_VERIFY_WITH_TIMEOUT(task.isFinished(), 5000);
+    QCOMPARE(expectFutureVariant<ConnectionRacer::Winner>(task).index, std::size_t(1));
+}
+
+void tst_QXmppConnectionRacer::allFail()
+{
+    QXmppLoggable logger;
+    ConnectionRacer racer(&logger, 10s);
+
+    auto task = racer.race({
+        ServerAddress { ServerAddress::Tcp, u"127.0.0.1"_s, closedPort() },
+        ServerAddress { ServerAddress::Tcp, u"127.0.0.1"_s, closedPort() },
+    });
+    QTRY_VERIFY_WITH_TIMEOUT(task.isFinished(), 5000);
+    QCOMPARE(expectFutureVariant<QAbstractSocket::SocketError>(task), QAbstractSocket::ConnectionRefusedError);
+
+    auto emptyTask = racer.race({});
+    QVERIFY(emptyTask.isFinished());
+    QCOMPARE(expectFutureVariant<QAbstractSocket::SocketError>(emptyTask), QAbstractSocket::HostNotFoundError);
+}
+
+void tst_QXmppConnectionRacer::abort()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    QXmppLoggable logger;
+    ConnectionRacer racer(&logger);
+
+    auto task = racer.race({
+        ServerAddress { ServerAddress::Tcp, u"127.0.0.1"_s, server.serverPort() },
+    });
+    racer.abort();
+    QVERIFY(!racer.isRunning());
+
+    QTest::qWait(50);
+    QVERIFY(!task.isFinished());
+}
+
+void tst_QXmppConnectionRacer::takeOver()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    QXmppLoggable logger;
+    ConnectionRacer racer(&logger, 10s);
+
+    const ServerAddress address { ServerAddress::Tcp, u"127.0.0.1"_s, server.serverPort() };
+    auto task = racer.race({ address });
+    QTRY_VERIFY_WITH_TIMEOUT(task.isFinished(), 5000);
+    auto winner = std::get<ConnectionRacer::Winner>(task.takeResult());
+    QVERIFY(winner.socket);
+    QCOMPARE(winner.socket->state(), QAbstractSocket::ConnectedState);
+
+    XmppSocket socket(nullptr);
+    socket.setSocket(new QSslSocket(&socket));
+    QSignalSpy startedSpy(&socket, &XmppSocket::started);
+    QVERIFY(socket.connectToSocket(address, winner.socket.get()));
+    QCOMPARE(startedSpy.size(), 1);
+
+    // the connection stays open after the socket of the racer is gone
+    winner.socket.reset();
+    QVERIFY(socket.isConnected());
+
+    QTRY_VERIFY(server.hasPendingConnections());
+    auto *peer = server.nextPendingConnection();
+    QVERIFY(socket.sendData(QByteArrayLiteral("<presence/>")));
+    QTRY_COMPARE(peer->bytesAvailable(), qint64(11));
+    QCOMPARE(peer->readAll(), QByteArrayLiteral("<presence/>"));
+
+    // no second connection has been made
+    QTest::qWait(50);
+    QVERIFY(!server.hasPendingConnections());
+}
+
+QTEST_MAIN(tst_QXmppConnectionRacer)
+#include "tst_qxmppconnectionracer.moc"
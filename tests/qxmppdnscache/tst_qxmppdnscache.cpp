@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "DnsCache.h"
+#include "util.h"
+
+using namespace QXmpp::Private;
+using namespace std::chrono_literals;
+
+class tst_QXmppDnsCache : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void init();
+    Q_SLOT void expiry();
+    Q_SLOT void maximumTtl();
+    Q_SLOT void negativeEntry();
+    Q_SLOT void cachedLookup();
+};
+
+void tst_QXmppDnsCache::init()
+{
+    DnsCache::instance().clear();
+}
+
+void tst_QXmppDnsCache::expiry()
+{
+    DnsCache cache;
+    const auto now = DnsCache::Clock::now();
+
+    cache.insertSrv(u"_xmpp-client._tcp.example.org"_s, QList<QDnsServiceRecord> { QDnsServiceRecord() }, 300s, now);
+    QVERIFY(cache.cachedSrv(u"_xmpp-client._tcp.example.org"_s, now + 299s));
+    QCOMPARE(std::get<QList<QDnsServiceRecord>>(*cache.cachedSrv(u"_xmpp-client._tcp.example.org"_s, now)).size(), 1);
+    QVERIFY(!cache.cachedSrv(u"_xmpp-client._tcp.example.org"_s, now + 300s));
+    QVERIFY(!cache.cachedSrv(u"_xmpps-client._tcp.example.org"_s, now));
+
+    // a TTL of 0 is not cached and removes the previous entry
+    cache.insertSrv(u"_xmpp-client._tcp.example.org"_s, QList<QDnsServiceRecord>(), 0s, now);
+    QVERIFY(!cache.cachedSrv(u"_xmpp-client._tcp.example.org"_s, now));
+}
+
+void tst_QXmppDnsCache::maximumTtl()
+{
+    DnsCache cache;
+    cache.setMaximumTtl(60s);
+    const auto now = DnsCache::Clock::now();
+
+    cache.insertSrv(u"_xmpp-server._tcp.example.org"_s, QList<QDnsServiceRecord>(), 24h, now);
+    QVERIFY(cache.cachedSrv(u"_xmpp-server._tcp.example.org"_s, now + 59s));
+    QVERIFY(!cache.cachedSrv(u"_xmpp-server._tcp.example.org"_s, now + 60s));
+}
+
+void tst_QXmppDnsCache::negativeEntry()
+{
+    DnsCache cache;
+    const auto now = DnsCache::Clock::now();
+
+    cache.insertSrv(u"_xmpp-client._tcp.invalid"_s, QXmppError { u"Not found"_s, QDnsLookup::NotFoundError }, cache.negativeTtl(), now);
+    auto cached = cache.cachedSrv(u"_xmpp-client._tcp.invalid"_s, now + 1s);
+    QVERIFY(cached);
+    auto error = expectVariant<QXmppError>(std::move(*cached));
+    QVERIFY(error.value<QDnsLookup::Error>() == QDnsLookup::NotFoundError);
+    QVERIFY(!cache.cachedSrv(u"_xmpp-client._tcp.invalid"_s, now + cache.negativeTtl()));
+}
+
+void tst_QXmppDnsCache::cachedLookup()
+{
+    auto &cache = DnsCache::instance();
+    cache.insertSrv(u"_xmpp-client._tcp.example.org"_s, QList<QDnsServiceRecord> { QDnsServiceRecord(), QDnsServiceRecord() }, 300s);
+
+    // no query is sent, the result is available immediately
+    auto task = cache.lookupSrv(u"_xmpp-client._tcp.example.org"_s);
+    QVERIFY(task.isFinished());
+    QCOMPARE(expectFutureVariant<QList<QDnsServiceRecord>>(task).size(), 2);
+}
+
+QTEST_MAIN(tst_QXmppDnsCache)
+#include "tst_qxmppdnscache.moc"
@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "QXmppLogger.h"
+
+#include "util.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+class tst_QXmppLogger : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void fileLogging_data();
+    Q_SLOT void fileLogging();
+    Q_SLOT void rotation_data();
+    Q_SLOT void rotation();
+};
+
+static QList<QByteArray> readLines(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    auto lines = file.readAll().split('\n');
+    if (!lines.isEmpty() && lines.constLast().isEmpty()) {
+        lines.removeLast();
+    }
+    return lines;
+}
+
+void tst_QXmppLogger::fileLogging_data()
+{
+    QTest::addColumn<bool>("asynchronous");
+
+    QTest::newRow("synchronous") << false;
+    QTest::newRow("asynchronous") << true;
+}
+
+void tst_QXmppLogger::fileLogging()
+{
+    QFETCH(bool, asynchronous);
+
+    QTemporaryDir dir;
+    const auto path = dir.filePath(u"qxmpp.log"_s);
+
+    QXmppLogger logger;
+    logger.setLogFilePath(path);
+    logger.setLoggingType(QXmppLogger::FileLogging);
+    logger.setAsynchronousFileLogging(asynchronous);
+    logger.setMessageTypes(QXmppLogger::SentMessage | QXmppLogger::WarningMessage);
+
+    for (int i = 0; i < 1000; i++) {
+        logger.log(QXmppLogger::SentMessage, u"<message id='%1'/>"_s.arg(i));
+    }
+    logger.log(QXmppLogger::DebugMessage, u"filtered"_s);
+    logger.flush();
+
+    const auto lines = readLines(path);
+    QCOMPARE(lines.size(), 1000);
+    QVERIFY(lines.first().endsWith(" SENT <message id='0'/>"));
+    QVERIFY(lines.last().endsWith(" SENT <message id='999'/>"));
+    QCOMPARE(logger.droppedMessageCount(), quint64(0));
+}
+
+void tst_QXmppLogger::rotation_data()
+{
+    QTest::addColumn<bool>("asynchronous");
+
+    QTest::newRow("synchronous") << false;
+    QTest::newRow("asynchronous") << true;
+}
+
+void tst_QXmppLogger::rotation()
+{
+    QFETCH(bool, asynchronous);
+
+    QTemporaryDir dir;
+    const auto path = dir.filePath(u"qxmpp.log"_s);
+
+    QXmppLogger logger;
+    logger.setLogFilePath(path);
+    logger.setLoggingType(QXmppLogger::FileLogging);
+    logger.setAsynchronousFileLogging(asynchronous);
+    logger.setMaximumLogFileSize(1024);
+    logger.setMaximumLogFileCount(2);
+
+    // every message is written on its own, so each one can trigger a rotation
+    for (int i = 0; i < 100; i++) {
+        logger.log(QXmppLogger::InformationMessage, QString(100, u'a'));
+        logger.flush();
+    }
+
+    QVERIFY(QFile::exists(path));
+    QVERIFY(QFile::exists(path + u".1"));
+    QVERIFY(QFile::exists(path + u".2"));
+    QVERIFY(!QFile::exists(path + u".3"));
+
+    QVERIFY(QFile(path + u".1").size() <= 1024 + 200);
+    QVERIFY(!readLines(path + u".1").isEmpty());
+}
+
+QTEST_MAIN(tst_QXmppLogger)
+#include "tst_qxmpplogger.moc"
@@ -65,6 +65,7 @@ private:
     Q_SLOT void testEncryptedFileSource();
     Q_SLOT void testReplies();
     Q_SLOT void testJingleMessageInitiationElement();
+    Q_SLOT void testLazyParsing();
 };
 
 void tst_QXmppMessage::testBasic_data()
@@ -1457,5 +1458,45 @@ void tst_QXmppMessage::testJingleMessageInitiationElement()
     QVERIFY(message2.jingleMessageInitiationElement());
 }
 
+void tst_QXmppMessage::testLazyParsing()
+{
+    const QByteArray xml(
+        "<message id=\"m1\" to=\"foo@example.com/QXmpp\" from=\"bar@example.com/QXmpp\" type=\"chat\">"
+        "<body>Hello</body>"
+        "<request xmlns=\"urn:xmpp:receipts\"/>"
+        "<reactions xmlns=\"urn:xmpp:reactions:0\" id=\"m0\"><reaction>\xf0\x9f\x91\x8b</reaction></reactions>"
+        "<x xmlns=\"urn:xmpp:unknown:protocol\"/>"
+        "</message>");
+
+    QXmppMessage message;
+    message.parseLazily(xmlToDom(xml));
+    QCOMPARE(message.id(), u"m1"_s);
+    QCOMPARE(message.type(), QXmppMessage::Chat);
+    QCOMPARE(message.body(), u"Hello"_s);
+
+    // copies parse independently
+    auto copy = message;
+    QVERIFY(message.isReceiptRequested());
+    QCOMPARE(message.reaction()->messageId(), u"m0"_s);
+    QCOMPARE(message.extensions().size(), 1);
+    QCOMPARE(copy.extensions().size(), 1);
+    QVERIFY(copy.isReceiptRequested());
+
+    // setters are not overwritten by deferred parsing
+    QXmppMessage modified;
+    modified.parseLazily(xmlToDom(xml));
+    modified.setReceiptRequested(false);
+    modified.setBody(u"Bye"_s);
+    QVERIFY(!modified.isReceiptRequested());
+    QCOMPARE(modified.body(), u"Bye"_s);
+    QVERIFY(modified.reaction().has_value());
+
+    // serialization includes the deferred extensions
+    QXmppMessage eager, lazy;
+    eager.parse(xmlToDom(xml));
+    lazy.parseLazily(xmlToDom(xml));
+    QCOMPARE(packetToXml(lazy), packetToXml(eager));
+}
+
 QTEST_MAIN(tst_QXmppMessage)
 #include "tst_qxmppmessage.moc"
@@ -0,0 +1,179 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "QXmppLogger.h"
+#include "QXmppMetrics.h"
+
+#include "util.h"
+
+#include <thread>
+#include <vector>
+
+class tst_QXmppMetrics : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void counters();
+    Q_SLOT void countersFromThreads();
+    Q_SLOT void gauges();
+    Q_SLOT void histograms();
+    Q_SLOT void typeMismatch();
+    Q_SLOT void prometheusText();
+    Q_SLOT void logger();
+};
+
+void tst_QXmppMetrics::counters()
+{
+    QXmppMetrics metrics;
+    QCOMPARE(metrics.counter(u"socket.writes"_s), qint64(0));
+
+    metrics.updateCounter(u"socket.writes"_s);
+    metrics.updateCounter(u"socket.writes"_s);
+    metrics.updateCounter(u"socket.written-bytes"_s, 1500);
+    QCOMPARE(metrics.counter(u"socket.writes"_s), qint64(2));
+    QCOMPARE(metrics.counter(u"socket.written-bytes"_s), qint64(1500));
+}
+
+void tst_QXmppMetrics::countersFromThreads()
+{
+    constexpr int threadCount = 8;
+    constexpr int iterations = 10000;
+
+    QXmppMetrics metrics;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back([&metrics] {
+            for (int j = 0; j < iterations; j++) {
+                metrics.updateCounter(u"shared"_s);
+                metrics.updateHistogram(u"durations"_s, 0.001);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    QCOMPARE(metrics.counter(u"shared"_s), qint64(threadCount * iterations));
+    QCOMPARE(metrics.histogramCount(u"durations"_s), quint64(threadCount * iterations));
+    QCOMPARE(metrics.histogramSum(u"durations"_s), 0.001 * threadCount * iterations);
+}
+
+void tst_QXmppMetrics::gauges()
+{
+    QXmppMetrics metrics;
+    QCOMPARE(metrics.gauge(u"queue"_s), 0.0);
+
+    metrics.setGauge(u"queue"_s, 12);
+    QCOMPARE(metrics.gauge(u"queue"_s), 12.0);
+
+    // set from another thread
+    std::thread([&metrics] { metrics.setGauge(u"queue"_s, 0.5); }).join();
+    QCOMPARE(metrics.gauge(u"queue"_s), 0.5);
+}
+
+void tst_QXmppMetrics::histograms()
+{
+    QXmppMetrics metrics;
+    metrics.updateHistogram(u"iq.round-trip-time"_s, 0.2);
+    metrics.updateHistogram(u"iq.round-trip-time"_s, 0.05);
+    metrics.updateHistogram(u"iq.round-trip-time"_s, 30);
+
+    QCOMPARE(metrics.histogramCount(u"iq.round-trip-time"_s), quint64(3));
+    QCOMPARE(metrics.histogramSum(u"iq.round-trip-time"_s), 30.25);
+    QCOMPARE(metrics.histogramCount(u"unknown"_s), quint64(0));
+}
+
+void tst_QXmppMetrics::typeMismatch()
+{
+    QXmppMetrics metrics;
+    metrics.updateCounter(u"metric"_s, 5);
+
+    // names are bound to the type used first
+    metrics.setGauge(u"metric"_s, 1);
+    metrics.updateHistogram(u"metric"_s, 1);
+    QCOMPARE(metrics.counter(u"metric"_s), qint64(5));
+    QCOMPARE(metrics.gauge(u"metric"_s), 0.0);
+    QCOMPARE(metrics.histogramCount(u"metric"_s), quint64(0));
+}
+
+void tst_QXmppMetrics::prometheusText()
+{
+    QXmppMetrics metrics;
+    metrics.updateCounter(u"socket.written-bytes"_s, 42);
+    metrics.setGauge(u"stream-management.unacknowledged-stanzas"_s, 3);
+    metrics.updateHistogram(u"iq.round-trip-time"_s, 0.2);
+    metrics.updateHistogram(u"iq.round-trip-time"_s, 3);
+
+    const auto expected = QStringLiteral(
+        "# TYPE qxmpp_iq_round_trip_time histogram\n"
+        "qxmpp_iq_round_trip_time_bucket{le=\"0.0005\"} 0\n"
+        "qxmpp_iq_round_trip_time_bucket{le=\"0.001\"} 0\n"
+        "qxmpp_iq_round_trip_time_bucket{le=\"0.0025\"} 0\n"
+        "qxmpp_iq_round_trip_time_bucket{le=\"0.005\"} 0\n"
+        "qxmpp_iq_round_trip_time_bucket{le=\"0.01\"} 0\n"
+        "qxmpp_iq_round_trip_time_bucket{le=\"0.025\"} 0\n"
+        "qxmpp_iq_round_trip_time_bucket{le=\"0.05\"} 0\n"
+        "qxmpp_iq_round_trip_time_bucket{le=\"0.1\"} 0\n"
+        "qxmpp_iq_round_trip_time_bucket{le=\"0.25\"} 1\n"
+        "qxmpp_iq_round_trip_time_bucket{le=\"0.5\"} 1\n"
+        "qxmpp_iq_round_trip_time_bucket{le=\"1\"} 1\n"
+        "qxmpp_iq_round_trip_time_bucket{le=\"2.5\"} 1\n"
+        "qxmpp_iq_round_trip_time_bucket{le=\"5\"} 2\n"
+        "qxmpp_iq_round_trip_time_bucket{le=\"10\"} 2\n"
+        "qxmpp_iq_round_trip_time_bucket{le=\"+Inf\"} 2\n"
+        "qxmpp_iq_round_trip_time_sum 3.2\n"
+        "qxmpp_iq_round_trip_time_count 2\n"
+        "# TYPE qxmpp_socket_written_bytes_total counter\n"
+        "qxmpp_socket_written_bytes_total 42\n"
+        "# TYPE qxmpp_stream_management_unacknowledged_stanzas gauge\n"
+        "qxmpp_stream_management_unacknowledged_stanzas 3\n");
+    QCOMPARE(metrics.toPrometheusText(), expected);
+}
+
+class TestLoggable : public QXmppLoggable
+{
+public:
+    using QXmppLoggable::QXmppLoggable;
+    using QXmppLoggable::connectLogger;
+};
+
+void tst_QXmppMetrics::logger()
+{
+    QXmppLogger logger;
+    QVERIFY(logger.metrics());
+    QVERIFY(!logger.metricsEnabled());
+
+    TestLoggable parent;
+    auto *loggable = new TestLoggable(&parent);
+    parent.connectLogger(&logger);
+    QVERIFY(!loggable->isMetricsEnabled());
+
+    // nothing is recorded by default
+    Q_EMIT loggable->updateCounter(u"client.reconnects"_s);
+    QCOMPARE(logger.metrics()->counter(u"client.reconnects"_s), qint64(0));
+
+    logger.setMetricsEnabled(true);
+    QVERIFY(loggable->isMetricsEnabled());
+
+    Q_EMIT loggable->updateCounter(u"client.reconnects"_s);
+    Q_EMIT loggable->setGauge(u"stream-management.unacknowledged-stanzas"_s, 7);
+    Q_EMIT loggable->updateHistogram(u"iq.round-trip-time"_s, 0.01);
+
+    QCOMPARE(logger.metrics()->counter(u"client.reconnects"_s), qint64(1));
+    QCOMPARE(logger.metrics()->gauge(u"stream-management.unacknowledged-stanzas"_s), 7.0);
+    QCOMPARE(logger.metrics()->histogramCount(u"iq.round-trip-time"_s), quint64(1));
+
+    // other receivers also enable metrics
+    logger.setMetricsEnabled(false);
+    QVERIFY(!loggable->isMetricsEnabled());
+    {
+        QSignalSpy spy(&parent, &QXmppLoggable::updateCounter);
+        QVERIFY(loggable->isMetricsEnabled());
+    }
+    QVERIFY(!loggable->isMetricsEnabled());
+}
+
+QTEST_MAIN(tst_QXmppMetrics)
+#include "tst_qxmppmetrics.moc"
@@ -0,0 +1,95 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "MpscQueue.h"
+#include "util.h"
+
+#include <memory>
+#include <vector>
+
+#include <QThread>
+
+using namespace QXmpp::Private;
+
+class tst_QXmppMpscQueue : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void fifo();
+    Q_SLOT void moveOnly();
+    Q_SLOT void concurrentProducers();
+};
+
+void tst_QXmppMpscQueue::fifo()
+{
+    MpscQueue<int> queue;
+    QVERIFY(!queue.pop());
+
+    queue.push(1);
+    queue.push(2);
+    QCOMPARE(queue.pop(), 1);
+    queue.push(3);
+    QCOMPARE(queue.pop(), 2);
+    QCOMPARE(queue.pop(), 3);
+    QVERIFY(!queue.pop());
+
+    // reuse after running empty
+    queue.push(4);
+    QCOMPARE(queue.pop(), 4);
+    QVERIFY(!queue.pop());
+}
+
+void tst_QXmppMpscQueue::moveOnly()
+{
+    MpscQueue<std::unique_ptr<int>> queue;
+    queue.push(std::make_unique<int>(1));
+    queue.push(std::make_unique<int>(2));
+
+    auto value = queue.pop();
+    QVERIFY(value);
+    QCOMPARE(**value, 1);
+
+    // the remaining element is freed by the queue
+}
+
+void tst_QXmppMpscQueue::concurrentProducers()
+{
+    constexpr int threadCount = 4;
+    constexpr int valueCount = 10000;
+
+    // value = thread * valueCount + index
+    MpscQueue<int> queue;
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back(QThread::create([&queue, i] {
+            for (int j = 0; j < valueCount; j++) {
+                queue.push(i * valueCount + j);
+            }
+        }));
+        threads.back()->start();
+    }
+
+    // the values of each producer are received in order
+    std::vector<int> next(threadCount, 0);
+    int received = 0;
+    while (received < threadCount * valueCount) {
+        if (auto value = queue.pop()) {
+            const auto thread = *value / valueCount;
+            QCOMPARE(*value % valueCount, next[thread]);
+            next[thread]++;
+            received++;
+        } else {
+            QThread::yieldCurrentThread();
+        }
+    }
+
+    for (const auto &thread : threads) {
+        thread->wait();
+    }
+    QVERIFY(!queue.pop());
+}
+
+QTEST_MAIN(tst_QXmppMpscQueue)
+#include "tst_qxmppmpscqueue.moc"
@@ -27,6 +27,7 @@ private:
     Q_SLOT void testPresenceWithLastUserInteraction();
     Q_SLOT void testPresenceWithMix();
     Q_SLOT void testPresenceWithVCard();
+    Q_SLOT void testLazyParsing();
 };
 
 void tst_QXmppPresence::testPresence_data()
@@ -342,5 +343,30 @@ void tst_QXmppPresence::testPresenceWithVCard()
 {
 }
 
+void tst_QXmppPresence::testLazyParsing()
+{
+    const QByteArray xml(
+        "<presence to=\"foo@example.com/QXmpp\" from=\"bar@example.com/QXmpp\">"
+        "<show>away</show>"
+        "<status>In a meeting</status>"
+        "<priority>5</priority>"
+        "<c xmlns=\"http://jabber.org/protocol/caps\" hash=\"sha-1\" node=\"https://github.com/qxmpp-project/qxmpp\" ver=\"QgayPKawpkPSDYmwT/WM94uAlu0=\"/>"
+        "<x xmlns=\"urn:xmpp:unknown:protocol\"/>"
+        "</presence>");
+
+    QXmppPresence presence;
+    presence.parseLazily(xmlToDom(xml));
+    QCOMPARE(presence.availableStatusType(), QXmppPresence::Away);
+    QCOMPARE(presence.statusText(), u"In a meeting"_s);
+    QCOMPARE(presence.priority(), 5);
+    QCOMPARE(presence.capabilityHash(), u"sha-1"_s);
+    QCOMPARE(presence.extensions().size(), 1);
+
+    QXmppPresence eager, lazy;
+    eager.parse(xmlToDom(xml));
+    lazy.parseLazily(xmlToDom(xml));
+    QCOMPARE(packetToXml(lazy), packetToXml(eager));
+}
+
 QTEST_MAIN(tst_QXmppPresence)
 #include "tst_qxmpppresence.moc"
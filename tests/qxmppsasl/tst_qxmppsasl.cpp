@@ -79,6 +79,7 @@ private:
     Q_SLOT void testClientPlain();
     Q_SLOT void testClientScramSha1();
     Q_SLOT void testClientScramSha1_bad();
+    Q_SLOT void testClientScramStoredKeys();
     Q_SLOT void testClientScramSha256();
     Q_SLOT void testClientWindowsLive();
     Q_SLOT void clientHtSha256();
@@ -92,6 +93,7 @@ private:
 
     // SASL 1 client manager
     Q_SLOT void saslManagerNoMechanisms();
+    Q_SLOT void saslManagerScramKeys();
 
     // SASL 2 client manager
     Q_SLOT void sasl2ManagerPlain();
@@ -237,6 +239,13 @@ void tst_QXmppSasl::testSuccess()
     QVERIFY(Sasl::Success::fromDom(xmlToDom(xml)));
     Sasl::Success success;
     serializePacket(success, xml);
+
+    // with additional data
+    const QByteArray xmlData = "<success xmlns=\"urn:ietf:params:xml:ns:xmpp-sasl\">dj1ybUY5cHFWOFM3c3VBb1pXamE0ZEpSa0ZzS1E9</success>";
+    auto parsed = Sasl::Success::fromDom(xmlToDom(xmlData));
+    QVERIFY(parsed);
+    QCOMPARE(parsed->additionalData, QByteArray("v=rmF9pqV8S7suAoZWja4dJRkFsKQ="));
+    serializePacket(*parsed, xmlData);
 }
 
 void tst_QXmppSasl::sasl2StreamFeature()
@@ -613,6 +622,57 @@ void tst_QXmppSasl::testClientScramSha1_bad()
     QVERIFY(!client->respond(QByteArray("r=fyko+d2lbbFgONRv9qkxdawL3rfcNHYJY1ZVvWVs7j,s=QSXCR+Q6sek8bf92")));
 }
 
+void tst_QXmppSasl::testClientScramStoredKeys()
+{
+    const QByteArray serverFirst = "r=fyko+d2lbbFgONRv9qkxdawL3rfcNHYJY1ZVvWVs7j,s=QSXCR+Q6sek8bf92,i=4096";
+    const QByteArray clientFinal = "c=biws,r=fyko+d2lbbFgONRv9qkxdawL3rfcNHYJY1ZVvWVs7j,p=v0X8v3Bz2T0CJGbJQyF0X+HI4Ts=";
+
+    // derive keys from the password
+    QXmppSaslDigestMd5::setNonce("fyko+d2lbbFgONRv9qkxdawL");
+    auto client = QXmppSaslClient::create("SCRAM-SHA-1");
+    client->setUsername("user");
+    client->setCredentials(Credentials { .password = "pencil" });
+    QVERIFY(client->respond(QByteArray()));
+    QCOMPARE(client->respond(serverFirst), clientFinal);
+
+    // keys are only stored after the server signature has been verified
+    Credentials credentials;
+    client->updateCredentials(credentials);
+    QVERIFY(credentials.scramKeys.isEmpty());
+    QVERIFY(client->handleSuccess(QByteArray("v=rmF9pqV8S7suAoZWja4dJRkFsKQ=")));
+    client->updateCredentials(credentials);
+    QCOMPARE(credentials.scramKeys.size(), 1);
+    QVERIFY(credentials.scramKeys.first().mechanism == SaslScramMechanism { SaslScramMechanism::Sha1 });
+    QCOMPARE(credentials.scramKeys.first().salt, QByteArray::fromBase64("QSXCR+Q6sek8bf92"));
+    QCOMPARE(credentials.scramKeys.first().iterations, 4096);
+
+    // keys are enough to select the mechanism
+    QVERIFY(QXmppSaslClient::isMechanismAvailable({ SaslScramMechanism { SaslScramMechanism::Sha1 } }, credentials));
+    QVERIFY(!QXmppSaslClient::isMechanismAvailable({ SaslScramMechanism { SaslScramMechanism::Sha256 } }, credentials));
+
+    // authenticate without password
+    QXmppSaslDigestMd5::setNonce("fyko+d2lbbFgONRv9qkxdawL");
+    client = QXmppSaslClient::create("SCRAM-SHA-1");
+    client->setUsername("user");
+    client->setCredentials(credentials);
+    QVERIFY(client->respond(QByteArray()));
+    QCOMPARE(client->respond(serverFirst), clientFinal);
+    QCOMPARE(client->respond(QByteArray("v=rmF9pqV8S7suAoZWja4dJRkFsKQ")), QByteArray());
+
+    // no new keys have been derived
+    auto updated = credentials;
+    client->updateCredentials(updated);
+    QVERIFY(updated.scramKeys == credentials.scramKeys);
+
+    // the server changed the iteration count, the password would be needed
+    QXmppSaslDigestMd5::setNonce("fyko+d2lbbFgONRv9qkxdawL");
+    client = QXmppSaslClient::create("SCRAM-SHA-1");
+    client->setUsername("user");
+    client->setCredentials(credentials);
+    QVERIFY(client->respond(QByteArray()));
+    QVERIFY(!client->respond("r=fyko+d2lbbFgONRv9qkxdawL3rfcNHYJY1ZVvWVs7j,s=QSXCR+Q6sek8bf92,i=8192"));
+}
+
 void tst_QXmppSasl::testClientScramSha256()
 {
     QXmppSaslDigestMd5::setNonce("rOprNGfwEbeRWgbNEkqO");
@@ -785,6 +845,36 @@ void tst_QXmppSasl::saslManagerNoMechanisms()
     QCOMPARE(error.type, QXmpp::AuthenticationError::MechanismMismatch);
 }
 
+void tst_QXmppSasl::saslManagerScramKeys()
+{
+    auto authenticate = [](const QByteArray &successData) {
+        SaslManagerTest test;
+        auto &sent = test.socket.sent;
+
+        QXmppConfiguration config;
+        config.setUser("user");
+        config.setPassword("pencil");
+
+        QXmppSaslDigestMd5::setNonce("fyko+d2lbbFgONRv9qkxdawL");
+        auto task = test.manager.authenticate(config, { "SCRAM-SHA-1" }, test.loggable.get());
+        test.manager.handleElement(xmlToDom("<challenge xmlns='urn:ietf:params:xml:ns:xmpp-sasl'>cj1meWtvK2QybGJiRmdPTlJ2OXFreGRhd0wzcmZjTkhZSlkxWlZ2V1ZzN2oscz1RU1hDUitRNnNlazhiZjkyLGk9NDA5Ng==</challenge>"));
+        test.manager.handleElement(xmlToDom("<success xmlns='urn:ietf:params:xml:ns:xmpp-sasl'>" + successData + "</success>"));
+
+        return std::tuple { sent.size(), task.isFinished() && std::holds_alternative<QXmpp::Success>(task.result()), config.credentialData().scramKeys.size() };
+    };
+
+    // the server signature is valid, the keys are stored
+    auto [sentCount, succeeded, keyCount] = authenticate("dj1ybUY5cHFWOFM3c3VBb1pXamE0ZEpSa0ZzS1E9");
+    QCOMPARE(sentCount, size_t(2));
+    QVERIFY(succeeded);
+    QCOMPARE(keyCount, qsizetype(1));
+
+    // the server could not be authenticated
+    std::tie(sentCount, succeeded, keyCount) = authenticate("dj1BQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUFBQUE9");
+    QVERIFY(!succeeded);
+    QCOMPARE(keyCount, qsizetype(0));
+}
+
 void tst_QXmppSasl::sasl2ManagerPlain()
 {
     Sasl2ManagerTest test;
@@ -0,0 +1,193 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "QXmppMessage.h"
+#include "QXmppUtils_p.h"
+
+#include "XmppSocket.h"
+#include "util.h"
+
+#include <cstdlib>
+#include <new>
+#include <optional>
+
+#include <QSslSocket>
+#include <QTcpServer>
+
+// Counts the allocations with operator new of the current thread. Qt's containers allocate with
+// malloc() and are not included.
+static thread_local qint64 allocationCount = 0;
+
+void *operator new(std::size_t size)
+{
+    allocationCount++;
+    if (auto *memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+using namespace QXmpp::Private;
+
+class tst_QXmppSerialization : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void initTestCase();
+    Q_SLOT void serializationBuffer();
+    Q_SLOT void serializationBufferLargePacket();
+
+    Q_SLOT void benchmarkSerializeXml();
+    Q_SLOT void benchmarkSerializationBuffer();
+    Q_SLOT void benchmarkAllocationsPerMessage_data();
+    Q_SLOT void benchmarkAllocationsPerMessage();
+
+private:
+    QXmppMessage m_message;
+    std::optional<double> m_allocationsWithoutBuffer;
+};
+
+void tst_QXmppSerialization::initTestCase()
+{
+    m_message.setId(u"c5d2b5e0-8b1c-4d6a-9e5f-0f0f6f1c7a3e"_s);
+    m_message.setFrom(u"juliet@capulet.example/balcony"_s);
+    m_message.setTo(u"romeo@montague.example"_s);
+    m_message.setType(QXmppMessage::Chat);
+    m_message.setBody(u"Wherefore art thou, Romeo?"_s);
+    m_message.setOriginId(u"de305d54-75b4-431b-adb2-eb6b9e546014"_s);
+    m_message.setReceiptRequested(true);
+    m_message.setMarkable(true);
+    m_message.setState(QXmppMessage::Active);
+}
+
+// copies the data, it is only valid during the call
+static QByteArray serialize(SerializationBuffer &buffer, const QXmppNonza &packet)
+{
+    return buffer.serialize(packet, [](const char *data, qsizetype size) {
+        return QByteArray(data, size);
+    });
+}
+
+void tst_QXmppSerialization::serializationBuffer()
+{
+    SerializationBuffer buffer;
+
+    const auto expected = serializeXml<QXmppNonza>(m_message);
+    QCOMPARE(serialize(buffer, m_message), expected);
+
+    // the second packet is written into the same memory
+    const auto pointer = [&] {
+        return buffer.serialize<QXmppNonza>(m_message, [](const char *data, qsizetype) { return data; });
+    };
+    const auto *data = pointer();
+    QCOMPARE(serialize(buffer, m_message), expected);
+    QCOMPARE(pointer(), data);
+
+    // namespaces of the previous packets do not leak into the next one
+    QXmppMessage other;
+    other.setBody(u"Hi"_s);
+    QCOMPARE(serialize(buffer, other), serializeXml<QXmppNonza>(other));
+
+    // a packet serialized while the buffer is in use gets its own memory
+    QByteArray nested;
+    const auto outer = buffer.serialize<QXmppNonza>(m_message, [&](const char *data, qsizetype size) {
+        nested = serialize(buffer, other);
+        return QByteArray(data, size);
+    });
+    QCOMPARE(nested, serializeXml<QXmppNonza>(other));
+    QCOMPARE(outer, expected);
+    QCOMPARE(pointer(), data);
+}
+
+void tst_QXmppSerialization::serializationBufferLargePacket()
+{
+    SerializationBuffer buffer;
+
+    QXmppMessage large;
+    large.setBody(QString(256 * 1024, u'a'));
+    QCOMPARE(serialize(buffer, large), serializeXml<QXmppNonza>(large));
+    QVERIFY(buffer.sizeHint() > 256 * 1024);
+
+    // the hint decays and the memory is released again
+    for (int i = 0; i < 64; i++) {
+        QCOMPARE(serialize(buffer, m_message), serializeXml<QXmppNonza>(m_message));
+    }
+    QCOMPARE(buffer.sizeHint(), qsizetype(1024));
+}
+
+void tst_QXmppSerialization::benchmarkSerializeXml()
+{
+    QBENCHMARK {
+        auto data = serializeXml<QXmppNonza>(m_message);
+        QVERIFY(!data.isEmpty());
+    }
+}
+
+void tst_QXmppSerialization::benchmarkSerializationBuffer()
+{
+    SerializationBuffer buffer;
+    QBENCHMARK {
+        const auto size = buffer.serialize<QXmppNonza>(m_message, [](const char *, qsizetype size) { return size; });
+        QVERIFY(size > 0);
+    }
+}
+
+void tst_QXmppSerialization::benchmarkAllocationsPerMessage_data()
+{
+    QTest::addColumn<bool>("reuseBuffer");
+
+    QTest::newRow("serializeXml") << false;
+    QTest::newRow("SerializationBuffer") << true;
+}
+
+void tst_QXmppSerialization::benchmarkAllocationsPerMessage()
+{
+    QFETCH(bool, reuseBuffer);
+
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    XmppSocket socket(this);
+    auto *sslSocket = new QSslSocket(&socket);
+    socket.setSocket(sslSocket);
+    sslSocket->connectToHost(server.serverAddress(), server.serverPort());
+    QVERIFY(sslSocket->waitForConnected());
+    QVERIFY(server.waitForNewConnection(1000));
+
+    qint64 allocations = 0;
+    qint64 messages = 0;
+    QBENCHMARK {
+        const auto start = allocationCount;
+        if (reuseBuffer) {
+            QVERIFY(socket.sendXml<QXmppNonza>(m_message));
+        } else {
+            QVERIFY(socket.sendData(serializeXml<QXmppNonza>(m_message)));
+        }
+        allocations += allocationCount - start;
+        messages++;
+    }
+
+    const auto perMessage = double(allocations) / double(messages);
+    qInfo("%.2f allocations per sent message", perMessage);
+
+    if (!reuseBuffer) {
+        m_allocationsWithoutBuffer = perMessage;
+    } else if (m_allocationsWithoutBuffer) {
+        QVERIFY(perMessage < *m_allocationsWithoutBuffer);
+    }
+}
+
+QTEST_MAIN(tst_QXmppSerialization)
+#include "tst_qxmppserialization.moc"
@@ -14,6 +14,8 @@ class tst_QXmppServer : public QObject
 private:
     Q_SLOT void testConnect_data();
     Q_SLOT void testConnect();
+    Q_SLOT void benchmarkConnect_data();
+    Q_SLOT void benchmarkConnect();
 };
 
 void tst_QXmppServer::testConnect_data()
@@ -91,5 +93,68 @@ void tst_QXmppServer::testConnect()
     QCOMPARE(client.isConnected(), connected);
 }
 
+void tst_QXmppServer::benchmarkConnect_data()
+{
+    QTest::addColumn<bool>("pipelining");
+
+    QTest::newRow("sequential") << false;
+    QTest::newRow("pipelined") << true;
+}
+
+void tst_QXmppServer::benchmarkConnect()
+{
+    QFETCH(bool, pipelining);
+
+    const QString testDomain("localhost");
+    const QHostAddress testHost(QHostAddress::LocalHost);
+    const quint16 testPort = 12345;
+
+    TestPasswordChecker passwordChecker;
+    passwordChecker.addCredentials("testuser", "testpwd");
+
+    QXmppServer server;
+    server.setDomain(testDomain);
+    server.setPasswordChecker(&passwordChecker);
+    server.listenForClients(testHost, testPort);
+
+    QXmppClient client;
+
+    QEventLoop loop;
+    connect(&client, &QXmppClient::connected,
+            &loop, &QEventLoop::quit);
+    connect(&client, &QXmppClient::disconnected,
+            &loop, &QEventLoop::quit);
+
+    QXmppConfiguration config;
+    config.setDomain(testDomain);
+    config.setHost(testHost.toString());
+    config.setPort(testPort);
+    config.setUser("testuser");
+    config.setPassword("testpwd");
+    config.setSaslAuthMechanism("PLAIN");
+    config.setUseSasl2Authentication(false);
+    config.setStreamPipeliningEnabled(pipelining);
+
+    // the first connection fills the stream features cache
+    client.connectToServer(config);
+    loop.exec();
+    QVERIFY(client.isConnected());
+    client.disconnectFromServer();
+    if (client.state() != QXmppClient::DisconnectedState) {
+        loop.exec();
+    }
+
+    QBENCHMARK {
+        client.connectToServer(config);
+        loop.exec();
+        QVERIFY(client.isConnected());
+
+        client.disconnectFromServer();
+        if (client.state() != QXmppClient::DisconnectedState) {
+            loop.exec();
+        }
+    }
+}
+
 QTEST_MAIN(tst_QXmppServer)
 #include "tst_qxmppserver.moc"
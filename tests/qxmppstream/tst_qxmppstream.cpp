@@ -3,17 +3,29 @@
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
 #include "QXmppConstants_p.h"
+#include "QXmppMessage.h"
 #include "QXmppStreamError_p.h"
+#include "QXmppStreamManagement_p.h"
 
 #include "Stream.h"
+#include "TokenBucket.h"
+#include "XmlTree.h"
 #include "XmppSocket.h"
 #include "compat/QXmppStartTlsPacket.h"
 #include "util.h"
 
+#include <algorithm>
+#include <limits>
+
+#include <QElapsedTimer>
+#include <QSslSocket>
+#include <QTcpServer>
+
 using namespace QXmpp;
 using namespace QXmpp::Private;
 
 Q_DECLARE_METATYPE(QDomElement)
+Q_DECLARE_METATYPE(QXmpp::StreamError)
 
 class tst_QXmppStream : public QObject
 {
@@ -22,10 +34,20 @@ class tst_QXmppStream : public QObject
 private:
     Q_SLOT void initTestCase();
     Q_SLOT void testProcessData();
+    Q_SLOT void testProcessDataIncremental();
+    Q_SLOT void testProcessDataSizeLimit();
+    Q_SLOT void testProcessDataInvalid();
+    Q_SLOT void testWriteCoalescing();
+    Q_SLOT void testUnacknowledgedQueue();
+    Q_SLOT void testTokenBucket();
 #ifdef BUILD_INTERNAL_TESTS
+    Q_SLOT void testAckRequestPolicy();
+    Q_SLOT void testSendPriorities();
+    Q_SLOT void testRateLimit();
     Q_SLOT void streamOpen();
     Q_SLOT void testStreamError();
     Q_SLOT void starttlsPackets();
+    Q_SLOT void emptyElementHandler();
 #endif
 
     // parsing
@@ -36,6 +58,7 @@ private:
 void tst_QXmppStream::initTestCase()
 {
     qRegisterMetaType<QDomElement>();
+    qRegisterMetaType<QXmpp::StreamError>();
 }
 
 void tst_QXmppStream::testProcessData()
@@ -103,7 +126,433 @@ void tst_QXmppStream::testProcessData()
     socket.processData(R"(</stream:stream>)");
 }
 
+void tst_QXmppStream::testProcessDataIncremental()
+{
+    XmppSocket socket(this);
+
+    QSignalSpy onStreamReceived(&socket, &XmppSocket::streamReceived);
+    QSignalSpy onStanzaReceived(&socket, &XmppSocket::stanzaReceived);
+    QSignalSpy onStreamClosed(&socket, &XmppSocket::streamClosed);
+
+    socket.processData(R"(<?xml version='1.0'?><stream:stream xmlns='jabber:client' xmlns:stream='http://etherx.jabber.org/streams' id='s1'>)");
+    QCOMPARE(onStreamReceived.size(), 1);
+
+    // complete stanza followed by a partial one: first one is processed directly
+    socket.processData(R"(<message id="1"><body>a &lt;b&gt; "c"</body></message><message id="2"><bo)");
+    QCOMPARE(onStanzaReceived.size(), 1);
+    auto message = onStanzaReceived[0][0].value<QDomElement>();
+    QCOMPARE(message.attribute(u"id"_s), u"1"_s);
+    QCOMPARE(message.firstChildElement().text(), u"a <b> \"c\""_s);
+
+    // quotes, comments and CDATA sections do not confuse the parser
+    socket.processData(R"(dy a='/>'><![CDATA[</message>]]></body><!-- </message> --></message>)");
+    QCOMPARE(onStanzaReceived.size(), 2);
+    message = onStanzaReceived[1][0].value<QDomElement>();
+    QCOMPARE(message.attribute(u"id"_s), u"2"_s);
+    QCOMPARE(message.firstChildElement().text(), u"</message>"_s);
+    QCOMPARE(message.namespaceURI(), u"jabber:client"_s);
+
+    // split tags and empty elements
+    socket.processData(R"(<r xmlns='urn:xmpp:sm:3')");
+    QCOMPARE(onStanzaReceived.size(), 2);
+    socket.processData(R"(/><a xmlns='urn:xmpp:sm:3' h='1'/>)");
+    QCOMPARE(onStanzaReceived.size(), 4);
+    QCOMPARE(onStanzaReceived[2][0].value<QDomElement>().tagName(), u"r"_s);
+    QCOMPARE(onStanzaReceived[3][0].value<QDomElement>().attribute(u"h"_s), u"1"_s);
+
+    // whitespace ping
+    socket.processData(" ");
+    QCOMPARE(onStanzaReceived.size(), 5);
+    QVERIFY(onStanzaReceived[4][0].value<QDomElement>().isNull());
+
+    // stream restart (e.g. after SASL)
+    socket.processData(R"(<?xml version='1.0'?><stream:stream xmlns='jabber:client' xmlns:stream='http://etherx.jabber.org/streams' id='s2'><stream:features/>)");
+    QCOMPARE(onStreamReceived.size(), 2);
+    QCOMPARE(onStreamReceived[1][0].value<QDomElement>().attribute(u"id"_s), u"s2"_s);
+    QCOMPARE(onStanzaReceived.size(), 6);
+    QCOMPARE(onStanzaReceived[5][0].value<QDomElement>().tagName(), u"features"_s);
+
+    socket.processData(R"(</stream:stream>)");
+    QCOMPARE(onStreamClosed.size(), 1);
+}
+
+void tst_QXmppStream::testProcessDataSizeLimit()
+{
+    XmppSocket socket(this);
+    socket.setMaximumStanzaSize(64);
+
+    QSignalSpy onStanzaReceived(&socket, &XmppSocket::stanzaReceived);
+    QSignalSpy onStreamErrorSent(&socket, &XmppSocket::streamErrorSent);
+
+    socket.processData(R"(<stream:stream xmlns='jabber:client' xmlns:stream='http://etherx.jabber.org/streams'>)");
+    socket.processData(R"(<message><body>small</body></message>)");
+    QCOMPARE(onStanzaReceived.size(), 1);
+    QCOMPARE(onStreamErrorSent.size(), 0);
+
+    // limit is enforced before the element is complete
+    socket.processData(R"(<message><body>)");
+    socket.processData(QByteArray(64, 'a'));
+    QCOMPARE(onStreamErrorSent.size(), 1);
+    QCOMPARE(onStreamErrorSent[0][0].value<StreamError>(), StreamError::PolicyViolation);
+
+    // everything after the error is ignored
+    socket.processData(R"(</body></message><message/>)");
+    QCOMPARE(onStanzaReceived.size(), 1);
+    QCOMPARE(onStreamErrorSent.size(), 1);
+}
+
+void tst_QXmppStream::testProcessDataInvalid()
+{
+    XmppSocket socket(this);
+
+    QSignalSpy onStreamReceived(&socket, &XmppSocket::streamReceived);
+    QSignalSpy onStanzaReceived(&socket, &XmppSocket::stanzaReceived);
+    QSignalSpy onStreamErrorSent(&socket, &XmppSocket::streamErrorSent);
+
+    socket.processData(R"(<stream:stream xmlns='jabber:client' xmlns:stream='http://etherx.jabber.org/streams'>)");
+    QCOMPARE(onStreamReceived.size(), 1);
+
+    // only <stream:stream> restarts the stream, not every tag starting with it
+    socket.processData(R"(<stream:streamfoo/>)");
+    QCOMPARE(onStreamReceived.size(), 1);
+    QCOMPARE(onStanzaReceived.size(), 1);
+    QCOMPARE(onStanzaReceived[0][0].value<QDomElement>().tagName(), u"streamfoo"_s);
+
+    // invalid elements end the stream, the stanza and everything after it are not processed
+    socket.processData(R"(<foo:message/><message/>)");
+    QCOMPARE(onStanzaReceived.size(), 1);
+    QCOMPARE(onStreamErrorSent.size(), 1);
+    QCOMPARE(onStreamErrorSent[0][0].value<StreamError>(), StreamError::NotWellFormed);
+
+    socket.processData(R"(<message/>)");
+    QCOMPARE(onStanzaReceived.size(), 1);
+    QCOMPARE(onStreamErrorSent.size(), 1);
+}
+
+void tst_QXmppStream::testWriteCoalescing()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    XmppSocket socket(this);
+    socket.setWriteCoalescingEnabled(true);
+    socket.setWriteCoalescingThreshold(32);
+    auto *sslSocket = new QSslSocket(&socket);
+    socket.setSocket(sslSocket);
+
+    QSignalSpy onCounterUpdated(&socket, &QXmppLoggable::updateCounter);
+    auto writes = [&] {
+        return std::count_if(onCounterUpdated.cbegin(), onCounterUpdated.cend(), [](const auto &args) {
+            return args[0].toString() == u"socket.writes";
+        });
+    };
+
+    sslSocket->connectToHost(server.serverAddress(), server.serverPort());
+    QVERIFY(sslSocket->waitForConnected());
+    QVERIFY(server.waitForNewConnection(1000));
+    auto *peer = server.nextPendingConnection();
+
+    // small packets are held back until the event loop runs
+    QVERIFY(socket.sendData("<r/>"));
+    QVERIFY(socket.sendData("<a h='1'/>"));
+    QCOMPARE(writes(), 0);
+    QTRY_COMPARE(writes(), 1);
+
+    // reaching the threshold flushes immediately
+    QVERIFY(socket.sendData(QByteArray(40, ' ')));
+    QCOMPARE(writes(), 2);
+
+    // explicit flush
+    QVERIFY(socket.sendData("<r/>"));
+    QVERIFY(socket.flush());
+    QCOMPARE(writes(), 3);
+
+    QByteArray received;
+    QTRY_VERIFY((received += peer->readAll()).size() == 58);
+    QCOMPARE(received, QByteArray("<r/><a h='1'/>" + QByteArray(40, ' ') + "<r/>"));
+}
+
+void tst_QXmppStream::testUnacknowledgedQueue()
+{
+    UnacknowledgedQueue<QString> queue;
+    QVERIFY(queue.isEmpty());
+
+    QStringList removed;
+    auto collect = [&](const QString &item) { removed << item; };
+
+    // sequence numbers wrap around
+    const quint32 first = std::numeric_limits<quint32>::max() - 9;
+    for (quint32 i = 0; i < 20; i++) {
+        queue.append(first + i, QString::number(i));
+    }
+    QCOMPARE(queue.size(), std::size_t(20));
+    QCOMPARE(queue.capacity(), std::size_t(32));
+    QCOMPARE(queue.firstSequenceNumber(), first);
+
+    // acks for older stanzas are ignored
+    queue.removeUntil(first - 1, collect);
+    QVERIFY(removed.isEmpty());
+
+    queue.removeUntil(first + 2, collect);
+    QCOMPARE(removed, (QStringList { u"0"_s, u"1"_s, u"2"_s }));
+    QCOMPARE(queue.firstSequenceNumber(), first + 3);
+
+    // across the wrap-around
+    removed.clear();
+    queue.removeUntil(1, collect);
+    QCOMPARE(removed.size(), 9);
+    QCOMPARE(removed.constLast(), u"11"_s);
+    QCOMPARE(queue.firstSequenceNumber(), quint32(2));
+
+    // the ring buffer is reused after trimming
+    for (quint32 i = 20; i < 30; i++) {
+        queue.append(first + i, QString::number(i));
+    }
+    QCOMPARE(queue.size(), std::size_t(18));
+    QCOMPARE(queue.capacity(), std::size_t(32));
+
+    queue.renumber(1);
+    QStringList items;
+    queue.forEach([&](const QString &item) { items << item; });
+    QCOMPARE(items.size(), 18);
+    QCOMPARE(items.constFirst(), u"12"_s);
+    QCOMPARE(items.constLast(), u"29"_s);
+
+    removed.clear();
+    queue.removeAll(collect);
+    QCOMPARE(removed, items);
+    QVERIFY(queue.isEmpty());
+}
+
+void tst_QXmppStream::testTokenBucket()
+{
+    using namespace std::chrono_literals;
+    const auto start = TokenBucket::Clock::now();
+
+    // disabled
+    TokenBucket unlimited;
+    QVERIFY(unlimited.isAvailable(1e9, start));
+    QCOMPARE(unlimited.delay(1e9, start), TokenBucket::Clock::duration::zero());
+
+    TokenBucket bucket(100, 200, start);
+    QVERIFY(bucket.isAvailable(200, start));
+    bucket.take(150, start);
+    QCOMPARE(bucket.tokens(start), 50.0);
+    QVERIFY(!bucket.isAvailable(100, start));
+    QCOMPARE(bucket.delay(100, start), TokenBucket::Clock::duration(500ms));
+    QVERIFY(bucket.isAvailable(100, start + 500ms));
+
+    // refilled up to the capacity
+    QCOMPARE(bucket.tokens(start + 10s), 200.0);
+
+    // larger amounts are allowed with a full bucket and result in debt
+    QVERIFY(bucket.isAvailable(300, start + 10s));
+    bucket.take(300, start + 10s);
+    QCOMPARE(bucket.tokens(start + 10s), -100.0);
+    QCOMPARE(bucket.delay(100, start + 10s), TokenBucket::Clock::duration(2s));
+}
+
 #ifdef BUILD_INTERNAL_TESTS
+void tst_QXmppStream::testAckRequestPolicy()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    XmppSocket socket(this);
+    auto *sslSocket = new QSslSocket(&socket);
+    socket.setSocket(sslSocket);
+
+    sslSocket->connectToHost(server.serverAddress(), server.serverPort());
+    QVERIFY(sslSocket->waitForConnected());
+    QVERIFY(server.waitForNewConnection(1000));
+    auto *peer = server.nextPendingConnection();
+
+    QByteArray received;
+    auto requests = [&] {
+        received += peer->readAll();
+        return received.count("<r xmlns");
+    };
+
+    StreamAckManager manager(socket);
+    manager.enableStreamManagement(true);
+
+    QXmppMessage message;
+    message.setTo(u"juliet@capulet.example"_s);
+    message.setBody(u"Hi"_s);
+
+    // every third stanza
+    manager.setAckRequestPolicy(3, {}, false);
+    for (int i = 0; i < 7; i++) {
+        manager.send(message);
+    }
+    QCOMPARE(manager.unacknowledgedStanzaCount(), std::size_t(7));
+    QTRY_COMPARE(requests(), 2);
+
+    manager.setAcknowledgedSequenceNumber(6);
+    QCOMPARE(manager.unacknowledgedStanzaCount(), std::size_t(1));
+
+    // once per burst
+    manager.setAckRequestPolicy(0, {}, true);
+    for (int i = 0; i < 5; i++) {
+        manager.send(message);
+    }
+    QTRY_COMPARE(requests(), 3);
+    QTest::qWait(20);
+    QCOMPARE(requests(), 3);
+
+    // after a delay
+    manager.setAckRequestPolicy(0, std::chrono::milliseconds(50), false);
+    manager.send(message);
+    manager.send(message);
+    QTest::qWait(10);
+    QCOMPARE(requests(), 3);
+    QTRY_COMPARE(requests(), 4);
+
+    manager.setAcknowledgedSequenceNumber(14);
+    QCOMPARE(manager.unacknowledgedStanzaCount(), std::size_t(0));
+
+    // without any condition, an acknowledgement is requested for every stanza
+    manager.setAckRequestPolicy(0, {}, false);
+    manager.send(message);
+    QTRY_COMPARE(requests(), 5);
+}
+
+void tst_QXmppStream::testSendPriorities()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    XmppSocket socket(this);
+    auto *sslSocket = new QSslSocket(&socket);
+    socket.setSocket(sslSocket);
+
+    sslSocket->connectToHost(server.serverAddress(), server.serverPort());
+    QVERIFY(sslSocket->waitForConnected());
+    QVERIFY(server.waitForNewConnection(1000));
+    auto *peer = server.nextPendingConnection();
+
+    QByteArray received;
+    auto bodies = [&] {
+        received += peer->readAll();
+        QStringList result;
+        for (qsizetype i = received.indexOf("<body>"); i >= 0; i = received.indexOf("<body>", i + 1)) {
+            result << QString::fromUtf8(received.mid(i + 6, received.indexOf("</body>", i) - i - 6));
+        }
+        return result;
+    };
+    auto message = [](const QString &body) {
+        QXmppMessage message;
+        message.setTo(u"juliet@capulet.example"_s);
+        message.setBody(body);
+        return message;
+    };
+
+    StreamAckManager manager(socket);
+    QSignalSpy lowSpy(&socket, &XmppSocket::writeBufferLow);
+
+    // the socket buffers written data until the event loop runs, so everything after the first
+    // stanza exceeds the limit
+    manager.setWriteBufferHighWaterMark(1);
+    auto first = manager.send(message(u"1"_s), SendPriority::Bulk);
+    QVERIFY(first.isFinished());
+    QVERIFY(manager.isWriteBufferFull());
+
+    auto bulk = manager.send(message(u"2"_s), SendPriority::Bulk);
+    manager.send(message(u"3"_s), SendPriority::Interactive);
+    manager.send(message(u"4"_s), SendPriority::Bulk);
+    QVERIFY(!bulk.isFinished());
+    QCOMPARE(manager.heldBackPacketCount(), std::size_t(3));
+
+    // control traffic is never held back
+    manager.send(message(u"5"_s), SendPriority::Control);
+    QCOMPARE(manager.heldBackPacketCount(), std::size_t(3));
+
+    // interactive stanzas overtake bulk stanzas, the order within a priority is kept
+    QTRY_COMPARE(bodies(), (QStringList { u"1"_s, u"5"_s, u"3"_s, u"2"_s, u"4"_s }));
+    QCOMPARE(manager.heldBackPacketCount(), std::size_t(0));
+    QVERIFY(bulk.isFinished());
+    QTRY_COMPARE(lowSpy.size(), 1);
+    QVERIFY(!manager.isWriteBufferFull());
+
+    // with stream management, held back stanzas are resent after resumption
+    manager.enableStreamManagement(true);
+    manager.setAckRequestPolicy(0, {}, false);
+    manager.send(message(u"6"_s));
+    manager.send(message(u"7"_s));
+    QCOMPARE(manager.heldBackPacketCount(), std::size_t(1));
+    QCOMPARE(manager.unacknowledgedStanzaCount(), std::size_t(1));
+
+    manager.onSessionClosed();
+    QCOMPARE(manager.heldBackPacketCount(), std::size_t(0));
+    QCOMPARE(manager.unacknowledgedStanzaCount(), std::size_t(2));
+    QCOMPARE(manager.lastOutgoingSequenceNumber(), 2u);
+
+    // without a limit nothing is held back
+    manager.setWriteBufferHighWaterMark(0);
+    manager.send(message(u"8"_s), SendPriority::Bulk);
+    QCOMPARE(manager.heldBackPacketCount(), std::size_t(0));
+}
+
+void tst_QXmppStream::testRateLimit()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    XmppSocket socket(this);
+    auto *sslSocket = new QSslSocket(&socket);
+    socket.setSocket(sslSocket);
+
+    sslSocket->connectToHost(server.serverAddress(), server.serverPort());
+    QVERIFY(sslSocket->waitForConnected());
+    QVERIFY(server.waitForNewConnection(1000));
+    auto *peer = server.nextPendingConnection();
+
+    QByteArray received;
+    auto messages = [&] {
+        received += peer->readAll();
+        return received.count("<message ");
+    };
+
+    QXmppMessage message;
+    message.setTo(u"juliet@capulet.example"_s);
+    message.setBody(u"Hi"_s);
+
+    StreamAckManager manager(socket);
+    QSignalSpy delaySpy(&socket, &QXmppLoggable::updateHistogram);
+
+    // 20 stanzas per second without bursts
+    manager.setRateLimit(0, 20, {});
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < 3; i++) {
+        manager.send(message);
+    }
+    QCOMPARE(manager.heldBackPacketCount(), std::size_t(2));
+
+    // control traffic is not held back
+    manager.send(message, SendPriority::Control);
+    QCOMPARE(manager.heldBackPacketCount(), std::size_t(2));
+
+    QTRY_COMPARE(messages(), 4);
+    QVERIFY(timer.elapsed() >= 100);
+    QCOMPARE(manager.heldBackPacketCount(), std::size_t(0));
+
+    // the queueing delay is recorded
+    QCOMPARE(delaySpy.size(), 2);
+    QCOMPARE(delaySpy.at(0).at(0).toString(), u"send-queue.delay"_s);
+    QVERIFY(delaySpy.at(1).at(1).toDouble() > 0);
+
+    // removing the limit writes held back stanzas
+    manager.setRateLimit(0, 20, {});
+    for (int i = 0; i < 3; i++) {
+        manager.send(message);
+    }
+    QCOMPARE(manager.heldBackPacketCount(), std::size_t(2));
+    manager.setRateLimit(0, 0, {});
+    QCOMPARE(manager.heldBackPacketCount(), std::size_t(0));
+    QTRY_COMPARE(messages(), 7);
+}
+
 void tst_QXmppStream::streamOpen()
 {
     auto xml = "<?xml version='1.0' encoding='UTF-8'?><stream:stream from='juliet@im.example.com' to='im.example.com' version='1.0' xmlns='jabber:client' xmlns:stream='http://etherx.jabber.org/streams'>";
@@ -145,6 +594,10 @@ void tst_QXmppStream::testStreamError()
         }
         QCOMPARE(parsed, error);
     }
+
+    StreamErrorElement policyViolation { StreamError::PolicyViolation, u"Too large"_s };
+    serializePacket(policyViolation,
+                    "<stream:error><policy-violation xmlns='urn:ietf:params:xml:ns:xmpp-streams'/><text xmlns='urn:ietf:params:xml:ns:xmpp-streams'>Too large</text></stream:error>");
 }
 
 void tst_QXmppStream::starttlsPackets()
@@ -157,6 +610,36 @@ void tst_QXmppStream::starttlsPackets()
     auto proceed = unwrap(StarttlsProceed::fromDom(xmlToDom(xml2)));
     serializePacket(proceed, xml2);
 }
+
+void tst_QXmppStream::emptyElementHandler()
+{
+    XmppSocket socket(this);
+    QSignalSpy onStanzaReceived(&socket, &XmppSocket::stanzaReceived);
+
+    std::vector<quint32> acks;
+    QStringList namespaces;
+    socket.setEmptyElementHandler([&](const XmlElement &element) {
+        namespaces << element.namespaceURI();
+        if (auto ack = SmAck::fromDom(element)) {
+            acks.push_back(ack->seqNo);
+            return true;
+        }
+        return false;
+    });
+
+    socket.processData(R"(<stream:stream xmlns='jabber:client' xmlns:stream='http://etherx.jabber.org/streams'>)");
+
+    // handled elements are not parsed into a QDomElement
+    socket.processData(R"(<a xmlns='urn:xmpp:sm:3' h='3'/>)");
+    QCOMPARE(acks, std::vector<quint32> { 3 });
+    QCOMPARE(onStanzaReceived.size(), 0);
+
+    // unhandled elements are emitted as usual, elements with children are not passed
+    socket.processData(R"(<presence/><message><body>Hi</body></message>)");
+    QCOMPARE(namespaces, (QStringList { u"urn:xmpp:sm:3"_s, u"jabber:client"_s }));
+    QCOMPARE(onStanzaReceived.size(), 2);
+    QCOMPARE(onStanzaReceived[0][0].value<QDomElement>().tagName(), u"presence"_s);
+}
 #endif
 
 void tst_QXmppStream::testStartTlsPacket_data()
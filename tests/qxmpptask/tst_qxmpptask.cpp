@@ -0,0 +1,282 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "QXmppPromise.h"
+#include "QXmppTask.h"
+
+#include "util.h"
+
+#include <cstdlib>
+#include <new>
+
+#include <QScopeGuard>
+
+// Counts the allocations with operator new of the current thread. Qt's containers allocate with
+// malloc() and are not included.
+static thread_local qint64 allocationCount = 0;
+
+void *operator new(std::size_t size)
+{
+    allocationCount++;
+    if (auto *memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+class tst_QXmppTask : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void then();
+    Q_SLOT void thenContextDeleted();
+    Q_SLOT void overAligned();
+    Q_SLOT void benchmarkThen();
+    Q_SLOT void benchmarkAllocations_data();
+    Q_SLOT void benchmarkAllocations();
+#ifdef QXMPP_TASK_COROUTINES
+    Q_SLOT void awaitFinished();
+    Q_SLOT void awaitPending();
+    Q_SLOT void awaitChained();
+    Q_SLOT void awaitMoveOnly();
+    Q_SLOT void awaitAbandoned();
+#endif
+};
+
+void tst_QXmppTask::then()
+{
+    QXmppPromise<QString> promise;
+    QString result;
+    promise.task().then(this, [&](QString &&value) { result = std::move(value); });
+    QVERIFY(result.isEmpty());
+
+    promise.finish(u"value"_s);
+    QCOMPARE(result, u"value"_s);
+}
+
+void tst_QXmppTask::thenContextDeleted()
+{
+    QXmppPromise<void> promise;
+    bool called = false;
+    {
+        QObject context;
+        promise.task().then(&context, [&] { called = true; });
+    }
+    promise.finish();
+    QVERIFY(!called);
+}
+
+void tst_QXmppTask::overAligned()
+{
+    struct alignas(64) Value {
+        int value;
+    };
+
+    QXmppPromise<Value> promise;
+    promise.finish(Value { 42 });
+
+    auto task = promise.task();
+    QCOMPARE(reinterpret_cast<quintptr>(&task.result()) % 64, 0);
+    QCOMPARE(task.result().value, 42);
+}
+
+
+void tst_QXmppTask::benchmarkThen()
+{
+    int sum = 0;
+    QBENCHMARK {
+        QXmppPromise<QString> promise;
+        promise.task().then(this, [&sum](QString &&value) { sum += value.size(); });
+        promise.finish(u"result"_s);
+    }
+    QVERIFY(sum > 0);
+}
+
+// larger than the inline storage of continuations
+struct LargeCapture {
+    std::byte data[72];
+};
+static_assert(sizeof(LargeCapture) > QXmpp::Private::TaskContinuation::InlineSize);
+
+void tst_QXmppTask::benchmarkAllocations_data()
+{
+    QTest::addColumn<int>("scenario");
+    QTest::addColumn<qint64>("expectedAllocations");
+
+    QTest::newRow("then-before-finish") << 0 << qint64(0);
+    QTest::newRow("finish-before-take-result") << 1 << qint64(0);
+    // only the continuation is allocated
+    QTest::newRow("then-large-capture") << 2 << qint64(1);
+}
+
+void tst_QXmppTask::benchmarkAllocations()
+{
+    QFETCH(int, scenario);
+    QFETCH(qint64, expectedAllocations);
+
+    int sum = 0;
+    qint64 allocations = 0;
+    qint64 iterations = 0;
+
+    // fills the pool of the thread
+    {
+        QXmppPromise<int> promise;
+        promise.task().then(this, [](int &&) { });
+        promise.finish(1);
+    }
+
+    QBENCHMARK {
+        const auto start = allocationCount;
+        QXmppPromise<int> promise;
+        switch (scenario) {
+        case 0:
+            promise.task().then(this, [&sum](int &&value) { sum += value; });
+            promise.finish(1);
+            break;
+        case 1:
+            promise.finish(1);
+            sum += promise.task().takeResult();
+            break;
+        case 2:
+            promise.task().then(this, [&sum, large = LargeCapture()](int &&value) { sum += value + int(large.data[0]); });
+            promise.finish(1);
+            break;
+        }
+        allocations += allocationCount - start;
+        iterations++;
+    }
+
+    const auto perTask = double(allocations) / double(iterations);
+    qInfo("%.2f allocations per task", perTask);
+    QCOMPARE(allocations, expectedAllocations * iterations);
+    QVERIFY(sum > 0);
+}
+
+#ifdef QXMPP_TASK_COROUTINES
+static QXmppTask<int> length(QXmppTask<QString> task)
+{
+    auto value = co_await task;
+    co_return int(value.size());
+}
+
+void tst_QXmppTask::awaitFinished()
+{
+    QXmppPromise<QString> promise;
+    promise.finish(u"abc"_s);
+
+    auto task = length(promise.task());
+    QVERIFY(task.isFinished());
+    QCOMPARE(task.result(), 3);
+}
+
+void tst_QXmppTask::awaitPending()
+{
+    QXmppPromise<QString> promise;
+    auto task = length(promise.task());
+    QVERIFY(!task.isFinished());
+
+    // the coroutine is resumed by finish() directly
+    promise.finish(u"hello"_s);
+    QVERIFY(task.isFinished());
+    QCOMPARE(task.result(), 5);
+}
+
+static QXmppTask<void> sum(int &total, QXmppTask<QString> first, QXmppTask<void> second)
+{
+    total = co_await length(std::move(first));
+    co_await second;
+    total += 100;
+}
+
+void tst_QXmppTask::awaitChained()
+{
+    QXmppPromise<QString> first;
+    QXmppPromise<void> second;
+
+    int total = 0;
+    bool finished = false;
+    sum(total, first.task(), second.task()).then(this, [&] { finished = true; });
+
+    first.finish(u"four"_s);
+    QCOMPARE(total, 4);
+    QVERIFY(!finished);
+
+    second.finish();
+    QCOMPARE(total, 104);
+    QVERIFY(finished);
+}
+
+static QXmppTask<std::unique_ptr<int>> makeValue(QXmppTask<void> task)
+{
+    co_await task;
+    co_return std::make_unique<int>(42);
+}
+
+void tst_QXmppTask::awaitMoveOnly()
+{
+    QXmppPromise<void> promise;
+    std::unique_ptr<int> result;
+    makeValue(promise.task()).then(this, [&](std::unique_ptr<int> &&value) { result = std::move(value); });
+
+    promise.finish();
+    QVERIFY(result);
+    QCOMPARE(*result, 42);
+}
+
+static QXmppTask<int> guardedLength(QXmppTask<QString> task, bool &destroyed)
+{
+    auto guard = qScopeGuard([&] { destroyed = true; });
+    co_return co_await length(std::move(task));
+}
+
+void tst_QXmppTask::awaitAbandoned()
+{
+    // the promise is destroyed while the coroutines are suspended
+    bool destroyed = false;
+    auto promise = std::make_unique<QXmppPromise<QString>>();
+    auto copy = std::make_unique<QXmppPromise<QString>>(*promise);
+    auto task = guardedLength(promise->task(), destroyed);
+
+    promise.reset();
+    QVERIFY(!destroyed);
+
+    // the chain of awaiting coroutines is destroyed without being resumed
+    copy.reset();
+    QVERIFY(destroyed);
+    QVERIFY(!task.isFinished());
+
+    // the promise is destroyed before the task is awaited
+    destroyed = false;
+    promise = std::make_unique<QXmppPromise<QString>>();
+    auto abandonedTask = promise->task();
+    promise.reset();
+
+    auto otherTask = guardedLength(abandonedTask, destroyed);
+    QVERIFY(destroyed);
+    QVERIFY(!otherTask.isFinished());
+
+    // finished tasks are not abandoned
+    destroyed = false;
+    promise = std::make_unique<QXmppPromise<QString>>();
+    auto finishedTask = guardedLength(promise->task(), destroyed);
+    promise->finish(u"done"_s);
+    promise.reset();
+    QVERIFY(destroyed);
+    QCOMPARE(finishedTask.result(), 4);
+}
+#endif
+
+QTEST_MAIN(tst_QXmppTask)
+#include "tst_qxmpptask.moc"
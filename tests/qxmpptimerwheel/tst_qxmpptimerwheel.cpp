@@ -0,0 +1,131 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "TimerWheel.h"
+#include "util.h"
+
+#include <algorithm>
+
+using namespace QXmpp::Private;
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+class tst_QXmppTimerWheel : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void expire();
+    Q_SLOT void remove();
+    Q_SLOT void multipleRotations();
+    Q_SLOT void pastDeadline();
+    Q_SLOT void manyTimers();
+};
+
+void tst_QXmppTimerWheel::expire()
+{
+    const auto start = Clock::now();
+    TimerWheel<int> wheel(10ms, 8, start);
+
+    wheel.add(start + 25ms, 1);
+    wheel.add(start + 30ms, 2);
+    wheel.add(start + 45ms, 3);
+    QCOMPARE(wheel.size(), std::size_t(3));
+
+    QVERIFY(wheel.expire(start + 20ms).empty());
+    // deadlines are rounded up to the next tick
+    QCOMPARE(wheel.expire(start + 30ms), (std::vector<int> { 2, 1 }));
+    QVERIFY(wheel.expire(start + 40ms).empty());
+    QCOMPARE(wheel.expire(start + 50ms), (std::vector<int> { 3 }));
+    QVERIFY(wheel.isEmpty());
+}
+
+void tst_QXmppTimerWheel::remove()
+{
+    const auto start = Clock::now();
+    TimerWheel<int> wheel(10ms, 8, start);
+
+    auto a = wheel.add(start + 10ms, 1);
+    auto b = wheel.add(start + 10ms, 2);
+    auto c = wheel.add(start + 10ms, 3);
+
+    QVERIFY(wheel.remove(b));
+    QVERIFY(!wheel.remove(b));
+    QVERIFY(!wheel.remove({}));
+    QCOMPARE(wheel.size(), std::size_t(2));
+
+    // the node of b is reused, the old handle stays invalid
+    auto d = wheel.add(start + 20ms, 4);
+    QCOMPARE(d.index, b.index);
+    QVERIFY(!wheel.remove(b));
+
+    QCOMPARE(wheel.expire(start + 10ms), (std::vector<int> { 3, 1 }));
+    QVERIFY(!wheel.remove(a));
+    QVERIFY(!wheel.remove(c));
+    QVERIFY(wheel.remove(d));
+    QVERIFY(wheel.isEmpty());
+}
+
+void tst_QXmppTimerWheel::multipleRotations()
+{
+    const auto start = Clock::now();
+    TimerWheel<int> wheel(10ms, 4, start);
+
+    // same slot, different rotations
+    wheel.add(start + 10ms, 1);
+    wheel.add(start + 50ms, 2);
+    wheel.add(start + 90ms, 3);
+
+    QCOMPARE(wheel.expire(start + 10ms), (std::vector<int> { 1 }));
+    QVERIFY(wheel.expire(start + 40ms).empty());
+    QCOMPARE(wheel.expire(start + 50ms), (std::vector<int> { 2 }));
+
+    // jumping over several rotations at once
+    wheel.add(start + 120ms, 4);
+    auto expired = wheel.expire(start + 1s);
+    std::sort(expired.begin(), expired.end());
+    QCOMPARE(expired, (std::vector<int> { 3, 4 }));
+    QVERIFY(wheel.isEmpty());
+}
+
+void tst_QXmppTimerWheel::pastDeadline()
+{
+    const auto start = Clock::now();
+    TimerWheel<int> wheel(10ms, 8, start);
+    QVERIFY(wheel.expire(start + 100ms).empty());
+
+    // expires on the next tick
+    wheel.add(start + 50ms, 1);
+    QVERIFY(wheel.expire(start + 105ms).empty());
+    QCOMPARE(wheel.expire(start + 110ms), (std::vector<int> { 1 }));
+}
+
+void tst_QXmppTimerWheel::manyTimers()
+{
+    const auto start = Clock::now();
+    TimerWheel<int> wheel(100ms, 512, start);
+
+    std::vector<TimerWheel<int>::Handle> handles;
+    for (int i = 0; i < 100000; i++) {
+        handles.push_back(wheel.add(start + std::chrono::milliseconds(i % 60000), i));
+    }
+    // remove every second timer
+    for (std::size_t i = 0; i < handles.size(); i += 2) {
+        QVERIFY(wheel.remove(handles[i]));
+    }
+    QCOMPARE(wheel.size(), std::size_t(50000));
+
+    std::size_t expired = 0;
+    for (auto time = start; time <= start + 60s; time += 1s) {
+        for (int value : wheel.expire(time)) {
+            QVERIFY(value % 2 == 1);
+            QVERIFY(start + std::chrono::milliseconds(value % 60000) <= time);
+            expired++;
+        }
+    }
+    QCOMPARE(expired, std::size_t(50000));
+}
+
+QTEST_MAIN(tst_QXmppTimerWheel)
+#include "tst_qxmpptimerwheel.moc"
@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "QXmppConfiguration.h"
+#include "QXmppTlsSessionCache.h"
+
+#include "util.h"
+
+using namespace std::chrono_literals;
+
+class tst_QXmppTlsSessionCache : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void insertAndRemove();
+    Q_SLOT void configuration();
+};
+
+void tst_QXmppTlsSessionCache::insertAndRemove()
+{
+    QXmppTlsSessionCache cache;
+    QVERIFY(cache.sessionTicket(u"example.org"_s, u"xmpp.example.org"_s, 5222).isEmpty());
+
+    cache.insert(u"example.org"_s, u"xmpp.example.org"_s, 5222, QByteArrayLiteral("ticket1"), 1h);
+    cache.insert(u"example.org"_s, u"xmpp.example.org"_s, 5223, QByteArrayLiteral("ticket2"), 1h);
+    QCOMPARE(cache.size(), 2);
+    QCOMPARE(cache.sessionTicket(u"example.org"_s, u"xmpp.example.org"_s, 5222), QByteArrayLiteral("ticket1"));
+    QCOMPARE(cache.sessionTicket(u"Example.org"_s, u"XMPP.example.org"_s, 5223), QByteArrayLiteral("ticket2"));
+    QVERIFY(cache.sessionTicket(u"example.org"_s, u"other.example.org"_s, 5222).isEmpty());
+
+    // tickets are not offered for other domains hosted on the same server
+    QVERIFY(cache.sessionTicket(u"example.net"_s, u"xmpp.example.org"_s, 5222).isEmpty());
+    cache.insert(u"example.net"_s, u"xmpp.example.org"_s, 5222, QByteArrayLiteral("ticket6"), 1h);
+    QCOMPARE(cache.sessionTicket(u"example.net"_s, u"xmpp.example.org"_s, 5222), QByteArrayLiteral("ticket6"));
+    QCOMPARE(cache.sessionTicket(u"example.org"_s, u"xmpp.example.org"_s, 5222), QByteArrayLiteral("ticket1"));
+    cache.remove(u"example.net"_s, u"xmpp.example.org"_s, 5222);
+
+    // new tickets replace old ones
+    cache.insert(u"example.org"_s, u"xmpp.example.org"_s, 5222, QByteArrayLiteral("ticket3"), 1h);
+    QCOMPARE(cache.sessionTicket(u"example.org"_s, u"xmpp.example.org"_s, 5222), QByteArrayLiteral("ticket3"));
+
+    // tickets without lifetime are not stored
+    cache.insert(u"example.org"_s, u"xmpp.example.org"_s, 5222, QByteArrayLiteral("ticket4"), 0s);
+    QVERIFY(cache.sessionTicket(u"example.org"_s, u"xmpp.example.org"_s, 5222).isEmpty());
+
+    cache.remove(u"example.org"_s, u"xmpp.example.org"_s, 5223);
+    QVERIFY(cache.sessionTicket(u"example.org"_s, u"xmpp.example.org"_s, 5223).isEmpty());
+    QCOMPARE(cache.size(), 0);
+
+    cache.insert(u"example.org"_s, u"xmpp.example.org"_s, 5222, QByteArrayLiteral("ticket5"), 1h);
+    cache.clear();
+    QCOMPARE(cache.size(), 0);
+}
+
+void tst_QXmppTlsSessionCache::configuration()
+{
+    // resuming sessions is opt-in
+    QXmppConfiguration config;
+    QVERIFY(!config.tlsSessionCache());
+
+    // copies share the cache
+    config.setTlsSessionCache(std::make_shared<QXmppTlsSessionCache>());
+    auto copy = config;
+    copy.setDomain(u"example.org"_s);
+    QCOMPARE(copy.tlsSessionCache(), config.tlsSessionCache());
+
+    config.setTlsSessionCache(nullptr);
+    QVERIFY(!config.tlsSessionCache());
+    QVERIFY(copy.tlsSessionCache());
+}
+
+QTEST_MAIN(tst_QXmppTlsSessionCache)
+#include "tst_qxmpptlssessioncache.moc"
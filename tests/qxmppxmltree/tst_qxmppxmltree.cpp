@@ -0,0 +1,170 @@
+// SPDX-FileCopyrightText: 2026 QXmpp contributors
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "QXmppConstants_p.h"
+#include "QXmppUtils_p.h"
+
+#include "XmlTree.h"
+#include "util.h"
+
+using namespace QXmpp::Private;
+
+static const QByteArray MESSAGE_XML = QByteArrayLiteral(
+    "<message xmlns='jabber:client' id='m1' from='juliet@capulet.example/balcony' to='romeo@montague.example' type='chat'>"
+    "<body>Wherefore art thou, Romeo? &lt;3 &#x1F339;</body>"
+    "<thread>e0ffe42b28561960c6b12b944a092794b9683a38</thread>"
+    "<active xmlns='http://jabber.org/protocol/chatstates'/>"
+    "<request xmlns='urn:xmpp:receipts'/>"
+    "<markable xmlns='urn:xmpp:chat-markers:0'/>"
+    "<origin-id xmlns='urn:xmpp:sid:0' id='de305d54-75b4-431b-adb2-eb6b9e546014'/>"
+    "<stanza-id xmlns='urn:xmpp:sid:0' id='5f3dbc5e-e1d3-4077-a492-693f3769c7ad' by='romeo@montague.example'/>"
+    "<reactions id='744f6e18-a57a-11e9-a656-4889e7820c76' xmlns='urn:xmpp:reactions:0'>"
+    "<reaction>\xf0\x9f\x91\x8b</reaction><reaction>\xf0\x9f\x90\xa2</reaction>"
+    "</reactions>"
+    "</message>");
+
+class tst_QXmppXmlTree : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void parse();
+    Q_SLOT void namespaces();
+    Q_SLOT void text();
+    Q_SLOT void invalid_data();
+    Q_SLOT void invalid();
+
+    Q_SLOT void benchmarkDom();
+    Q_SLOT void benchmarkXmlTree();
+};
+
+void tst_QXmppXmlTree::parse()
+{
+    auto doc = XmlDocument::parse(MESSAGE_XML);
+    QVERIFY(doc.has_value());
+
+    auto el = doc->documentElement();
+    QCOMPARE(el.tagName(), u"message"_s);
+    QCOMPARE(el.namespaceURI(), u"jabber:client"_s);
+    QCOMPARE(el.attribute(u"id"), u"m1"_s);
+    QCOMPARE(el.attribute(u"type"), u"chat"_s);
+    QVERIFY(el.hasAttribute(u"to"));
+    QVERIFY(!el.hasAttribute(u"lang"));
+    QCOMPARE(el.attribute(u"lang", u"en"_s), u"en"_s);
+
+    QCOMPARE(el.firstChildElement().tagName(), u"body"_s);
+    QCOMPARE(el.firstChildElement(u"thread").text(), u"e0ffe42b28561960c6b12b944a092794b9683a38"_s);
+    QCOMPARE(el.firstChildElement({}, u"urn:xmpp:receipts").tagName(), u"request"_s);
+    QVERIFY(el.firstChildElement(u"request", u"urn:xmpp:sid:0").isNull());
+
+    auto stanzaId = firstChildElement(el, u"stanza-id", u"urn:xmpp:sid:0");
+    QCOMPARE(stanzaId.attribute(u"by"), u"romeo@montague.example"_s);
+    QVERIFY(stanzaId.parentElement() == el);
+
+    QStringList reactions;
+    for (const auto &reaction : iterChildElements(firstChildElement(el, u"reactions"), u"reaction")) {
+        reactions << reaction.text();
+    }
+    QCOMPARE(reactions, (QStringList { u"👋"_s, u"🐢"_s }));
+
+    int sidElements = 0;
+    for (const auto &child : iterChildElements(el, {}, u"urn:xmpp:sid:0")) {
+        QVERIFY(child.hasNamespace(u"urn:xmpp:sid:0"));
+        sidElements++;
+    }
+    QCOMPARE(sidElements, 2);
+}
+
+void tst_QXmppXmlTree::namespaces()
+{
+    auto doc = XmlDocument::parse(
+        "<stream:features><mechanisms xmlns='urn:ietf:params:xml:ns:xmpp-sasl'><mechanism>PLAIN</mechanism></mechanisms>"
+        "<x:y xmlns:x='urn:x' x:a='1' b='2' xml:lang='de'><z/></x:y></stream:features>",
+        "jabber:client");
+    QVERIFY(doc.has_value());
+
+    auto el = doc->documentElement();
+    QVERIFY(el.hasTagName(u"features"));
+    QVERIFY(el.hasNamespace(ns_stream));
+
+    auto mechanism = el.firstChildElement().firstChildElement();
+    QCOMPARE(mechanism.namespaceURI(), u"urn:ietf:params:xml:ns:xmpp-sasl"_s);
+
+    auto y = el.firstChildElement(u"y");
+    QCOMPARE(y.namespaceURI(), u"urn:x"_s);
+    // attributes are looked up by their qualified name like in QDomElement
+    QCOMPARE(y.attribute(u"x:a"), u"1"_s);
+    QCOMPARE(y.attribute(u"b"), u"2"_s);
+    QCOMPARE(y.attribute(u"xml:lang"), u"de"_s);
+    QVERIFY(!y.hasAttribute(u"a"));
+    QVERIFY(!y.hasAttribute(u"lang"));
+    QCOMPARE(y.attributeNS(u"urn:x", u"a"), u"1"_s);
+    QCOMPARE(y.attributeNS(u"http://www.w3.org/XML/1998/namespace", u"lang"), u"de"_s);
+    QVERIFY(y.attributeNS(u"urn:x", u"b").isNull());
+    // namespace declarations are not attributes
+    QVERIFY(!y.hasAttribute(u"x"));
+    // default namespace is inherited from the context
+    QCOMPARE(y.firstChildElement().namespaceURI(), u"jabber:client"_s);
+}
+
+void tst_QXmppXmlTree::text()
+{
+    auto doc = XmlDocument::parse(
+        "<a t='x&amp;y&#10;z\tw'>1 &lt;<b>2</b><![CDATA[ <3> ]]><!-- 4 -->&quot;5&apos;\r\n</a>");
+    QVERIFY(doc.has_value());
+
+    auto el = doc->documentElement();
+    QCOMPARE(el.attribute(u"t"), u"x&y\nz w"_s);
+    QCOMPARE(el.text(), u"1 <2 <3> \"5'\n"_s);
+    QCOMPARE(el.firstChildElement().text(), u"2"_s);
+}
+
+void tst_QXmppXmlTree::invalid_data()
+{
+    QTest::addColumn<QByteArray>("xml");
+
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("unclosed") << QByteArray("<a><b></b>");
+    QTest::newRow("mismatch") << QByteArray("<a></b>");
+    QTest::newRow("two-roots") << QByteArray("<a/><b/>");
+    QTest::newRow("text-outside") << QByteArray("x<a/>");
+    QTest::newRow("unknown-prefix") << QByteArray("<x:a/>");
+    QTest::newRow("unquoted-attribute") << QByteArray("<a b=c/>");
+    QTest::newRow("doctype") << QByteArray("<!DOCTYPE a><a/>");
+}
+
+void tst_QXmppXmlTree::invalid()
+{
+    QFETCH(QByteArray, xml);
+    QVERIFY(!XmlDocument::parse(xml).has_value());
+}
+
+void tst_QXmppXmlTree::benchmarkDom()
+{
+    // same wrapping as in XmppSocket
+    const QByteArray xml = "<stream:stream xmlns='jabber:client' xmlns:stream='http://etherx.jabber.org/streams'>" + MESSAGE_XML + "</stream:stream>";
+
+    QBENCHMARK {
+        QDomDocument doc;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+        doc.setContent(xml, QDomDocument::ParseOption::UseNamespaceProcessing);
+#else
+        doc.setContent(xml, true);
+#endif
+        auto el = doc.documentElement().firstChildElement();
+        QVERIFY(!firstChildElement(el, u"body").text().isEmpty());
+    }
+}
+
+void tst_QXmppXmlTree::benchmarkXmlTree()
+{
+    QBENCHMARK {
+        auto doc = XmlDocument::parse(MESSAGE_XML, "jabber:client");
+        auto el = doc->documentElement();
+        QVERIFY(!firstChildElement(el, u"body").text().isEmpty());
+    }
+}
+
+QTEST_MAIN(tst_QXmppXmlTree)
+#include "tst_qxmppxmltree.moc"